@@ -0,0 +1,135 @@
+//
+//  ArquivoMapeado.h
+//
+//  Arquivo inteiro mapeado em memória (mmap / MapViewOfFile). Usado pelos
+//  loaders de mapa para ler sem copiar para um buffer intermediário.
+//
+
+#ifndef ArquivoMapeado_h
+#define ArquivoMapeado_h
+
+#include <cstddef>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// O mapeamento é desfeito no destrutor. Com copiaNaEscrita as páginas podem
+// ser alteradas em memória; a alteração nunca volta para o arquivo
+class ArquivoMapeado {
+    char *dados;
+    size_t tamanho;
+#ifdef _WIN32
+    HANDLE arquivo, mapeamento;
+#else
+    int fd;
+#endif
+
+public:
+    ArquivoMapeado() {
+        this->dados = NULL;
+        this->tamanho = 0;
+#ifdef _WIN32
+        this->arquivo = INVALID_HANDLE_VALUE;
+        this->mapeamento = NULL;
+#else
+        this->fd = -1;
+#endif
+    }
+
+    ~ArquivoMapeado() {
+        fechar();
+    }
+
+    ArquivoMapeado(const ArquivoMapeado &) = delete;
+    ArquivoMapeado &operator=(const ArquivoMapeado &) = delete;
+
+    bool abrir(const char *caminho, bool copiaNaEscrita = false) {
+        fechar();
+#ifdef _WIN32
+        this->arquivo = CreateFileA(caminho, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                                    FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (this->arquivo == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER tam;
+        if (!GetFileSizeEx(this->arquivo, &tam) || tam.QuadPart == 0) {
+            fechar();
+            return false;
+        }
+        this->tamanho = (size_t)tam.QuadPart;
+        this->mapeamento = CreateFileMappingA(this->arquivo, NULL, copiaNaEscrita ? PAGE_WRITECOPY : PAGE_READONLY,
+                                              0, 0, NULL);
+        if (this->mapeamento == NULL) {
+            fechar();
+            return false;
+        }
+        this->dados = (char *)MapViewOfFile(this->mapeamento, copiaNaEscrita ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+#else
+        this->fd = open(caminho, O_RDONLY);
+        if (this->fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(this->fd, &st) != 0 || st.st_size == 0) {
+            fechar();
+            return false;
+        }
+        this->tamanho = (size_t)st.st_size;
+        int protecao = copiaNaEscrita ? PROT_READ | PROT_WRITE : PROT_READ;
+        void *p = mmap(NULL, this->tamanho, protecao, MAP_PRIVATE, this->fd, 0);
+        if (p == MAP_FAILED) {
+            fechar();
+            return false;
+        }
+        madvise(p, this->tamanho, MADV_SEQUENTIAL);
+        this->dados = (char *)p;
+#endif
+        return this->dados != NULL;
+    }
+
+    void fechar() {
+#ifdef _WIN32
+        if (this->dados)
+            UnmapViewOfFile(this->dados);
+        if (this->mapeamento)
+            CloseHandle(this->mapeamento);
+        if (this->arquivo != INVALID_HANDLE_VALUE)
+            CloseHandle(this->arquivo);
+        this->mapeamento = NULL;
+        this->arquivo = INVALID_HANDLE_VALUE;
+#else
+        if (this->dados)
+            munmap(this->dados, this->tamanho);
+        if (this->fd >= 0)
+            close(this->fd);
+        this->fd = -1;
+#endif
+        this->dados = NULL;
+        this->tamanho = 0;
+    }
+
+    const char *getDados() const {
+        return this->dados;
+    }
+
+    // Só pode ser escrito se o arquivo foi aberto com copiaNaEscrita
+    char *getDados() {
+        return this->dados;
+    }
+
+    size_t getTamanho() const {
+        return this->tamanho;
+    }
+};
+
+#endif /* ArquivoMapeado_h */
@@ -0,0 +1,659 @@
+//
+//  BlockCompression.h
+//
+//  Compressão de texturas em blocos de 4x4 pixels, feita na CPU pela
+//  ferramenta texc (tools/texc.cpp). Não usa OpenGL.
+//
+//  BC7 (16 bytes por bloco, 8 bits por pixel): cada bloco é tentado nos
+//  modos 6 (RGBA numa reta, extremos de 7 bits + p-bit, índices de 4 bits)
+//  e 5 (cor e alpha em retas separadas, índices de 2 bits para cada) e fica
+//  o que errar menos. O 6 é o melhor para cores suaves; o 5, para as bordas
+//  dos sprites. Os extremos saem do eixo principal das cores do bloco e são
+//  reajustados por mínimos quadrados com os índices escolhidos. A cor de
+//  pixels com alpha 0 não entra no erro, já que não aparece.
+//
+//  BC3 / DXT5 (16 bytes por bloco): cor como no BC1 (dois extremos RGB565
+//  e 4 tons) mais um bloco de alpha com dois extremos de 8 bits e 8 tons.
+//  Pior que o BC7 nas cores, mas existe em placas sem OpenGL 4.2.
+//
+//  Os decodificadores seguem a especificação e servem para a texc medir o
+//  erro do que gravou.
+//
+
+#ifndef BlockCompression_h
+#define BlockCompression_h
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#define BYTES_BLOCO_COMPRIMIDO 16
+
+enum FormatoBloco { BLOCO_BC7, BLOCO_BC3 };
+
+namespace blocos {
+
+// Pesos de interpolação do BC7 para índices de 4 e de 2 bits
+static const int PESOS_BC7_4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+static const int PESOS_BC7_2[4] = {0, 21, 43, 64};
+
+inline int limitar(int v, int lo, int hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+// Eixo de maior variação das cores do bloco (iteração de potência na
+// matriz de covariância); media recebe a média dos canais. Com usar, só os
+// pixels marcados entram na conta
+inline void eixoPrincipal(const uint8_t *rgba, int canais, const bool *usar, float media[4], float eixo[4]) {
+    for (int c = 0; c < 4; c++)
+        media[c] = eixo[c] = 0.0f;
+    int n = 0;
+    for (int p = 0; p < 16; p++) {
+        if (usar && !usar[p])
+            continue;
+        n++;
+        for (int c = 0; c < canais; c++)
+            media[c] += rgba[p * 4 + c];
+    }
+    if (n == 0)
+        return;
+    for (int c = 0; c < canais; c++)
+        media[c] /= (float)n;
+
+    float cov[4][4] = {{0}};
+    for (int p = 0; p < 16; p++) {
+        if (usar && !usar[p])
+            continue;
+        float d[4];
+        for (int c = 0; c < canais; c++)
+            d[c] = rgba[p * 4 + c] - media[c];
+        for (int i = 0; i < canais; i++)
+            for (int j = 0; j < canais; j++)
+                cov[i][j] += d[i] * d[j];
+    }
+
+    // Começa pela diagonal do cubo envolvente, que já é uma boa aproximação
+    float v[4] = {0, 0, 0, 0};
+    for (int c = 0; c < canais; c++) {
+        int lo = 255, hi = 0;
+        for (int p = 0; p < 16; p++) {
+            if (usar && !usar[p])
+                continue;
+            lo = std::min(lo, (int)rgba[p * 4 + c]);
+            hi = std::max(hi, (int)rgba[p * 4 + c]);
+        }
+        v[c] = (float)(hi - lo);
+    }
+    for (int it = 0; it < 8; it++) {
+        float w[4] = {0, 0, 0, 0};
+        for (int i = 0; i < canais; i++)
+            for (int j = 0; j < canais; j++)
+                w[i] += cov[i][j] * v[j];
+        float norma = 0.0f;
+        for (int c = 0; c < canais; c++)
+            norma = std::max(norma, std::fabs(w[c]));
+        if (norma < 1e-6f)
+            break;
+        for (int c = 0; c < canais; c++)
+            v[c] = w[c] / norma;
+    }
+    float tam = 0.0f;
+    for (int c = 0; c < canais; c++)
+        tam += v[c] * v[c];
+    if (tam > 1e-12f) {
+        tam = std::sqrt(tam);
+        for (int c = 0; c < canais; c++)
+            eixo[c] = v[c] / tam;
+    }
+}
+
+// Escreve nBits de valor a partir do bit *pos (LSB primeiro)
+inline void escreverBits(uint8_t *bloco, int &pos, uint32_t valor, int nBits) {
+    for (int b = 0; b < nBits; b++, pos++)
+        if (valor & (1u << b))
+            bloco[pos >> 3] |= (uint8_t)(1u << (pos & 7));
+}
+
+inline uint32_t lerBits(const uint8_t *bloco, int &pos, int nBits) {
+    uint32_t valor = 0;
+    for (int b = 0; b < nBits; b++, pos++)
+        if (bloco[pos >> 3] & (1u << (pos & 7)))
+            valor |= 1u << b;
+    return valor;
+}
+
+// ---------------------------------------------------------------- BC7 ----
+
+inline int interpolarBC7(int e0, int e1, int peso) {
+    return ((64 - peso) * e0 + peso * e1 + 32) >> 6;
+}
+
+// Erro quadrático de um pixel decodificado. A cor de um pixel totalmente
+// transparente não aparece, então só o alpha conta
+inline int erroPixel(const uint8_t *original, const uint8_t *decodificado) {
+    int da = (int)original[3] - decodificado[3];
+    int erro = da * da;
+    if (original[3] > 0) {
+        for (int c = 0; c < 3; c++) {
+            int d = (int)original[c] - decodificado[c];
+            erro += d * d;
+        }
+    }
+    return erro;
+}
+
+// Extremos que minimizam o erro nos canais [c0, c1) para os índices dados
+// (mínimos quadrados), usando só os pixels marcados em usar
+inline bool reajustarBC7(const uint8_t *rgba, const uint8_t indices[16], const int *pesos, int c0, int c1,
+                         const bool usar[16], float a[4], float b[4]) {
+    float aa = 0, ab = 0, bb = 0, ax[4] = {0, 0, 0, 0}, bx[4] = {0, 0, 0, 0};
+    for (int p = 0; p < 16; p++) {
+        if (!usar[p])
+            continue;
+        float w = pesos[indices[p]] / 64.0f;
+        aa += (1 - w) * (1 - w);
+        ab += (1 - w) * w;
+        bb += w * w;
+        for (int c = c0; c < c1; c++) {
+            ax[c] += (1 - w) * rgba[p * 4 + c];
+            bx[c] += w * rgba[p * 4 + c];
+        }
+    }
+    float det = aa * bb - ab * ab;
+    if (std::fabs(det) < 1e-6f)
+        return false;
+    for (int c = c0; c < c1; c++) {
+        a[c] = std::min(255.0f, std::max(0.0f, (bb * ax[c] - ab * bx[c]) / det));
+        b[c] = std::min(255.0f, std::max(0.0f, (aa * bx[c] - ab * ax[c]) / det));
+    }
+    return true;
+}
+
+// Pontas do eixo principal dos canais [0, canais) dos pixels marcados
+inline void extremosNoEixo(const uint8_t *rgba, int canais, const bool *usar, float a[4], float b[4]) {
+    float media[4], eixo[4];
+    eixoPrincipal(rgba, canais, usar, media, eixo);
+    float tMin = 0.0f, tMax = 0.0f;
+    for (int p = 0; p < 16; p++) {
+        if (usar && !usar[p])
+            continue;
+        float t = 0.0f;
+        for (int c = 0; c < canais; c++)
+            t += (rgba[p * 4 + c] - media[c]) * eixo[c];
+        tMin = std::min(tMin, t);
+        tMax = std::max(tMax, t);
+    }
+    for (int c = 0; c < canais; c++) {
+        a[c] = std::min(255.0f, std::max(0.0f, media[c] + tMin * eixo[c]));
+        b[c] = std::min(255.0f, std::max(0.0f, media[c] + tMax * eixo[c]));
+    }
+}
+
+// Índice de peso mais próximo de cada pixel nos canais [c0, c1). Pixels
+// fora de usar ficam com o índice 0
+inline void escolherIndices(const uint8_t *rgba, const int e0[4], const int e1[4], const int *pesos, int nPesos,
+                            int c0, int c1, const bool *usar, uint8_t indices[16]) {
+    for (int p = 0; p < 16; p++) {
+        indices[p] = 0;
+        if (usar && !usar[p])
+            continue;
+        int menor = 1 << 30;
+        for (int i = 0; i < nPesos; i++) {
+            int erro = 0;
+            for (int c = c0; c < c1; c++) {
+                int d = interpolarBC7(e0[c], e1[c], pesos[i]) - rgba[p * 4 + c];
+                erro += d * d;
+            }
+            if (erro < menor) {
+                menor = erro;
+                indices[p] = (uint8_t)i;
+            }
+        }
+    }
+}
+
+// Modo 6: RGBA numa reta só, extremos de 7 bits + p-bit, índices de 4 bits
+struct BlocoModo6 {
+    int c[2][4]; // 0..127
+    int p[2];
+    uint8_t indices[16];
+};
+
+inline void expandirModo6(const BlocoModo6 &m, int e0[4], int e1[4]) {
+    for (int c = 0; c < 4; c++) {
+        e0[c] = (m.c[0][c] << 1) | m.p[0];
+        e1[c] = (m.c[1][c] << 1) | m.p[1];
+    }
+}
+
+// Melhor extremo de 7 bits + p-bit para uma cor de 8 bits por canal
+inline void quantizarModo6(const float cor[4], int c7[4], int &pBit) {
+    float menorErro = 1e30f;
+    pBit = 0;
+    for (int c = 0; c < 4; c++)
+        c7[c] = 0;
+    for (int p = 0; p < 2; p++) {
+        int q[4];
+        float erro = 0.0f;
+        for (int c = 0; c < 4; c++) {
+            q[c] = limitar((int)std::floor((cor[c] - p) / 2.0f + 0.5f), 0, 127);
+            float d = (float)((q[c] << 1) | p) - cor[c];
+            erro += d * d;
+        }
+        if (erro < menorErro) {
+            menorErro = erro;
+            pBit = p;
+            memcpy(c7, q, sizeof(q));
+        }
+    }
+}
+
+inline void montarModo6(const uint8_t *rgba, const float a[4], const float b[4], BlocoModo6 &m) {
+    quantizarModo6(a, m.c[0], m.p[0]);
+    quantizarModo6(b, m.c[1], m.p[1]);
+    int e0[4], e1[4];
+    expandirModo6(m, e0, e1);
+    escolherIndices(rgba, e0, e1, PESOS_BC7_4, 16, 0, 4, NULL, m.indices);
+}
+
+inline void gravarModo6(BlocoModo6 m, uint8_t saida[BYTES_BLOCO_COMPRIMIDO]) {
+    // O índice do pixel 0 é gravado com 3 bits: o bit alto tem que ser 0
+    if (m.indices[0] & 8) {
+        for (int c = 0; c < 4; c++)
+            std::swap(m.c[0][c], m.c[1][c]);
+        std::swap(m.p[0], m.p[1]);
+        for (int p = 0; p < 16; p++)
+            m.indices[p] = (uint8_t)(15 - m.indices[p]);
+    }
+    memset(saida, 0, BYTES_BLOCO_COMPRIMIDO);
+    int pos = 0;
+    escreverBits(saida, pos, 1u << 6, 7);
+    for (int c = 0; c < 4; c++) {
+        escreverBits(saida, pos, (uint32_t)m.c[0][c], 7);
+        escreverBits(saida, pos, (uint32_t)m.c[1][c], 7);
+    }
+    escreverBits(saida, pos, (uint32_t)m.p[0], 1);
+    escreverBits(saida, pos, (uint32_t)m.p[1], 1);
+    escreverBits(saida, pos, m.indices[0], 3);
+    for (int p = 1; p < 16; p++)
+        escreverBits(saida, pos, m.indices[p], 4);
+}
+
+// Modo 5: RGB e alpha em retas separadas, cor com 7 bits e alpha com 8,
+// índices de 2 bits para cada um. Resolve os blocos de borda dos sprites,
+// onde pixels transparentes e opacos de cores diferentes não cabem numa
+// reta RGBA só
+struct BlocoModo5 {
+    int cor[2][3]; // 0..127
+    int alfa[2];   // 0..255
+    uint8_t indicesCor[16], indicesAlfa[16];
+};
+
+inline void expandirModo5(const BlocoModo5 &m, int e0[4], int e1[4]) {
+    for (int c = 0; c < 3; c++) {
+        e0[c] = (m.cor[0][c] << 1) | (m.cor[0][c] >> 6);
+        e1[c] = (m.cor[1][c] << 1) | (m.cor[1][c] >> 6);
+    }
+    e0[3] = m.alfa[0];
+    e1[3] = m.alfa[1];
+}
+
+inline void montarModo5(const uint8_t *rgba, const bool visivel[16], const float a[4], const float b[4],
+                        BlocoModo5 &m) {
+    for (int c = 0; c < 3; c++) {
+        m.cor[0][c] = limitar((int)(a[c] * 127.0f / 255.0f + 0.5f), 0, 127);
+        m.cor[1][c] = limitar((int)(b[c] * 127.0f / 255.0f + 0.5f), 0, 127);
+    }
+    m.alfa[0] = limitar((int)(a[3] + 0.5f), 0, 255);
+    m.alfa[1] = limitar((int)(b[3] + 0.5f), 0, 255);
+    int e0[4], e1[4];
+    expandirModo5(m, e0, e1);
+    escolherIndices(rgba, e0, e1, PESOS_BC7_2, 4, 0, 3, visivel, m.indicesCor);
+    escolherIndices(rgba, e0, e1, PESOS_BC7_2, 4, 3, 4, NULL, m.indicesAlfa);
+}
+
+inline void gravarModo5(BlocoModo5 m, uint8_t saida[BYTES_BLOCO_COMPRIMIDO]) {
+    // Os índices do pixel 0 são gravados com 1 bit cada
+    if (m.indicesCor[0] & 2) {
+        for (int c = 0; c < 3; c++)
+            std::swap(m.cor[0][c], m.cor[1][c]);
+        for (int p = 0; p < 16; p++)
+            m.indicesCor[p] = (uint8_t)(3 - m.indicesCor[p]);
+    }
+    if (m.indicesAlfa[0] & 2) {
+        std::swap(m.alfa[0], m.alfa[1]);
+        for (int p = 0; p < 16; p++)
+            m.indicesAlfa[p] = (uint8_t)(3 - m.indicesAlfa[p]);
+    }
+    memset(saida, 0, BYTES_BLOCO_COMPRIMIDO);
+    int pos = 0;
+    escreverBits(saida, pos, 1u << 5, 6);
+    escreverBits(saida, pos, 0, 2); // sem rotação de canais
+    for (int c = 0; c < 3; c++) {
+        escreverBits(saida, pos, (uint32_t)m.cor[0][c], 7);
+        escreverBits(saida, pos, (uint32_t)m.cor[1][c], 7);
+    }
+    escreverBits(saida, pos, (uint32_t)m.alfa[0], 8);
+    escreverBits(saida, pos, (uint32_t)m.alfa[1], 8);
+    escreverBits(saida, pos, m.indicesCor[0], 1);
+    for (int p = 1; p < 16; p++)
+        escreverBits(saida, pos, m.indicesCor[p], 2);
+    escreverBits(saida, pos, m.indicesAlfa[0], 1);
+    for (int p = 1; p < 16; p++)
+        escreverBits(saida, pos, m.indicesAlfa[p], 2);
+}
+
+} // namespace blocos
+
+// Decodifica um bloco BC7 nos modos 5 e 6; false (e pixels zerados) nos
+// outros modos, que a texc não gera
+inline bool descomprimirBlocoBC7(const uint8_t bloco[BYTES_BLOCO_COMPRIMIDO], uint8_t rgba[64]) {
+    using namespace blocos;
+    memset(rgba, 0, 64);
+    int e0[4], e1[4];
+    if ((bloco[0] & 0x7F) == 0x40) {
+        int pos = 7;
+        BlocoModo6 m;
+        for (int c = 0; c < 4; c++) {
+            m.c[0][c] = (int)lerBits(bloco, pos, 7);
+            m.c[1][c] = (int)lerBits(bloco, pos, 7);
+        }
+        m.p[0] = (int)lerBits(bloco, pos, 1);
+        m.p[1] = (int)lerBits(bloco, pos, 1);
+        expandirModo6(m, e0, e1);
+        for (int p = 0; p < 16; p++) {
+            int i = (int)lerBits(bloco, pos, p == 0 ? 3 : 4);
+            for (int c = 0; c < 4; c++)
+                rgba[p * 4 + c] = (uint8_t)interpolarBC7(e0[c], e1[c], PESOS_BC7_4[i]);
+        }
+        return true;
+    }
+    if ((bloco[0] & 0x3F) == 0x20) {
+        int pos = 6;
+        int rotacao = (int)lerBits(bloco, pos, 2);
+        BlocoModo5 m;
+        for (int c = 0; c < 3; c++) {
+            m.cor[0][c] = (int)lerBits(bloco, pos, 7);
+            m.cor[1][c] = (int)lerBits(bloco, pos, 7);
+        }
+        m.alfa[0] = (int)lerBits(bloco, pos, 8);
+        m.alfa[1] = (int)lerBits(bloco, pos, 8);
+        expandirModo5(m, e0, e1);
+        for (int p = 0; p < 16; p++) {
+            int i = (int)lerBits(bloco, pos, p == 0 ? 1 : 2);
+            for (int c = 0; c < 3; c++)
+                rgba[p * 4 + c] = (uint8_t)interpolarBC7(e0[c], e1[c], PESOS_BC7_2[i]);
+        }
+        for (int p = 0; p < 16; p++) {
+            int i = (int)lerBits(bloco, pos, p == 0 ? 1 : 2);
+            rgba[p * 4 + 3] = (uint8_t)interpolarBC7(e0[3], e1[3], PESOS_BC7_2[i]);
+        }
+        if (rotacao > 0)
+            for (int p = 0; p < 16; p++)
+                std::swap(rgba[p * 4 + 3], rgba[p * 4 + rotacao - 1]);
+        return true;
+    }
+    return false;
+}
+
+// Comprime um bloco de 16 pixels RGBA8 (linha a linha) em BC7, no modo 6
+// ou no 5, o que errar menos
+inline void comprimirBlocoBC7(const uint8_t rgba[64], uint8_t saida[BYTES_BLOCO_COMPRIMIDO]) {
+    using namespace blocos;
+    bool todos[16], visivel[16];
+    for (int p = 0; p < 16; p++) {
+        todos[p] = true;
+        visivel[p] = rgba[p * 4 + 3] > 0;
+    }
+
+    uint8_t candidato[BYTES_BLOCO_COMPRIMIDO], decodificado[64];
+    int menorErro = 1 << 30;
+    float a[4], b[4];
+
+    // Modo 6, com dois reajustes dos extremos pelos índices escolhidos
+    extremosNoEixo(rgba, 4, NULL, a, b);
+    for (int it = 0; it < 3; it++) {
+        BlocoModo6 m;
+        montarModo6(rgba, a, b, m);
+        gravarModo6(m, candidato);
+        descomprimirBlocoBC7(candidato, decodificado);
+        int erro = 0;
+        for (int p = 0; p < 16; p++)
+            erro += erroPixel(rgba + p * 4, decodificado + p * 4);
+        if (erro < menorErro) {
+            menorErro = erro;
+            memcpy(saida, candidato, BYTES_BLOCO_COMPRIMIDO);
+        }
+        if (erro == 0 || !reajustarBC7(rgba, m.indices, PESOS_BC7_4, 0, 4, todos, a, b))
+            break;
+    }
+    if (menorErro == 0)
+        return;
+
+    // Modo 5: a cor só dos pixels visíveis, o alpha de todos
+    extremosNoEixo(rgba, 3, visivel, a, b);
+    a[3] = 255.0f;
+    b[3] = 0.0f;
+    for (int p = 0; p < 16; p++) {
+        a[3] = std::min(a[3], (float)rgba[p * 4 + 3]);
+        b[3] = std::max(b[3], (float)rgba[p * 4 + 3]);
+    }
+    for (int it = 0; it < 2; it++) {
+        BlocoModo5 m;
+        montarModo5(rgba, visivel, a, b, m);
+        gravarModo5(m, candidato);
+        descomprimirBlocoBC7(candidato, decodificado);
+        int erro = 0;
+        for (int p = 0; p < 16; p++)
+            erro += erroPixel(rgba + p * 4, decodificado + p * 4);
+        if (erro < menorErro) {
+            menorErro = erro;
+            memcpy(saida, candidato, BYTES_BLOCO_COMPRIMIDO);
+        }
+        if (erro == 0 || !reajustarBC7(rgba, m.indicesCor, PESOS_BC7_2, 0, 3, visivel, a, b))
+            break;
+    }
+}
+
+// ---------------------------------------------------------------- BC3 ----
+
+namespace blocos {
+
+inline uint16_t para565(const float cor[3]) {
+    int r = limitar((int)(cor[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+    int g = limitar((int)(cor[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+    int b = limitar((int)(cor[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+inline void de565(uint16_t v, int cor[3]) {
+    int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+    cor[0] = (r << 3) | (r >> 2);
+    cor[1] = (g << 2) | (g >> 4);
+    cor[2] = (b << 3) | (b >> 2);
+}
+
+// Os 4 tons do bloco de cor no modo de 4 cores (o único do BC3)
+inline void paletaBC1(uint16_t c0, uint16_t c1, int paleta[4][3]) {
+    de565(c0, paleta[0]);
+    de565(c1, paleta[1]);
+    for (int c = 0; c < 3; c++) {
+        paleta[2][c] = (2 * paleta[0][c] + paleta[1][c]) / 3;
+        paleta[3][c] = (paleta[0][c] + 2 * paleta[1][c]) / 3;
+    }
+}
+
+inline void paletaAlpha(int a0, int a1, int paleta[8]) {
+    paleta[0] = a0;
+    paleta[1] = a1;
+    if (a0 > a1) {
+        for (int i = 1; i < 7; i++)
+            paleta[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+    } else {
+        for (int i = 1; i < 5; i++)
+            paleta[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+        paleta[6] = 0;
+        paleta[7] = 255;
+    }
+}
+
+} // namespace blocos
+
+// Comprime um bloco de 16 pixels RGBA8 (linha a linha) em BC3
+inline void comprimirBlocoBC3(const uint8_t rgba[64], uint8_t saida[BYTES_BLOCO_COMPRIMIDO]) {
+    using namespace blocos;
+    memset(saida, 0, BYTES_BLOCO_COMPRIMIDO);
+
+    // Alpha: extremos no máximo e no mínimo, 8 tons entre eles
+    int aMin = 255, aMax = 0;
+    for (int p = 0; p < 16; p++) {
+        aMin = std::min(aMin, (int)rgba[p * 4 + 3]);
+        aMax = std::max(aMax, (int)rgba[p * 4 + 3]);
+    }
+    saida[0] = (uint8_t)aMax;
+    saida[1] = (uint8_t)aMin;
+    if (aMax > aMin) {
+        int paleta[8];
+        paletaAlpha(aMax, aMin, paleta);
+        int pos = 16;
+        for (int p = 0; p < 16; p++) {
+            int menor = 1 << 30, escolhido = 0;
+            for (int i = 0; i < 8; i++) {
+                int d = std::abs(paleta[i] - rgba[p * 4 + 3]);
+                if (d < menor) {
+                    menor = d;
+                    escolhido = i;
+                }
+            }
+            escreverBits(saida, pos, (uint32_t)escolhido, 3);
+        }
+    }
+
+    // Cor: extremos nas pontas do eixo principal RGB dos pixels visíveis
+    bool visivel[16];
+    for (int p = 0; p < 16; p++)
+        visivel[p] = rgba[p * 4 + 3] > 0;
+    float a[4], b[4];
+    extremosNoEixo(rgba, 3, visivel, a, b);
+    uint16_t c0 = para565(a), c1 = para565(b);
+    if (c0 < c1)
+        std::swap(c0, c1);
+
+    uint8_t *cor = saida + 8;
+    cor[0] = (uint8_t)(c0 & 0xFF);
+    cor[1] = (uint8_t)(c0 >> 8);
+    cor[2] = (uint8_t)(c1 & 0xFF);
+    cor[3] = (uint8_t)(c1 >> 8);
+    if (c0 == c1)
+        return; // todos os índices 0
+
+    int paleta[4][3];
+    paletaBC1(c0, c1, paleta);
+    int pos = 32;
+    for (int p = 0; p < 16; p++) {
+        int menor = 1 << 30, escolhido = 0;
+        for (int i = 0; i < 4; i++) {
+            int erro = 0;
+            for (int c = 0; c < 3; c++) {
+                int d = paleta[i][c] - rgba[p * 4 + c];
+                erro += d * d;
+            }
+            if (erro < menor) {
+                menor = erro;
+                escolhido = i;
+            }
+        }
+        escreverBits(cor, pos, (uint32_t)escolhido, 2);
+    }
+}
+
+inline void descomprimirBlocoBC3(const uint8_t bloco[BYTES_BLOCO_COMPRIMIDO], uint8_t rgba[64]) {
+    using namespace blocos;
+    int alphas[8];
+    paletaAlpha(bloco[0], bloco[1], alphas);
+    uint16_t c0 = (uint16_t)(bloco[8] | (bloco[9] << 8)), c1 = (uint16_t)(bloco[10] | (bloco[11] << 8));
+    int paleta[4][3];
+    paletaBC1(c0, c1, paleta);
+
+    int posAlpha = 16, posCor = 96;
+    for (int p = 0; p < 16; p++) {
+        int ia = (int)lerBits(bloco, posAlpha, 3);
+        int ic = (int)lerBits(bloco, posCor, 2);
+        for (int c = 0; c < 3; c++)
+            rgba[p * 4 + c] = (uint8_t)paleta[ic][c];
+        rgba[p * 4 + 3] = (uint8_t)alphas[ia];
+    }
+}
+
+// ------------------------------------------------------------- imagens ---
+
+// Bytes de uma imagem largura x altura comprimida em blocos 4x4
+inline size_t bytesComprimidos(int largura, int altura) {
+    return (size_t)((largura + 3) / 4) * ((altura + 3) / 4) * BYTES_BLOCO_COMPRIMIDO;
+}
+
+// Comprime uma imagem RGBA8 inteira. Nas bordas de imagens que não são
+// múltiplas de 4 o bloco é completado repetindo a última linha/coluna
+inline void comprimirImagem(FormatoBloco formato, const uint8_t *rgba, int largura, int altura,
+                            std::vector<uint8_t> &saida) {
+    int bx = (largura + 3) / 4, by = (altura + 3) / 4;
+    saida.resize(bytesComprimidos(largura, altura));
+    uint8_t bloco[64];
+    for (int j = 0; j < by; j++) {
+        for (int i = 0; i < bx; i++) {
+            for (int y = 0; y < 4; y++) {
+                int py = std::min(j * 4 + y, altura - 1);
+                for (int x = 0; x < 4; x++) {
+                    int px = std::min(i * 4 + x, largura - 1);
+                    memcpy(bloco + (y * 4 + x) * 4, rgba + ((size_t)py * largura + px) * 4, 4);
+                }
+            }
+            uint8_t *destino = &saida[((size_t)j * bx + i) * BYTES_BLOCO_COMPRIMIDO];
+            if (formato == BLOCO_BC7)
+                comprimirBlocoBC7(bloco, destino);
+            else
+                comprimirBlocoBC3(bloco, destino);
+        }
+    }
+}
+
+inline void descomprimirImagem(FormatoBloco formato, const uint8_t *blocos, int largura, int altura,
+                               std::vector<uint8_t> &rgba) {
+    int bx = (largura + 3) / 4, by = (altura + 3) / 4;
+    rgba.resize((size_t)largura * altura * 4);
+    uint8_t bloco[64];
+    for (int j = 0; j < by; j++) {
+        for (int i = 0; i < bx; i++) {
+            const uint8_t *origem = blocos + ((size_t)j * bx + i) * BYTES_BLOCO_COMPRIMIDO;
+            if (formato == BLOCO_BC7)
+                descomprimirBlocoBC7(origem, bloco);
+            else
+                descomprimirBlocoBC3(origem, bloco);
+            for (int y = 0; y < 4 && j * 4 + y < altura; y++)
+                for (int x = 0; x < 4 && i * 4 + x < largura; x++)
+                    memcpy(&rgba[((size_t)(j * 4 + y) * largura + i * 4 + x) * 4], bloco + (y * 4 + x) * 4, 4);
+        }
+    }
+}
+
+// Próximo nível de mipmap (metade de cada lado, mínimo 1) pela média de
+// 2x2 pixels, como o glGenerateMipmap
+inline void reduzirMetade(const uint8_t *rgba, int largura, int altura, std::vector<uint8_t> &saida) {
+    int l = std::max(1, largura / 2), a = std::max(1, altura / 2);
+    saida.resize((size_t)l * a * 4);
+    for (int y = 0; y < a; y++) {
+        int y0 = std::min(2 * y, altura - 1), y1 = std::min(2 * y + 1, altura - 1);
+        for (int x = 0; x < l; x++) {
+            int x0 = std::min(2 * x, largura - 1), x1 = std::min(2 * x + 1, largura - 1);
+            for (int c = 0; c < 4; c++) {
+                int soma = rgba[((size_t)y0 * largura + x0) * 4 + c] + rgba[((size_t)y0 * largura + x1) * 4 + c] +
+                           rgba[((size_t)y1 * largura + x0) * 4 + c] + rgba[((size_t)y1 * largura + x1) * 4 + c];
+                saida[((size_t)y * l + x) * 4 + c] = (uint8_t)((soma + 2) / 4);
+            }
+        }
+    }
+}
+
+#endif /* BlockCompression_h */
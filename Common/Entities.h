@@ -0,0 +1,246 @@
+//
+//  Entities.h
+//
+//  Registro das entidades do jogo (moedas, personagem e o que mais andar
+//  pelo mapa) em estrutura de arrays: cada atributo num vetor próprio, com a
+//  k-ésima entidade viva na posição k de todos eles. O desenho e a colisão
+//  percorrem só os vetores de que precisam, em ordem, em vez de pular entre
+//  structs espalhadas.
+//
+//  Quem guarda uma entidade guarda o seu Entidade (índice do slot e
+//  geração), que continua valendo enquanto ela existir, mesmo que a posição
+//  dela nos vetores mude. remover() tapa o buraco com a última entidade e
+//  incrementa a geração do slot, então um Entidade antigo deixa de ser
+//  válido em vez de apontar para quem reaproveitar o slot.
+//
+//  Posições em células (linha, coluna), como pos no ProvaGB-Tilemap; as do
+//  passo anterior ficam guardadas para o desenho interpolar. sprite é um
+//  índice na tabela de sprites de quem usa o registro.
+//
+
+#ifndef Entities_h
+#define Entities_h
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#define ENTIDADE_SEM_INDICE 0xFFFFFFFFu
+
+// Bits de flags
+enum FlagsEntidade {
+    ENTIDADE_VISIVEL = 1,
+    ENTIDADE_MOEDA = 2, // coletável
+    ENTIDADE_ATOR = 4   // anda pelo mapa e coleta moedas
+};
+
+struct Entidade {
+    uint32_t slot;
+    uint32_t geracao;
+};
+
+class RegistroEntidades {
+    // Densos, um valor por entidade viva
+    std::vector<float> linha, coluna;
+    std::vector<float> linhaAnterior, colunaAnterior;
+    std::vector<uint16_t> sprite;
+    std::vector<uint8_t> animacao, quadro, nQuadros;
+    std::vector<uint8_t> flags;
+    std::vector<uint32_t> slotDe; // posição densa -> slot
+
+    // Por slot
+    std::vector<uint32_t> indiceDe; // slot -> posição densa, ENTIDADE_SEM_INDICE se livre
+    std::vector<uint32_t> geracoes;
+    std::vector<uint32_t> livres;
+
+public:
+    Entidade criar(float linha, float coluna, int sprite, int nQuadros, uint8_t flags) {
+        uint32_t slot;
+        if (!this->livres.empty()) {
+            slot = this->livres.back();
+            this->livres.pop_back();
+        } else {
+            slot = (uint32_t)this->indiceDe.size();
+            this->indiceDe.push_back(ENTIDADE_SEM_INDICE);
+            this->geracoes.push_back(0);
+        }
+
+        this->indiceDe[slot] = (uint32_t)this->linha.size();
+        this->linha.push_back(linha);
+        this->coluna.push_back(coluna);
+        this->linhaAnterior.push_back(linha);
+        this->colunaAnterior.push_back(coluna);
+        this->sprite.push_back((uint16_t)sprite);
+        this->animacao.push_back(0);
+        this->quadro.push_back(0);
+        this->nQuadros.push_back((uint8_t)(nQuadros > 0 ? nQuadros : 1));
+        this->flags.push_back(flags);
+        this->slotDe.push_back(slot);
+
+        Entidade e = {slot, this->geracoes[slot]};
+        return e;
+    }
+
+    // false se a entidade já não existia
+    bool remover(Entidade e) {
+        int k = this->indice(e);
+        if (k < 0)
+            return false;
+
+        // A última entidade ocupa o lugar da removida
+        size_t ultimo = this->linha.size() - 1;
+        if ((size_t)k != ultimo) {
+            this->linha[k] = this->linha[ultimo];
+            this->coluna[k] = this->coluna[ultimo];
+            this->linhaAnterior[k] = this->linhaAnterior[ultimo];
+            this->colunaAnterior[k] = this->colunaAnterior[ultimo];
+            this->sprite[k] = this->sprite[ultimo];
+            this->animacao[k] = this->animacao[ultimo];
+            this->quadro[k] = this->quadro[ultimo];
+            this->nQuadros[k] = this->nQuadros[ultimo];
+            this->flags[k] = this->flags[ultimo];
+            this->slotDe[k] = this->slotDe[ultimo];
+            this->indiceDe[this->slotDe[k]] = (uint32_t)k;
+        }
+        this->linha.pop_back();
+        this->coluna.pop_back();
+        this->linhaAnterior.pop_back();
+        this->colunaAnterior.pop_back();
+        this->sprite.pop_back();
+        this->animacao.pop_back();
+        this->quadro.pop_back();
+        this->nQuadros.pop_back();
+        this->flags.pop_back();
+        this->slotDe.pop_back();
+
+        this->indiceDe[e.slot] = ENTIDADE_SEM_INDICE;
+        this->geracoes[e.slot]++;
+        this->livres.push_back(e.slot);
+        return true;
+    }
+
+    void limpar() {
+        for (size_t k = 0; k < this->slotDe.size(); k++) {
+            uint32_t slot = this->slotDe[k];
+            this->indiceDe[slot] = ENTIDADE_SEM_INDICE;
+            this->geracoes[slot]++;
+            this->livres.push_back(slot);
+        }
+        this->linha.clear();
+        this->coluna.clear();
+        this->linhaAnterior.clear();
+        this->colunaAnterior.clear();
+        this->sprite.clear();
+        this->animacao.clear();
+        this->quadro.clear();
+        this->nQuadros.clear();
+        this->flags.clear();
+        this->slotDe.clear();
+    }
+
+    void reservar(size_t n) {
+        this->linha.reserve(n);
+        this->coluna.reserve(n);
+        this->linhaAnterior.reserve(n);
+        this->colunaAnterior.reserve(n);
+        this->sprite.reserve(n);
+        this->animacao.reserve(n);
+        this->quadro.reserve(n);
+        this->nQuadros.reserve(n);
+        this->flags.reserve(n);
+        this->slotDe.reserve(n);
+    }
+
+    // Posição da entidade nos vetores densos, -1 se ela não existe mais
+    int indice(Entidade e) const {
+        if (e.slot >= this->indiceDe.size() || this->geracoes[e.slot] != e.geracao)
+            return -1;
+        return (int)this->indiceDe[e.slot];
+    }
+
+    bool valida(Entidade e) const {
+        return this->indice(e) >= 0;
+    }
+
+    // A entidade na posição densa k
+    Entidade getEntidade(size_t k) const {
+        Entidade e = {this->slotDe[k], this->geracoes[this->slotDe[k]]};
+        return e;
+    }
+
+    size_t tamanho() const {
+        return this->linha.size();
+    }
+
+    // No começo de cada passo de lógica, antes de mover alguém
+    void guardarPosicoes() {
+        if (this->linha.empty())
+            return;
+        memcpy(this->linhaAnterior.data(), this->linha.data(), this->linha.size() * sizeof(float));
+        memcpy(this->colunaAnterior.data(), this->coluna.data(), this->coluna.size() * sizeof(float));
+    }
+
+    // Quadro de cada animação no passo, a quadrosPorSegundo com a lógica a
+    // hz passos por segundo
+    void animar(long passo, double quadrosPorSegundo, int hz) {
+        int q = (int)(passo * quadrosPorSegundo / hz);
+        for (size_t k = 0; k < this->quadro.size(); k++)
+            this->quadro[k] = (uint8_t)(q % this->nQuadros[k]);
+    }
+
+    float *getLinhas() {
+        return this->linha.data();
+    }
+
+    float *getColunas() {
+        return this->coluna.data();
+    }
+
+    const float *getLinhas() const {
+        return this->linha.data();
+    }
+
+    const float *getColunas() const {
+        return this->coluna.data();
+    }
+
+    const float *getLinhasAnteriores() const {
+        return this->linhaAnterior.data();
+    }
+
+    const float *getColunasAnteriores() const {
+        return this->colunaAnterior.data();
+    }
+
+    const uint16_t *getSprites() const {
+        return this->sprite.data();
+    }
+
+    uint8_t *getAnimacoes() {
+        return this->animacao.data();
+    }
+
+    const uint8_t *getAnimacoes() const {
+        return this->animacao.data();
+    }
+
+    const uint8_t *getQuadros() const {
+        return this->quadro.data();
+    }
+
+    uint8_t *getFlags() {
+        return this->flags.data();
+    }
+
+    const uint8_t *getFlags() const {
+        return this->flags.data();
+    }
+
+    size_t getMemoryBytes() const {
+        size_t porEntidade = 4 * sizeof(float) + sizeof(uint16_t) + 4 * sizeof(uint8_t) + sizeof(uint32_t);
+        return this->linha.capacity() * porEntidade + this->indiceDe.capacity() * 2 * sizeof(uint32_t) +
+               this->livres.capacity() * sizeof(uint32_t);
+    }
+};
+
+#endif /* Entities_h */
@@ -0,0 +1,372 @@
+//
+//  FlowField.h
+//
+//  Campo de fluxo até a moeda mais próxima: para cada casa da MapGrid, a
+//  distância (em custo de caminho) até a moeda mais perto e a direção do
+//  primeiro passo rumo a ela. Um mapa de Dijkstra só serve a quantos
+//  coletores houver, em vez de um A* por agente: cada um só lê a direção da
+//  casa em que está.
+//
+//  Movimentos e custos como em Pathfinding.h: 8 direções, custos[tile] para
+//  entrar na casa, diagonal sqrt(2) vezes mais cara, < 0 intransponível. A
+//  lava pode ser intransponível ou só cara, conforme a tabela passada.
+//
+//  calcular() monta o campo inteiro de um de dois modos:
+//    CAMPO_DIJKSTRA  Dijkstra com todas as moedas como origem;
+//    CAMPO_VARREDURA varreduras alternadas de cima para baixo e de baixo
+//                    para cima, linha a linha, até nada mudar. Cada linha
+//                    primeiro recebe as três casas vizinhas da linha
+//                    anterior, um laço sem dependência entre colunas feito
+//                    com SSE (4 casas por vez) quando disponível, e depois
+//                    é varrida nos dois sentidos. Com poucos obstáculos
+//                    converge em poucas varreduras e percorre a memória em
+//                    ordem.
+//  Os dois dão as mesmas distâncias.
+//
+//  removerMoeda() atualiza o campo só onde a moeda removida era a mais
+//  próxima: as casas cuja direção leva até ela são invalidadas e
+//  recalculadas por um Dijkstra que parte das casas válidas em volta.
+//
+
+#ifndef FlowField_h
+#define FlowField_h
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CAMPO_SSE 1
+#endif
+
+#include "MapData.h"
+#include "Pathfinding.h"
+
+#define DISTANCIA_INFINITA 1e30f
+
+enum ModoCampo {
+    CAMPO_DIJKSTRA = 0,
+    CAMPO_VARREDURA
+};
+
+class CampoFluxo {
+    struct NoAberto {
+        float d;
+        int32_t casa;
+        bool operator>(const NoAberto &outro) const {
+            return this->d > outro.d;
+        }
+    };
+
+    int largura, altura;
+    std::vector<float> custoCasa;  // custos[tile], < 0 intransponível
+    std::vector<float> distancia;  // DISTANCIA_INFINITA onde não há caminho
+    std::vector<int8_t> direcao;   // 0..7 (ordem de Pathfinder), -1 na moeda ou sem caminho
+    std::vector<NoAberto> heap;
+    std::vector<uint8_t> invalida; // rascunho de removerMoeda()
+    std::vector<int32_t> fila;
+    int varreduras;                // do último CAMPO_VARREDURA
+
+    static constexpr int DL[8] = {-1, 1, 0, 0, -1, -1, 1, 1};
+    static constexpr int DC[8] = {0, 0, -1, 1, -1, 1, -1, 1};
+    static constexpr int OPOSTA[8] = {1, 0, 3, 2, 7, 6, 5, 4};
+
+public:
+    CampoFluxo() {
+        this->largura = this->altura = 0;
+        this->varreduras = 0;
+    }
+
+    // Campo das moedas (ITEM_MOEDA) da grade
+    void calcular(const MapGrid &grade, const float custos[256], ModoCampo modo = CAMPO_DIJKSTRA) {
+        this->largura = grade.getWidth();
+        this->altura = grade.getHeight();
+        size_t n = (size_t)this->largura * this->altura;
+        this->custoCasa.resize(n);
+        this->distancia.assign(n, DISTANCIA_INFINITA);
+        this->direcao.assign(n, -1);
+        this->invalida.assign(n, 0);
+
+        this->heap.clear();
+        for (int l = 0; l < this->altura; l++) {
+            const CelulaMapa *linha = grade.getLinha(l);
+            for (int c = 0; c < this->largura; c++) {
+                int i = l * this->largura + c;
+                this->custoCasa[i] = custos[linha[c].tile];
+                if (linha[c].item == ITEM_MOEDA && this->custoCasa[i] >= 0.0f) {
+                    this->distancia[i] = 0.0f;
+                    NoAberto a = {0.0f, i};
+                    this->heap.push_back(a);
+                }
+            }
+        }
+
+        if (modo == CAMPO_VARREDURA) {
+            this->heap.clear();
+            this->varrer();
+            this->calcularDirecoes();
+        } else {
+            std::make_heap(this->heap.begin(), this->heap.end(), std::greater<NoAberto>());
+            this->dijkstra(NULL);
+        }
+    }
+
+    // A moeda em (linha, coluna) foi coletada. Devolve quantas casas foram
+    // recalculadas
+    int removerMoeda(int linha, int coluna) {
+        if (linha < 0 || coluna < 0 || linha >= this->altura || coluna >= this->largura)
+            return 0;
+        int origem = linha * this->largura + coluna;
+        if (this->distancia[origem] != 0.0f)
+            return 0;
+
+        // Casas cujo caminho passa pela moeda: a árvore de direções abaixo dela
+        this->fila.clear();
+        this->fila.push_back(origem);
+        this->invalida[origem] = 1;
+        for (size_t k = 0; k < this->fila.size(); k++) {
+            int i = this->fila[k];
+            int l = i / this->largura, c = i % this->largura;
+            for (int d = 0; d < 8; d++) {
+                int nl = l + DL[d], nc = c + DC[d];
+                if (nl < 0 || nc < 0 || nl >= this->altura || nc >= this->largura)
+                    continue;
+                int v = nl * this->largura + nc;
+                if (!this->invalida[v] && this->direcao[v] == OPOSTA[d]) {
+                    this->invalida[v] = 1;
+                    this->fila.push_back(v);
+                }
+            }
+        }
+        for (size_t k = 0; k < this->fila.size(); k++) {
+            this->distancia[this->fila[k]] = DISTANCIA_INFINITA;
+            this->direcao[this->fila[k]] = -1;
+        }
+
+        // Cada casa invalidada começa pelo melhor vizinho que continua válido
+        this->heap.clear();
+        for (size_t k = 0; k < this->fila.size(); k++) {
+            int i = this->fila[k];
+            if (this->custoCasa[i] < 0.0f)
+                continue;
+            int l = i / this->largura, c = i % this->largura;
+            for (int d = 0; d < 8; d++) {
+                int nl = l + DL[d], nc = c + DC[d];
+                if (nl < 0 || nc < 0 || nl >= this->altura || nc >= this->largura)
+                    continue;
+                int u = nl * this->largura + nc;
+                if (this->invalida[u] || this->distancia[u] >= DISTANCIA_INFINITA)
+                    continue;
+                float dv = this->distancia[u] + this->custoCasa[u] * (d < 4 ? 1.0f : CUSTO_DIAGONAL);
+                if (dv < this->distancia[i]) {
+                    this->distancia[i] = dv;
+                    this->direcao[i] = (int8_t)d;
+                }
+            }
+            if (this->distancia[i] < DISTANCIA_INFINITA) {
+                NoAberto a = {this->distancia[i], i};
+                this->heap.push_back(a);
+            }
+        }
+        std::make_heap(this->heap.begin(), this->heap.end(), std::greater<NoAberto>());
+        this->dijkstra(&this->invalida);
+
+        for (size_t k = 0; k < this->fila.size(); k++)
+            this->invalida[this->fila[k]] = 0;
+        return (int)this->fila.size();
+    }
+
+    float getDistancia(int linha, int coluna) const {
+        return this->distancia[(size_t)linha * this->largura + coluna];
+    }
+
+    // Direção do passo rumo à moeda mais próxima (índice em DL/DC de
+    // Pathfinder), -1 numa moeda ou sem caminho
+    int getDirecao(int linha, int coluna) const {
+        return this->direcao[(size_t)linha * this->largura + coluna];
+    }
+
+    // A casa seguinte rumo à moeda; false se não há para onde ir
+    bool proximaCasa(PontoGrade casa, PontoGrade &proxima) const {
+        int d = this->getDirecao(casa.linha, casa.coluna);
+        if (d < 0)
+            return false;
+        proxima.linha = casa.linha + DL[d];
+        proxima.coluna = casa.coluna + DC[d];
+        return true;
+    }
+
+    int getVarreduras() const {
+        return this->varreduras;
+    }
+
+private:
+    // Dijkstra a partir do heap. Com somente, só as casas marcadas nele
+    // podem mudar
+    void dijkstra(const std::vector<uint8_t> *somente) {
+        while (!this->heap.empty()) {
+            std::pop_heap(this->heap.begin(), this->heap.end(), std::greater<NoAberto>());
+            NoAberto a = this->heap.back();
+            this->heap.pop_back();
+            int u = a.casa;
+            if (a.d > this->distancia[u])
+                continue;
+
+            // Andar de v para u custa entrar em u
+            int l = u / this->largura, c = u % this->largura;
+            float custo = this->custoCasa[u];
+            for (int d = 0; d < 8; d++) {
+                int nl = l + DL[d], nc = c + DC[d];
+                if (nl < 0 || nc < 0 || nl >= this->altura || nc >= this->largura)
+                    continue;
+                int v = nl * this->largura + nc;
+                if (this->custoCasa[v] < 0.0f || (somente && !(*somente)[v]))
+                    continue;
+                float dv = a.d + custo * (d < 4 ? 1.0f : CUSTO_DIAGONAL);
+                if (dv < this->distancia[v]) {
+                    this->distancia[v] = dv;
+                    this->direcao[v] = (int8_t)OPOSTA[d];
+                    NoAberto b = {dv, v};
+                    this->heap.push_back(b);
+                    std::push_heap(this->heap.begin(), this->heap.end(), std::greater<NoAberto>());
+                }
+            }
+        }
+    }
+
+    // Traz para a linha dist (bloqueio = DISTANCIA_INFINITA nas casas
+    // intransponíveis, 0 nas outras) o caminho pelas três casas da linha
+    // vizinha. true se alguma casa melhorou
+    bool relaxarLinha(float *dist, const float *bloqueio, const float *distViz, const float *custoViz) const {
+        int w = this->largura;
+        bool mudou = false;
+        int c = 0;
+        if (w >= 3) {
+            // Na primeira e na última coluna falta um dos vizinhos diagonais
+            c = 1;
+#ifdef CAMPO_SSE
+            const __m128 diagonal = _mm_set1_ps(CUSTO_DIAGONAL);
+            for (; c + 4 <= w - 1; c += 4) {
+                __m128 reta = _mm_add_ps(_mm_loadu_ps(distViz + c), _mm_loadu_ps(custoViz + c));
+                __m128 esq = _mm_add_ps(_mm_loadu_ps(distViz + c - 1), _mm_mul_ps(_mm_loadu_ps(custoViz + c - 1), diagonal));
+                __m128 dir = _mm_add_ps(_mm_loadu_ps(distViz + c + 1), _mm_mul_ps(_mm_loadu_ps(custoViz + c + 1), diagonal));
+                __m128 cand = _mm_add_ps(_mm_min_ps(reta, _mm_min_ps(esq, dir)), _mm_loadu_ps(bloqueio + c));
+                __m128 atual = _mm_loadu_ps(dist + c);
+                if (_mm_movemask_ps(_mm_cmplt_ps(cand, atual))) {
+                    _mm_storeu_ps(dist + c, _mm_min_ps(cand, atual));
+                    mudou = true;
+                }
+            }
+#endif
+            for (; c < w - 1; c++) {
+                float cand = std::min(distViz[c] + custoViz[c],
+                                      std::min(distViz[c - 1] + custoViz[c - 1] * CUSTO_DIAGONAL,
+                                               distViz[c + 1] + custoViz[c + 1] * CUSTO_DIAGONAL)) +
+                             bloqueio[c];
+                if (cand < dist[c]) {
+                    dist[c] = cand;
+                    mudou = true;
+                }
+            }
+        }
+
+        // As duas pontas
+        int pontas[2] = {0, w - 1};
+        for (int k = 0; k < (w > 1 ? 2 : 1); k++) {
+            int p = pontas[k];
+            float cand = distViz[p] + custoViz[p];
+            if (p > 0)
+                cand = std::min(cand, distViz[p - 1] + custoViz[p - 1] * CUSTO_DIAGONAL);
+            if (p < w - 1)
+                cand = std::min(cand, distViz[p + 1] + custoViz[p + 1] * CUSTO_DIAGONAL);
+            cand += bloqueio[p];
+            if (cand < dist[p]) {
+                dist[p] = cand;
+                mudou = true;
+            }
+        }
+        return mudou;
+    }
+
+    // Varre a linha para a direita e para a esquerda (vizinhos na mesma linha)
+    bool varrerLinha(float *dist, const float *bloqueio, const float *custo) const {
+        bool mudou = false;
+        for (int c = 1; c < this->largura; c++) {
+            float cand = dist[c - 1] + custo[c - 1] + bloqueio[c];
+            if (cand < dist[c]) {
+                dist[c] = cand;
+                mudou = true;
+            }
+        }
+        for (int c = this->largura - 2; c >= 0; c--) {
+            float cand = dist[c + 1] + custo[c + 1] + bloqueio[c];
+            if (cand < dist[c]) {
+                dist[c] = cand;
+                mudou = true;
+            }
+        }
+        return mudou;
+    }
+
+    void varrer() {
+        // Custo 0 e bloqueio infinito nas casas intransponíveis: a distância
+        // delas fica infinita e não melhora nenhuma vizinha
+        size_t n = this->custoCasa.size();
+        std::vector<float> custo(n), bloqueio(n);
+        for (size_t i = 0; i < n; i++) {
+            bool passavel = this->custoCasa[i] >= 0.0f;
+            custo[i] = passavel ? this->custoCasa[i] : 0.0f;
+            bloqueio[i] = passavel ? 0.0f : DISTANCIA_INFINITA;
+        }
+
+        int w = this->largura;
+        float *d = this->distancia.data();
+        this->varreduras = 0;
+        for (bool mudou = true; mudou;) {
+            mudou = false;
+            for (int l = 0; l < this->altura; l++) {
+                float *linha = d + (size_t)l * w;
+                if (l > 0)
+                    mudou |= this->relaxarLinha(linha, &bloqueio[(size_t)l * w], linha - w, &custo[(size_t)(l - 1) * w]);
+                mudou |= this->varrerLinha(linha, &bloqueio[(size_t)l * w], &custo[(size_t)l * w]);
+            }
+            for (int l = this->altura - 1; l >= 0; l--) {
+                float *linha = d + (size_t)l * w;
+                if (l < this->altura - 1)
+                    mudou |= this->relaxarLinha(linha, &bloqueio[(size_t)l * w], linha + w, &custo[(size_t)(l + 1) * w]);
+                mudou |= this->varrerLinha(linha, &bloqueio[(size_t)l * w], &custo[(size_t)l * w]);
+            }
+            this->varreduras++;
+        }
+    }
+
+    // Direção de cada casa: o vizinho pelo qual a distância dela é obtida
+    void calcularDirecoes() {
+        for (int l = 0; l < this->altura; l++) {
+            for (int c = 0; c < this->largura; c++) {
+                int i = l * this->largura + c;
+                float melhor = this->distancia[i];
+                if (melhor <= 0.0f || melhor >= DISTANCIA_INFINITA)
+                    continue;
+                float menor = DISTANCIA_INFINITA;
+                for (int d = 0; d < 8; d++) {
+                    int nl = l + DL[d], nc = c + DC[d];
+                    if (nl < 0 || nc < 0 || nl >= this->altura || nc >= this->largura)
+                        continue;
+                    int u = nl * this->largura + nc;
+                    if (this->custoCasa[u] < 0.0f || this->distancia[u] >= DISTANCIA_INFINITA)
+                        continue;
+                    float dv = this->distancia[u] + this->custoCasa[u] * (d < 4 ? 1.0f : CUSTO_DIAGONAL);
+                    if (dv < menor) {
+                        menor = dv;
+                        this->direcao[i] = (int8_t)d;
+                    }
+                }
+            }
+        }
+    }
+};
+
+#endif /* FlowField_h */
@@ -0,0 +1,129 @@
+//
+//  GameLoop.h
+//
+//  Laço de jogo com a lógica em passo fixo, separada do desenho. PassoFixo
+//  conta quantos passos de 1/hz segundos venceram desde o início e devolve
+//  a cada frame quantos faltam rodar: com o desenho mais rápido que a
+//  lógica a maioria dos frames não roda passo nenhum; com o desenho lento
+//  um frame roda vários, e o jogo não fica mais lento. A contagem é feita
+//  em passos inteiros (e não somando dt) para dar o mesmo resultado com o
+//  mesmo relógio, como o relógio fixo do modo headless.
+//
+//  alfa() é a fração do passo seguinte já decorrida, para o desenho
+//  interpolar entre o estado do passo anterior e o do atual.
+//
+//  LimitadorFrames segura o fim do frame até completar 1/fps segundos
+//  (--fps-max), dormindo a maior parte da espera em vez de girar a CPU.
+//
+
+#ifndef GameLoop_h
+#define GameLoop_h
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#define HZ_LOGICA 60.0
+
+class PassoFixo {
+    double hz;
+    int maxPassos;    // passos por frame antes de descartar o atraso
+    double origem;    // tempo do passo 0
+    long passos;      // passos já rodados
+    double agora;
+    bool iniciado;
+
+public:
+    PassoFixo(double hz = HZ_LOGICA, int maxPassos = 8) {
+        this->hz = hz;
+        this->maxPassos = maxPassos;
+        this->origem = this->agora = 0.0;
+        this->passos = 0;
+        this->iniciado = false;
+    }
+
+    // Quantos passos de lógica rodar neste frame, com agora em segundos. O
+    // primeiro chamado só marca a origem. Um atraso de mais de maxPassos
+    // (janela arrastada, carga de disco) é descartado: a lógica continua de
+    // onde estava em vez de rodar todos os passos perdidos de uma vez
+    int avancar(double agora) {
+        this->agora = agora;
+        if (!this->iniciado) {
+            this->origem = agora;
+            this->iniciado = true;
+            return 0;
+        }
+
+        // A folga absorve o arredondamento de k / hz * hz
+        long devidos = (long)floor((agora - this->origem) * this->hz + 1e-6);
+        long n = devidos - this->passos;
+        if (n > this->maxPassos) {
+            this->origem += (double)(n - this->maxPassos) / this->hz;
+            n = this->maxPassos;
+        }
+        if (n < 0)
+            n = 0;
+        this->passos += n;
+        return (int)n;
+    }
+
+    // Fração (0 a 1) do próximo passo decorrida no último avancar()
+    float alfa() const {
+        double a = (this->agora - this->origem) * this->hz - this->passos;
+        return (float)(a < 0.0 ? 0.0 : (a > 1.0 ? 1.0 : a));
+    }
+
+    long getPassos() const {
+        return this->passos;
+    }
+
+    double getHz() const {
+        return this->hz;
+    }
+};
+
+class LimitadorFrames {
+    typedef std::chrono::steady_clock Relogio;
+
+    double fps;
+    Relogio::time_point proximo;
+    bool iniciado;
+
+public:
+    // fps <= 0: sem limite
+    LimitadorFrames(double fps = 0.0) {
+        this->fps = fps;
+        this->iniciado = false;
+    }
+
+    bool estaAtivo() const {
+        return this->fps > 0.0;
+    }
+
+    // Chamado uma vez por frame, depois do swap
+    void esperar() {
+        if (this->fps <= 0.0)
+            return;
+
+        Relogio::duration periodo = std::chrono::duration_cast<Relogio::duration>(std::chrono::duration<double>(1.0 / this->fps));
+        Relogio::time_point agora = Relogio::now();
+        if (!this->iniciado) {
+            this->proximo = agora + periodo;
+            this->iniciado = true;
+            return;
+        }
+
+        // Dorme até 1 ms antes (a resolução do sleep) e gira o resto
+        if (this->proximo - agora > std::chrono::milliseconds(1))
+            std::this_thread::sleep_until(this->proximo - std::chrono::milliseconds(1));
+        while (Relogio::now() < this->proximo)
+            std::this_thread::yield();
+
+        // Um frame que já passou do prazo não acumula crédito para os seguintes
+        this->proximo += periodo;
+        if (this->proximo < Relogio::now())
+            this->proximo = Relogio::now() + periodo;
+    }
+};
+
+#endif /* GameLoop_h */
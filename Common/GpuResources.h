@@ -0,0 +1,386 @@
+//
+//  GpuResources.h
+//
+//  Cache dos objetos GL do jogo (VBOs, VAOs e texturas), com a contagem de
+//  referências de cada um e a memória de vídeo que ocupam por tipo.
+//
+//  geometria() recebe os vértices e o formato deles (FormatoVertices) e
+//  devolve um VAO com o VBO já ligado; se já existe uma geometria com o
+//  mesmo formato e os mesmos bytes, devolve a mesma e só soma uma
+//  referência. Assim os três tipos de tile, que usam o mesmo losango, ficam
+//  com um VAO só. Os outros objetos (buffers de instâncias, VAOs próprios,
+//  texturas) entram por criarBuffer(), criarVAO() ou adotar() e não são
+//  deduplicados, só contados.
+//
+//  Quem recebe um RecursoGPU (slot e geração, como Entidade em
+//  Common/Entities.h) devolve com liberar(); o objeto GL é apagado quando a
+//  última referência sai. liberarTudo(), no fim do programa, apaga o que
+//  sobrou e diz quantos ainda tinham dono.
+//
+//  Os bytes de cada recurso são os que a GL recebeu (glBufferData,
+//  glTexImage*); quem muda o tamanho de um buffer avisa com setBytes(). É
+//  uma estimativa: o driver pode alinhar ou guardar cópias.
+//
+
+#ifndef GpuResources_h
+#define GpuResources_h
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <glad/glad.h>
+
+#define MAX_ATRIBUTOS_FORMATO 8
+#define RECURSO_SEM_SLOT 0xFFFFFFFFu
+
+enum TipoRecursoGPU {
+    RECURSO_GEOMETRIA = 0, // VBO de vértices estáticos e o VAO dele
+    RECURSO_BUFFER,        // instâncias, comandos indiretos e outros buffers
+    RECURSO_VAO,           // VAOs criados à parte
+    RECURSO_TEXTURA,
+    NUM_TIPOS_RECURSO
+};
+
+struct RecursoGPU {
+    uint32_t slot;
+    uint32_t geracao;
+};
+
+inline RecursoGPU recursoNulo() {
+    RecursoGPU r = {RECURSO_SEM_SLOT, 0};
+    return r;
+}
+
+struct AtributoVertice {
+    GLuint local;
+    GLint componentes;
+    GLenum tipo;
+    GLboolean normalizado;
+    size_t deslocamento;
+};
+
+// Atributos intercalados num só VBO, na ordem em que foram adicionados
+struct FormatoVertices {
+    int nAtributos;
+    AtributoVertice atributos[MAX_ATRIBUTOS_FORMATO];
+    GLsizei stride;
+
+    FormatoVertices() {
+        this->nAtributos = 0;
+        this->stride = 0;
+        memset(this->atributos, 0, sizeof(this->atributos));
+    }
+
+    // false se já há MAX_ATRIBUTOS_FORMATO atributos ou o tipo não é conhecido
+    bool adicionar(GLuint local, GLint componentes, GLenum tipo = GL_FLOAT, GLboolean normalizado = GL_FALSE) {
+        size_t tamanho = tamanhoTipo(tipo);
+        if (this->nAtributos >= MAX_ATRIBUTOS_FORMATO || tamanho == 0)
+            return false;
+        AtributoVertice &a = this->atributos[this->nAtributos++];
+        a.local = local;
+        a.componentes = componentes;
+        a.tipo = tipo;
+        a.normalizado = normalizado;
+        a.deslocamento = (size_t)this->stride;
+        this->stride += (GLsizei)(componentes * tamanho);
+        return true;
+    }
+
+    bool operator==(const FormatoVertices &outro) const {
+        if (this->nAtributos != outro.nAtributos || this->stride != outro.stride)
+            return false;
+        for (int k = 0; k < this->nAtributos; k++) {
+            const AtributoVertice &a = this->atributos[k], &b = outro.atributos[k];
+            if (a.local != b.local || a.componentes != b.componentes || a.tipo != b.tipo ||
+                a.normalizado != b.normalizado || a.deslocamento != b.deslocamento)
+                return false;
+        }
+        return true;
+    }
+
+    static size_t tamanhoTipo(GLenum tipo) {
+        switch (tipo) {
+        case GL_FLOAT:
+        case GL_INT:
+        case GL_UNSIGNED_INT:
+            return 4;
+        case GL_HALF_FLOAT:
+        case GL_SHORT:
+        case GL_UNSIGNED_SHORT:
+            return 2;
+        case GL_BYTE:
+        case GL_UNSIGNED_BYTE:
+            return 1;
+        default:
+            return 0;
+        }
+    }
+};
+
+// Recursos vivos de um tipo
+struct UsoRecursosGPU {
+    long quantidade;
+    size_t bytes;
+    long reaproveitados; // geometria(): pedidos atendidos por uma que já existia
+};
+
+class RecursosGPU {
+    struct Entrada {
+        TipoRecursoGPU tipo;
+        GLuint nome;   // VBO, buffer, VAO ou textura
+        GLuint VAO;    // só em RECURSO_GEOMETRIA
+        size_t bytes;
+        int referencias;
+        GLsizei nVertices;
+        uint64_t hash; // do formato e dos vértices, para achar geometrias iguais
+        FormatoVertices formato;
+        std::vector<unsigned char> vertices;
+    };
+
+    std::vector<Entrada> entradas; // por slot
+    std::vector<uint32_t> geracoes;
+    std::vector<uint32_t> livres;
+    UsoRecursosGPU uso[NUM_TIPOS_RECURSO];
+
+public:
+    RecursosGPU() {
+        memset(this->uso, 0, sizeof(this->uso));
+    }
+
+    // VAO + VBO com os vértices no formato dado. Chamar com o contexto GL
+    // corrente; o VAO e o VBO ficam desvinculados na volta
+    RecursoGPU geometria(const FormatoVertices &formato, const void *vertices, size_t bytes, GLsizei nVertices) {
+        uint64_t h = hashGeometria(formato, vertices, bytes);
+        for (size_t s = 0; s < this->entradas.size(); s++) {
+            Entrada &e = this->entradas[s];
+            if (e.referencias > 0 && e.tipo == RECURSO_GEOMETRIA && e.hash == h && e.bytes == bytes &&
+                e.nVertices == nVertices && e.formato == formato && memcmp(e.vertices.data(), vertices, bytes) == 0) {
+                e.referencias++;
+                this->uso[RECURSO_GEOMETRIA].reaproveitados++;
+                RecursoGPU r = {(uint32_t)s, this->geracoes[s]};
+                return r;
+            }
+        }
+
+        GLuint VBO, VAO;
+        glGenBuffers(1, &VBO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)bytes, vertices, GL_STATIC_DRAW);
+
+        glGenVertexArrays(1, &VAO);
+        glBindVertexArray(VAO);
+        for (int k = 0; k < formato.nAtributos; k++) {
+            const AtributoVertice &a = formato.atributos[k];
+            glVertexAttribPointer(a.local, a.componentes, a.tipo, a.normalizado, formato.stride,
+                                  (GLvoid *)a.deslocamento);
+            glEnableVertexAttribArray(a.local);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+
+        RecursoGPU r = this->novaEntrada(RECURSO_GEOMETRIA, VBO, bytes);
+        Entrada &e = this->entradas[r.slot];
+        e.VAO = VAO;
+        e.nVertices = nVertices;
+        e.hash = h;
+        e.formato = formato;
+        e.vertices.assign((const unsigned char *)vertices, (const unsigned char *)vertices + bytes);
+        return r;
+    }
+
+    // Buffer vazio (glGenBuffers); os dados e o tamanho ficam com quem chama
+    RecursoGPU criarBuffer() {
+        GLuint nome;
+        glGenBuffers(1, &nome);
+        return this->novaEntrada(RECURSO_BUFFER, nome, 0);
+    }
+
+    RecursoGPU criarVAO() {
+        GLuint nome;
+        glGenVertexArrays(1, &nome);
+        return this->novaEntrada(RECURSO_VAO, nome, 0);
+    }
+
+    // Passa para o cache um objeto criado fora dele (por exemplo a textura
+    // de um atlas), que passa a ser apagado por liberar()/liberarTudo()
+    RecursoGPU adotar(TipoRecursoGPU tipo, GLuint nome, size_t bytes) {
+        return this->novaEntrada(tipo, nome, bytes);
+    }
+
+    // Mais um dono para o mesmo recurso
+    RecursoGPU compartilhar(RecursoGPU r) {
+        if (this->valido(r))
+            this->entradas[r.slot].referencias++;
+        return r;
+    }
+
+    // Devolve uma referência e anula r; false se r já não valia
+    bool liberar(RecursoGPU &r) {
+        if (!this->valido(r)) {
+            r = recursoNulo();
+            return false;
+        }
+        Entrada &e = this->entradas[r.slot];
+        if (--e.referencias == 0)
+            this->apagar(r.slot);
+        r = recursoNulo();
+        return true;
+    }
+
+    // Apaga todos os objetos ainda vivos. Devolve quantos não tinham sido
+    // liberados pelos donos
+    int liberarTudo() {
+        int vivos = 0;
+        for (size_t s = 0; s < this->entradas.size(); s++) {
+            if (this->entradas[s].referencias <= 0)
+                continue;
+            vivos++;
+            this->apagar((uint32_t)s);
+        }
+        return vivos;
+    }
+
+    // Tamanho atual de um buffer ou textura, depois de um glBufferData ou
+    // glTexImage* feito por quem chama
+    void setBytes(RecursoGPU r, size_t bytes) {
+        if (!this->valido(r))
+            return;
+        Entrada &e = this->entradas[r.slot];
+        this->uso[e.tipo].bytes = this->uso[e.tipo].bytes - e.bytes + bytes;
+        e.bytes = bytes;
+    }
+
+    bool valido(RecursoGPU r) const {
+        return r.slot < this->entradas.size() && this->geracoes[r.slot] == r.geracao &&
+               this->entradas[r.slot].referencias > 0;
+    }
+
+    // Nome GL do buffer, VAO ou textura; o VBO numa geometria
+    GLuint getNome(RecursoGPU r) const {
+        return this->valido(r) ? this->entradas[r.slot].nome : 0;
+    }
+
+    // VAO de uma geometria, ou o próprio nome de um RECURSO_VAO
+    GLuint getVAO(RecursoGPU r) const {
+        if (!this->valido(r))
+            return 0;
+        const Entrada &e = this->entradas[r.slot];
+        return e.tipo == RECURSO_GEOMETRIA ? e.VAO : (e.tipo == RECURSO_VAO ? e.nome : 0);
+    }
+
+    GLsizei getNumVertices(RecursoGPU r) const {
+        return this->valido(r) ? this->entradas[r.slot].nVertices : 0;
+    }
+
+    int getReferencias(RecursoGPU r) const {
+        return this->valido(r) ? this->entradas[r.slot].referencias : 0;
+    }
+
+    const UsoRecursosGPU &getUso(TipoRecursoGPU tipo) const {
+        return this->uso[tipo];
+    }
+
+    size_t getBytesTotal() const {
+        size_t total = 0;
+        for (int t = 0; t < NUM_TIPOS_RECURSO; t++)
+            total += this->uso[t].bytes;
+        return total;
+    }
+
+    static const char *nomeTipo(TipoRecursoGPU tipo) {
+        switch (tipo) {
+        case RECURSO_GEOMETRIA:
+            return "geometria";
+        case RECURSO_BUFFER:
+            return "buffers";
+        case RECURSO_VAO:
+            return "VAOs";
+        case RECURSO_TEXTURA:
+            return "texturas";
+        default:
+            return "?";
+        }
+    }
+
+private:
+    RecursoGPU novaEntrada(TipoRecursoGPU tipo, GLuint nome, size_t bytes) {
+        uint32_t slot;
+        if (!this->livres.empty()) {
+            slot = this->livres.back();
+            this->livres.pop_back();
+        } else {
+            slot = (uint32_t)this->entradas.size();
+            this->entradas.push_back(Entrada());
+            this->geracoes.push_back(0);
+        }
+
+        Entrada &e = this->entradas[slot];
+        e.tipo = tipo;
+        e.nome = nome;
+        e.VAO = 0;
+        e.bytes = bytes;
+        e.referencias = 1;
+        e.nVertices = 0;
+        e.hash = 0;
+        e.formato = FormatoVertices();
+        e.vertices.clear();
+
+        this->uso[tipo].quantidade++;
+        this->uso[tipo].bytes += bytes;
+        RecursoGPU r = {slot, this->geracoes[slot]};
+        return r;
+    }
+
+    void apagar(uint32_t slot) {
+        Entrada &e = this->entradas[slot];
+        switch (e.tipo) {
+        case RECURSO_GEOMETRIA:
+            glDeleteVertexArrays(1, &e.VAO);
+            glDeleteBuffers(1, &e.nome);
+            break;
+        case RECURSO_BUFFER:
+            glDeleteBuffers(1, &e.nome);
+            break;
+        case RECURSO_VAO:
+            glDeleteVertexArrays(1, &e.nome);
+            break;
+        case RECURSO_TEXTURA:
+            glDeleteTextures(1, &e.nome);
+            break;
+        default:
+            break;
+        }
+        this->uso[e.tipo].quantidade--;
+        this->uso[e.tipo].bytes -= e.bytes;
+
+        e.referencias = 0;
+        e.nome = e.VAO = 0;
+        e.bytes = 0;
+        std::vector<unsigned char>().swap(e.vertices);
+        this->geracoes[slot]++;
+        this->livres.push_back(slot);
+    }
+
+    // FNV-1a do formato e dos bytes dos vértices
+    static uint64_t hashGeometria(const FormatoVertices &formato, const void *vertices, size_t bytes) {
+        uint64_t h = 14695981039346656037ull;
+        const unsigned char *p = (const unsigned char *)vertices;
+        for (size_t k = 0; k < bytes; k++) {
+            h ^= p[k];
+            h *= 1099511628211ull;
+        }
+        for (int k = 0; k < formato.nAtributos; k++) {
+            const AtributoVertice &a = formato.atributos[k];
+            uint64_t campos[4] = {a.local, (uint64_t)a.componentes, a.tipo, a.deslocamento};
+            for (int c = 0; c < 4; c++) {
+                h ^= campos[c];
+                h *= 1099511628211ull;
+            }
+        }
+        return h;
+    }
+};
+
+#endif /* GpuResources_h */
@@ -0,0 +1,295 @@
+//
+//  Headless.h
+//
+//  Modo --headless dos executáveis, para rodar o desenho em máquinas de CI
+//  sem monitor nem GPU. A janela da GLFW é criada invisível; sem servidor
+//  gráfico (Linux sem DISPLAY/WAYLAND_DISPLAY) a GLFW 3.4 usa a plataforma
+//  nula com contexto OSMesa, que roda no rasterizador de software.
+//
+//  O programa desenha N frames num framebuffer próprio (CapturaHeadless), com
+//  o relógio da GLFW fixo em 60 Hz para as animações não dependerem da
+//  velocidade da máquina. A leitura de cada frame vai para um de dois pixel
+//  buffers (PBO) e só é mapeada no frame seguinte, quando a cópia já
+//  terminou; o último é lido ao final e comparado com a imagem de
+//  referência (golden) em PNG.
+//
+//  Usa stbi_load e stbi_write_png: quem inclui este arquivo precisa ter as
+//  implementações da stb_image e da stb_image_write em algum .cpp
+//  (STB_IMAGE_IMPLEMENTATION, STB_IMAGE_WRITE_IMPLEMENTATION).
+//
+
+#ifndef Headless_h
+#define Headless_h
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <stb_image.h>
+#include <stb_image_write.h>
+
+#define FRAMES_HEADLESS 60
+#define HZ_HEADLESS 60.0
+
+// Opções de linha de comando do modo headless
+struct OpcoesHeadless {
+    bool ativo;
+    int frames;           // --headless=N
+    std::string golden;   // --golden=arquivo.png
+    bool atualizarGolden; // --atualizar-golden: regrava a referência
+    int tolerancia;       // --tolerancia=N: diferença máxima por canal (0-255)
+    double maxDiferentes; // fração de pixels fora da tolerância aceita
+
+    OpcoesHeadless() {
+        this->ativo = false;
+        this->frames = FRAMES_HEADLESS;
+        this->atualizarGolden = false;
+        // Rasterizadores diferentes não arredondam igual nas bordas dos
+        // triângulos e na mistura de cores
+        this->tolerancia = 8;
+        this->maxDiferentes = 0.001;
+    }
+
+    // Reconhece um argumento do modo headless; devolve false se não é um deles
+    bool ler(const char *arg) {
+        if (strcmp(arg, "--headless") == 0) {
+            this->ativo = true;
+        } else if (strncmp(arg, "--headless=", 11) == 0) {
+            this->ativo = true;
+            this->frames = std::max(1, atoi(arg + 11));
+        } else if (strncmp(arg, "--golden=", 9) == 0) {
+            this->golden = arg + 9;
+        } else if (strcmp(arg, "--atualizar-golden") == 0) {
+            this->atualizarGolden = true;
+        } else if (strncmp(arg, "--tolerancia=", 13) == 0) {
+            this->tolerancia = atoi(arg + 13);
+        } else {
+            return false;
+        }
+        return true;
+    }
+};
+
+// Substitui o glfwInit(). Fora do modo headless só inicializa a GLFW; nele
+// também deixa pedida a janela invisível
+inline bool iniciarGlfw(const OpcoesHeadless &opcoes) {
+    if (!opcoes.ativo)
+        return glfwInit() == GLFW_TRUE;
+
+    bool semTela = false;
+#if defined(GLFW_PLATFORM_NULL) && defined(GLFW_OSMESA_CONTEXT_API) && defined(__linux__)
+    semTela = getenv("DISPLAY") == NULL && getenv("WAYLAND_DISPLAY") == NULL;
+    if (semTela)
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
+    if (!glfwInit())
+        return false;
+
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#if defined(GLFW_PLATFORM_NULL) && defined(GLFW_OSMESA_CONTEXT_API)
+    if (semTela)
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+#endif
+    return true;
+}
+
+class CapturaHeadless {
+    GLuint fbo, cor, profundidade;
+    GLuint pbo[2];
+    int largura, altura;
+    long capturados;
+    std::vector<unsigned char> imagem; // RGBA, primeira linha em cima
+    std::chrono::steady_clock::time_point inicio;
+
+public:
+    CapturaHeadless() {
+        this->fbo = this->cor = this->profundidade = 0;
+        this->pbo[0] = this->pbo[1] = 0;
+        this->largura = this->altura = 0;
+        this->capturados = 0;
+    }
+
+    // Cria o framebuffer do tamanho da janela e deixa ele ligado: todo o
+    // desenho seguinte vai para ele, e não para a janela invisível
+    bool criar(int largura, int altura, std::string &erro) {
+        this->largura = largura;
+        this->altura = altura;
+
+        glGenRenderbuffers(1, &this->cor);
+        glBindRenderbuffer(GL_RENDERBUFFER, this->cor);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, largura, altura);
+        glGenRenderbuffers(1, &this->profundidade);
+        glBindRenderbuffer(GL_RENDERBUFFER, this->profundidade);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, largura, altura);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glGenFramebuffers(1, &this->fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, this->fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, this->cor);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, this->profundidade);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            erro = "framebuffer headless incompleto";
+            this->liberar();
+            return false;
+        }
+
+        glGenBuffers(2, this->pbo);
+        for (int k = 0; k < 2; k++) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, this->pbo[k]);
+            glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)largura * altura * 4, NULL, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        this->imagem.assign((size_t)largura * altura * 4, 0);
+        this->capturados = 0;
+        this->inicio = std::chrono::steady_clock::now();
+        return true;
+    }
+
+    // Chamado no começo de cada frame: o relógio da GLFW anda 1/60 s por frame
+    void iniciarFrame(long frame) const {
+        glfwSetTime(frame / HZ_HEADLESS);
+    }
+
+    // Chamado no fim do frame, no lugar do glfwSwapBuffers. Começa a cópia
+    // deste frame e recolhe a do anterior, que já deve ter terminado
+    void capturar() {
+        int atual = (int)(this->capturados % 2);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, this->pbo[atual]);
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+        glReadPixels(0, 0, this->largura, this->altura, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+        if (this->capturados > 0)
+            this->recolher(1 - atual);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        this->capturados++;
+    }
+
+    // Recolhe a última cópia (espera a GPU) e devolve o tempo médio por
+    // frame, em ms, desde criar()
+    double finalizar() {
+        if (this->capturados > 0) {
+            this->recolher((int)((this->capturados - 1) % 2));
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - this->inicio).count();
+        return this->capturados > 0 ? ms / this->capturados : 0.0;
+    }
+
+    const std::vector<unsigned char> &getImagem() const {
+        return this->imagem;
+    }
+
+    long getCapturados() const {
+        return this->capturados;
+    }
+
+    // Compara o último frame com opcoes.golden. Só com --atualizar-golden o
+    // frame é gravado como nova referência; uma referência ausente ou
+    // ilegível é falha, para o teste não passar sozinho numa máquina limpa.
+    // Se a comparação falha, grava o frame ao lado da referência
+    // (<golden>.atual.png) para inspeção
+    bool compararGolden(const OpcoesHeadless &opcoes, std::ostream &saida, std::string &erro) const {
+        const std::string &caminho = opcoes.golden;
+        if (caminho.empty())
+            return true;
+
+        if (opcoes.atualizarGolden) {
+            if (!this->gravarPng(caminho)) {
+                erro = "nao foi possivel gravar " + caminho;
+                return false;
+            }
+            saida << "Golden gravado em " << caminho << std::endl;
+            return true;
+        }
+
+        FILE *arquivo = fopen(caminho.c_str(), "rb");
+        if (!arquivo) {
+            erro = "golden ausente: " + caminho + " (use --atualizar-golden para gravar)";
+            return false;
+        }
+        int w = 0, h = 0, canais = 0;
+        unsigned char *ref = stbi_load_from_file(arquivo, &w, &h, &canais, 4);
+        fclose(arquivo);
+        if (!ref) {
+            erro = "golden ilegivel: " + caminho + " (" + stbi_failure_reason() + ")";
+            return false;
+        }
+
+        if (w != this->largura || h != this->altura) {
+            stbi_image_free(ref);
+            char msg[256];
+            snprintf(msg, sizeof(msg), "%s: golden tem %dx%d, frame tem %dx%d", caminho.c_str(), w, h, this->largura, this->altura);
+            erro = msg;
+            return false;
+        }
+
+        long diferentes = 0;
+        int maiorDiferenca = 0;
+        size_t nPixels = (size_t)w * h;
+        for (size_t p = 0; p < nPixels; p++) {
+            int d = 0;
+            for (int c = 0; c < 4; c++)
+                d = std::max(d, abs((int)this->imagem[p * 4 + c] - (int)ref[p * 4 + c]));
+            maiorDiferenca = std::max(maiorDiferenca, d);
+            if (d > opcoes.tolerancia)
+                diferentes++;
+        }
+        stbi_image_free(ref);
+
+        double fracao = (double)diferentes / nPixels;
+        char msg[256];
+        snprintf(msg, sizeof(msg), "%s: %ld pixels diferentes (%.3f%%), maior diferenca %d", caminho.c_str(),
+                 diferentes, fracao * 100.0, maiorDiferenca);
+        saida << msg << std::endl;
+        if (fracao <= opcoes.maxDiferentes)
+            return true;
+
+        std::string atual = caminho + ".atual.png";
+        this->gravarPng(atual);
+        erro = std::string(msg) + "; frame gravado em " + atual;
+        return false;
+    }
+
+    void liberar() {
+        if (this->pbo[0])
+            glDeleteBuffers(2, this->pbo);
+        if (this->fbo) {
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glDeleteFramebuffers(1, &this->fbo);
+        }
+        if (this->cor)
+            glDeleteRenderbuffers(1, &this->cor);
+        if (this->profundidade)
+            glDeleteRenderbuffers(1, &this->profundidade);
+        this->fbo = this->cor = this->profundidade = 0;
+        this->pbo[0] = this->pbo[1] = 0;
+    }
+
+private:
+    // Copia o PBO k para a imagem, invertendo as linhas (o GL lê de baixo
+    // para cima). Deixa o PBO k ligado em GL_PIXEL_PACK_BUFFER
+    void recolher(int k) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, this->pbo[k]);
+        size_t linha = (size_t)this->largura * 4;
+        const unsigned char *dados = (const unsigned char *)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+                                                                             (GLsizeiptr)(linha * this->altura), GL_MAP_READ_BIT);
+        if (!dados)
+            return;
+        for (int y = 0; y < this->altura; y++)
+            memcpy(&this->imagem[(size_t)y * linha], dados + (size_t)(this->altura - 1 - y) * linha, linha);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+
+    bool gravarPng(const std::string &caminho) const {
+        return stbi_write_png(caminho.c_str(), this->largura, this->altura, 4, this->imagem.data(), this->largura * 4) != 0;
+    }
+};
+
+#endif /* Headless_h */
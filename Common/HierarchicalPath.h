@@ -0,0 +1,693 @@
+//
+//  HierarchicalPath.h
+//
+//  Busca de caminho hierárquica (HPA*) para consultas longas em mapas
+//  grandes. A MapGrid é dividida em clusters de TAM_CLUSTER_HPA x
+//  TAM_CLUSTER_HPA casas. Nas bordas entre dois clusters vizinhos, cada
+//  trecho contínuo de casas passáveis dos dois lados vira uma entrada, com
+//  uma transição no meio (ou duas, nas pontas, nos trechos de
+//  ENTRADA_LONGA_HPA casas ou mais). Cada transição são dois nós do grafo
+//  abstrato, um de cada lado, ligados pelo passo que cruza a borda. Dentro
+//  de um cluster, os nós são ligados pelo menor caminho que não sai dele,
+//  calculado na construção e guardado como a sequência de direções.
+//
+//  Uma consulta liga a origem e o destino aos nós dos seus clusters (um
+//  Dijkstra em cada cluster), roda o A* no grafo abstrato, que tem poucas
+//  dezenas de nós por cluster em vez de 256 casas, e expande o resultado
+//  com os caminhos guardados. O caminho não é sempre o ótimo (passa pelas
+//  transições), mas fica perto dele. Como o resultado já é aproximado, a
+//  heurística do A* abstrato é multiplicada por PESO_HEURISTICA_HPA: o
+//  custo de cada trecho passa um pouco do octil, e com a heurística exata o
+//  A* abriria uma faixa larga de nós em volta do caminho.
+//
+//  Os movimentos e custos são os de Pathfinding.h, com a diagonal podendo
+//  cortar o canto. Por isso uma diagonal entre duas casas da borda, ou
+//  entre os cantos de quatro clusters, também pode ser a única passagem, e
+//  vira uma transição quando nenhuma casa reta ao lado atravessa.
+//
+//  Quando um tile muda, marcarAlterada() marca o cluster dele; na próxima
+//  consulta (ou em reparar()) só as bordas que tocam os clusters marcados
+//  são refeitas, e só as ligações internas deles e dos 8 vizinhos, que
+//  dividem essas bordas, são recalculadas.
+//
+//  A grade e a tabela de custos passadas a construir() precisam continuar
+//  vivas. Uma NavegacaoHPA não pode ser usada por duas threads ao mesmo
+//  tempo.
+//
+
+#ifndef HierarchicalPath_h
+#define HierarchicalPath_h
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "MapData.h"
+#include "Pathfinding.h"
+
+#define TAM_CLUSTER_HPA 16
+#define ENTRADA_LONGA_HPA 6
+#define PESO_HEURISTICA_HPA 1.1f
+
+class NavegacaoHPA {
+    // Um lado de uma transição. celula < 0 marca um nó livre
+    struct NoHPA {
+        int32_t celula, cluster;
+        int32_t borda;          // 4 * cluster dono + tipo (BORDA_*)
+        int32_t par;            // o nó do outro lado da borda
+        float custoPar;         // custo de passar para o par
+        int32_t primeiraAresta; // em clusters[cluster].arestas
+        int32_t numArestas;
+    };
+
+    // Ligação interna até outro nó do mesmo cluster; o caminho são tamanho
+    // direções a partir de passos[inicio] do cluster
+    struct ArestaHPA {
+        int32_t para;
+        float custo;
+        uint32_t inicio, tamanho;
+    };
+
+    struct ClusterHPA {
+        std::vector<int32_t> nos;
+        std::vector<ArestaHPA> arestas;
+        std::vector<uint8_t> passos;
+        bool sujo;
+    };
+
+    struct NoAberto {
+        float f;
+        int32_t no;
+        bool operator>(const NoAberto &outro) const {
+            return this->f > outro.f;
+        }
+    };
+
+    // Bordas de que cada cluster é dono: com o vizinho da direita, com o de
+    // baixo e os cantos com os de baixo à direita e à esquerda
+    enum { BORDA_LESTE = 0, BORDA_SUL, BORDA_SUDESTE, BORDA_SUDOESTE };
+
+    const MapGrid *grade;
+    const float *custos;
+    float custoMinimo;
+    int largura, altura;
+    int clustersX, clustersY;
+    std::vector<NoHPA> nos;
+    std::vector<int32_t> livres;
+    std::vector<ClusterHPA> clusters;
+    std::vector<int32_t> sujos;
+
+    // Resultado de um Dijkstra dentro de um cluster, com índices locais ao
+    // retângulo dele
+    struct BuscaLocal {
+        int l0, c0, l1, c1;
+        float g[TAM_CLUSTER_HPA * TAM_CLUSTER_HPA];
+        int8_t dir[TAM_CLUSTER_HPA * TAM_CLUSTER_HPA];
+        uint8_t fechado[TAM_CLUSTER_HPA * TAM_CLUSTER_HPA];
+    };
+
+    // Custos de entrada das casas do cluster carregado, lidos da grade uma
+    // vez para todos os Dijkstras nele
+    int clusterCarregado;
+    float custosCluster[TAM_CLUSTER_HPA * TAM_CLUSTER_HPA];
+    std::vector<NoAberto> heapLocal;
+    BuscaLocal buscaOrigem, buscaDestino;
+
+    // A* no grafo abstrato; a origem e o destino da consulta são os nós
+    // nos.size() e nos.size() + 1
+    // Estado de cada nó na busca, junto para um relaxamento tocar uma
+    // linha de cache só
+    struct EstadoNo {
+        float g;
+        int32_t pai;
+        uint32_t marca; // geracao * 2 (visto) ou geracao * 2 + 1 (fechado)
+    };
+    std::vector<EstadoNo> estado;
+    std::vector<NoAberto> heap;
+    uint32_t geracao;
+    std::vector<std::pair<int32_t, float> > ligacoesOrigem, ligacoesDestino;
+    std::vector<uint8_t> direcoes; // rascunho para expandir um trecho
+    EstatisticasBusca estatisticas;
+
+    // Mesma ordem de Pathfinder: as 4 retas e depois as 4 diagonais
+    static constexpr int DL[8] = {-1, 1, 0, 0, -1, -1, 1, 1};
+    static constexpr int DC[8] = {0, 0, -1, 1, -1, 1, -1, 1};
+    static constexpr int OPOSTA[8] = {1, 0, 3, 2, 7, 6, 5, 4};
+
+public:
+    NavegacaoHPA() {
+        this->grade = NULL;
+        this->custos = NULL;
+        this->custoMinimo = 1.0f;
+        this->largura = this->altura = 0;
+        this->clustersX = this->clustersY = 0;
+        this->clusterCarregado = -1;
+        this->geracao = 0;
+        this->estatisticas.nosExpandidos = this->estatisticas.nosAbertos = 0;
+        this->estatisticas.custo = -1.0f;
+    }
+
+    // Monta o grafo abstrato do mapa inteiro
+    void construir(const MapGrid &grade, const float custos[256]) {
+        this->grade = &grade;
+        this->custos = custos;
+        this->largura = grade.getWidth();
+        this->altura = grade.getHeight();
+        this->clustersX = (this->largura + TAM_CLUSTER_HPA - 1) / TAM_CLUSTER_HPA;
+        this->clustersY = (this->altura + TAM_CLUSTER_HPA - 1) / TAM_CLUSTER_HPA;
+
+        this->custoMinimo = 1.0f;
+        for (int t = 0; t < 256; t++)
+            if (custos[t] >= 0.0f)
+                this->custoMinimo = std::min(this->custoMinimo, custos[t]);
+
+        this->nos.clear();
+        this->livres.clear();
+        this->sujos.clear();
+        this->clusters.assign((size_t)this->clustersX * this->clustersY, ClusterHPA());
+        for (size_t k = 0; k < this->clusters.size(); k++)
+            this->clusters[k].sujo = false;
+
+        for (int k = 0; k < (int)this->clusters.size(); k++)
+            for (int tipo = BORDA_LESTE; tipo <= BORDA_SUDOESTE; tipo++)
+                this->gerarBorda(k, tipo);
+        for (int k = 0; k < (int)this->clusters.size(); k++)
+            this->ligarCluster(k);
+    }
+
+    // A casa (linha, coluna) mudou de tile
+    void marcarAlterada(int linha, int coluna) {
+        if (this->clusters.empty() || linha < 0 || coluna < 0 || linha >= this->altura || coluna >= this->largura)
+            return;
+        int k = (linha / TAM_CLUSTER_HPA) * this->clustersX + coluna / TAM_CLUSTER_HPA;
+        if (!this->clusters[k].sujo) {
+            this->clusters[k].sujo = true;
+            this->sujos.push_back(k);
+        }
+    }
+
+    // Refaz as bordas dos clusters marcados e as ligações internas deles e
+    // dos vizinhos. Devolve quantos clusters foram religados
+    int reparar() {
+        if (this->sujos.empty())
+            return 0;
+
+        std::vector<uint8_t> afetado(this->clusters.size(), 0);
+        std::vector<int32_t> afetados;
+        std::vector<int32_t> bordas;
+        for (size_t s = 0; s < this->sujos.size(); s++) {
+            int cx = this->sujos[s] % this->clustersX, cy = this->sujos[s] / this->clustersX;
+            for (int dy = -1; dy <= 1; dy++)
+                for (int dx = -1; dx <= 1; dx++) {
+                    int k = this->clusterEm(cx + dx, cy + dy);
+                    if (k >= 0 && !afetado[k]) {
+                        afetado[k] = 1;
+                        afetados.push_back(k);
+                    }
+                }
+
+            // As quatro bordas do cluster e as dos vizinhos que o tocam
+            int k = this->sujos[s];
+            for (int tipo = BORDA_LESTE; tipo <= BORDA_SUDOESTE; tipo++)
+                bordas.push_back(4 * k + tipo);
+            int esquerda = this->clusterEm(cx - 1, cy), acima = this->clusterEm(cx, cy - 1);
+            int acimaEsquerda = this->clusterEm(cx - 1, cy - 1), acimaDireita = this->clusterEm(cx + 1, cy - 1);
+            if (esquerda >= 0)
+                bordas.push_back(4 * esquerda + BORDA_LESTE);
+            if (acima >= 0)
+                bordas.push_back(4 * acima + BORDA_SUL);
+            if (acimaEsquerda >= 0)
+                bordas.push_back(4 * acimaEsquerda + BORDA_SUDESTE);
+            if (acimaDireita >= 0)
+                bordas.push_back(4 * acimaDireita + BORDA_SUDOESTE);
+            this->clusters[k].sujo = false;
+        }
+        std::sort(bordas.begin(), bordas.end());
+        bordas.erase(std::unique(bordas.begin(), bordas.end()), bordas.end());
+
+        // Os dois lados de uma transição dessas bordas estão em clusters
+        // afetados, então basta olhar os nós deles
+        for (size_t a = 0; a < afetados.size(); a++) {
+            std::vector<int32_t> &lista = this->clusters[afetados[a]].nos;
+            size_t ficam = 0;
+            for (size_t k = 0; k < lista.size(); k++) {
+                NoHPA &no = this->nos[lista[k]];
+                if (std::binary_search(bordas.begin(), bordas.end(), no.borda)) {
+                    no.celula = -1;
+                    this->livres.push_back(lista[k]);
+                } else {
+                    lista[ficam++] = lista[k];
+                }
+            }
+            lista.resize(ficam);
+        }
+        for (size_t b = 0; b < bordas.size(); b++)
+            this->gerarBorda(bordas[b] / 4, bordas[b] % 4);
+        for (size_t a = 0; a < afetados.size(); a++)
+            this->ligarCluster(afetados[a]);
+
+        this->sujos.clear();
+        return (int)afetados.size();
+    }
+
+    // Como Pathfinder::buscarAEstrela, mas no grafo abstrato. Repara antes
+    // os clusters marcados
+    bool buscar(PontoGrade origem, PontoGrade destino, std::vector<PontoGrade> &caminho) {
+        caminho.clear();
+        this->estatisticas.nosExpandidos = this->estatisticas.nosAbertos = 0;
+        this->estatisticas.custo = -1.0f;
+        if (this->clusters.empty())
+            return false;
+        this->reparar();
+
+        if (!this->passavel(origem.linha, origem.coluna) || !this->passavel(destino.linha, destino.coluna))
+            return false;
+        int celOrigem = this->indice(origem.linha, origem.coluna);
+        int celDestino = this->indice(destino.linha, destino.coluna);
+        if (celOrigem == celDestino) {
+            caminho.push_back(origem);
+            this->estatisticas.custo = 0.0f;
+            return true;
+        }
+
+        int kOrigem = this->clusterDe(celOrigem), kDestino = this->clusterDe(celDestino);
+        int32_t noOrigem = (int32_t)this->nos.size(), noDestino = noOrigem + 1;
+
+        // Ligações da origem aos nós do seu cluster, e o caminho direto se o
+        // destino está no mesmo cluster
+        BuscaLocal &bo = this->buscaOrigem, &bd = this->buscaDestino;
+        this->ligacoesOrigem.clear();
+        this->carregarCluster(kOrigem);
+        this->dijkstraLocal(bo, celOrigem, false);
+        const std::vector<int32_t> &nosOrigem = this->clusters[kOrigem].nos;
+        for (size_t k = 0; k < nosOrigem.size(); k++) {
+            float custo = this->custoLocal(bo, this->nos[nosOrigem[k]].celula);
+            if (custo >= 0.0f)
+                this->ligacoesOrigem.push_back(std::make_pair(nosOrigem[k], custo));
+        }
+        if (kOrigem == kDestino && this->custoLocal(bo, celDestino) >= 0.0f)
+            this->ligacoesOrigem.push_back(std::make_pair(noDestino, this->custoLocal(bo, celDestino)));
+
+        // Custo de cada nó do cluster do destino até ele
+        this->ligacoesDestino.clear();
+        this->carregarCluster(kDestino);
+        this->dijkstraLocal(bd, celDestino, true);
+        const std::vector<int32_t> &nosDestino = this->clusters[kDestino].nos;
+        for (size_t k = 0; k < nosDestino.size(); k++) {
+            float custo = this->custoLocal(bd, this->nos[nosDestino[k]].celula);
+            if (custo >= 0.0f)
+                this->ligacoesDestino.push_back(std::make_pair(nosDestino[k], custo));
+        }
+
+        if (!this->buscarAbstrato(noOrigem, noDestino, kDestino, destino))
+            return false;
+
+        // Expande o caminho abstrato, do destino para a origem
+        std::vector<int32_t> sequencia;
+        for (int32_t n = noDestino; n >= 0; n = this->estado[n].pai)
+            sequencia.push_back(n);
+        std::reverse(sequencia.begin(), sequencia.end());
+
+        caminho.push_back(origem);
+        for (size_t s = 0; s + 1 < sequencia.size(); s++) {
+            int32_t a = sequencia[s], b = sequencia[s + 1];
+            if (a == noOrigem) {
+                this->trechoLocal(bo, b == noDestino ? celDestino : this->nos[b].celula);
+                this->andar(caminho);
+            } else if (b == noDestino) {
+                this->direcoes.clear();
+                int cel = this->nos[a].celula;
+                while (cel != celDestino) {
+                    int d = bd.dir[this->local(bd, cel)];
+                    this->direcoes.push_back((uint8_t)d);
+                    cel = this->indice(cel / this->largura + DL[d], cel % this->largura + DC[d]);
+                }
+                this->andar(caminho);
+            } else if (this->nos[a].cluster != this->nos[b].cluster) {
+                int cel = this->nos[b].celula;
+                PontoGrade p = {cel / this->largura, cel % this->largura};
+                caminho.push_back(p);
+            } else {
+                const ClusterHPA &cl = this->clusters[this->nos[a].cluster];
+                const NoHPA &no = this->nos[a];
+                for (int e = no.primeiraAresta; e < no.primeiraAresta + no.numArestas; e++) {
+                    if (cl.arestas[e].para != b)
+                        continue;
+                    this->direcoes.assign(cl.passos.begin() + cl.arestas[e].inicio,
+                                          cl.passos.begin() + cl.arestas[e].inicio + cl.arestas[e].tamanho);
+                    this->andar(caminho);
+                    break;
+                }
+            }
+        }
+        this->estatisticas.custo = this->estado[noDestino].g;
+        return true;
+    }
+
+    const EstatisticasBusca &getEstatisticas() const {
+        return this->estatisticas;
+    }
+
+    size_t getNumNos() const {
+        return this->nos.size() - this->livres.size();
+    }
+
+    size_t getNumArestas() const {
+        size_t n = 0;
+        for (size_t k = 0; k < this->clusters.size(); k++)
+            n += this->clusters[k].arestas.size();
+        return n;
+    }
+
+    size_t getMemoryBytes() const {
+        size_t n = this->nos.capacity() * sizeof(NoHPA) + this->clusters.capacity() * sizeof(ClusterHPA);
+        for (size_t k = 0; k < this->clusters.size(); k++)
+            n += this->clusters[k].nos.capacity() * sizeof(int32_t) +
+                 this->clusters[k].arestas.capacity() * sizeof(ArestaHPA) + this->clusters[k].passos.capacity();
+        return n;
+    }
+
+private:
+    int indice(int l, int c) const {
+        return l * this->largura + c;
+    }
+
+    int clusterEm(int cx, int cy) const {
+        if (cx < 0 || cy < 0 || cx >= this->clustersX || cy >= this->clustersY)
+            return -1;
+        return cy * this->clustersX + cx;
+    }
+
+    int clusterDe(int celula) const {
+        return (celula / this->largura / TAM_CLUSTER_HPA) * this->clustersX + (celula % this->largura) / TAM_CLUSTER_HPA;
+    }
+
+    float custoEntrada(int l, int c) const {
+        if (l < 0 || c < 0 || l >= this->altura || c >= this->largura)
+            return -1.0f;
+        return this->custos[this->grade->getTile(l, c)];
+    }
+
+    bool passavel(int l, int c) const {
+        return this->custoEntrada(l, c) >= 0.0f;
+    }
+
+    void limites(int k, int &l0, int &c0, int &l1, int &c1) const {
+        l0 = (k / this->clustersX) * TAM_CLUSTER_HPA;
+        c0 = (k % this->clustersX) * TAM_CLUSTER_HPA;
+        l1 = std::min(l0 + TAM_CLUSTER_HPA, this->altura);
+        c1 = std::min(c0 + TAM_CLUSTER_HPA, this->largura);
+    }
+
+    int novoNo() {
+        if (!this->livres.empty()) {
+            int32_t n = this->livres.back();
+            this->livres.pop_back();
+            return n;
+        }
+        this->nos.push_back(NoHPA());
+        return (int)this->nos.size() - 1;
+    }
+
+    // Transição da casa (la, ca), do cluster dono da borda, para (lb, cb)
+    void criarTransicao(int borda, int la, int ca, int lb, int cb) {
+        bool diagonal = la != lb && ca != cb;
+        float mult = diagonal ? CUSTO_DIAGONAL : 1.0f;
+        int a = this->novoNo(), b = this->novoNo();
+        NoHPA &na = this->nos[a];
+        na.celula = this->indice(la, ca);
+        na.cluster = this->clusterDe(na.celula);
+        na.borda = borda;
+        na.par = b;
+        na.custoPar = this->custoEntrada(lb, cb) * mult;
+        na.primeiraAresta = na.numArestas = 0;
+        NoHPA &nb = this->nos[b];
+        nb.celula = this->indice(lb, cb);
+        nb.cluster = this->clusterDe(nb.celula);
+        nb.borda = borda;
+        nb.par = a;
+        nb.custoPar = this->custoEntrada(la, ca) * mult;
+        nb.primeiraAresta = nb.numArestas = 0;
+        this->clusters[na.cluster].nos.push_back(a);
+        this->clusters[nb.cluster].nos.push_back(b);
+    }
+
+    // Cria as transições de uma borda do cluster k com o vizinho
+    void gerarBorda(int k, int tipo) {
+        int cx = k % this->clustersX, cy = k / this->clustersX;
+        int l0, c0, l1, c1;
+        this->limites(k, l0, c0, l1, c1);
+        int borda = 4 * k + tipo;
+
+        if (tipo == BORDA_SUDESTE || tipo == BORDA_SUDOESTE) {
+            // Cantos: só a diagonal entre os quatro clusters, quando as duas
+            // casas retas ao lado estão bloqueadas
+            int lado = tipo == BORDA_SUDESTE ? 1 : -1;
+            if (this->clusterEm(cx + lado, cy + 1) < 0)
+                return;
+            int la = l1 - 1, ca = tipo == BORDA_SUDESTE ? c1 - 1 : c0;
+            if (this->passavel(la, ca) && this->passavel(la + 1, ca + lado) && !this->passavel(la, ca + lado) &&
+                !this->passavel(la + 1, ca))
+                this->criarTransicao(borda, la, ca, la + 1, ca + lado);
+            return;
+        }
+
+        // Casas ao longo da borda: (l, c) deste lado e (l + dl, c + dc) do
+        // outro, andando (sl, sc) de uma para a próxima
+        bool leste = tipo == BORDA_LESTE;
+        if (this->clusterEm(cx + leste, cy + !leste) < 0)
+            return;
+        int dl = leste ? 0 : 1, dc = leste ? 1 : 0;
+        int sl = leste ? 1 : 0, sc = leste ? 0 : 1;
+        int lIni = leste ? l0 : l1 - 1, cIni = leste ? c1 - 1 : c0;
+        int n = leste ? l1 - l0 : c1 - c0;
+
+        int inicio = -1;
+        for (int i = 0; i <= n; i++) {
+            bool reta = i < n && this->passavel(lIni + i * sl, cIni + i * sc) &&
+                        this->passavel(lIni + i * sl + dl, cIni + i * sc + dc);
+            if (reta && inicio < 0)
+                inicio = i;
+            if (reta || inicio < 0)
+                continue;
+            int tamanho = i - inicio;
+            if (tamanho >= ENTRADA_LONGA_HPA) {
+                this->criarTransicao(borda, lIni + inicio * sl, cIni + inicio * sc, lIni + inicio * sl + dl,
+                                     cIni + inicio * sc + dc);
+                this->criarTransicao(borda, lIni + (i - 1) * sl, cIni + (i - 1) * sc, lIni + (i - 1) * sl + dl,
+                                     cIni + (i - 1) * sc + dc);
+            } else {
+                int m = inicio + tamanho / 2;
+                this->criarTransicao(borda, lIni + m * sl, cIni + m * sc, lIni + m * sl + dl, cIni + m * sc + dc);
+            }
+            inicio = -1;
+        }
+
+        // Diagonais que cruzam a borda entre as posições i e i + 1 onde
+        // nenhuma das duas tem passagem reta
+        for (int i = 0; i + 1 < n; i++) {
+            int la = lIni + i * sl, ca = cIni + i * sc;
+            int lb = la + sl, cb = ca + sc;
+            if ((this->passavel(la, ca) && this->passavel(la + dl, ca + dc)) ||
+                (this->passavel(lb, cb) && this->passavel(lb + dl, cb + dc)))
+                continue;
+            if (this->passavel(la, ca) && this->passavel(lb + dl, cb + dc))
+                this->criarTransicao(borda, la, ca, lb + dl, cb + dc);
+            if (this->passavel(lb, cb) && this->passavel(la + dl, ca + dc))
+                this->criarTransicao(borda, lb, cb, la + dl, ca + dc);
+        }
+    }
+
+    // Liga cada par de nós do cluster pelo menor caminho dentro dele
+    void ligarCluster(int k) {
+        ClusterHPA &cl = this->clusters[k];
+        BuscaLocal &busca = this->buscaOrigem;
+        cl.arestas.clear();
+        cl.passos.clear();
+        this->carregarCluster(k);
+        for (size_t a = 0; a < cl.nos.size(); a++) {
+            NoHPA &no = this->nos[cl.nos[a]];
+            no.primeiraAresta = (int32_t)cl.arestas.size();
+            this->dijkstraLocal(busca, no.celula, false);
+            for (size_t b = 0; b < cl.nos.size(); b++) {
+                int cel = this->nos[cl.nos[b]].celula;
+                float custo = this->custoLocal(busca, cel);
+                if (a == b || custo < 0.0f)
+                    continue;
+                this->trechoLocal(busca, cel);
+                ArestaHPA aresta = {cl.nos[b], custo, (uint32_t)cl.passos.size(), (uint32_t)this->direcoes.size()};
+                cl.passos.insert(cl.passos.end(), this->direcoes.begin(), this->direcoes.end());
+                cl.arestas.push_back(aresta);
+            }
+            no.numArestas = (int32_t)cl.arestas.size() - no.primeiraAresta;
+        }
+    }
+
+    int local(const BuscaLocal &busca, int celula) const {
+        return (celula / this->largura - busca.l0) * (busca.c1 - busca.c0) + (celula % this->largura - busca.c0);
+    }
+
+    // Custo da busca até (ou a partir de) celula, -1 se não chega
+    float custoLocal(const BuscaLocal &busca, int celula) const {
+        int i = this->local(busca, celula);
+        return busca.fechado[i] ? busca.g[i] : -1.0f;
+    }
+
+    void carregarCluster(int k) {
+        int l0, c0, l1, c1;
+        this->limites(k, l0, c0, l1, c1);
+        int w = c1 - c0;
+        for (int l = l0; l < l1; l++) {
+            const CelulaMapa *linha = this->grade->getLinha(l);
+            for (int c = c0; c < c1; c++)
+                this->custosCluster[(l - l0) * w + (c - c0)] = this->custos[linha[c].tile];
+        }
+        this->clusterCarregado = k;
+    }
+
+    // Dijkstra de celula para todo o cluster carregado, sem sair dele. Com
+    // reverso, calcula o custo de cada casa até celula, e dir dá a direção
+    // do passo seguinte rumo a ela; senão dir dá a direção do passo que
+    // chegou na casa
+    void dijkstraLocal(BuscaLocal &busca, int celula, bool reverso) {
+        this->limites(this->clusterCarregado, busca.l0, busca.c0, busca.l1, busca.c1);
+        int w = busca.c1 - busca.c0, h = busca.l1 - busca.l0;
+        std::fill(busca.fechado, busca.fechado + w * h, 0);
+        std::fill(busca.g, busca.g + w * h, -1.0f);
+        this->heapLocal.clear();
+
+        int i = this->local(busca, celula);
+        busca.g[i] = 0.0f;
+        busca.dir[i] = -1;
+        NoAberto a = {0.0f, i};
+        this->heapLocal.push_back(a);
+        while (!this->heapLocal.empty()) {
+            std::pop_heap(this->heapLocal.begin(), this->heapLocal.end(), std::greater<NoAberto>());
+            int u = this->heapLocal.back().no;
+            this->heapLocal.pop_back();
+            if (busca.fechado[u])
+                continue;
+            busca.fechado[u] = 1;
+
+            int l = u / w, c = u % w;
+            for (int d = 0; d < 8; d++) {
+                int nl = l + DL[d], nc = c + DC[d];
+                if (nl < 0 || nc < 0 || nl >= h || nc >= w)
+                    continue;
+                int v = nl * w + nc;
+                if (this->custosCluster[v] < 0.0f || busca.fechado[v])
+                    continue;
+                float custo = this->custosCluster[reverso ? u : v] * (d < 4 ? 1.0f : CUSTO_DIAGONAL);
+                float gv = busca.g[u] + custo;
+                if (busca.g[v] >= 0.0f && gv >= busca.g[v])
+                    continue;
+                busca.g[v] = gv;
+                busca.dir[v] = (int8_t)(reverso ? OPOSTA[d] : d);
+                NoAberto b = {gv, v};
+                this->heapLocal.push_back(b);
+                std::push_heap(this->heapLocal.begin(), this->heapLocal.end(), std::greater<NoAberto>());
+            }
+        }
+    }
+
+    // Direções da origem da busca (para frente) até celula
+    void trechoLocal(const BuscaLocal &busca, int celula) {
+        this->direcoes.clear();
+        int l = celula / this->largura, c = celula % this->largura;
+        for (int d = busca.dir[this->local(busca, celula)]; d >= 0;) {
+            this->direcoes.push_back((uint8_t)d);
+            l -= DL[d];
+            c -= DC[d];
+            d = busca.dir[this->local(busca, this->indice(l, c))];
+        }
+        std::reverse(this->direcoes.begin(), this->direcoes.end());
+    }
+
+    // Acrescenta ao caminho as casas das direções em direcoes
+    void andar(std::vector<PontoGrade> &caminho) const {
+        PontoGrade p = caminho.back();
+        for (size_t k = 0; k < this->direcoes.size(); k++) {
+            p.linha += DL[this->direcoes[k]];
+            p.coluna += DC[this->direcoes[k]];
+            caminho.push_back(p);
+        }
+    }
+
+    float heuristica(int32_t no, int32_t noOrigem, PontoGrade destino) const {
+        if (no >= noOrigem)
+            return 0.0f;
+        int cel = this->nos[no].celula;
+        int dl = abs(cel / this->largura - destino.linha), dc = abs(cel % this->largura - destino.coluna);
+        int menor = std::min(dl, dc), maior = std::max(dl, dc);
+        return ((float)(maior - menor) + CUSTO_DIAGONAL * menor) * this->custoMinimo * PESO_HEURISTICA_HPA;
+    }
+
+    void relaxar(int32_t de, int32_t para, float g, int32_t noOrigem, PontoGrade destino) {
+        EstadoNo &e = this->estado[para];
+        uint32_t m = e.marca;
+        if (m == this->geracao * 2 + 1)
+            return;
+        if (m == this->geracao * 2 && g >= e.g)
+            return;
+        e.g = g;
+        e.pai = de;
+        e.marca = this->geracao * 2;
+        NoAberto a = {g + this->heuristica(para, noOrigem, destino), para};
+        this->heap.push_back(a);
+        std::push_heap(this->heap.begin(), this->heap.end(), std::greater<NoAberto>());
+        this->estatisticas.nosAbertos++;
+    }
+
+    bool buscarAbstrato(int32_t noOrigem, int32_t noDestino, int kDestino, PontoGrade destino) {
+        size_t n = this->nos.size() + 2;
+        if (this->estado.size() < n) {
+            EstadoNo vazio = {0.0f, -1, 0};
+            this->estado.resize(n, vazio);
+        }
+        if (++this->geracao >= 0x7FFFFFFF) {
+            for (size_t k = 0; k < this->estado.size(); k++)
+                this->estado[k].marca = 0;
+            this->geracao = 1;
+        }
+
+        this->heap.clear();
+        EstadoNo inicial = {0.0f, -1, this->geracao * 2};
+        this->estado[noOrigem] = inicial;
+        NoAberto inicio = {0.0f, noOrigem};
+        this->heap.push_back(inicio);
+
+        while (!this->heap.empty()) {
+            std::pop_heap(this->heap.begin(), this->heap.end(), std::greater<NoAberto>());
+            int32_t u = this->heap.back().no;
+            this->heap.pop_back();
+            if (this->estado[u].marca == this->geracao * 2 + 1)
+                continue;
+            this->estado[u].marca = this->geracao * 2 + 1;
+            this->estatisticas.nosExpandidos++;
+            if (u == noDestino)
+                return true;
+
+            if (u == noOrigem) {
+                for (size_t k = 0; k < this->ligacoesOrigem.size(); k++)
+                    this->relaxar(u, this->ligacoesOrigem[k].first, this->ligacoesOrigem[k].second, noOrigem, destino);
+                continue;
+            }
+
+            const NoHPA &no = this->nos[u];
+            float gu = this->estado[u].g;
+            this->relaxar(u, no.par, gu + no.custoPar, noOrigem, destino);
+            const ClusterHPA &cl = this->clusters[no.cluster];
+            for (int e = no.primeiraAresta; e < no.primeiraAresta + no.numArestas; e++)
+                this->relaxar(u, cl.arestas[e].para, gu + cl.arestas[e].custo, noOrigem, destino);
+            if (no.cluster == kDestino)
+                for (size_t k = 0; k < this->ligacoesDestino.size(); k++)
+                    if (this->ligacoesDestino[k].first == u)
+                        this->relaxar(u, noDestino, gu + this->ligacoesDestino[k].second, noOrigem, destino);
+        }
+        return false;
+    }
+};
+
+#endif /* HierarchicalPath_h */
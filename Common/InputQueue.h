@@ -0,0 +1,89 @@
+//
+//  InputQueue.h
+//
+//  Fila circular sem lock para um produtor e um consumidor (SPSC). Os
+//  callbacks da GLFW inserem os eventos de teclado e mouse e o passo de
+//  lógica os retira; o callback não toca no estado do jogo nem espera por
+//  nada.
+//
+//  Cada lado só escreve o seu índice: o produtor publica o item com store
+//  release em fim, o consumidor o enxerga com load acquire (e o contrário
+//  para liberar a posição). N precisa ser potência de 2; a fila guarda até
+//  N itens. Cheia, inserir() devolve false e o evento é contado como
+//  perdido, em vez de bloquear o produtor; quem consome deve olhar
+//  getPerdidos(), porque esses eventos não chegam nem a uma gravação.
+//
+//  Com a GLFW, hoje produtor e consumidor são a mesma thread: os callbacks
+//  rodam dentro do glfwPollEvents() do laço principal, que depois roda os
+//  passos de lógica. A ordem acquire/release só passa a importar com uma
+//  thread própria de entrada.
+//
+
+#ifndef InputQueue_h
+#define InputQueue_h
+
+#include <atomic>
+#include <cstddef>
+
+// Valor de tecla dos cliques no mapa, que não corresponde a nenhuma da GLFW
+#define TECLA_CLIQUE -1
+
+// Uma tecla pressionada ou solta (valores da GLFW), ou um clique numa casa
+// do mapa (tecla == TECLA_CLIQUE, com a casa em linha e coluna)
+struct EventoTecla {
+    int tecla;
+    int acao; // GLFW_PRESS, GLFW_RELEASE ou GLFW_REPEAT
+    int mods;
+    int linha, coluna;
+};
+
+template <typename T, size_t N>
+class FilaSPSC {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "o tamanho da FilaSPSC precisa ser potencia de 2");
+
+    // Os dois índices em linhas de cache separadas, para produtor e
+    // consumidor em threads diferentes não disputarem a mesma linha
+    alignas(64) std::atomic<size_t> inicio; // próximo a retirar (consumidor)
+    alignas(64) std::atomic<size_t> fim;    // próximo a inserir (produtor)
+    alignas(64) T itens[N];
+    std::atomic<long> perdidos; // só o produtor escreve
+
+public:
+    FilaSPSC() : inicio(0), fim(0), perdidos(0) {}
+
+    // Lado do produtor
+    bool inserir(const T &item) {
+        size_t f = this->fim.load(std::memory_order_relaxed);
+        if (f - this->inicio.load(std::memory_order_acquire) == N) {
+            this->perdidos.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        this->itens[f & (N - 1)] = item;
+        this->fim.store(f + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Lado do consumidor
+    bool retirar(T &item) {
+        size_t i = this->inicio.load(std::memory_order_relaxed);
+        if (i == this->fim.load(std::memory_order_acquire))
+            return false;
+        item = this->itens[i & (N - 1)];
+        this->inicio.store(i + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool vazia() const {
+        return this->inicio.load(std::memory_order_acquire) == this->fim.load(std::memory_order_acquire);
+    }
+
+    size_t tamanho() const {
+        return this->fim.load(std::memory_order_acquire) - this->inicio.load(std::memory_order_acquire);
+    }
+
+    long getPerdidos() const {
+        return this->perdidos.load(std::memory_order_relaxed);
+    }
+};
+
+#endif /* InputQueue_h */
@@ -0,0 +1,229 @@
+//
+//  InputReplay.h
+//
+//  Gravação de uma partida do ProvaGB-Tilemap para repetir exatamente a
+//  mesma sessão (--gravar / --replay). Como a lógica roda em passos fixos
+//  (GameLoop.h) e só muda com os eventos de teclado e os cliques, basta
+//  guardar o mapa inicial e cada evento com o número do passo em que foi
+//  tratado: entregue no mesmo passo, o evento produz o mesmo estado,
+//  qualquer que seja a velocidade do desenho.
+//
+//  Layout do arquivo (.pgrp, little-endian):
+//    CabecalhoReplay                      128 bytes
+//    caminho do tileset                   cab.bytesTileset bytes, sem \0
+//    células do mapa inicial              largura * altura * 2 bytes (CelulaMapa)
+//    EventoGravado x cab.numEventos       16 bytes cada
+//
+//  O cabeçalho também traz o estado no fim da gravação (EstadoReplay), que
+//  o replay compara com o que obteve.
+//
+
+#ifndef InputReplay_h
+#define InputReplay_h
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "InputQueue.h"
+#include "MapData.h"
+
+#define REPLAY_VERSAO 2
+
+// Resumo do estado do jogo, gravado no fim da sessão
+struct EstadoReplay {
+    uint32_t passos;          // passos de lógica rodados
+    uint32_t moedasColetadas;
+    uint8_t ganhou, perdeu;
+    uint8_t reservado[2];
+    int32_t linha, coluna;    // posição do personagem
+    uint64_t hashMapa;        // FNV-1a das células (tiles pisados, moedas)
+
+    bool operator==(const EstadoReplay &outro) const {
+        return this->passos == outro.passos && this->moedasColetadas == outro.moedasColetadas &&
+               this->ganhou == outro.ganhou && this->perdeu == outro.perdeu &&
+               this->linha == outro.linha && this->coluna == outro.coluna && this->hashMapa == outro.hashMapa;
+    }
+
+    bool operator!=(const EstadoReplay &outro) const {
+        return !(*this == outro);
+    }
+};
+
+struct CabecalhoReplay {
+    char magica[4];              // "PGRP"
+    uint32_t versao;             // REPLAY_VERSAO
+    uint32_t largura, altura;    // em células
+    uint32_t tileWidth, tileHeight;
+    uint32_t numTiles;
+    uint32_t bytesTileset;
+    uint32_t numEventos;
+    uint8_t reservado[60];
+    EstadoReplay final;
+};
+
+// Evento tratado no passo de lógica passo
+struct EventoGravado {
+    uint32_t passo;
+    int16_t tecla;
+    uint8_t acao;
+    uint8_t mods;           // só os 8 bits de baixo dos modificadores da GLFW
+    int32_t linha, coluna;  // casa clicada (tecla == TECLA_CLIQUE)
+};
+
+static_assert(sizeof(EstadoReplay) == 32, "estado do replay deve ter 32 bytes");
+static_assert(sizeof(CabecalhoReplay) == 128, "cabecalho do replay deve ter 128 bytes");
+static_assert(sizeof(EventoGravado) == 16, "evento gravado deve ter 16 bytes");
+
+inline uint64_t hashMapa(const MapGrid &grade) {
+    const uint8_t *p = (const uint8_t *)grade.getCelulas();
+    uint64_t h = 14695981039346656037ull;
+    for (size_t k = 0; k < grade.getMemoryBytes(); k++) {
+        h ^= p[k];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+class GravacaoEntrada {
+    MapData mapaInicial; // cópia com células próprias
+    std::vector<EventoGravado> eventos;
+    EstadoReplay final;
+    size_t proximo; // próximo evento a entregar no replay
+
+public:
+    GravacaoEntrada() {
+        memset(&this->final, 0, sizeof(this->final));
+        this->proximo = 0;
+    }
+
+    // Começa a gravar a partir do mapa como está agora
+    void iniciar(const MapData &mapa) {
+        this->mapaInicial = mapa;
+        this->eventos.clear();
+        this->proximo = 0;
+    }
+
+    void registrar(long passo, const EventoTecla &evento) {
+        EventoGravado e = {(uint32_t)passo, (int16_t)evento.tecla, (uint8_t)evento.acao, (uint8_t)evento.mods,
+                           (int32_t)evento.linha, (int32_t)evento.coluna};
+        this->eventos.push_back(e);
+    }
+
+    bool salvar(const std::string &caminho, const EstadoReplay &final, std::string &erro) {
+        this->final = final;
+
+        CabecalhoReplay cab;
+        memset(&cab, 0, sizeof(cab));
+        memcpy(cab.magica, "PGRP", 4);
+        cab.versao = REPLAY_VERSAO;
+        cab.largura = (uint32_t)this->mapaInicial.mapWidth;
+        cab.altura = (uint32_t)this->mapaInicial.mapHeight;
+        cab.tileWidth = (uint32_t)this->mapaInicial.tileWidth;
+        cab.tileHeight = (uint32_t)this->mapaInicial.tileHeight;
+        cab.numTiles = (uint32_t)this->mapaInicial.numTiles;
+        cab.bytesTileset = (uint32_t)this->mapaInicial.tilesetPath.size();
+        cab.numEventos = (uint32_t)this->eventos.size();
+        cab.final = final;
+
+        FILE *arq = fopen(caminho.c_str(), "wb");
+        if (!arq) {
+            erro = "Erro ao criar arquivo: " + caminho;
+            return false;
+        }
+        size_t bytesMapa = this->mapaInicial.grade.getMemoryBytes();
+        bool ok = fwrite(&cab, sizeof(cab), 1, arq) == 1 &&
+                  fwrite(this->mapaInicial.tilesetPath.data(), 1, cab.bytesTileset, arq) == cab.bytesTileset &&
+                  fwrite(this->mapaInicial.grade.getCelulas(), 1, bytesMapa, arq) == bytesMapa;
+        if (ok && !this->eventos.empty())
+            ok = fwrite(this->eventos.data(), sizeof(EventoGravado), this->eventos.size(), arq) == this->eventos.size();
+        ok = (fclose(arq) == 0) && ok;
+        if (!ok)
+            erro = "Erro ao gravar arquivo: " + caminho;
+        return ok;
+    }
+
+    // Lê uma gravação e devolve em mapa o mapa inicial dela
+    bool carregar(const std::string &caminho, MapData &mapa, std::string &erro) {
+        FILE *arq = fopen(caminho.c_str(), "rb");
+        if (!arq) {
+            erro = "Erro ao abrir arquivo: " + caminho;
+            return false;
+        }
+
+        long bytesArquivo = -1;
+        if (fseek(arq, 0, SEEK_END) == 0) {
+            bytesArquivo = ftell(arq);
+            rewind(arq);
+        }
+
+        CabecalhoReplay cab;
+        bool ok = fread(&cab, sizeof(cab), 1, arq) == 1 && memcmp(cab.magica, "PGRP", 4) == 0 &&
+                  cab.versao == REPLAY_VERSAO && cab.largura > 0 && cab.altura > 0 &&
+                  cab.largura <= INT32_MAX / cab.altura && cab.bytesTileset < 4096;
+        if (!ok) {
+            fclose(arq);
+            erro = caminho + ": nao e uma gravacao valida (versao " + std::to_string(REPLAY_VERSAO) + ")";
+            return false;
+        }
+
+        // Confere os tamanhos do cabeçalho com o arquivo antes de alocar: um
+        // arquivo truncado ou corrompido não pode pedir gigabytes
+        size_t nCelulas = (size_t)cab.largura * cab.altura;
+        uint64_t esperado = sizeof(cab) + (uint64_t)cab.bytesTileset + (uint64_t)nCelulas * sizeof(CelulaMapa) +
+                            (uint64_t)cab.numEventos * sizeof(EventoGravado);
+        if (bytesArquivo < 0 || (uint64_t)bytesArquivo != esperado) {
+            fclose(arq);
+            erro = caminho + ": arquivo truncado";
+            return false;
+        }
+
+        std::string tileset(cab.bytesTileset, '\0');
+        std::shared_ptr<std::vector<CelulaMapa> > celulas = std::make_shared<std::vector<CelulaMapa> >(nCelulas);
+        this->eventos.resize(cab.numEventos);
+        ok = fread(&tileset[0], 1, cab.bytesTileset, arq) == cab.bytesTileset &&
+             fread(celulas->data(), sizeof(CelulaMapa), nCelulas, arq) == nCelulas &&
+             fread(this->eventos.data(), sizeof(EventoGravado), cab.numEventos, arq) == cab.numEventos;
+        fclose(arq);
+        if (!ok) {
+            erro = caminho + ": arquivo truncado";
+            return false;
+        }
+
+        mapa.tilesetPath = tileset;
+        mapa.numTiles = (int)cab.numTiles;
+        mapa.tileWidth = (int)cab.tileWidth;
+        mapa.tileHeight = (int)cab.tileHeight;
+        mapa.mapWidth = (int)cab.largura;
+        mapa.mapHeight = (int)cab.altura;
+        mapa.grade.usarMemoriaExterna(mapa.mapWidth, mapa.mapHeight, celulas->data(), celulas);
+        this->mapaInicial = mapa;
+        this->final = cab.final;
+        this->proximo = 0;
+        return true;
+    }
+
+    // Põe na fila os eventos gravados para o passo, antes de a lógica
+    // esvaziá-la
+    template <size_t N>
+    void entregar(long passo, FilaSPSC<EventoTecla, N> &fila) {
+        while (this->proximo < this->eventos.size() && this->eventos[this->proximo].passo <= (uint32_t)passo) {
+            const EventoGravado &e = this->eventos[this->proximo++];
+            EventoTecla evento = {e.tecla, e.acao, e.mods, e.linha, e.coluna};
+            fila.inserir(evento);
+        }
+    }
+
+    const EstadoReplay &getEstadoFinal() const {
+        return this->final;
+    }
+
+    size_t getNumEventos() const {
+        return this->eventos.size();
+    }
+};
+
+#endif /* InputReplay_h */
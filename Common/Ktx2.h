@@ -0,0 +1,271 @@
+//
+//  Ktx2.h
+//
+//  Leitura e gravação de texturas KTX2 (Khronos), o contêiner que a
+//  ferramenta texc grava com os blocos BC7 ou BC3 de Common/BlockCompression.h.
+//  Não usa OpenGL: quem envia para a GPU é o CarregadorTexturas.
+//
+//  Só o que a texc gera é aceito: textura 2D, uma camada, uma face, sem
+//  supercompressão, em VK_FORMAT_BC7_UNORM_BLOCK ou VK_FORMAT_BC3_UNORM_BLOCK.
+//
+//  Layout (little-endian):
+//    CabecalhoKtx2                      80 bytes
+//    NivelKtx2 x levelCount             24 bytes cada, nível 0 = o maior
+//    descritor de formato (DFD)
+//    dados dos níveis, do menor para o maior, começando em múltiplos de 16
+//
+
+#ifndef Ktx2_h
+#define Ktx2_h
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "ArquivoMapeado.h"
+
+#define VK_FORMAT_BC3_UNORM_BLOCK 137
+#define VK_FORMAT_BC7_UNORM_BLOCK 145
+#define KTX2_ALINHAMENTO 16
+#define KTX2_MAX_NIVEIS 16
+
+static const uint8_t IDENTIFICADOR_KTX2[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+struct CabecalhoKtx2 {
+    uint8_t identificador[12];
+    uint32_t vkFormat;
+    uint32_t typeSize;                 // 1 para formatos em blocos
+    uint32_t pixelWidth, pixelHeight;
+    uint32_t pixelDepth;               // 0: textura 2D
+    uint32_t layerCount;               // 0: não é array
+    uint32_t faceCount;                // 1: não é cubemap
+    uint32_t levelCount;
+    uint32_t supercompressionScheme;   // 0: nenhuma
+    uint32_t dfdByteOffset, dfdByteLength;
+    uint32_t kvdByteOffset, kvdByteLength;
+    uint64_t sgdByteOffset, sgdByteLength;
+};
+
+struct NivelKtx2 {
+    uint64_t byteOffset; // a partir do início do arquivo
+    uint64_t byteLength;
+    uint64_t uncompressedByteLength;
+};
+
+static_assert(sizeof(CabecalhoKtx2) == 80, "cabecalho KTX2 deve ter 80 bytes");
+static_assert(sizeof(NivelKtx2) == 24, "indice de nivel KTX2 deve ter 24 bytes");
+
+// Tamanho de um nível de mipmap, mínimo 1
+inline int dimensaoNivel(int dimensao, int nivel) {
+    return std::max(1, dimensao >> nivel);
+}
+
+// KTX2 aberto e validado; os níveis são lidos direto do arquivo mapeado
+class TexturaKtx2 {
+    ArquivoMapeado arquivo;
+    const CabecalhoKtx2 *cabecalho;
+    const NivelKtx2 *niveis;
+
+public:
+    TexturaKtx2() {
+        this->cabecalho = NULL;
+        this->niveis = NULL;
+    }
+
+    bool abrir(const std::string &caminho, std::string &erro) {
+        this->cabecalho = NULL;
+        this->niveis = NULL;
+        if (!this->arquivo.abrir(caminho.c_str())) {
+            erro = "Erro ao abrir arquivo: " + caminho;
+            return false;
+        }
+
+        size_t tamanho = this->arquivo.getTamanho();
+        const CabecalhoKtx2 *cab = (const CabecalhoKtx2 *)this->arquivo.getDados();
+        if (tamanho < sizeof(CabecalhoKtx2) ||
+            memcmp(cab->identificador, IDENTIFICADOR_KTX2, sizeof(IDENTIFICADOR_KTX2)) != 0) {
+            erro = caminho + ": nao e um arquivo KTX2";
+            return false;
+        }
+        if (cab->vkFormat != VK_FORMAT_BC7_UNORM_BLOCK && cab->vkFormat != VK_FORMAT_BC3_UNORM_BLOCK) {
+            erro = caminho + ": vkFormat " + std::to_string(cab->vkFormat) + " nao suportado (use BC7 ou BC3)";
+            return false;
+        }
+        if (cab->pixelDepth > 1 || cab->layerCount > 1 || cab->faceCount != 1 || cab->supercompressionScheme != 0 ||
+            cab->pixelWidth == 0 || cab->pixelHeight == 0) {
+            erro = caminho + ": so texturas 2D simples, sem supercompressao, sao suportadas";
+            return false;
+        }
+        uint32_t nNiveis = std::max(1u, cab->levelCount);
+        if (nNiveis > KTX2_MAX_NIVEIS || tamanho < sizeof(CabecalhoKtx2) + (uint64_t)nNiveis * sizeof(NivelKtx2)) {
+            erro = caminho + ": cabecalho KTX2 corrompido";
+            return false;
+        }
+
+        const NivelKtx2 *niv = (const NivelKtx2 *)(cab + 1);
+        for (uint32_t k = 0; k < nNiveis; k++) {
+            uint64_t esperado = bytesNivel(cab->pixelWidth, cab->pixelHeight, k);
+            bool ok = niv[k].byteLength == esperado && niv[k].byteOffset <= tamanho &&
+                      niv[k].byteLength <= tamanho - niv[k].byteOffset;
+            if (!ok) {
+                erro = caminho + ": nivel " + std::to_string(k) + " do KTX2 corrompido ou truncado";
+                return false;
+            }
+        }
+
+        this->cabecalho = cab;
+        this->niveis = niv;
+        return true;
+    }
+
+    const CabecalhoKtx2 &getCabecalho() const {
+        return *this->cabecalho;
+    }
+
+    int getLargura() const {
+        return (int)this->cabecalho->pixelWidth;
+    }
+
+    int getAltura() const {
+        return (int)this->cabecalho->pixelHeight;
+    }
+
+    int getNumNiveis() const {
+        return (int)std::max(1u, this->cabecalho->levelCount);
+    }
+
+    uint32_t getVkFormat() const {
+        return this->cabecalho->vkFormat;
+    }
+
+    const uint8_t *getDadosNivel(int nivel) const {
+        return (const uint8_t *)this->arquivo.getDados() + this->niveis[nivel].byteOffset;
+    }
+
+    size_t getBytesNivel(int nivel) const {
+        return (size_t)this->niveis[nivel].byteLength;
+    }
+
+    // Soma dos níveis 0..nNiveis-1
+    size_t getBytesNiveis(int nNiveis) const {
+        size_t total = 0;
+        for (int k = 0; k < nNiveis; k++)
+            total += this->getBytesNivel(k);
+        return total;
+    }
+
+    static uint64_t bytesNivel(uint32_t largura, uint32_t altura, uint32_t nivel) {
+        uint64_t l = (uint64_t)dimensaoNivel((int)largura, (int)nivel);
+        uint64_t a = (uint64_t)dimensaoNivel((int)altura, (int)nivel);
+        return ((l + 3) / 4) * ((a + 3) / 4) * 16;
+    }
+};
+
+namespace ktx2 {
+
+inline void anexar32(std::vector<uint8_t> &v, uint32_t x) {
+    for (int b = 0; b < 4; b++)
+        v.push_back((uint8_t)(x >> (8 * b)));
+}
+
+// Descritor de formato (Khronos Data Format) mínimo para BC7 ou BC3: um
+// bloco básico, blocos de 4x4 com 16 bytes, cores lineares BT.709
+inline std::vector<uint8_t> descritorFormato(uint32_t vkFormat) {
+    const uint32_t MODELO_BC3 = 130, MODELO_BC7 = 134;
+    bool bc7 = vkFormat == VK_FORMAT_BC7_UNORM_BLOCK;
+    int nAmostras = bc7 ? 1 : 2;
+    uint32_t tamanhoBloco = 24 + 16 * (uint32_t)nAmostras;
+
+    std::vector<uint8_t> dfd;
+    anexar32(dfd, 4 + tamanhoBloco);               // dfdTotalSize
+    anexar32(dfd, 0);                              // vendorId e descriptorType: Khronos, básico
+    anexar32(dfd, 2 | (tamanhoBloco << 16));       // versão 1.3 do formato, tamanho do bloco
+    anexar32(dfd, (bc7 ? MODELO_BC7 : MODELO_BC3) | (1u << 8) | (1u << 16)); // BT.709, linear, alpha direto
+    anexar32(dfd, 3 | (3u << 8));                  // blocos de 4x4x1x1 (dimensões - 1)
+    anexar32(dfd, 16);                             // bytes por bloco no plano 0
+    anexar32(dfd, 0);
+    if (bc7) {
+        anexar32(dfd, 0 | (127u << 16) | (0u << 24)); // 128 bits, canal de dados do BC7
+        anexar32(dfd, 0);
+        anexar32(dfd, 0);
+        anexar32(dfd, 0xFFFFFFFFu);
+    } else {
+        anexar32(dfd, 0 | (63u << 16) | (15u << 24));  // alpha: bits 0..63
+        anexar32(dfd, 0);
+        anexar32(dfd, 0);
+        anexar32(dfd, 0xFFFFFFFFu);
+        anexar32(dfd, 64 | (63u << 16) | (0u << 24)); // cor: bits 64..127
+        anexar32(dfd, 0);
+        anexar32(dfd, 0);
+        anexar32(dfd, 0xFFFFFFFFu);
+    }
+    return dfd;
+}
+
+} // namespace ktx2
+
+// Grava um KTX2 com os níveis já comprimidos (niveis[0] = o maior)
+inline bool gravarKtx2(const std::string &caminho, uint32_t vkFormat, int largura, int altura,
+                       const std::vector<std::vector<uint8_t>> &niveis, std::string &erro) {
+    if (niveis.empty() || niveis.size() > KTX2_MAX_NIVEIS) {
+        erro = "numero de niveis invalido para KTX2";
+        return false;
+    }
+    for (size_t k = 0; k < niveis.size(); k++) {
+        if (niveis[k].size() != TexturaKtx2::bytesNivel((uint32_t)largura, (uint32_t)altura, (uint32_t)k)) {
+            erro = "nivel " + std::to_string(k) + " com tamanho errado para KTX2";
+            return false;
+        }
+    }
+
+    std::vector<uint8_t> dfd = ktx2::descritorFormato(vkFormat);
+
+    CabecalhoKtx2 cab;
+    memset(&cab, 0, sizeof(cab));
+    memcpy(cab.identificador, IDENTIFICADOR_KTX2, sizeof(IDENTIFICADOR_KTX2));
+    cab.vkFormat = vkFormat;
+    cab.typeSize = 1;
+    cab.pixelWidth = (uint32_t)largura;
+    cab.pixelHeight = (uint32_t)altura;
+    cab.faceCount = 1;
+    cab.levelCount = (uint32_t)niveis.size();
+    cab.dfdByteOffset = (uint32_t)(sizeof(CabecalhoKtx2) + niveis.size() * sizeof(NivelKtx2));
+    cab.dfdByteLength = (uint32_t)dfd.size();
+
+    // Os dados vão do menor nível para o maior, como pede a especificação
+    std::vector<NivelKtx2> indice(niveis.size());
+    uint64_t offset = cab.dfdByteOffset + cab.dfdByteLength;
+    for (size_t k = niveis.size(); k-- > 0;) {
+        offset = (offset + KTX2_ALINHAMENTO - 1) / KTX2_ALINHAMENTO * KTX2_ALINHAMENTO;
+        indice[k].byteOffset = offset;
+        indice[k].byteLength = niveis[k].size();
+        indice[k].uncompressedByteLength = niveis[k].size();
+        offset += niveis[k].size();
+    }
+
+    FILE *arq = fopen(caminho.c_str(), "wb");
+    if (!arq) {
+        erro = "Erro ao criar arquivo: " + caminho;
+        return false;
+    }
+
+    bool ok = fwrite(&cab, sizeof(cab), 1, arq) == 1;
+    ok = ok && fwrite(indice.data(), sizeof(NivelKtx2), indice.size(), arq) == indice.size();
+    ok = ok && fwrite(dfd.data(), 1, dfd.size(), arq) == dfd.size();
+    uint64_t escritos = cab.dfdByteOffset + cab.dfdByteLength;
+    static const char zeros[KTX2_ALINHAMENTO] = {0};
+    for (size_t k = niveis.size(); k-- > 0 && ok;) {
+        ok = fwrite(zeros, 1, (size_t)(indice[k].byteOffset - escritos), arq) == indice[k].byteOffset - escritos;
+        ok = ok && fwrite(niveis[k].data(), 1, niveis[k].size(), arq) == niveis[k].size();
+        escritos = indice[k].byteOffset + niveis[k].size();
+    }
+    ok = (fclose(arq) == 0) && ok;
+    if (!ok)
+        erro = "Erro ao gravar arquivo: " + caminho;
+    return ok;
+}
+
+#endif /* Ktx2_h */
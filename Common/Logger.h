@@ -0,0 +1,137 @@
+//
+//  Logger.h
+//
+//  Log com níveis e buffer. escreverLog() formata como printf e só guarda a
+//  mensagem se o nível estiver ligado (--log=erro|aviso|info|debug); o texto
+//  vai para um buffer em memória e só chega ao stdout quando o buffer passa
+//  de TAM_BUFFER_LOG, em descarregar() ou no fim do programa. Quem chama
+//  nunca espera pelo terminal: o cout << endl que havia no callback de
+//  teclado esvaziava o stdout a cada tecla.
+//
+//  Erros são a exceção: vão direto para o stderr, junto com o que estava no
+//  buffer, para não se perderem se o programa cair logo depois.
+//
+//  Não é thread-safe: todas as chamadas devem vir da thread principal.
+//
+
+#ifndef Logger_h
+#define Logger_h
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#define TAM_BUFFER_LOG 16384
+
+enum NivelLog {
+    LOG_ERRO = 0,
+    LOG_AVISO,
+    LOG_INFO,
+    LOG_DEBUG
+};
+
+class Logger {
+    NivelLog nivel;
+    std::string buffer;
+    long descartadas; // mensagens abaixo do nível, nem formatadas
+
+public:
+    Logger() {
+        this->nivel = LOG_INFO;
+        this->descartadas = 0;
+        this->buffer.reserve(TAM_BUFFER_LOG);
+    }
+
+    ~Logger() {
+        this->descarregar();
+    }
+
+    static Logger &padrao() {
+        static Logger l;
+        return l;
+    }
+
+    void setNivel(NivelLog nivel) {
+        this->nivel = nivel;
+    }
+
+    NivelLog getNivel() const {
+        return this->nivel;
+    }
+
+    // "erro", "aviso", "info" ou "debug"; false se o nome não é conhecido
+    bool setNivel(const char *nome) {
+        const char *nomes[] = {"erro", "aviso", "info", "debug"};
+        for (int k = 0; k < 4; k++) {
+            if (strcmp(nome, nomes[k]) == 0) {
+                this->nivel = (NivelLog)k;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool ativo(NivelLog nivel) const {
+        return nivel <= this->nivel;
+    }
+
+    long getDescartadas() const {
+        return this->descartadas;
+    }
+
+    void descartar() {
+        this->descartadas++;
+    }
+
+    void escrever(NivelLog nivel, const char *formato, va_list args) {
+        if (!this->ativo(nivel)) {
+            this->descartadas++;
+            return;
+        }
+
+        char linha[1024];
+        int n = vsnprintf(linha, sizeof(linha), formato, args);
+        if (n < 0)
+            return;
+        n = n < (int)sizeof(linha) ? n : (int)sizeof(linha) - 1;
+
+        if (nivel == LOG_ERRO) {
+            this->descarregar();
+            fwrite(linha, 1, n, stderr);
+            fputc('\n', stderr);
+            fflush(stderr);
+            return;
+        }
+
+        this->buffer.append(linha, n);
+        this->buffer.push_back('\n');
+        if (this->buffer.size() >= TAM_BUFFER_LOG)
+            this->descarregar();
+    }
+
+    void descarregar() {
+        if (this->buffer.empty())
+            return;
+        fwrite(this->buffer.data(), 1, this->buffer.size(), stdout);
+        fflush(stdout);
+        this->buffer.clear();
+    }
+};
+
+#if defined(__GNUC__)
+__attribute__((format(printf, 2, 3)))
+#endif
+inline void escreverLog(NivelLog nivel, const char *formato, ...) {
+    Logger &l = Logger::padrao();
+    if (!l.ativo(nivel)) {
+        l.descartar();
+        return;
+    }
+    va_list args;
+    va_start(args, formato);
+    l.escrever(nivel, formato, args);
+    va_end(args);
+}
+
+#endif /* Logger_h */
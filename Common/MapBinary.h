@@ -0,0 +1,196 @@
+//
+//  MapBinary.h
+//
+//  Formato binário de mapa (.tmapb), gerado offline pela ferramenta mapc a
+//  partir de .txt / .tmap / .tmx. O arquivo é mapeado em memória e as camadas
+//  são usadas no lugar, sem nenhuma conversão na carga.
+//
+//  Layout (little-endian):
+//    CabecalhoTmapb                     128 bytes
+//    DescritorCamada x numCamadas        64 bytes cada
+//    dados de cada camada, em ordem de linha (linha 0 = topo do arquivo
+//    de origem), começando em múltiplos de TMAPB_ALINHAMENTO
+//
+//  Cada célula de uma camada ocupa 1 (uint8) ou 2 (uint16) bytes. Nas camadas
+//  de índices de tile o maior valor (TMAPB_SEM_TILE8/16) indica célula vazia.
+//
+
+#ifndef MapBinary_h
+#define MapBinary_h
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "ArquivoMapeado.h"
+
+#define TMAPB_VERSAO 1
+#define TMAPB_ALINHAMENTO 64
+#define TMAPB_SEM_TILE8 0xFF
+#define TMAPB_SEM_TILE16 0xFFFF
+
+struct CabecalhoTmapb {
+    char magica[4];                 // "TMPB"
+    uint32_t versao;                // TMAPB_VERSAO
+    uint32_t largura, altura;       // em células
+    uint32_t tileWidth, tileHeight; // em pixels, 0 se a origem não informa
+    uint32_t numTiles;              // tiles no tileset, 0 se a origem não informa
+    uint32_t numCamadas;
+    char tileset[96];               // caminho do tileset como na origem, com \0
+};
+
+struct DescritorCamada {
+    char nome[48];           // com \0
+    uint32_t bytesPorCelula; // 1 ou 2
+    uint32_t reservado;
+    uint64_t offset;         // a partir do início do arquivo
+};
+
+static_assert(sizeof(CabecalhoTmapb) == 128, "cabecalho .tmapb deve ter 128 bytes");
+static_assert(sizeof(DescritorCamada) == 64, "descritor de camada .tmapb deve ter 64 bytes");
+
+// Camada a gravar: largura * altura células de bytesPorCelula bytes
+struct CamadaTmapb {
+    std::string nome;
+    int bytesPorCelula;
+    const void *dados;
+};
+
+// .tmapb aberto para uso no lugar. Com copiaNaEscrita as camadas podem ser
+// alteradas em memória (ex.: moedas coletadas) sem mexer no arquivo
+class MapaBinario {
+    ArquivoMapeado arquivo;
+    const CabecalhoTmapb *cabecalho;
+    const DescritorCamada *camadas;
+
+public:
+    MapaBinario() {
+        this->cabecalho = NULL;
+        this->camadas = NULL;
+    }
+
+    bool abrir(const std::string &caminho, std::string &erro, bool copiaNaEscrita = false) {
+        this->cabecalho = NULL;
+        this->camadas = NULL;
+        if (!this->arquivo.abrir(caminho.c_str(), copiaNaEscrita)) {
+            erro = "Erro ao abrir arquivo: " + caminho;
+            return false;
+        }
+
+        size_t tamanho = this->arquivo.getTamanho();
+        const CabecalhoTmapb *cab = (const CabecalhoTmapb *)this->arquivo.getDados();
+        if (tamanho < sizeof(CabecalhoTmapb) || memcmp(cab->magica, "TMPB", 4) != 0) {
+            erro = caminho + ": nao e um arquivo .tmapb";
+            return false;
+        }
+        if (cab->versao != TMAPB_VERSAO) {
+            erro = caminho + ": versao " + std::to_string(cab->versao) + " do .tmapb nao suportada (esperada " +
+                   std::to_string(TMAPB_VERSAO) + ")";
+            return false;
+        }
+        if (cab->tileset[sizeof(cab->tileset) - 1] != '\0' ||
+            tamanho < sizeof(CabecalhoTmapb) + (uint64_t)cab->numCamadas * sizeof(DescritorCamada)) {
+            erro = caminho + ": cabecalho .tmapb corrompido";
+            return false;
+        }
+
+        const DescritorCamada *desc = (const DescritorCamada *)(cab + 1);
+        uint64_t nCelulas = (uint64_t)cab->largura * cab->altura;
+        for (uint32_t k = 0; k < cab->numCamadas; k++) {
+            bool ok = (desc[k].bytesPorCelula == 1 || desc[k].bytesPorCelula == 2) &&
+                      desc[k].nome[sizeof(desc[k].nome) - 1] == '\0' && desc[k].offset <= tamanho &&
+                      nCelulas * desc[k].bytesPorCelula <= tamanho - desc[k].offset;
+            if (!ok) {
+                erro = caminho + ": camada " + std::to_string(k) + " do .tmapb corrompida ou truncada";
+                return false;
+            }
+        }
+
+        this->cabecalho = cab;
+        this->camadas = desc;
+        return true;
+    }
+
+    const CabecalhoTmapb &getCabecalho() const {
+        return *this->cabecalho;
+    }
+
+    int getNumCamadas() const {
+        return (int)this->cabecalho->numCamadas;
+    }
+
+    const DescritorCamada &getDescritor(int camada) const {
+        return this->camadas[camada];
+    }
+
+    // Índice da camada com esse nome, ou -1
+    int buscarCamada(const char *nome) const {
+        for (int k = 0; k < getNumCamadas(); k++)
+            if (strcmp(this->camadas[k].nome, nome) == 0)
+                return k;
+        return -1;
+    }
+
+    // Ponteiro para as células da camada dentro do arquivo mapeado
+    void *getDadosCamada(int camada) {
+        return this->arquivo.getDados() + this->camadas[camada].offset;
+    }
+
+    const void *getDadosCamada(int camada) const {
+        return this->arquivo.getDados() + this->camadas[camada].offset;
+    }
+};
+
+// Grava um .tmapb. Os campos magica, versao e numCamadas de base são
+// preenchidos aqui; o resto vem de quem chama
+inline bool gravarMapaBinario(const std::string &caminho, const CabecalhoTmapb &base,
+                              const std::vector<CamadaTmapb> &camadas, std::string &erro) {
+    CabecalhoTmapb cab = base;
+    memcpy(cab.magica, "TMPB", 4);
+    cab.versao = TMAPB_VERSAO;
+    cab.numCamadas = (uint32_t)camadas.size();
+    cab.tileset[sizeof(cab.tileset) - 1] = '\0';
+
+    size_t nCelulas = (size_t)cab.largura * cab.altura;
+    std::vector<DescritorCamada> desc(camadas.size());
+    uint64_t offset = sizeof(CabecalhoTmapb) + camadas.size() * sizeof(DescritorCamada);
+    for (size_t k = 0; k < camadas.size(); k++) {
+        if (camadas[k].nome.size() >= sizeof(desc[k].nome) ||
+            (camadas[k].bytesPorCelula != 1 && camadas[k].bytesPorCelula != 2)) {
+            erro = "camada invalida para .tmapb: " + camadas[k].nome;
+            return false;
+        }
+        memset(&desc[k], 0, sizeof(DescritorCamada));
+        memcpy(desc[k].nome, camadas[k].nome.c_str(), camadas[k].nome.size());
+        desc[k].bytesPorCelula = (uint32_t)camadas[k].bytesPorCelula;
+        offset = (offset + TMAPB_ALINHAMENTO - 1) / TMAPB_ALINHAMENTO * TMAPB_ALINHAMENTO;
+        desc[k].offset = offset;
+        offset += nCelulas * camadas[k].bytesPorCelula;
+    }
+
+    FILE *arq = fopen(caminho.c_str(), "wb");
+    if (!arq) {
+        erro = "Erro ao criar arquivo: " + caminho;
+        return false;
+    }
+
+    bool ok = fwrite(&cab, sizeof(cab), 1, arq) == 1;
+    if (!desc.empty())
+        ok = ok && fwrite(desc.data(), sizeof(DescritorCamada), desc.size(), arq) == desc.size();
+    uint64_t escritos = sizeof(CabecalhoTmapb) + desc.size() * sizeof(DescritorCamada);
+    static const char zeros[TMAPB_ALINHAMENTO] = {0};
+    for (size_t k = 0; k < camadas.size() && ok; k++) {
+        ok = fwrite(zeros, 1, (size_t)(desc[k].offset - escritos), arq) == desc[k].offset - escritos;
+        size_t bytes = nCelulas * camadas[k].bytesPorCelula;
+        ok = ok && fwrite(camadas[k].dados, 1, bytes, arq) == bytes;
+        escritos = desc[k].offset + bytes;
+    }
+    ok = (fclose(arq) == 0) && ok;
+    if (!ok)
+        erro = "Erro ao gravar arquivo: " + caminho;
+    return ok;
+}
+
+#endif /* MapBinary_h */
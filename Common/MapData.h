@@ -0,0 +1,135 @@
+//
+//  MapData.h
+//
+//  Mapa do jogo isométrico (ProvaGB-Tilemap) em memória contígua: uma única
+//  grade em ordem de linha, com as camadas de tile e de item intercaladas
+//  célula a célula (2 bytes por célula), no lugar de um vector por linha e
+//  por camada.
+//
+//  A grade pode ser dona das células (mapas lidos de texto ou gerados) ou
+//  usar memória de fora, como a camada de um .tmapb mapeado (MapBinary.h).
+//
+
+#ifndef MapData_h
+#define MapData_h
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Valor de tile que não corresponde a nenhum tipo conhecido
+#define TILE_INVALIDO 255
+
+// Valores da camada de itens
+#define ITEM_VAZIO 0
+#define ITEM_MOEDA 1
+
+struct CelulaMapa {
+    uint8_t tile;
+    uint8_t item;
+};
+
+class MapGrid {
+    int width, height;              // dimensões da matriz
+    std::vector<CelulaMapa> celulas; // células próprias, linha a linha
+    CelulaMapa *dados;              // celulas.data() ou a memória externa
+    std::shared_ptr<void> dono;     // mantém a memória externa viva
+
+public:
+    MapGrid() {
+        this->width = 0;
+        this->height = 0;
+        this->dados = NULL;
+    }
+
+    // Uma cópia sempre tem células próprias, mesmo que a original seja externa
+    MapGrid(const MapGrid &outra) {
+        this->dados = NULL;
+        *this = outra;
+    }
+
+    MapGrid &operator=(const MapGrid &outra) {
+        if (this != &outra) {
+            this->width = outra.width;
+            this->height = outra.height;
+            this->celulas.assign(outra.dados, outra.dados + (size_t)outra.width * outra.height);
+            this->dados = this->celulas.data();
+            this->dono.reset();
+        }
+        return *this;
+    }
+
+    void resize(int w, int h) {
+        this->width = w;
+        this->height = h;
+        CelulaMapa vazia = {0, ITEM_VAZIO};
+        this->celulas.assign((size_t)w * h, vazia);
+        this->dados = this->celulas.data();
+        this->dono.reset();
+    }
+
+    // Passa a usar w * h células em memória de outro objeto, sem copiar.
+    // dono é guardado só para que a memória não seja liberada antes da grade
+    void usarMemoriaExterna(int w, int h, CelulaMapa *memoria, std::shared_ptr<void> dono) {
+        this->width = w;
+        this->height = h;
+        this->celulas.clear();
+        this->celulas.shrink_to_fit();
+        this->dados = memoria;
+        this->dono = dono;
+    }
+
+    int getWidth() const {
+        return this->width;
+    }
+
+    int getHeight() const {
+        return this->height;
+    }
+
+    // Acesso por (linha, coluna), a mesma ordem de mapa.tiles[i][j]
+    uint8_t getTile(int row, int col) const {
+        return this->dados[(size_t)row * this->width + col].tile;
+    }
+
+    void setTile(int row, int col, uint8_t tile) {
+        this->dados[(size_t)row * this->width + col].tile = tile;
+    }
+
+    uint8_t getItem(int row, int col) const {
+        return this->dados[(size_t)row * this->width + col].item;
+    }
+
+    void setItem(int row, int col, uint8_t item) {
+        this->dados[(size_t)row * this->width + col].item = item;
+    }
+
+    CelulaMapa* getCelulas() {
+        return this->dados;
+    }
+
+    const CelulaMapa* getCelulas() const {
+        return this->dados;
+    }
+
+    // Ponteiro para o início da linha, para percorrer a linha sequencialmente
+    const CelulaMapa* getLinha(int row) const {
+        return this->dados + (size_t)row * this->width;
+    }
+
+    size_t getMemoryBytes() const {
+        return (size_t)this->width * this->height * sizeof(CelulaMapa);
+    }
+};
+
+struct MapData {
+    std::string tilesetPath;
+    int numTiles;
+    int tileWidth, tileHeight;
+    int mapWidth, mapHeight;
+    MapGrid grade; // tile: 0=terra, 1=lava, 2=rosa; item: 0=vazio, 1=moeda
+};
+
+#endif /* MapData_h */
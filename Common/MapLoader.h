@@ -0,0 +1,257 @@
+//
+//  MapLoader.h
+//
+//  Leitura do map.txt do jogo isométrico sem ifstream: o arquivo é mapeado
+//  em memória e os inteiros são lidos por um scanner próprio que escreve
+//  direto na MapGrid. Em caso de erro informa linha e coluna do arquivo.
+//
+//  Também lê e grava a versão compilada do mapa (.tmapb, ver MapBinary.h),
+//  cuja camada "celulas" já tem o layout da MapGrid e é usada no lugar.
+//
+//  Formato (ver README):
+//    nome do tileset
+//    numTiles tileWidth tileHeight
+//    mapWidth mapHeight
+//    mapHeight linhas de mapWidth índices de tile (índices do PNG)
+//    mapHeight linhas de mapWidth itens (0 = vazio, 1 = moeda)
+//
+
+#ifndef MapLoader_h
+#define MapLoader_h
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "ArquivoMapeado.h"
+#include "MapBinary.h"
+#include "MapData.h"
+
+#define PASTA_TILESETS "assets/tilesets/"
+
+// Scanner de inteiros sobre um buffer; conta linhas para as mensagens de erro
+class LeitorInteiros {
+    const char *p, *fim;
+    const char *inicioLinha;
+    int linha;
+
+public:
+    LeitorInteiros(const char *inicio, const char *fim) {
+        this->p = inicio;
+        this->fim = fim;
+        this->inicioLinha = inicio;
+        this->linha = 1;
+    }
+
+    // Lê até o fim da linha atual (sem o \r\n)
+    std::string lerLinha() {
+        const char *ini = this->p;
+        while (this->p < this->fim && *this->p != '\n')
+            this->p++;
+        const char *f = this->p;
+        if (f > ini && f[-1] == '\r')
+            f--;
+        if (this->p < this->fim)
+            proximaLinha();
+        return std::string(ini, f);
+    }
+
+    bool lerInt(int &valor) {
+        pularEspacos();
+        if (this->p == this->fim)
+            return false;
+
+        bool negativo = *this->p == '-';
+        this->p += negativo;
+
+        // (unsigned)(c - '0') <= 9 testa o dígito com uma só comparação
+        const char *inicioNumero = this->p;
+        unsigned v = 0;
+        while (this->p < this->fim && (unsigned)(*this->p - '0') <= 9u)
+            v = v * 10u + (unsigned)(*this->p++ - '0');
+
+        if (this->p == inicioNumero)
+            return false;
+        // O número tem que terminar num separador
+        if (this->p < this->fim && !ehEspaco(*this->p))
+            return false;
+
+        valor = negativo ? -(int)v : (int)v;
+        return true;
+    }
+
+    int getLinha() const {
+        return this->linha;
+    }
+
+    int getColuna() const {
+        return (int)(this->p - this->inicioLinha) + 1;
+    }
+
+    bool noFim() const {
+        return this->p == this->fim;
+    }
+
+    // Descrição do ponto atual para mensagens de erro
+    std::string descreverPosicao() const {
+        std::string s = std::to_string(getLinha()) + ":" + std::to_string(getColuna());
+        if (this->p == this->fim)
+            return s + " (fim do arquivo)";
+        return s + " (encontrado '" + std::string(1, *this->p) + "')";
+    }
+
+private:
+    static bool ehEspaco(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    void proximaLinha() {
+        this->p++;
+        this->linha++;
+        this->inicioLinha = this->p;
+    }
+
+    void pularEspacos() {
+        while (this->p < this->fim && ehEspaco(*this->p)) {
+            if (*this->p == '\n')
+                proximaLinha();
+            else
+                this->p++;
+        }
+    }
+};
+
+// Carrega o map.txt em mapData. Os índices de tile do PNG são convertidos
+// para os tipos do jogo (2 = terra, 4 = lava, 6 = rosa, resto inválido) e os
+// itens diferentes de 1 viram vazio, como no carregamento original
+inline bool carregarMapaTexto(const std::string &caminho, MapData &mapData, std::string &erro) {
+    ArquivoMapeado arquivo;
+    if (!arquivo.abrir(caminho.c_str())) {
+        erro = "Erro ao abrir arquivo: " + caminho;
+        return false;
+    }
+
+    LeitorInteiros leitor(arquivo.getDados(), arquivo.getDados() + arquivo.getTamanho());
+    mapData.tilesetPath = PASTA_TILESETS + leitor.lerLinha();
+
+    int cabecalho[5];
+    const char *nomes[5] = {"numTiles", "tileWidth", "tileHeight", "mapWidth", "mapHeight"};
+    for (int k = 0; k < 5; k++) {
+        if (!leitor.lerInt(cabecalho[k])) {
+            erro = caminho + ":" + leitor.descreverPosicao() + ": esperado inteiro para " + nomes[k];
+            return false;
+        }
+    }
+    mapData.numTiles = cabecalho[0];
+    mapData.tileWidth = cabecalho[1];
+    mapData.tileHeight = cabecalho[2];
+    mapData.mapWidth = cabecalho[3];
+    mapData.mapHeight = cabecalho[4];
+
+    if (mapData.mapWidth <= 0 || mapData.mapHeight <= 0) {
+        erro = caminho + ": dimensoes do mapa invalidas";
+        return false;
+    }
+
+    mapData.grade.resize(mapData.mapWidth, mapData.mapHeight);
+
+    // Tabela de conversão índice do PNG -> tipo do jogo, sem ramos no laço
+    uint8_t tipoTile[256];
+    for (int k = 0; k < 256; k++)
+        tipoTile[k] = TILE_INVALIDO;
+    tipoTile[2] = 0; // Terra
+    tipoTile[4] = 1; // Lava
+    tipoTile[6] = 2; // Rosa
+
+    CelulaMapa *celula = mapData.grade.getCelulas();
+    size_t nCelulas = (size_t)mapData.mapWidth * mapData.mapHeight;
+
+    for (size_t k = 0; k < nCelulas; k++) {
+        int valor;
+        if (!leitor.lerInt(valor)) {
+            erro = caminho + ":" + leitor.descreverPosicao() + ": esperado indice de tile";
+            return false;
+        }
+        celula[k].tile = (unsigned)valor <= 255u ? tipoTile[valor] : TILE_INVALIDO;
+    }
+
+    // Se o arquivo acabar antes da camada de itens estar completa, o resto
+    // fica vazio (o ifstream antigo aceitava isso e o map.txt do jogo tem uma
+    // linha de itens a menos); qualquer outro conteúdo inválido é erro
+    for (size_t k = 0; k < nCelulas; k++) {
+        int valor;
+        if (!leitor.lerInt(valor)) {
+            if (leitor.noFim())
+                break;
+            erro = caminho + ":" + leitor.descreverPosicao() + ": esperado item";
+            return false;
+        }
+        celula[k].item = valor == 1 ? ITEM_MOEDA : ITEM_VAZIO;
+    }
+
+    return true;
+}
+
+// Grava mapData como .tmapb com uma camada "celulas" de 2 bytes por célula
+// (tile no primeiro byte, item no segundo, igual a CelulaMapa)
+inline bool salvarMapaBinario(const std::string &caminho, const MapData &mapData, std::string &erro) {
+    static_assert(sizeof(CelulaMapa) == 2, "CelulaMapa deve ocupar 2 bytes");
+
+    CabecalhoTmapb cab;
+    memset(&cab, 0, sizeof(cab));
+    cab.largura = (uint32_t)mapData.mapWidth;
+    cab.altura = (uint32_t)mapData.mapHeight;
+    cab.tileWidth = (uint32_t)mapData.tileWidth;
+    cab.tileHeight = (uint32_t)mapData.tileHeight;
+    cab.numTiles = (uint32_t)mapData.numTiles;
+
+    // O .tmapb guarda o nome do tileset como no map.txt, sem a pasta
+    std::string tileset = mapData.tilesetPath;
+    if (tileset.compare(0, strlen(PASTA_TILESETS), PASTA_TILESETS) == 0)
+        tileset = tileset.substr(strlen(PASTA_TILESETS));
+    if (tileset.size() >= sizeof(cab.tileset)) {
+        erro = "nome do tileset longo demais para .tmapb: " + tileset;
+        return false;
+    }
+    memcpy(cab.tileset, tileset.c_str(), tileset.size());
+
+    std::vector<CamadaTmapb> camadas(1);
+    camadas[0].nome = "celulas";
+    camadas[0].bytesPorCelula = 2;
+    camadas[0].dados = mapData.grade.getCelulas();
+    return gravarMapaBinario(caminho, cab, camadas, erro);
+}
+
+// Carrega um .tmapb gerado por salvarMapaBinario. A grade passa a apontar
+// para a camada dentro do arquivo mapeado (cópia na escrita, para que o jogo
+// possa alterar tiles e itens), então o custo não depende do tamanho do mapa
+inline bool carregarMapaBinario(const std::string &caminho, MapData &mapData, std::string &erro) {
+    std::shared_ptr<MapaBinario> arquivo = std::make_shared<MapaBinario>();
+    if (!arquivo->abrir(caminho, erro, true))
+        return false;
+
+    int camada = arquivo->buscarCamada("celulas");
+    if (camada < 0 || arquivo->getDescritor(camada).bytesPorCelula != sizeof(CelulaMapa)) {
+        erro = caminho + ": .tmapb sem camada \"celulas\" de 2 bytes (gere com mapc a partir de um map.txt)";
+        return false;
+    }
+
+    const CabecalhoTmapb &cab = arquivo->getCabecalho();
+    if (cab.largura == 0 || cab.altura == 0 || cab.largura > INT32_MAX / cab.altura) {
+        erro = caminho + ": dimensoes do mapa invalidas";
+        return false;
+    }
+    mapData.tilesetPath = PASTA_TILESETS + std::string(cab.tileset);
+    mapData.numTiles = (int)cab.numTiles;
+    mapData.tileWidth = (int)cab.tileWidth;
+    mapData.tileHeight = (int)cab.tileHeight;
+    mapData.mapWidth = (int)cab.largura;
+    mapData.mapHeight = (int)cab.altura;
+    mapData.grade.usarMemoriaExterna(mapData.mapWidth, mapData.mapHeight,
+                                     (CelulaMapa *)arquivo->getDadosCamada(camada), arquivo);
+    return true;
+}
+
+#endif /* MapLoader_h */
@@ -0,0 +1,235 @@
+//
+//  PathQueue.h
+//
+//  Fila de pedidos de caminho atendida por um grupo de threads, para muitos
+//  agentes pedirem caminho sem o frame esperar pelas buscas. O laço
+//  principal põe os pedidos com pedir() e, a cada frame, recolhe com
+//  coletar() os que ficaram prontos; coletar() nunca espera: se uma thread
+//  estiver entregando resultados naquele instante, ele volta vazio e os
+//  resultados vêm no frame seguinte.
+//
+//  Cada thread tem o seu Pathfinder (os vetores por nó do mapa e o heap) e
+//  os seus buffers de resposta, reaproveitados entre as buscas, então as
+//  threads não alocam nem disputam memória depois de aquecidas. As threads
+//  pegam os pedidos em lotes de TAM_LOTE_CAMINHOS e entregam o lote inteiro
+//  de uma vez, para tocar nos mutexes poucas vezes.
+//
+//  As casas de todos os caminhos de uma entrega ficam num só vetor
+//  (LoteRespostas::pontos) e cada resposta aponta o seu trecho, em vez de
+//  um vector por caminho.
+//
+//  As threads leem a grade e a tabela de custos sem lock: quem chama não
+//  pode alterá-las com pedidos pendentes (aguardar() espera todos).
+//
+
+#ifndef PathQueue_h
+#define PathQueue_h
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "Pathfinding.h"
+
+#define TAM_LOTE_CAMINHOS 8
+
+struct PedidoCaminho {
+    unsigned int id; // do agente, devolvido na resposta
+    PontoGrade origem, destino;
+};
+
+struct RespostaCaminho {
+    unsigned int id;
+    bool achou;
+    unsigned int inicio, tamanho; // trecho de LoteRespostas::pontos
+    long nosExpandidos;
+};
+
+struct LoteRespostas {
+    std::vector<RespostaCaminho> respostas;
+    std::vector<PontoGrade> pontos;
+
+    void limpar() {
+        this->respostas.clear();
+        this->pontos.clear();
+    }
+
+    // Acrescenta as respostas de outro lote, corrigindo os trechos
+    void acrescentar(const LoteRespostas &outro) {
+        unsigned int base = (unsigned int)this->pontos.size();
+        for (size_t k = 0; k < outro.respostas.size(); k++) {
+            this->respostas.push_back(outro.respostas[k]);
+            this->respostas.back().inicio += base;
+        }
+        this->pontos.insert(this->pontos.end(), outro.pontos.begin(), outro.pontos.end());
+    }
+};
+
+class FilaCaminhos {
+    const MapGrid *grade;
+    const float *custos;
+    bool usarJPS;
+    std::vector<std::thread> threads;
+
+    std::mutex mtxPedidos;
+    std::condition_variable cvPedidos; // há pedido ou é para parar
+    std::condition_variable cvOcioso;  // pendentes chegou a 0
+    std::deque<PedidoCaminho> pedidos;
+    long pendentes; // pedidos ainda não entregues
+    bool parar;
+
+    std::mutex mtxProntas;
+    LoteRespostas prontas;
+
+public:
+    FilaCaminhos() {
+        this->grade = NULL;
+        this->custos = NULL;
+        this->usarJPS = false;
+        this->pendentes = 0;
+        this->parar = false;
+    }
+
+    ~FilaCaminhos() {
+        this->encerrar();
+    }
+
+    // Sobe nThreads threads (<= 0: uma por núcleo) para buscar na grade. Com
+    // usarJPS as buscas usam o JPS, que só vale com custo uniforme
+    bool iniciar(const MapGrid &grade, const float custos[256], int nThreads, bool usarJPS, std::string &erro) {
+        if (!this->threads.empty()) {
+            erro = "FilaCaminhos ja iniciada";
+            return false;
+        }
+        if (nThreads <= 0)
+            nThreads = (int)std::thread::hardware_concurrency();
+        if (nThreads <= 0)
+            nThreads = 1;
+
+        this->grade = &grade;
+        this->custos = custos;
+        this->usarJPS = usarJPS;
+        this->parar = false;
+        this->pendentes = 0;
+        try {
+            for (int t = 0; t < nThreads; t++)
+                this->threads.push_back(std::thread(&FilaCaminhos::trabalhar, this));
+        } catch (const std::system_error &e) {
+            erro = std::string("Erro ao criar threads de busca: ") + e.what();
+            this->encerrar();
+            return false;
+        }
+        return true;
+    }
+
+    // Para as threads depois de atender os pedidos já feitos
+    void encerrar() {
+        {
+            std::lock_guard<std::mutex> trava(this->mtxPedidos);
+            this->parar = true;
+        }
+        this->cvPedidos.notify_all();
+        for (size_t t = 0; t < this->threads.size(); t++)
+            this->threads[t].join();
+        this->threads.clear();
+    }
+
+    void pedir(const PedidoCaminho &pedido) {
+        {
+            std::lock_guard<std::mutex> trava(this->mtxPedidos);
+            this->pedidos.push_back(pedido);
+            this->pendentes++;
+        }
+        this->cvPedidos.notify_one();
+    }
+
+    void pedir(const std::vector<PedidoCaminho> &lote) {
+        {
+            std::lock_guard<std::mutex> trava(this->mtxPedidos);
+            this->pedidos.insert(this->pedidos.end(), lote.begin(), lote.end());
+            this->pendentes += (long)lote.size();
+        }
+        this->cvPedidos.notify_all();
+    }
+
+    // Troca lote pelas respostas prontas (lote é limpo antes; a troca
+    // devolve os buffers dele para as threads, sem alocar). Não espera:
+    // devolve 0 se o buffer estiver ocupado
+    size_t coletar(LoteRespostas &lote) {
+        lote.limpar();
+        std::unique_lock<std::mutex> trava(this->mtxProntas, std::try_to_lock);
+        if (!trava.owns_lock())
+            return 0;
+        std::swap(lote.respostas, this->prontas.respostas);
+        std::swap(lote.pontos, this->prontas.pontos);
+        return lote.respostas.size();
+    }
+
+    // Espera até todos os pedidos feitos estarem em coletar()
+    void aguardar() {
+        std::unique_lock<std::mutex> trava(this->mtxPedidos);
+        this->cvOcioso.wait(trava, [this] { return this->pendentes == 0; });
+    }
+
+    long getPendentes() {
+        std::lock_guard<std::mutex> trava(this->mtxPedidos);
+        return this->pendentes;
+    }
+
+    int getNumThreads() const {
+        return (int)this->threads.size();
+    }
+
+private:
+    void trabalhar() {
+        Pathfinder pathfinder;
+        std::vector<PontoGrade> caminho;
+        LoteRespostas feitas;
+        PedidoCaminho lote[TAM_LOTE_CAMINHOS];
+
+        for (;;) {
+            int n = 0;
+            {
+                std::unique_lock<std::mutex> trava(this->mtxPedidos);
+                this->cvPedidos.wait(trava, [this] { return this->parar || !this->pedidos.empty(); });
+                if (this->pedidos.empty())
+                    return;
+                while (n < TAM_LOTE_CAMINHOS && !this->pedidos.empty()) {
+                    lote[n++] = this->pedidos.front();
+                    this->pedidos.pop_front();
+                }
+            }
+
+            feitas.limpar();
+            for (int k = 0; k < n; k++) {
+                bool achou = this->usarJPS
+                                 ? pathfinder.buscarJPS(*this->grade, this->custos, lote[k].origem, lote[k].destino, caminho)
+                                 : pathfinder.buscarAEstrela(*this->grade, this->custos, lote[k].origem, lote[k].destino, caminho);
+                RespostaCaminho r = {lote[k].id, achou, (unsigned int)feitas.pontos.size(), 0,
+                                     pathfinder.getEstatisticas().nosExpandidos};
+                if (achou) {
+                    r.tamanho = (unsigned int)caminho.size();
+                    feitas.pontos.insert(feitas.pontos.end(), caminho.begin(), caminho.end());
+                }
+                feitas.respostas.push_back(r);
+            }
+
+            {
+                std::lock_guard<std::mutex> trava(this->mtxProntas);
+                this->prontas.acrescentar(feitas);
+            }
+            {
+                std::lock_guard<std::mutex> trava(this->mtxPedidos);
+                this->pendentes -= n;
+                if (this->pendentes == 0)
+                    this->cvOcioso.notify_all();
+            }
+        }
+    }
+};
+
+#endif /* PathQueue_h */
@@ -0,0 +1,364 @@
+//
+//  Pathfinding.h
+//
+//  Busca de caminhos na MapGrid do jogo isométrico, com os 8 movimentos do
+//  teclado (W/A/S/D e as diagonais Q/E/Z/X). Cada tipo de tile tem um custo
+//  de entrada (custos[tile], < 0 = intransponível, como a lava, que é letal);
+//  o passo diagonal custa sqrt(2) vezes o reto. Como no jogo, a diagonal é
+//  permitida mesmo com as duas casas retas ao lado bloqueadas.
+//
+//  buscarAEstrela() é o A* com heurística octil. buscarJPS() é o jump point
+//  search: em vez de pôr na lista aberta cada vizinho, segue em linha reta
+//  ou diagonal até um ponto de salto (o destino ou uma casa com vizinho
+//  forçado por um obstáculo), o que corta a maior parte dos nós em áreas
+//  abertas. O JPS só é ótimo com custo uniforme: ele usa os custos apenas
+//  para saber o que é passável e considera todo tile passável com custo 1.
+//
+//  A lista aberta é um heap binário (std::push_heap/pop_heap) com remoção
+//  preguiçosa: um nó melhorado entra de novo e a entrada velha é ignorada
+//  ao sair. Os vetores por nó são alocados uma vez por tamanho de mapa e
+//  reaproveitados entre buscas; um contador de geração marca o que vale
+//  para a busca atual, sem limpar os vetores a cada consulta.
+//
+//  Um Pathfinder não pode ser usado por duas threads ao mesmo tempo.
+//
+
+#ifndef Pathfinding_h
+#define Pathfinding_h
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "MapData.h"
+
+#define CUSTO_DIAGONAL 1.41421356f
+
+struct PontoGrade {
+    int linha, coluna;
+};
+
+// Resultado da última busca
+struct EstatisticasBusca {
+    long nosExpandidos; // nós retirados da lista aberta
+    long nosAbertos;    // entradas postas no heap
+    float custo;        // custo do caminho encontrado, ou -1
+};
+
+class Pathfinder {
+    struct NoAberto {
+        float f;
+        int32_t no;
+        bool operator>(const NoAberto &outro) const {
+            return this->f > outro.f;
+        }
+    };
+
+    int largura, altura;
+    std::vector<float> g;
+    std::vector<int32_t> pai;
+    std::vector<uint32_t> marca; // geracao * 2 (visto) ou geracao * 2 + 1 (fechado)
+    std::vector<NoAberto> heap;
+    uint32_t geracao;
+    EstatisticasBusca estatisticas;
+
+    // Da busca em andamento
+    const MapGrid *grade;
+    const float *custos;
+    float custoMinimo;
+
+public:
+    Pathfinder() {
+        this->largura = this->altura = 0;
+        this->geracao = 0;
+        this->grade = NULL;
+        this->custos = NULL;
+        this->custoMinimo = 1.0f;
+        this->estatisticas.nosExpandidos = this->estatisticas.nosAbertos = 0;
+        this->estatisticas.custo = -1.0f;
+    }
+
+    const EstatisticasBusca &getEstatisticas() const {
+        return this->estatisticas;
+    }
+
+    // caminho recebe as casas da origem ao destino, inclusive. false se o
+    // destino é inalcançável (ou uma das pontas é intransponível)
+    bool buscarAEstrela(const MapGrid &grade, const float custos[256], PontoGrade origem, PontoGrade destino,
+                        std::vector<PontoGrade> &caminho) {
+        if (!this->iniciar(grade, custos, origem, destino, caminho))
+            return false;
+
+        const int dl[8] = {-1, 1, 0, 0, -1, -1, 1, 1};
+        const int dc[8] = {0, 0, -1, 1, -1, 1, -1, 1};
+        int alvo = this->indice(destino.linha, destino.coluna);
+
+        while (!this->heap.empty()) {
+            int n = this->retirar();
+            if (n < 0)
+                continue;
+            if (n == alvo)
+                return this->reconstruir(alvo, caminho);
+
+            int l = n / this->largura, c = n % this->largura;
+            for (int k = 0; k < 8; k++) {
+                int nl = l + dl[k], nc = c + dc[k];
+                float custo = this->custoEntrada(nl, nc);
+                if (custo < 0.0f)
+                    continue;
+                this->relaxar(n, this->indice(nl, nc), this->g[n] + custo * (k < 4 ? 1.0f : CUSTO_DIAGONAL), destino);
+            }
+        }
+        return false;
+    }
+
+    bool buscarJPS(const MapGrid &grade, const float custos[256], PontoGrade origem, PontoGrade destino,
+                   std::vector<PontoGrade> &caminho) {
+        if (!this->iniciar(grade, custos, origem, destino, caminho))
+            return false;
+        this->custoMinimo = 1.0f;
+
+        int alvo = this->indice(destino.linha, destino.coluna);
+        while (!this->heap.empty()) {
+            int n = this->retirar();
+            if (n < 0)
+                continue;
+            if (n == alvo)
+                return this->reconstruir(alvo, caminho);
+
+            int l = n / this->largura, c = n % this->largura;
+            int dirs[8][2];
+            int nDirs = this->vizinhosPodados(n, l, c, dirs);
+            for (int k = 0; k < nDirs; k++) {
+                int salto = this->saltar(l, c, dirs[k][0], dirs[k][1], destino);
+                if (salto < 0)
+                    continue;
+                int sl = salto / this->largura, sc = salto % this->largura;
+                this->relaxar(n, salto, this->g[n] + octil(abs(sl - l), abs(sc - c)), destino);
+            }
+        }
+        return false;
+    }
+
+private:
+    static float octil(int dl, int dc) {
+        int menor = std::min(dl, dc), maior = std::max(dl, dc);
+        return (float)(maior - menor) + CUSTO_DIAGONAL * menor;
+    }
+
+    int indice(int l, int c) const {
+        return l * this->largura + c;
+    }
+
+    // Custo de entrar na casa, < 0 se fora do mapa ou intransponível
+    float custoEntrada(int l, int c) const {
+        if (l < 0 || c < 0 || l >= this->altura || c >= this->largura)
+            return -1.0f;
+        return this->custos[this->grade->getTile(l, c)];
+    }
+
+    bool passavel(int l, int c) const {
+        return this->custoEntrada(l, c) >= 0.0f;
+    }
+
+    bool iniciar(const MapGrid &grade, const float custos[256], PontoGrade origem, PontoGrade destino,
+                 std::vector<PontoGrade> &caminho) {
+        caminho.clear();
+        this->estatisticas.nosExpandidos = this->estatisticas.nosAbertos = 0;
+        this->estatisticas.custo = -1.0f;
+
+        if (grade.getWidth() != this->largura || grade.getHeight() != this->altura) {
+            this->largura = grade.getWidth();
+            this->altura = grade.getHeight();
+            size_t n = (size_t)this->largura * this->altura;
+            this->g.assign(n, 0.0f);
+            this->pai.assign(n, -1);
+            this->marca.assign(n, 0);
+            this->geracao = 0;
+        }
+        this->grade = &grade;
+        this->custos = custos;
+
+        // Com a heurística multiplicada pelo menor custo passável ela nunca
+        // passa do custo real, mesmo com tiles mais baratos que 1
+        this->custoMinimo = 1.0f;
+        for (int t = 0; t < 256; t++)
+            if (custos[t] >= 0.0f)
+                this->custoMinimo = std::min(this->custoMinimo, custos[t]);
+
+        if (!this->passavel(origem.linha, origem.coluna) || !this->passavel(destino.linha, destino.coluna))
+            return false;
+
+        // Geração 0 é a dos vetores recém-criados; ao dar a volta, limpa
+        if (++this->geracao >= 0x7FFFFFFF) {
+            std::fill(this->marca.begin(), this->marca.end(), 0);
+            this->geracao = 1;
+        }
+        this->heap.clear();
+
+        int n = this->indice(origem.linha, origem.coluna);
+        this->g[n] = 0.0f;
+        this->pai[n] = -1;
+        this->marca[n] = this->geracao * 2;
+        this->inserir(n, this->heuristica(n, destino));
+        return true;
+    }
+
+    float heuristica(int n, PontoGrade destino) const {
+        int l = n / this->largura, c = n % this->largura;
+        return octil(abs(l - destino.linha), abs(c - destino.coluna)) * this->custoMinimo;
+    }
+
+    void inserir(int n, float f) {
+        NoAberto a = {f, n};
+        this->heap.push_back(a);
+        std::push_heap(this->heap.begin(), this->heap.end(), std::greater<NoAberto>());
+        this->estatisticas.nosAbertos++;
+    }
+
+    // Tira o menor f; -1 se a entrada era de um nó já fechado
+    int retirar() {
+        std::pop_heap(this->heap.begin(), this->heap.end(), std::greater<NoAberto>());
+        int n = this->heap.back().no;
+        this->heap.pop_back();
+        if (this->marca[n] == this->geracao * 2 + 1)
+            return -1;
+        this->marca[n] = this->geracao * 2 + 1;
+        this->estatisticas.nosExpandidos++;
+        return n;
+    }
+
+    void relaxar(int de, int para, float g, PontoGrade destino) {
+        uint32_t m = this->marca[para];
+        if (m == this->geracao * 2 + 1)
+            return;
+        if (m == this->geracao * 2 && g >= this->g[para])
+            return;
+        this->g[para] = g;
+        this->pai[para] = de;
+        this->marca[para] = this->geracao * 2;
+        this->inserir(para, g + this->heuristica(para, destino));
+    }
+
+    // Segue pai[] do destino à origem. Entre dois pontos de salto do JPS o
+    // trecho é reto ou diagonal, e as casas do meio são preenchidas
+    bool reconstruir(int alvo, std::vector<PontoGrade> &caminho) {
+        this->estatisticas.custo = this->g[alvo];
+        for (int n = alvo; n >= 0; n = this->pai[n]) {
+            PontoGrade p = {n / this->largura, n % this->largura};
+            if (!caminho.empty()) {
+                PontoGrade ultimo = caminho.back();
+                int sl = (p.linha > ultimo.linha) - (p.linha < ultimo.linha);
+                int sc = (p.coluna > ultimo.coluna) - (p.coluna < ultimo.coluna);
+                for (PontoGrade q = {ultimo.linha + sl, ultimo.coluna + sc}; q.linha != p.linha || q.coluna != p.coluna;
+                     q.linha += sl, q.coluna += sc)
+                    caminho.push_back(q);
+            }
+            caminho.push_back(p);
+        }
+        std::reverse(caminho.begin(), caminho.end());
+        return true;
+    }
+
+    // Direções a explorar a partir de n, conforme a direção em que se chegou
+    // nele: as naturais (que seguem o movimento) e as forçadas por um
+    // obstáculo ao lado. Sem pai, as 8
+    int vizinhosPodados(int n, int l, int c, int dirs[8][2]) const {
+        int nDirs = 0;
+        int p = this->pai[n];
+        if (p < 0) {
+            for (int a = -1; a <= 1; a++)
+                for (int b = -1; b <= 1; b++)
+                    if ((a || b) && this->passavel(l + a, c + b)) {
+                        dirs[nDirs][0] = a;
+                        dirs[nDirs][1] = b;
+                        nDirs++;
+                    }
+            return nDirs;
+        }
+
+        int pl = p / this->largura, pc = p % this->largura;
+        int dl = (l > pl) - (l < pl), dc = (c > pc) - (c < pc);
+        int candidatos[5][2];
+        int nCand = 0;
+        if (dl && dc) {
+            int naturais[3][2] = {{dl, 0}, {0, dc}, {dl, dc}};
+            for (int k = 0; k < 3; k++, nCand++) {
+                candidatos[nCand][0] = naturais[k][0];
+                candidatos[nCand][1] = naturais[k][1];
+            }
+            if (!this->passavel(l, c - dc)) {
+                candidatos[nCand][0] = dl;
+                candidatos[nCand][1] = -dc;
+                nCand++;
+            }
+            if (!this->passavel(l - dl, c)) {
+                candidatos[nCand][0] = -dl;
+                candidatos[nCand][1] = dc;
+                nCand++;
+            }
+        } else if (dl) {
+            candidatos[nCand][0] = dl;
+            candidatos[nCand][1] = 0;
+            nCand++;
+            for (int lado = -1; lado <= 1; lado += 2)
+                if (!this->passavel(l, c + lado)) {
+                    candidatos[nCand][0] = dl;
+                    candidatos[nCand][1] = lado;
+                    nCand++;
+                }
+        } else {
+            candidatos[nCand][0] = 0;
+            candidatos[nCand][1] = dc;
+            nCand++;
+            for (int lado = -1; lado <= 1; lado += 2)
+                if (!this->passavel(l + lado, c)) {
+                    candidatos[nCand][0] = lado;
+                    candidatos[nCand][1] = dc;
+                    nCand++;
+                }
+        }
+
+        for (int k = 0; k < nCand; k++)
+            if (this->passavel(l + candidatos[k][0], c + candidatos[k][1])) {
+                dirs[nDirs][0] = candidatos[k][0];
+                dirs[nDirs][1] = candidatos[k][1];
+                nDirs++;
+            }
+        return nDirs;
+    }
+
+    // Anda de (l, c) na direção (dl, dc) até o destino, uma casa com vizinho
+    // forçado ou um obstáculo. Devolve o ponto de salto ou -1. Na diagonal,
+    // uma casa de onde um salto reto acha algo também é ponto de salto
+    int saltar(int l, int c, int dl, int dc, PontoGrade destino) const {
+        for (;;) {
+            l += dl;
+            c += dc;
+            if (!this->passavel(l, c))
+                return -1;
+            if (l == destino.linha && c == destino.coluna)
+                return this->indice(l, c);
+
+            if (dl && dc) {
+                if ((!this->passavel(l, c - dc) && this->passavel(l + dl, c - dc)) ||
+                    (!this->passavel(l - dl, c) && this->passavel(l - dl, c + dc)))
+                    return this->indice(l, c);
+                if (this->saltar(l, c, dl, 0, destino) >= 0 || this->saltar(l, c, 0, dc, destino) >= 0)
+                    return this->indice(l, c);
+            } else if (dl) {
+                if ((!this->passavel(l, c + 1) && this->passavel(l + dl, c + 1)) ||
+                    (!this->passavel(l, c - 1) && this->passavel(l + dl, c - 1)))
+                    return this->indice(l, c);
+            } else {
+                if ((!this->passavel(l + 1, c) && this->passavel(l + 1, c + dc)) ||
+                    (!this->passavel(l - 1, c) && this->passavel(l - 1, c + dc)))
+                    return this->indice(l, c);
+            }
+        }
+    }
+};
+
+#endif /* Pathfinding_h */
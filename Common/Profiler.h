@@ -0,0 +1,324 @@
+//
+//  Profiler.h
+//
+//  Medição de tempo por frame em escopos nomeados (entrada, colisão,
+//  desenho do mapa...). Cada escopo mede o tempo de CPU com steady_clock e
+//  o de GPU com uma query GL_TIME_ELAPSED em volta dos comandos emitidos
+//  nele. As queries são lidas LATENCIA_PERFIL frames depois, quando a GPU já
+//  terminou, para a leitura não travar o pipeline.
+//
+//  Os últimos JANELA_PERFIL valores de cada escopo ficam guardados para os
+//  percentis (p50/p95/p99) do resumo; todos os eventos ficam em memória
+//  para salvar() no fim: .json gera um trace do Chrome (chrome://tracing,
+//  Perfetto), qualquer outra extensão gera CSV.
+//
+//  Só uma GL_TIME_ELAPSED pode estar ativa por vez: num escopo aberto dentro
+//  de outro só o tempo de CPU é medido.
+//
+
+#ifndef Profiler_h
+#define Profiler_h
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#define LATENCIA_PERFIL 4
+#define JANELA_PERFIL 300
+
+class Profiler {
+    struct Evento {
+        int escopo;
+        long frame;
+        double inicioUs, cpuUs;
+        double gpuUs; // < 0 se não foi medido
+    };
+
+    struct Escopo {
+        std::string nome;
+        double inicioUs;
+        size_t evento;      // evento aberto
+        bool gpu;           // abriu a query de GPU
+        std::vector<double> cpuMs, gpuMs; // janelas circulares
+        size_t proxCpu, proxGpu;
+    };
+
+    // Query de um frame que ainda não foi lida
+    struct Pendente {
+        size_t evento;
+        GLuint query;
+    };
+
+    bool ativo, medirGpu, gpuOcupada;
+    long frame;
+    int escopoFrame;
+    std::chrono::steady_clock::time_point t0;
+    std::vector<Escopo> escopos;
+    std::vector<Evento> eventos;
+    std::vector<Pendente> pendentes[LATENCIA_PERFIL];
+    std::vector<GLuint> livres; // queries já lidas, prontas para reuso
+    std::vector<GLuint> todas;
+
+public:
+    Profiler() {
+        this->ativo = this->medirGpu = this->gpuOcupada = false;
+        this->frame = 0;
+        this->escopoFrame = -1;
+    }
+
+    Profiler(const Profiler &) = delete;
+    Profiler &operator=(const Profiler &) = delete;
+
+    // Liga a medição. Sem GPU (ou sem contexto GL) só mede CPU
+    void ativar(bool gpu = true) {
+        this->ativo = true;
+        this->medirGpu = gpu;
+        this->t0 = std::chrono::steady_clock::now();
+        this->escopoFrame = registrar("frame");
+    }
+
+    bool estaAtivo() const {
+        return this->ativo;
+    }
+
+    // Identificador do escopo, criado na primeira vez que o nome aparece
+    int registrar(const char *nome) {
+        for (size_t k = 0; k < this->escopos.size(); k++)
+            if (this->escopos[k].nome == nome)
+                return (int)k;
+        Escopo e;
+        e.nome = nome;
+        e.inicioUs = 0.0;
+        e.evento = 0;
+        e.gpu = false;
+        e.proxCpu = e.proxGpu = 0;
+        this->escopos.push_back(e);
+        return (int)this->escopos.size() - 1;
+    }
+
+    // O escopo "frame" mede só CPU, de iniciarFrame a terminarFrame. Aqui
+    // também são lidas as queries de LATENCIA_PERFIL frames atrás
+    void iniciarFrame() {
+        if (!this->ativo)
+            return;
+        coletar(this->frame % LATENCIA_PERFIL, false);
+        Escopo &e = this->escopos[this->escopoFrame];
+        e.inicioUs = agoraUs();
+        e.evento = novoEvento(this->escopoFrame, e.inicioUs);
+    }
+
+    void terminarFrame() {
+        if (!this->ativo)
+            return;
+        Escopo &e = this->escopos[this->escopoFrame];
+        Evento &ev = this->eventos[e.evento];
+        ev.cpuUs = agoraUs() - ev.inicioUs;
+        adicionar(e.cpuMs, e.proxCpu, ev.cpuUs / 1000.0);
+        this->frame++;
+    }
+
+    void iniciar(int escopo) {
+        if (!this->ativo)
+            return;
+        Escopo &e = this->escopos[escopo];
+        e.inicioUs = agoraUs();
+        e.evento = novoEvento(escopo, e.inicioUs);
+        e.gpu = this->medirGpu && !this->gpuOcupada;
+        if (e.gpu) {
+            GLuint q = novaQuery();
+            glBeginQuery(GL_TIME_ELAPSED, q);
+            Pendente p = {e.evento, q};
+            this->pendentes[this->frame % LATENCIA_PERFIL].push_back(p);
+            this->gpuOcupada = true;
+        }
+    }
+
+    void terminar(int escopo) {
+        if (!this->ativo)
+            return;
+        Escopo &e = this->escopos[escopo];
+        if (e.gpu) {
+            glEndQuery(GL_TIME_ELAPSED);
+            this->gpuOcupada = false;
+            e.gpu = false;
+        }
+        Evento &ev = this->eventos[e.evento];
+        ev.cpuUs = agoraUs() - ev.inicioUs;
+        adicionar(e.cpuMs, e.proxCpu, ev.cpuUs / 1000.0);
+    }
+
+    // Lê todas as queries ainda pendentes (espera a GPU terminar)
+    void finalizar() {
+        if (!this->ativo)
+            return;
+        for (int s = 0; s < LATENCIA_PERFIL; s++)
+            coletar(s, true);
+    }
+
+    // Percentil p (0..1) dos últimos valores do escopo, em ms; -1 se vazio
+    double percentil(int escopo, double p, bool gpu) const {
+        const Escopo &e = this->escopos[escopo];
+        std::vector<double> v = gpu ? e.gpuMs : e.cpuMs;
+        if (v.empty())
+            return -1.0;
+        size_t k = (size_t)(p * (v.size() - 1) + 0.5);
+        std::nth_element(v.begin(), v.begin() + k, v.end());
+        return v[k];
+    }
+
+    // Tabela com p50/p95/p99 de CPU e GPU por escopo
+    void imprimirResumo(std::ostream &saida) const {
+        char linha[256];
+        snprintf(linha, sizeof(linha), "%-12s %9s %9s %9s   %9s %9s %9s", "escopo (ms)", "cpu p50", "cpu p95",
+                 "cpu p99", "gpu p50", "gpu p95", "gpu p99");
+        saida << linha << std::endl;
+        for (size_t k = 0; k < this->escopos.size(); k++) {
+            double v[6];
+            for (int g = 0; g < 2; g++) {
+                v[3 * g + 0] = percentil((int)k, 0.50, g == 1);
+                v[3 * g + 1] = percentil((int)k, 0.95, g == 1);
+                v[3 * g + 2] = percentil((int)k, 0.99, g == 1);
+            }
+            int n = snprintf(linha, sizeof(linha), "%-12s", this->escopos[k].nome.c_str());
+            for (int c = 0; c < 6 && n < (int)sizeof(linha); c++)
+                n += v[c] < 0.0 ? snprintf(linha + n, sizeof(linha) - n, c == 3 ? "   %9s" : " %9s", "-")
+                                : snprintf(linha + n, sizeof(linha) - n, c == 3 ? "   %9.3f" : " %9.3f", v[c]);
+            saida << linha << std::endl;
+        }
+        saida << this->frame << " frames medidos" << std::endl;
+    }
+
+    // .json: trace do Chrome (CPU na thread 1, GPU na thread 2, com o início
+    // da GPU aproximado pelo da CPU); senão CSV frame,escopo,inicio,cpu,gpu
+    bool salvar(const std::string &caminho, std::string &erro) const {
+        FILE *arq = fopen(caminho.c_str(), "w");
+        if (!arq) {
+            erro = "Erro ao criar arquivo: " + caminho;
+            return false;
+        }
+
+        bool json = caminho.size() >= 5 && caminho.compare(caminho.size() - 5, 5, ".json") == 0;
+        if (json) {
+            fprintf(arq, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+            fprintf(arq, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n");
+            fprintf(arq, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}");
+        } else {
+            fprintf(arq, "frame,escopo,inicio_ms,cpu_ms,gpu_ms\n");
+        }
+
+        for (size_t k = 0; k < this->eventos.size(); k++) {
+            const Evento &ev = this->eventos[k];
+            const char *nome = this->escopos[ev.escopo].nome.c_str();
+            if (json) {
+                fprintf(arq, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.1f,\"dur\":%.1f,"
+                             "\"args\":{\"frame\":%ld}}",
+                        nome, ev.inicioUs, ev.cpuUs, ev.frame);
+                if (ev.gpuUs >= 0.0)
+                    fprintf(arq, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":%.1f,\"dur\":%.1f,"
+                                 "\"args\":{\"frame\":%ld}}",
+                            nome, ev.inicioUs, ev.gpuUs, ev.frame);
+            } else if (ev.gpuUs >= 0.0) {
+                fprintf(arq, "%ld,%s,%.4f,%.4f,%.4f\n", ev.frame, nome, ev.inicioUs / 1000.0, ev.cpuUs / 1000.0,
+                        ev.gpuUs / 1000.0);
+            } else {
+                fprintf(arq, "%ld,%s,%.4f,%.4f,\n", ev.frame, nome, ev.inicioUs / 1000.0, ev.cpuUs / 1000.0);
+            }
+        }
+        if (json)
+            fprintf(arq, "\n]}\n");
+
+        if (fclose(arq) != 0) {
+            erro = "Erro ao gravar arquivo: " + caminho;
+            return false;
+        }
+        return true;
+    }
+
+    // Apaga as queries; chamar com o contexto GL ainda ativo
+    void liberar() {
+        if (!this->todas.empty())
+            glDeleteQueries((GLsizei)this->todas.size(), this->todas.data());
+        this->todas.clear();
+        this->livres.clear();
+        for (int s = 0; s < LATENCIA_PERFIL; s++)
+            this->pendentes[s].clear();
+    }
+
+private:
+    double agoraUs() const {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - this->t0).count();
+    }
+
+    size_t novoEvento(int escopo, double inicioUs) {
+        Evento ev = {escopo, this->frame, inicioUs, 0.0, -1.0};
+        this->eventos.push_back(ev);
+        return this->eventos.size() - 1;
+    }
+
+    GLuint novaQuery() {
+        if (this->livres.empty()) {
+            GLuint q;
+            glGenQueries(1, &q);
+            this->todas.push_back(q);
+            return q;
+        }
+        GLuint q = this->livres.back();
+        this->livres.pop_back();
+        return q;
+    }
+
+    // Lê as queries do slot. Sem esperar, as que ainda não terminaram ficam
+    // para depois, mas LATENCIA_PERFIL frames costumam ser suficientes
+    void coletar(int slot, bool esperar) {
+        std::vector<Pendente> &p = this->pendentes[slot];
+        size_t restantes = 0;
+        for (size_t k = 0; k < p.size(); k++) {
+            GLint pronta = GL_TRUE;
+            if (!esperar)
+                glGetQueryObjectiv(p[k].query, GL_QUERY_RESULT_AVAILABLE, &pronta);
+            if (!pronta) {
+                p[restantes++] = p[k];
+                continue;
+            }
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(p[k].query, GL_QUERY_RESULT, &ns);
+            Evento &ev = this->eventos[p[k].evento];
+            ev.gpuUs = ns / 1000.0;
+            Escopo &e = this->escopos[ev.escopo];
+            adicionar(e.gpuMs, e.proxGpu, ev.gpuUs / 1000.0);
+            this->livres.push_back(p[k].query);
+        }
+        p.resize(restantes);
+    }
+
+    static void adicionar(std::vector<double> &janela, size_t &prox, double v) {
+        if (janela.size() < JANELA_PERFIL)
+            janela.push_back(v);
+        else
+            janela[prox] = v;
+        prox = (prox + 1) % JANELA_PERFIL;
+    }
+};
+
+// Mede o bloco em que é declarado: EscopoPerfil e(perfil, id);
+class EscopoPerfil {
+    Profiler &perfil;
+    int escopo;
+
+public:
+    EscopoPerfil(Profiler &perfil, int escopo) : perfil(perfil), escopo(escopo) {
+        perfil.iniciar(escopo);
+    }
+
+    ~EscopoPerfil() {
+        this->perfil.terminar(this->escopo);
+    }
+};
+
+#endif /* Profiler_h */
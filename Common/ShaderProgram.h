@@ -0,0 +1,212 @@
+//
+//  ShaderProgram.h
+//
+//  Programa de shader com os uniforms resolvidos uma vez, logo depois do
+//  link: adotar() percorre os uniforms ativos com glGetActiveUniform e
+//  guarda a localização de cada um. No desenho os setters recebem o índice
+//  devolvido por localizar(), sem glGetUniformLocation por string, e
+//  lembram o último valor enviado: um glUniform* com o valor que o programa
+//  já tem não é repassado ao driver. usar() também só chama glUseProgram
+//  quando o programa em uso muda.
+//
+//  O cache só vale se todos os glUniform* / glUseProgram do programa
+//  passarem por aqui. Os setters usam glUniform*, então o programa precisa
+//  estar em uso (usar()) quando forem chamados.
+//
+
+#ifndef ShaderProgram_h
+#define ShaderProgram_h
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+// Chamadas GL poupadas desde o último zerarContadores(), somando todos os
+// programas. Quem chama zera uma vez por frame para ter o valor por frame
+struct ContadoresShader {
+    long localizacoesEvitadas; // glGetUniformLocation que cada set faria
+    long uniformsEvitados;     // glUniform* com o valor que já estava no programa
+    long trocasEvitadas;       // glUseProgram do programa que já estava em uso
+    long uniformsEnviados;     // glUniform* que chegaram ao driver
+
+    long evitadas() const {
+        return this->localizacoesEvitadas + this->uniformsEvitados + this->trocasEvitadas;
+    }
+};
+
+class ShaderProgram {
+    struct Uniform {
+        std::string nome; // sem o "[0]" dos arrays
+        GLint local;
+        GLint tamanho;    // elementos, > 1 para arrays
+        std::vector<uint32_t> valor;
+        size_t bytesDefinidos;
+    };
+
+    GLuint id;
+    std::vector<Uniform> uniforms;
+
+public:
+    ShaderProgram() {
+        this->id = 0;
+    }
+
+    // Passa a controlar um programa já ligado e lê os seus uniforms ativos
+    void adotar(GLuint programa) {
+        this->id = programa;
+        this->uniforms.clear();
+
+        GLint n = 0, maiorNome = 0;
+        glGetProgramiv(programa, GL_ACTIVE_UNIFORMS, &n);
+        glGetProgramiv(programa, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maiorNome);
+        std::vector<GLchar> nome(std::max(maiorNome, 1));
+        for (GLint k = 0; k < n; k++) {
+            GLsizei comprimento = 0;
+            GLint tamanho = 0;
+            GLenum tipo = 0;
+            glGetActiveUniform(programa, (GLuint)k, (GLsizei)nome.size(), &comprimento, &tamanho, &tipo, nome.data());
+
+            Uniform u;
+            u.nome.assign(nome.data(), comprimento);
+            // Uniforms de blocos (UBO) não têm localização
+            u.local = glGetUniformLocation(programa, u.nome.c_str());
+            if (u.local < 0)
+                continue;
+            if (u.nome.size() > 3 && u.nome.compare(u.nome.size() - 3, 3, "[0]") == 0)
+                u.nome.resize(u.nome.size() - 3);
+            u.tamanho = tamanho;
+            u.valor.assign((size_t)componentes(tipo) * tamanho, 0);
+            u.bytesDefinidos = 0;
+            this->uniforms.push_back(u);
+        }
+    }
+
+    GLuint getID() const {
+        return this->id;
+    }
+
+    void usar() const {
+        if (programaEmUso() == this->id) {
+            contadores().trocasEvitadas++;
+            return;
+        }
+        glUseProgram(this->id);
+        programaEmUso() = this->id;
+    }
+
+    // Índice do uniform para os setters, ou -1 se o nome não é um uniform
+    // ativo (o compilador remove os que não são usados). Setters com -1
+    // não fazem nada, como glUniform* com localização -1
+    int localizar(const char *nome) const {
+        for (size_t k = 0; k < this->uniforms.size(); k++)
+            if (this->uniforms[k].nome == nome)
+                return (int)k;
+        return -1;
+    }
+
+    int getNumUniforms() const {
+        return (int)this->uniforms.size();
+    }
+
+    void setInt(int u, GLint v) {
+        if (mudou(u, &v, sizeof(v)))
+            glUniform1i(this->uniforms[u].local, v);
+    }
+
+    void setFloat(int u, GLfloat v) {
+        if (mudou(u, &v, sizeof(v)))
+            glUniform1f(this->uniforms[u].local, v);
+    }
+
+    void setVec2(int u, GLfloat x, GLfloat y) {
+        GLfloat v[2] = {x, y};
+        if (mudou(u, v, sizeof(v)))
+            glUniform2fv(this->uniforms[u].local, 1, v);
+    }
+
+    void setVec3(int u, GLfloat x, GLfloat y, GLfloat z) {
+        GLfloat v[3] = {x, y, z};
+        if (mudou(u, v, sizeof(v)))
+            glUniform3fv(this->uniforms[u].local, 1, v);
+    }
+
+    void setVec4(int u, GLfloat x, GLfloat y, GLfloat z, GLfloat w) {
+        GLfloat v[4] = {x, y, z, w};
+        if (mudou(u, v, sizeof(v)))
+            glUniform4fv(this->uniforms[u].local, 1, v);
+    }
+
+    // n vec4 a partir do primeiro elemento do array
+    void setVec4Array(int u, int n, const GLfloat *v) {
+        if (mudou(u, v, sizeof(GLfloat) * 4 * n))
+            glUniform4fv(this->uniforms[u].local, n, v);
+    }
+
+    void setMat4(int u, const GLfloat *m) {
+        if (mudou(u, m, sizeof(GLfloat) * 16))
+            glUniformMatrix4fv(this->uniforms[u].local, 1, GL_FALSE, m);
+    }
+
+    static const ContadoresShader &getContadores() {
+        return contadores();
+    }
+
+    static void zerarContadores() {
+        ContadoresShader &c = contadores();
+        c.localizacoesEvitadas = c.uniformsEvitados = c.trocasEvitadas = c.uniformsEnviados = 0;
+    }
+
+private:
+    // Compara com o último valor enviado; true se o glUniform* precisa ser feito
+    bool mudou(int u, const void *v, size_t bytes) {
+        ContadoresShader &c = contadores();
+        c.localizacoesEvitadas++;
+        if (u < 0)
+            return false;
+
+        Uniform &un = this->uniforms[u];
+        bytes = std::min(bytes, un.valor.size() * sizeof(uint32_t));
+        if (bytes <= un.bytesDefinidos && memcmp(un.valor.data(), v, bytes) == 0) {
+            c.uniformsEvitados++;
+            return false;
+        }
+        memcpy(un.valor.data(), v, bytes);
+        un.bytesDefinidos = std::max(un.bytesDefinidos, bytes);
+        c.uniformsEnviados++;
+        return true;
+    }
+
+    // Palavras de 32 bits por elemento do uniform
+    static int componentes(GLenum tipo) {
+        switch (tipo) {
+        case GL_FLOAT_VEC2: case GL_INT_VEC2: case GL_BOOL_VEC2:
+            return 2;
+        case GL_FLOAT_VEC3: case GL_INT_VEC3: case GL_BOOL_VEC3:
+            return 3;
+        case GL_FLOAT_VEC4: case GL_INT_VEC4: case GL_BOOL_VEC4: case GL_FLOAT_MAT2:
+            return 4;
+        case GL_FLOAT_MAT3:
+            return 9;
+        case GL_FLOAT_MAT4:
+            return 16;
+        default: // escalares e samplers
+            return 1;
+        }
+    }
+
+    static ContadoresShader &contadores() {
+        static ContadoresShader c = {0, 0, 0, 0};
+        return c;
+    }
+
+    static GLuint &programaEmUso() {
+        static GLuint p = 0;
+        return p;
+    }
+};
+
+#endif /* ShaderProgram_h */
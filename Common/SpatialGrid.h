@@ -0,0 +1,208 @@
+//
+//  SpatialGrid.h
+//
+//  Índice espacial das entidades (Common/Entities.h) numa grade uniforme
+//  sobre o mapa: cada balde cobre tamBalde x tamBalde casas e tem a lista
+//  das entidades cuja posição cai nele. As consultas por raio ou por
+//  retângulo só olham os baldes que a área toca, então achar os vizinhos de
+//  uma entidade não depende de quantas existem no mapa todo.
+//
+//  As listas são encadeadas pelos próprios vetores do índice, por slot da
+//  entidade (anterior/proximo), sem alocar nada ao inserir, mover ou
+//  remover. mover() só troca a entidade de lista quando ela muda de balde;
+//  dentro do mesmo balde só atualiza a posição guardada. Posições fora do
+//  mapa vão para o balde da borda mais próxima.
+//
+//  O mapa é limitado e pequeno perto da memória, então a grade é densa (um
+//  int por balde) em vez de uma tabela hash das chaves de balde.
+//
+
+#ifndef SpatialGrid_h
+#define SpatialGrid_h
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "Entities.h"
+
+#define TAM_BALDE_GRADE 4
+#define FORA_DA_GRADE -1
+
+class GradeEspacial {
+    int largura, altura;     // em casas
+    int tamBalde;
+    int baldesLinhas, baldesColunas;
+    std::vector<int32_t> cabeca; // primeiro slot de cada balde, FORA_DA_GRADE se vazio
+
+    // Por slot de entidade
+    std::vector<int32_t> anterior, proximo;
+    std::vector<int32_t> balde; // FORA_DA_GRADE se a entidade não está no índice
+    std::vector<uint32_t> geracao;
+    std::vector<float> linha, coluna;
+    size_t quantidade;
+
+public:
+    GradeEspacial() {
+        this->largura = this->altura = 0;
+        this->tamBalde = TAM_BALDE_GRADE;
+        this->baldesLinhas = this->baldesColunas = 0;
+        this->quantidade = 0;
+    }
+
+    // Esvazia o índice e o prepara para um mapa largura x altura
+    void iniciar(int largura, int altura, int tamBalde = TAM_BALDE_GRADE) {
+        this->largura = largura;
+        this->altura = altura;
+        this->tamBalde = tamBalde > 0 ? tamBalde : TAM_BALDE_GRADE;
+        this->baldesLinhas = (altura + this->tamBalde - 1) / this->tamBalde;
+        this->baldesColunas = (largura + this->tamBalde - 1) / this->tamBalde;
+        this->cabeca.assign((size_t)this->baldesLinhas * this->baldesColunas, FORA_DA_GRADE);
+        this->balde.assign(this->balde.size(), FORA_DA_GRADE);
+        this->quantidade = 0;
+    }
+
+    // false se a entidade já estava no índice
+    bool inserir(Entidade e, float linha, float coluna) {
+        if (e.slot >= this->balde.size()) {
+            size_t n = std::max((size_t)e.slot + 1, this->balde.size() * 2);
+            this->anterior.resize(n);
+            this->proximo.resize(n);
+            this->balde.resize(n, FORA_DA_GRADE);
+            this->geracao.resize(n);
+            this->linha.resize(n);
+            this->coluna.resize(n);
+        }
+        if (this->balde[e.slot] != FORA_DA_GRADE)
+            return false;
+
+        this->geracao[e.slot] = e.geracao;
+        this->linha[e.slot] = linha;
+        this->coluna[e.slot] = coluna;
+        this->ligar(e.slot, this->baldeDe(linha, coluna));
+        this->quantidade++;
+        return true;
+    }
+
+    // false se a entidade não está no índice
+    bool mover(Entidade e, float linha, float coluna) {
+        if (!this->contem(e))
+            return false;
+        this->linha[e.slot] = linha;
+        this->coluna[e.slot] = coluna;
+        int b = this->baldeDe(linha, coluna);
+        if (b != this->balde[e.slot]) {
+            this->desligar(e.slot);
+            this->ligar(e.slot, b);
+        }
+        return true;
+    }
+
+    bool remover(Entidade e) {
+        if (!this->contem(e))
+            return false;
+        this->desligar(e.slot);
+        this->balde[e.slot] = FORA_DA_GRADE;
+        this->quantidade--;
+        return true;
+    }
+
+    bool contem(Entidade e) const {
+        return e.slot < this->balde.size() && this->balde[e.slot] != FORA_DA_GRADE && this->geracao[e.slot] == e.geracao;
+    }
+
+    // Acrescenta a saida as entidades a no máximo raio casas de (linha,
+    // coluna). Devolve quantas acrescentou
+    size_t consultarRaio(float linha, float coluna, float raio, std::vector<Entidade> &saida) const {
+        size_t antes = saida.size();
+        float raio2 = raio * raio;
+        int bl0, bc0, bl1, bc1;
+        if (!this->baldesEntre(linha - raio, coluna - raio, linha + raio, coluna + raio, bl0, bc0, bl1, bc1))
+            return 0;
+        for (int bl = bl0; bl <= bl1; bl++) {
+            for (int bc = bc0; bc <= bc1; bc++) {
+                for (int32_t s = this->cabeca[bl * this->baldesColunas + bc]; s != FORA_DA_GRADE; s = this->proximo[s]) {
+                    float dl = this->linha[s] - linha, dc = this->coluna[s] - coluna;
+                    if (dl * dl + dc * dc <= raio2) {
+                        Entidade e = {(uint32_t)s, this->geracao[s]};
+                        saida.push_back(e);
+                    }
+                }
+            }
+        }
+        return saida.size() - antes;
+    }
+
+    // As entidades com linha0 <= linha <= linha1 e coluna0 <= coluna <= coluna1
+    size_t consultarRetangulo(float linha0, float coluna0, float linha1, float coluna1, std::vector<Entidade> &saida) const {
+        size_t antes = saida.size();
+        int bl0, bc0, bl1, bc1;
+        if (!this->baldesEntre(linha0, coluna0, linha1, coluna1, bl0, bc0, bl1, bc1))
+            return 0;
+        for (int bl = bl0; bl <= bl1; bl++) {
+            for (int bc = bc0; bc <= bc1; bc++) {
+                for (int32_t s = this->cabeca[bl * this->baldesColunas + bc]; s != FORA_DA_GRADE; s = this->proximo[s]) {
+                    if (this->linha[s] >= linha0 && this->linha[s] <= linha1 && this->coluna[s] >= coluna0 &&
+                        this->coluna[s] <= coluna1) {
+                        Entidade e = {(uint32_t)s, this->geracao[s]};
+                        saida.push_back(e);
+                    }
+                }
+            }
+        }
+        return saida.size() - antes;
+    }
+
+    size_t tamanho() const {
+        return this->quantidade;
+    }
+
+    int getTamBalde() const {
+        return this->tamBalde;
+    }
+
+    size_t getMemoryBytes() const {
+        return this->cabeca.capacity() * sizeof(int32_t) +
+               this->balde.capacity() * (3 * sizeof(int32_t) + sizeof(uint32_t) + 2 * sizeof(float));
+    }
+
+private:
+    int baldeDe(float linha, float coluna) const {
+        int bl = std::min(std::max((int)floorf(linha), 0), this->altura - 1) / this->tamBalde;
+        int bc = std::min(std::max((int)floorf(coluna), 0), this->largura - 1) / this->tamBalde;
+        return bl * this->baldesColunas + bc;
+    }
+
+    // Faixa de baldes que o retângulo toca, presa ao mapa como as posições
+    bool baldesEntre(float linha0, float coluna0, float linha1, float coluna1, int &bl0, int &bc0, int &bl1,
+                     int &bc1) const {
+        if (this->cabeca.empty() || linha1 < linha0 || coluna1 < coluna0)
+            return false;
+        bl0 = std::min(std::max((int)floorf(linha0), 0), this->altura - 1) / this->tamBalde;
+        bl1 = std::min(std::max((int)floorf(linha1), 0), this->altura - 1) / this->tamBalde;
+        bc0 = std::min(std::max((int)floorf(coluna0), 0), this->largura - 1) / this->tamBalde;
+        bc1 = std::min(std::max((int)floorf(coluna1), 0), this->largura - 1) / this->tamBalde;
+        return true;
+    }
+
+    void ligar(uint32_t s, int b) {
+        this->balde[s] = b;
+        this->anterior[s] = FORA_DA_GRADE;
+        this->proximo[s] = this->cabeca[b];
+        if (this->cabeca[b] != FORA_DA_GRADE)
+            this->anterior[this->cabeca[b]] = (int32_t)s;
+        this->cabeca[b] = (int32_t)s;
+    }
+
+    void desligar(uint32_t s) {
+        if (this->anterior[s] != FORA_DA_GRADE)
+            this->proximo[this->anterior[s]] = this->proximo[s];
+        else
+            this->cabeca[this->balde[s]] = this->proximo[s];
+        if (this->proximo[s] != FORA_DA_GRADE)
+            this->anterior[this->proximo[s]] = this->anterior[s];
+    }
+};
+
+#endif /* SpatialGrid_h */
@@ -0,0 +1,376 @@
+//
+//  SpriteBatch.h
+//
+//  Lote de sprites: em vez de um VAO, uniforms e um draw call por sprite,
+//  quem desenha acumula quads (posição, escala, retângulo UV, tint) com
+//  desenhar() e, no fim do frame, finalizar() ordena os quads por camada e
+//  textura, copia para o VBO e faz um draw instanciado por textura.
+//
+//  O VBO é um anel de REGIOES_LOTE_SPRITES regiões de capacidade quads,
+//  criado com glBufferStorage e mapeado uma vez só (persistente e
+//  coerente): finalizar() escreve direto na memória mapeada da região da
+//  vez, sem glBufferData/glMapBuffer por frame. Uma cerca (glFenceSync)
+//  depois dos draws de cada região marca quando a GPU terminou de ler; a
+//  região só é reescrita depois que a cerca dela passou, então com três
+//  regiões a CPU monta um frame enquanto a GPU ainda desenha os anteriores.
+//  Se o frame tiver mais quads que uma região, ele é desenhado em pedaços,
+//  avançando pelo anel.
+//
+//  Sem OpenGL 4.4 nem GL_ARB_buffer_storage o lote cai para um VBO comum,
+//  órfão a cada pedaço (glBufferData com NULL) e preenchido com
+//  glBufferSubData.
+//
+//  A ordem de desenho é a da camada (menor primeiro); dentro da mesma
+//  camada os quads de uma textura saem juntos, na ordem em que foram
+//  pedidos. Quando os pedidos já chegam em ordem finalizar() não ordena.
+//  Com poucas combinações de camada e textura no frame (o normal) a ordem sai
+//  de uma contagem por chave, sem comparar quads.
+//
+//  O lote só cuida dos buffers e do VAO. O shader em uso (de quem chama)
+//  lê os atributos por instância abaixo e monta os cantos do quad com
+//  gl_VertexID, como um GL_TRIANGLE_STRIP de 4 vértices:
+//    location 0: vec2 posicao (centro)   location 2: vec4 uvRect (u, v, du, dv)
+//    location 1: vec2 escala             location 3: vec4 tint
+//  A textura vai na unidade ativa (glActiveTexture) de quem chama.
+//
+
+#ifndef SpriteBatch_h
+#define SpriteBatch_h
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#define REGIOES_LOTE_SPRITES 3
+#define CAPACIDADE_LOTE_SPRITES 65536
+#define MAX_CHAVES_CONTAGEM 64 // acima disso finalizar() ordena com std::sort
+
+struct QuadSprite {
+    float posicao[2];
+    float escala[2];
+    float uv[4]; // u, v, du, dv
+    float tint[4];
+};
+
+struct EstatisticasLote {
+    long quads;
+    long drawCalls;
+    long pedacos;  // regiões do anel usadas
+    long esperas;  // vezes que a CPU esperou a GPU liberar uma região
+    bool ordenou;  // os pedidos chegaram fora de ordem
+};
+
+class LoteSprites {
+    GLuint VAO, VBO;
+    size_t capacidade; // quads por região
+    bool persistente;
+    QuadSprite *mapeado; // início do anel, NULL sem buffer persistente
+    GLsync cercas[REGIOES_LOTE_SPRITES];
+    int regiao;
+
+    // Pedidos do frame: o quad e a chave camada/textura de cada um
+    std::vector<QuadSprite> quads;
+    std::vector<uint64_t> chaves;
+    bool emOrdem;
+
+    struct ChaveQuad {
+        uint64_t chave;
+        uint32_t indice;
+
+        bool operator<(const ChaveQuad &outra) const {
+            return this->chave != outra.chave ? this->chave < outra.chave : this->indice < outra.indice;
+        }
+    };
+    std::vector<ChaveQuad> ordem;
+    std::vector<uint64_t> distintas; // chaves do frame, para a contagem
+    std::vector<size_t> inicioChave;
+    std::vector<uint32_t> grupoDe;
+    std::vector<QuadSprite> copia; // pedaço montado, sem buffer persistente
+
+    EstatisticasLote estatisticas;
+
+public:
+    LoteSprites() {
+        this->VAO = this->VBO = 0;
+        this->capacidade = 0;
+        this->persistente = false;
+        this->mapeado = NULL;
+        for (int r = 0; r < REGIOES_LOTE_SPRITES; r++)
+            this->cercas[r] = 0;
+        this->regiao = 0;
+        this->emOrdem = true;
+        memset(&this->estatisticas, 0, sizeof(this->estatisticas));
+    }
+
+    ~LoteSprites() {
+        this->liberar();
+    }
+
+    // Cria o VAO e o anel com capacidade quads por região. Precisa do
+    // contexto GL corrente
+    bool criar(size_t capacidade, std::string &erro) {
+        if (this->VAO != 0) {
+            erro = "LoteSprites ja criado";
+            return false;
+        }
+        if (capacidade == 0) {
+            erro = "LoteSprites: capacidade zero";
+            return false;
+        }
+        this->capacidade = capacidade;
+        this->persistente = GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage;
+
+        glGenVertexArrays(1, &this->VAO);
+        glBindVertexArray(this->VAO);
+        glGenBuffers(1, &this->VBO);
+        glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+
+        if (this->persistente) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            GLsizeiptr tamanho = (GLsizeiptr)(REGIOES_LOTE_SPRITES * capacidade * sizeof(QuadSprite));
+            glBufferStorage(GL_ARRAY_BUFFER, tamanho, NULL, flags);
+            this->mapeado = (QuadSprite *)glMapBufferRange(GL_ARRAY_BUFFER, 0, tamanho, flags);
+            if (this->mapeado == NULL) {
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+                glBindVertexArray(0);
+                erro = "LoteSprites: falha ao mapear o VBO persistente";
+                this->liberar();
+                return false;
+            }
+        } else {
+            glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(capacidade * sizeof(QuadSprite)), NULL, GL_STREAM_DRAW);
+            this->copia.reserve(capacidade);
+        }
+
+        for (GLuint a = 0; a < 4; a++) {
+            glEnableVertexAttribArray(a);
+            glVertexAttribDivisor(a, 1);
+        }
+        this->apontarAtributos(0);
+
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+        return true;
+    }
+
+    void liberar() {
+        for (int r = 0; r < REGIOES_LOTE_SPRITES; r++) {
+            if (this->cercas[r] != 0)
+                glDeleteSync(this->cercas[r]);
+            this->cercas[r] = 0;
+        }
+        if (this->mapeado != NULL) {
+            glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            this->mapeado = NULL;
+        }
+        if (this->VBO != 0)
+            glDeleteBuffers(1, &this->VBO);
+        if (this->VAO != 0)
+            glDeleteVertexArrays(1, &this->VAO);
+        this->VAO = this->VBO = 0;
+        this->regiao = 0;
+    }
+
+    // Reserva espaço para n pedidos por frame
+    void reservar(size_t n) {
+        this->quads.reserve(n);
+        this->chaves.reserve(n);
+    }
+
+    void desenhar(GLuint textura, int camada, const QuadSprite &quad) {
+        uint64_t chave = ((uint64_t)(uint32_t)(camada + 0x80000000u) << 32) | textura;
+        if (!this->chaves.empty() && chave < this->chaves.back())
+            this->emOrdem = false;
+        this->quads.push_back(quad);
+        this->chaves.push_back(chave);
+    }
+
+    // Quad de largura x altura centrado em (x, y), com o retângulo uv da
+    // textura e tint branco
+    void desenhar(GLuint textura, int camada, float x, float y, float largura, float altura, float u, float v, float du,
+                  float dv) {
+        QuadSprite q = {{x, y}, {largura, altura}, {u, v, du, dv}, {1.0f, 1.0f, 1.0f, 1.0f}};
+        this->desenhar(textura, camada, q);
+    }
+
+    // Desenha os pedidos acumulados desde o último finalizar() e esvazia o
+    // lote. O shader e a projeção já devem estar prontos
+    void finalizar() {
+        this->estatisticas.quads = (long)this->quads.size();
+        this->estatisticas.drawCalls = 0;
+        this->estatisticas.pedacos = 0;
+        this->estatisticas.esperas = 0;
+        this->estatisticas.ordenou = !this->emOrdem;
+        if (this->quads.empty() || this->VAO == 0) {
+            this->limparPedidos();
+            return;
+        }
+
+        if (!this->emOrdem)
+            this->ordenar();
+
+        glBindVertexArray(this->VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+
+        size_t total = this->quads.size();
+        for (size_t inicio = 0; inicio < total; inicio += this->capacidade) {
+            size_t n = std::min(this->capacidade, total - inicio);
+            QuadSprite *destino = this->reservarRegiao(n);
+            if (this->emOrdem) {
+                memcpy(destino, &this->quads[inicio], n * sizeof(QuadSprite));
+            } else {
+                for (size_t k = 0; k < n; k++)
+                    destino[k] = this->quads[this->ordem[inicio + k].indice];
+            }
+            size_t base = this->persistente ? (size_t)this->regiao * this->capacidade : 0;
+            if (!this->persistente)
+                glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)(n * sizeof(QuadSprite)), destino);
+
+            // Um draw por trecho de mesma textura
+            size_t k = 0;
+            while (k < n) {
+                GLuint textura = (GLuint)(this->chaveDe(inicio + k) & 0xFFFFFFFFu);
+                size_t fim = k + 1;
+                while (fim < n && (GLuint)(this->chaveDe(inicio + fim) & 0xFFFFFFFFu) == textura)
+                    fim++;
+                glBindTexture(GL_TEXTURE_2D, textura);
+                this->apontarAtributos(base + k);
+                glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)(fim - k));
+                this->estatisticas.drawCalls++;
+                k = fim;
+            }
+
+            if (this->persistente) {
+                this->cercas[this->regiao] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                this->regiao = (this->regiao + 1) % REGIOES_LOTE_SPRITES;
+            }
+            this->estatisticas.pedacos++;
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+        this->limparPedidos();
+    }
+
+    size_t getPendentes() const {
+        return this->quads.size();
+    }
+
+    size_t getCapacidade() const {
+        return this->capacidade;
+    }
+
+    bool isPersistente() const {
+        return this->persistente;
+    }
+
+    // Do último finalizar()
+    const EstatisticasLote &getEstatisticas() const {
+        return this->estatisticas;
+    }
+
+private:
+    // Preenche ordem com os pedidos por chave, estável. Um frame costuma ter
+    // poucas combinações de camada e textura, então conta quantos quads cada
+    // uma tem e espalha os índices (O(n)); com muitas, ordena com std::sort
+    void ordenar() {
+        size_t n = this->quads.size();
+        this->ordem.resize(n);
+
+        this->distintas.clear();
+        for (size_t k = 0; k < n && this->distintas.size() <= MAX_CHAVES_CONTAGEM; k++) {
+            if (k > 0 && this->chaves[k] == this->chaves[k - 1])
+                continue;
+            if (std::find(this->distintas.begin(), this->distintas.end(), this->chaves[k]) == this->distintas.end())
+                this->distintas.push_back(this->chaves[k]);
+        }
+
+        if (this->distintas.size() > MAX_CHAVES_CONTAGEM) {
+            for (size_t k = 0; k < n; k++) {
+                this->ordem[k].chave = this->chaves[k];
+                this->ordem[k].indice = (uint32_t)k;
+            }
+            std::sort(this->ordem.begin(), this->ordem.end());
+            return;
+        }
+
+        std::sort(this->distintas.begin(), this->distintas.end());
+        size_t nChaves = this->distintas.size();
+        this->inicioChave.assign(nChaves, 0);
+        this->grupoDe.resize(n);
+        for (size_t k = 0; k < n; k++) {
+            if (k > 0 && this->chaves[k] == this->chaves[k - 1]) {
+                this->grupoDe[k] = this->grupoDe[k - 1];
+            } else {
+                this->grupoDe[k] = (uint32_t)(std::lower_bound(this->distintas.begin(), this->distintas.end(),
+                                                               this->chaves[k]) -
+                                              this->distintas.begin());
+            }
+            this->inicioChave[this->grupoDe[k]]++;
+        }
+        size_t soma = 0;
+        for (size_t g = 0; g < nChaves; g++) {
+            size_t c = this->inicioChave[g];
+            this->inicioChave[g] = soma;
+            soma += c;
+        }
+        for (size_t k = 0; k < n; k++) {
+            ChaveQuad &destino = this->ordem[this->inicioChave[this->grupoDe[k]]++];
+            destino.chave = this->chaves[k];
+            destino.indice = (uint32_t)k;
+        }
+    }
+
+    uint64_t chaveDe(size_t posicao) const {
+        return this->emOrdem ? this->chaves[posicao] : this->ordem[posicao].chave;
+    }
+
+    // Onde escrever os próximos n quads: a região da vez do anel, depois de
+    // a GPU ter terminado de ler dela, ou o buffer de cópia
+    QuadSprite *reservarRegiao(size_t n) {
+        if (!this->persistente) {
+            glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(this->capacidade * sizeof(QuadSprite)), NULL, GL_STREAM_DRAW);
+            this->copia.resize(n);
+            return this->copia.data();
+        }
+
+        GLsync cerca = this->cercas[this->regiao];
+        if (cerca != 0) {
+            GLenum estado = glClientWaitSync(cerca, 0, 0);
+            if (estado == GL_TIMEOUT_EXPIRED) {
+                this->estatisticas.esperas++;
+                do {
+                    estado = glClientWaitSync(cerca, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+                } while (estado == GL_TIMEOUT_EXPIRED);
+            }
+            glDeleteSync(cerca);
+            this->cercas[this->regiao] = 0;
+        }
+        return this->mapeado + (size_t)this->regiao * this->capacidade;
+    }
+
+    // Atributos por instância a partir do quad primeiro do VBO
+    void apontarAtributos(size_t primeiro) {
+        const GLint tamanhos[] = {2, 2, 4, 4};
+        const size_t deslocamentos[] = {offsetof(QuadSprite, posicao), offsetof(QuadSprite, escala),
+                                        offsetof(QuadSprite, uv), offsetof(QuadSprite, tint)};
+        for (GLuint a = 0; a < 4; a++)
+            glVertexAttribPointer(a, tamanhos[a], GL_FLOAT, GL_FALSE, sizeof(QuadSprite),
+                                  (GLvoid *)(primeiro * sizeof(QuadSprite) + deslocamentos[a]));
+    }
+
+    void limparPedidos() {
+        this->quads.clear();
+        this->chaves.clear();
+        this->emOrdem = true;
+    }
+};
+
+#endif /* SpriteBatch_h */
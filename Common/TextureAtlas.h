@@ -0,0 +1,307 @@
+//
+//  TextureAtlas.h
+//
+//  Atlas de texturas: as imagens do jogo (tileset, spritesheets, moeda) são
+//  empacotadas na carga em uma ou mais páginas de uma GL_TEXTURE_2D_ARRAY.
+//  Como todas as páginas ficam numa única textura, o renderizador faz um só
+//  bind e cada sprite passa a ser um retângulo UV + camada (RegiaoAtlas) em
+//  vez de uma textura própria com as contas de ds/dt.
+//
+//  O empacotamento é por prateleiras: as imagens são ordenadas pela altura e
+//  colocadas lado a lado em linhas; quando uma linha enche abre-se outra, e
+//  quando a página enche abre-se outra página. Em volta de cada imagem fica
+//  uma margem com a borda repetida, para o filtro não puxar texels vizinhos.
+//
+//  Imagens maiores que o tamanho máximo pedido (ou que a página) são
+//  reduzidas por média de área antes de entrar no atlas.
+//
+//  Usa stbi_load: quem inclui este arquivo precisa ter a implementação da
+//  stb_image em algum .cpp (STB_IMAGE_IMPLEMENTATION).
+//
+
+#ifndef TextureAtlas_h
+#define TextureAtlas_h
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+// Retângulo de uma imagem dentro do atlas. u, v é o canto do primeiro texel
+// da imagem (linha 0 do arquivo), em coordenadas normalizadas da página
+struct RegiaoAtlas {
+    int pagina;
+    float u, v, du, dv;
+    int largura, altura; // em texels, já reduzida se foi o caso
+
+    // Célula (col, lin) de uma grade nCols x nLins dentro da região: frames
+    // de spritesheet ou tiles de tileset. lin 0 é a de cima da imagem
+    RegiaoAtlas celula(int col, int lin, int nCols, int nLins) const {
+        RegiaoAtlas r = *this;
+        r.du = this->du / nCols;
+        r.dv = this->dv / nLins;
+        r.u = this->u + col * r.du;
+        r.v = this->v + lin * r.dv;
+        r.largura = this->largura / nCols;
+        r.altura = this->altura / nLins;
+        return r;
+    }
+};
+
+class TextureAtlas {
+    struct Imagem {
+        std::string nome;
+        int largura, altura;
+        std::vector<unsigned char> rgba;
+        int pagina, x, y;
+    };
+
+    std::vector<Imagem> imagens;
+    std::vector<RegiaoAtlas> regioes; // mesma ordem de imagens, preenchidas em construir
+    int tamanhoPagina, margem;
+    int larguraPagina, alturaPagina, nPaginas;
+    GLuint texID;
+
+public:
+    TextureAtlas(int tamanhoPagina = 1024, int margem = 2) {
+        this->tamanhoPagina = tamanhoPagina;
+        this->margem = margem;
+        this->larguraPagina = this->alturaPagina = this->nPaginas = 0;
+        this->texID = 0;
+    }
+
+    TextureAtlas(const TextureAtlas &) = delete;
+    TextureAtlas &operator=(const TextureAtlas &) = delete;
+
+    // Lê a imagem e a guarda para o próximo construir(). Com larguraMax /
+    // alturaMax > 0 a imagem é reduzida (mantendo a proporção) para caber
+    bool adicionarImagem(const std::string &nome, const std::string &caminho, std::string &erro,
+                         int larguraMax = 0, int alturaMax = 0) {
+        int w, h, canais;
+        unsigned char *dados = stbi_load(caminho.c_str(), &w, &h, &canais, 4);
+        if (!dados) {
+            erro = "Erro ao carregar imagem: " + caminho;
+            return false;
+        }
+
+        Imagem img;
+        img.nome = nome;
+        img.largura = w;
+        img.altura = h;
+        img.rgba.assign(dados, dados + (size_t)w * h * 4);
+        img.pagina = img.x = img.y = -1;
+        stbi_image_free(dados);
+
+        // A página também limita o tamanho, descontada a margem
+        int limiteW = this->tamanhoPagina - 2 * this->margem, limiteH = limiteW;
+        if (larguraMax > 0)
+            limiteW = std::min(limiteW, larguraMax);
+        if (alturaMax > 0)
+            limiteH = std::min(limiteH, alturaMax);
+        if (w > limiteW || h > limiteH) {
+            float escala = std::min((float)limiteW / w, (float)limiteH / h);
+            reduzir(img, std::max(1, (int)(w * escala)), std::max(1, (int)(h * escala)));
+        }
+
+        this->imagens.push_back(img);
+        return true;
+    }
+
+    // Empacota as imagens adicionadas e cria a textura. Os pixels ficam só
+    // na GPU depois disso
+    bool construir(std::string &erro) {
+        if (this->imagens.empty()) {
+            erro = "atlas sem imagens";
+            return false;
+        }
+
+        GLint maxTextura = 0, maxCamadas = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextura);
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxCamadas);
+        if (maxTextura > 0 && this->tamanhoPagina > maxTextura) {
+            erro = "pagina de " + std::to_string(this->tamanhoPagina) + " maior que GL_MAX_TEXTURE_SIZE (" +
+                   std::to_string(maxTextura) + ")";
+            return false;
+        }
+
+        empacotar();
+        if (maxCamadas > 0 && this->nPaginas > maxCamadas) {
+            erro = "atlas precisa de " + std::to_string(this->nPaginas) + " paginas, acima de GL_MAX_ARRAY_TEXTURE_LAYERS";
+            return false;
+        }
+
+        // Todas as páginas têm o mesmo tamanho; a altura é cortada para a
+        // potência de 2 que cobre a página mais cheia
+        size_t bytesPagina = (size_t)this->larguraPagina * this->alturaPagina * 4;
+        std::vector<unsigned char> pixels(bytesPagina * this->nPaginas, 0);
+        for (size_t k = 0; k < this->imagens.size(); k++)
+            copiarComMargem(this->imagens[k], &pixels[bytesPagina * this->imagens[k].pagina]);
+
+        if (this->texID == 0)
+            glGenTextures(1, &this->texID);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, this->texID);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, this->larguraPagina, this->alturaPagina, this->nPaginas, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        this->regioes.resize(this->imagens.size());
+        for (size_t k = 0; k < this->imagens.size(); k++) {
+            Imagem &img = this->imagens[k];
+            RegiaoAtlas &r = this->regioes[k];
+            r.pagina = img.pagina;
+            r.u = (float)img.x / this->larguraPagina;
+            r.v = (float)img.y / this->alturaPagina;
+            r.du = (float)img.largura / this->larguraPagina;
+            r.dv = (float)img.altura / this->alturaPagina;
+            r.largura = img.largura;
+            r.altura = img.altura;
+            std::vector<unsigned char>().swap(img.rgba);
+        }
+        return true;
+    }
+
+    // Região da imagem com esse nome, ou NULL
+    const RegiaoAtlas *buscar(const std::string &nome) const {
+        for (size_t k = 0; k < this->regioes.size(); k++)
+            if (this->imagens[k].nome == nome)
+                return &this->regioes[k];
+        return NULL;
+    }
+
+    // Apaga a textura; chamar com o contexto GL ainda ativo
+    void liberar() {
+        if (this->texID)
+            glDeleteTextures(1, &this->texID);
+        this->texID = 0;
+    }
+
+    void bind(int unidade) const {
+        glActiveTexture(GL_TEXTURE0 + unidade);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, this->texID);
+    }
+
+    GLuint getTexID() const {
+        return this->texID;
+    }
+
+    int getNumImagens() const {
+        return (int)this->imagens.size();
+    }
+
+    int getNumPaginas() const {
+        return this->nPaginas;
+    }
+
+    int getLarguraPagina() const {
+        return this->larguraPagina;
+    }
+
+    int getAlturaPagina() const {
+        return this->alturaPagina;
+    }
+
+    // Tamanho da textura na GPU (RGBA8, sem mipmaps)
+    size_t getMemoryBytes() const {
+        return this->texID ? (size_t)this->larguraPagina * this->alturaPagina * this->nPaginas * 4 : 0;
+    }
+
+private:
+    // Prateleiras: ordena por altura e preenche linha a linha, página a página
+    void empacotar() {
+        std::vector<size_t> ordem(this->imagens.size());
+        for (size_t k = 0; k < ordem.size(); k++)
+            ordem[k] = k;
+        std::stable_sort(ordem.begin(), ordem.end(), [this](size_t a, size_t b) {
+            return this->imagens[a].altura > this->imagens[b].altura;
+        });
+
+        int m = this->margem, tam = this->tamanhoPagina;
+        int pagina = 0, x = 0, y = 0, alturaLinha = 0, maiorAltura = 0;
+        for (size_t k = 0; k < ordem.size(); k++) {
+            Imagem &img = this->imagens[ordem[k]];
+            int w = img.largura + 2 * m, h = img.altura + 2 * m;
+            if (x + w > tam) { // nova linha
+                x = 0;
+                y += alturaLinha;
+                alturaLinha = 0;
+            }
+            if (y + h > tam) { // nova página
+                pagina++;
+                x = y = alturaLinha = 0;
+            }
+            img.pagina = pagina;
+            img.x = x + m;
+            img.y = y + m;
+            x += w;
+            alturaLinha = std::max(alturaLinha, h);
+            maiorAltura = std::max(maiorAltura, y + alturaLinha);
+        }
+
+        this->nPaginas = pagina + 1;
+        this->larguraPagina = tam;
+        this->alturaPagina = 1;
+        while (this->alturaPagina < maiorAltura)
+            this->alturaPagina *= 2;
+        if (this->nPaginas > 1)
+            this->alturaPagina = tam;
+    }
+
+    // Copia a imagem para a página e repete a borda na margem
+    void copiarComMargem(const Imagem &img, unsigned char *pagina) const {
+        int m = this->margem;
+        for (int y = -m; y < img.altura + m; y++) {
+            int ys = std::min(std::max(y, 0), img.altura - 1);
+            unsigned char *dst = pagina + ((size_t)(img.y + y) * this->larguraPagina + img.x) * 4;
+            const unsigned char *src = &img.rgba[(size_t)ys * img.largura * 4];
+            memcpy(dst, src, (size_t)img.largura * 4);
+            for (int x = 1; x <= m; x++) {
+                memcpy(dst - 4 * x, src, 4);
+                memcpy(dst + 4 * (img.largura - 1 + x), src + 4 * (img.largura - 1), 4);
+            }
+        }
+    }
+
+    // Redução por média de área, com alfa pré-multiplicado para a cor das
+    // bordas transparentes não escurecer o resultado
+    static void reduzir(Imagem &img, int novaLargura, int novaAltura) {
+        std::vector<unsigned char> saida((size_t)novaLargura * novaAltura * 4);
+        for (int y = 0; y < novaAltura; y++) {
+            int y0 = (int)((long long)y * img.altura / novaAltura);
+            int y1 = std::max(y0 + 1, (int)((long long)(y + 1) * img.altura / novaAltura));
+            for (int x = 0; x < novaLargura; x++) {
+                int x0 = (int)((long long)x * img.largura / novaLargura);
+                int x1 = std::max(x0 + 1, (int)((long long)(x + 1) * img.largura / novaLargura));
+                double soma[4] = {0, 0, 0, 0};
+                for (int ys = y0; ys < y1; ys++) {
+                    const unsigned char *p = &img.rgba[((size_t)ys * img.largura + x0) * 4];
+                    for (int xs = x0; xs < x1; xs++, p += 4) {
+                        double a = p[3];
+                        soma[0] += p[0] * a;
+                        soma[1] += p[1] * a;
+                        soma[2] += p[2] * a;
+                        soma[3] += a;
+                    }
+                }
+                unsigned char *q = &saida[((size_t)y * novaLargura + x) * 4];
+                double n = (double)(y1 - y0) * (x1 - x0);
+                for (int c = 0; c < 3; c++)
+                    q[c] = soma[3] > 0 ? (unsigned char)(soma[c] / soma[3] + 0.5) : 0;
+                q[3] = (unsigned char)(soma[3] / n + 0.5);
+            }
+        }
+        img.rgba.swap(saida);
+        img.largura = novaLargura;
+        img.altura = novaAltura;
+    }
+};
+
+#endif /* TextureAtlas_h */
@@ -0,0 +1,304 @@
+//
+//  TextureCache.h
+//
+//  Cache de texturas por arquivo: a chave é o caminho canônico do arquivo
+//  (realpath / _fullpath, então "../assets/a.png" e "assets/a.png" dão na
+//  mesma) mais as opções de carga (wrap, filtros, mipmaps, anisotropia).
+//  Pedir de novo a mesma chave devolve a mesma textura, com mais uma
+//  referência no RecursosGPU (Common/GpuResources.h), em vez de decodificar
+//  e ocupar a memória de vídeo outra vez. A carga em si é do
+//  CarregadorTexturas (Common/TextureLoader.h).
+//
+//  O cache guarda uma referência de cada textura, então ela continua
+//  residente mesmo quando ninguém mais a usa; descartarSemUso() apaga as
+//  que só o cache segura.
+//
+//  Com RECARREGAR_TEXTURAS definido (builds Debug, pelo CMakeLists) e no
+//  Linux, os diretórios das texturas que estão em assets/ são observados
+//  com inotify. verificarMudancas(), chamado a cada frame, pede a
+//  decodificação de novo dos arquivos salvos desde a última chamada; a
+//  textura mantém o mesmo nome GL, então quem a usa não precisa saber.
+//
+
+#ifndef TextureCache_h
+#define TextureCache_h
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(RECARREGAR_TEXTURAS) && defined(__linux__)
+#define RECARGA_INOTIFY
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "GpuResources.h"
+#include "TextureLoader.h"
+
+class CacheTexturas {
+    struct Entrada {
+        std::string caminho; // canônico
+        OpcoesTextura opcoes;
+        RecursoGPU textura;  // a referência do cache
+        InfoTextura info;
+        long recargas;
+    };
+
+    RecursosGPU &recursos;
+    CarregadorTexturas &carregador;
+
+    std::vector<Entrada> entradas;
+    std::unordered_map<std::string, size_t> indices; // chave -> entrada
+    long pedidos, acertos, recargas;
+
+#ifdef RECARGA_INOTIFY
+    int fdInotify;
+    std::unordered_map<int, std::string> diretorios; // watch -> diretório
+#endif
+
+public:
+    CacheTexturas(RecursosGPU &recursos, CarregadorTexturas &carregador)
+        : recursos(recursos), carregador(carregador) {
+        this->pedidos = 0;
+        this->acertos = 0;
+        this->recargas = 0;
+#ifdef RECARGA_INOTIFY
+        this->fdInotify = -1;
+#endif
+    }
+
+    ~CacheTexturas() {
+        this->pararObservacao();
+    }
+
+    CacheTexturas(const CacheTexturas &) = delete;
+    CacheTexturas &operator=(const CacheTexturas &) = delete;
+
+    // Devolve em textura uma referência (a liberar com liberar()) para a
+    // textura do arquivo com essas opções, carregando-a se ainda não está no
+    // cache. Os pixels podem ainda estar a caminho, como em
+    // CarregadorTexturas::carregar()
+    bool obter(const std::string &caminho, const OpcoesTextura &opcoes, RecursoGPU &textura, InfoTextura &info,
+               std::string &erro) {
+        this->pedidos++;
+        std::string canonico = caminhoCanonico(caminho);
+        std::string chave = chaveDe(canonico, opcoes);
+
+        std::unordered_map<std::string, size_t>::iterator it = this->indices.find(chave);
+        if (it != this->indices.end()) {
+            Entrada &e = this->entradas[it->second];
+            if (this->recursos.valido(e.textura)) {
+                this->acertos++;
+                textura = this->recursos.compartilhar(e.textura);
+                info = e.info;
+                return true;
+            }
+            // Apagada por fora (liberarTudo() do RecursosGPU): carrega de novo
+            this->remover(it->second);
+        }
+
+        if (!this->carregador.carregar(canonico, opcoes, info, erro))
+            return false;
+
+        Entrada e;
+        e.caminho = canonico;
+        e.opcoes = opcoes;
+        e.info = info;
+        e.recargas = 0;
+        e.textura = this->recursos.adotar(RECURSO_TEXTURA, info.texID, info.bytes);
+        this->indices[chave] = this->entradas.size();
+        this->entradas.push_back(e);
+        this->observar(canonico);
+
+        textura = this->recursos.compartilhar(e.textura);
+        return true;
+    }
+
+    // Devolve a referência de quem pediu; a textura continua no cache
+    bool liberar(RecursoGPU &textura) {
+        return this->recursos.liberar(textura);
+    }
+
+    // Apaga as texturas que só o cache ainda segura. Devolve quantas
+    int descartarSemUso() {
+        int descartadas = 0;
+        for (size_t k = this->entradas.size(); k-- > 0;) {
+            if (this->recursos.getReferencias(this->entradas[k].textura) <= 1) {
+                this->remover(k);
+                descartadas++;
+            }
+        }
+        return descartadas;
+    }
+
+    // Solta as referências do cache e para de observar os arquivos. Chamar
+    // antes de RecursosGPU::liberarTudo() e com o contexto GL corrente
+    void liberarTudo() {
+        for (size_t k = 0; k < this->entradas.size(); k++)
+            this->recursos.liberar(this->entradas[k].textura);
+        this->entradas.clear();
+        this->indices.clear();
+        this->pararObservacao();
+    }
+
+    // Pede a recarga das texturas cujos arquivos foram salvos desde a última
+    // chamada e devolve quantas. Os pixels novos vão para a GPU pelo
+    // CarregadorTexturas::atualizar(). Sem RECARREGAR_TEXTURAS não faz nada
+    int verificarMudancas(std::string &erro) {
+        int recarregadas = 0;
+#ifdef RECARGA_INOTIFY
+        if (this->fdInotify < 0)
+            return 0;
+
+        // Um editor costuma gerar vários eventos por gravação: junta os
+        // arquivos de todos os eventos pendentes antes de recarregar
+        std::vector<std::string> mudados;
+        alignas(struct inotify_event) char buffer[4096];
+        for (;;) {
+            ssize_t lidos = read(this->fdInotify, buffer, sizeof(buffer));
+            if (lidos <= 0)
+                break;
+            for (ssize_t p = 0; p < lidos;) {
+                const struct inotify_event *ev = (const struct inotify_event *)(buffer + p);
+                p += sizeof(struct inotify_event) + ev->len;
+                std::unordered_map<int, std::string>::iterator d = this->diretorios.find(ev->wd);
+                if (d == this->diretorios.end() || ev->len == 0)
+                    continue;
+                std::string arquivo = d->second + "/" + ev->name;
+                bool repetido = false;
+                for (size_t m = 0; m < mudados.size() && !repetido; m++)
+                    repetido = mudados[m] == arquivo;
+                if (!repetido)
+                    mudados.push_back(arquivo);
+            }
+        }
+
+        // O .ktx2 gerado pela texc ao lado do .png também conta como mudança
+        bool primeiro = true;
+        for (size_t k = 0; k < this->entradas.size(); k++) {
+            Entrada &e = this->entradas[k];
+            std::string ktx2 = e.caminho.substr(0, e.caminho.find_last_of('.')) + ".ktx2";
+            bool mudou = false;
+            for (size_t m = 0; m < mudados.size() && !mudou; m++)
+                mudou = mudados[m] == e.caminho || (e.opcoes.usarKtx2 && mudados[m] == ktx2);
+            if (!mudou || !this->recursos.valido(e.textura))
+                continue;
+            std::string erroRecarga;
+            InfoTextura info;
+            if (!this->carregador.recarregar(e.info.texID, e.caminho, info, erroRecarga)) {
+                erro += (primeiro ? "" : "\n") + erroRecarga;
+                primeiro = false;
+                continue;
+            }
+            e.info = info;
+            e.recargas++;
+            this->recursos.setBytes(e.textura, info.bytes);
+            this->recargas++;
+            recarregadas++;
+        }
+#else
+        (void)erro;
+#endif
+        return recarregadas;
+    }
+
+    // true se o build observa os arquivos (RECARREGAR_TEXTURAS no Linux)
+    static bool recargaDisponivel() {
+#ifdef RECARGA_INOTIFY
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    int getNumTexturas() const {
+        return (int)this->entradas.size();
+    }
+
+    // obter() chamados e quantos foram atendidos por uma textura do cache
+    long getPedidos() const {
+        return this->pedidos;
+    }
+
+    long getAcertos() const {
+        return this->acertos;
+    }
+
+    long getRecargas() const {
+        return this->recargas;
+    }
+
+    static std::string caminhoCanonico(const std::string &caminho) {
+#ifdef _WIN32
+        char absoluto[_MAX_PATH];
+        if (_fullpath(absoluto, caminho.c_str(), _MAX_PATH) != NULL)
+            return absoluto;
+#else
+        char *absoluto = realpath(caminho.c_str(), NULL);
+        if (absoluto != NULL) {
+            std::string r = absoluto;
+            free(absoluto);
+            return r;
+        }
+#endif
+        return caminho; // não existe: carregar() dá o erro
+    }
+
+private:
+    static std::string chaveDe(const std::string &canonico, const OpcoesTextura &o) {
+        char opcoes[96];
+        snprintf(opcoes, sizeof(opcoes), "|%x|%x|%x|%x|%d|%d", (unsigned)o.wrapS, (unsigned)o.wrapT,
+                 (unsigned)o.filtroMin, (unsigned)o.filtroMag, (int)o.mipmaps, (int)o.anisotropia);
+        return canonico + opcoes;
+    }
+
+    // Solta a referência do cache e tira a entrada k (a última toma o lugar)
+    void remover(size_t k) {
+        this->recursos.liberar(this->entradas[k].textura);
+        this->indices.erase(chaveDe(this->entradas[k].caminho, this->entradas[k].opcoes));
+        size_t ultima = this->entradas.size() - 1;
+        if (k != ultima) {
+            this->entradas[k] = this->entradas[ultima];
+            this->indices[chaveDe(this->entradas[k].caminho, this->entradas[k].opcoes)] = k;
+        }
+        this->entradas.pop_back();
+    }
+
+    // Observa o diretório do arquivo (e não o arquivo: editores costumam
+    // salvar num temporário e renomear por cima)
+    void observar(const std::string &canonico) {
+#ifdef RECARGA_INOTIFY
+        if (canonico.find("/assets/") == std::string::npos)
+            return;
+        std::string diretorio = canonico.substr(0, canonico.find_last_of('/'));
+        for (std::unordered_map<int, std::string>::iterator d = this->diretorios.begin();
+             d != this->diretorios.end(); ++d) {
+            if (d->second == diretorio)
+                return;
+        }
+        if (this->fdInotify < 0)
+            this->fdInotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (this->fdInotify < 0)
+            return;
+        int wd = inotify_add_watch(this->fdInotify, diretorio.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd >= 0)
+            this->diretorios[wd] = diretorio;
+#else
+        (void)canonico;
+#endif
+    }
+
+    void pararObservacao() {
+#ifdef RECARGA_INOTIFY
+        if (this->fdInotify >= 0)
+            close(this->fdInotify);
+        this->fdInotify = -1;
+        this->diretorios.clear();
+#endif
+    }
+};
+
+#endif /* TextureCache_h */
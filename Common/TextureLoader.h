@@ -0,0 +1,524 @@
+//
+//  TextureLoader.h
+//
+//  Carregador de texturas compartilhado pelos exemplos: a decodificação dos
+//  PNGs (stbi_load) roda em threads e o laço principal só envia os pixels
+//  prontos para a GPU.
+//
+//  carregar() lê só o cabeçalho da imagem (stbi_info), então já devolve a
+//  textura com largura e altura certas; até os pixels chegarem ela mostra
+//  uma imagem provisória (xadrez 2x2). As threads decodificam sempre em
+//  RGBA8 e deixam o resultado numa lista; a cada frame atualizar() recolhe
+//  essa lista sem esperar (como FilaCaminhos::coletar em
+//  Common/PathQueue.h), copia cada imagem para um pixel buffer object e faz
+//  o glTexImage2D a partir dele, com o driver copiando para a textura sem
+//  segurar a CPU. maxBytes limita quanto é enviado por frame, para uma
+//  imagem grande não travar o desenho. aguardar() espera e envia tudo, para
+//  quem precisa das texturas prontas antes do primeiro frame (o modo
+//  headless, que compara o frame com uma referência).
+//
+//  Os PBOs se alternam (N_PBOS_TEXTURA) e cada um é órfão antes de ser
+//  escrito (glBufferData com NULL), então um envio não espera o anterior.
+//
+//  Texturas já comprimidas para a GPU (.ktx2 com BC7 ou BC3, gerados pela
+//  ferramenta texc) pulam a decodificação: a thread só copia os níveis do
+//  arquivo e atualizar() os envia com glCompressedTexImage2D, sem
+//  glGenerateMipmap. Pedir um .png usa o .ktx2 de mesmo nome ao lado dele,
+//  se existir, não for mais velho que o .png e a placa aceitar o formato.
+//
+//  Todas as chamadas GL ficam na thread que chama carregar()/atualizar(),
+//  que precisa ter o contexto corrente. Usa stbi_load: quem inclui este
+//  arquivo precisa ter a implementação da stb_image em algum .cpp.
+//
+
+#ifndef TextureLoader_h
+#define TextureLoader_h
+
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include "Ktx2.h"
+
+#define N_PBOS_TEXTURA 2
+#define TAM_PROVISORIA 2
+#define BYTES_TEXTURA_POR_FRAME (8 * 1024 * 1024) // sugestão de maxBytes para atualizar()
+
+struct OpcoesTextura {
+    GLint wrapS, wrapT;
+    GLint filtroMin, filtroMag;
+    bool mipmaps;
+    bool anisotropia; // o máximo que a placa aceitar
+    bool usarKtx2;    // troca um .png pelo .ktx2 ao lado dele, se houver
+
+    OpcoesTextura() {
+        this->wrapS = this->wrapT = GL_REPEAT;
+        this->filtroMin = this->filtroMag = GL_NEAREST;
+        this->mipmaps = true;
+        this->anisotropia = false;
+        this->usarKtx2 = true;
+    }
+};
+
+struct InfoTextura {
+    GLuint texID;
+    int largura, altura;
+    int canais;      // do arquivo
+    GLenum formato;  // GL_RGBA8 ou o formato comprimido do .ktx2
+    size_t bytes;    // na GPU, com os mipmaps
+    std::string arquivo; // o que foi lido de fato (o .ktx2, se trocou)
+};
+
+class CarregadorTexturas {
+    struct Pedido {
+        GLuint texID;
+        std::string caminho;
+        GLenum formato; // GL_RGBA8: decodificar; outro: copiar os níveis do .ktx2
+        int nNiveis;
+    };
+
+    struct Decodificada {
+        GLuint texID;
+        std::string caminho;
+        int largura, altura;
+        GLenum formato;
+        unsigned char *pixels; // RGBA da stbi_load, ou os níveis do .ktx2 em seguida (malloc); NULL se falhou
+        std::vector<size_t> bytesNiveis; // só no .ktx2
+    };
+
+    std::vector<std::thread> threads;
+
+    std::mutex mtxPedidos;
+    std::condition_variable cvPedidos; // há pedido ou é para parar
+    std::condition_variable cvOcioso;  // pendentes chegou a 0
+    std::deque<Pedido> pedidos;
+    long pendentes; // pedidos ainda não decodificados
+    bool parar;
+
+    std::mutex mtxProntas;
+    std::vector<Decodificada> prontas;
+
+    // Só na thread do contexto GL
+    std::vector<Decodificada> aEnviar;
+    std::vector<OpcoesTextura> opcoesDe; // por texID
+    GLuint pbos[N_PBOS_TEXTURA];
+    int proximoPbo;
+    long enviadas;
+    size_t bytesEnviados;
+
+public:
+    CarregadorTexturas() {
+        this->pendentes = 0;
+        this->parar = false;
+        for (int k = 0; k < N_PBOS_TEXTURA; k++)
+            this->pbos[k] = 0;
+        this->proximoPbo = 0;
+        this->enviadas = 0;
+        this->bytesEnviados = 0;
+    }
+
+    ~CarregadorTexturas() {
+        this->pararThreads();
+        this->descartar();
+    }
+
+    // Sobe nThreads threads de decodificação (<= 0: uma por núcleo, até 4) e
+    // cria os PBOs; precisa do contexto GL corrente
+    bool iniciar(int nThreads, std::string &erro) {
+        if (!this->threads.empty()) {
+            erro = "CarregadorTexturas ja iniciado";
+            return false;
+        }
+        if (nThreads <= 0)
+            nThreads = std::min(4, (int)std::thread::hardware_concurrency());
+        if (nThreads <= 0)
+            nThreads = 1;
+
+        this->parar = false;
+        this->pendentes = 0;
+        try {
+            for (int t = 0; t < nThreads; t++)
+                this->threads.push_back(std::thread(&CarregadorTexturas::trabalhar, this));
+        } catch (const std::system_error &e) {
+            erro = std::string("Erro ao criar threads de textura: ") + e.what();
+            this->pararThreads();
+            return false;
+        }
+        glGenBuffers(N_PBOS_TEXTURA, this->pbos);
+        return true;
+    }
+
+    // Para as threads, descarta o que não foi enviado e apaga os PBOs (as
+    // texturas continuam com quem as pediu). Com o contexto GL ainda ativo
+    void encerrar() {
+        this->pararThreads();
+        this->descartar();
+        if (this->pbos[0] != 0)
+            glDeleteBuffers(N_PBOS_TEXTURA, this->pbos);
+        for (int k = 0; k < N_PBOS_TEXTURA; k++)
+            this->pbos[k] = 0;
+    }
+
+    // Cria a textura com a imagem provisória e pede a decodificação. Falha
+    // na hora se o arquivo não existe ou não é uma imagem
+    bool carregar(const std::string &caminho, const OpcoesTextura &opcoes, InfoTextura &info, std::string &erro) {
+        if (this->threads.empty()) {
+            erro = "CarregadorTexturas nao iniciado";
+            return false;
+        }
+        int nNiveis;
+        if (!escolherArquivo(caminho, opcoes, info, nNiveis, erro))
+            return false;
+
+        glGenTextures(1, &info.texID);
+        glBindTexture(GL_TEXTURE_2D, info.texID);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, opcoes.wrapS);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, opcoes.wrapT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, opcoes.filtroMin);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, opcoes.filtroMag);
+        if (opcoes.anisotropia) {
+            GLfloat maxAniso = 0.0f;
+            glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAniso);
+            if (maxAniso > 0.0f)
+                glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, maxAniso);
+        }
+
+        // Xadrez magenta e preto, sem mipmaps, até a imagem chegar
+        const unsigned char provisoria[TAM_PROVISORIA * TAM_PROVISORIA * 4] = {255, 0, 255, 255, 0, 0, 0, 255,
+                                                                               0,   0, 0,   255, 255, 0, 255, 255};
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, TAM_PROVISORIA, TAM_PROVISORIA, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                     provisoria);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        if (info.texID >= this->opcoesDe.size())
+            this->opcoesDe.resize(info.texID + 1);
+        this->opcoesDe[info.texID] = opcoes;
+
+        this->pedir(info.texID, info.arquivo, info.formato, nNiveis);
+        return true;
+    }
+
+    // Decodifica de novo o arquivo de uma textura criada por carregar(), com
+    // as mesmas opções. A textura continua com a imagem antiga até a nova
+    // ser enviada por atualizar(); info recebe as dimensões novas
+    bool recarregar(GLuint texID, const std::string &caminho, InfoTextura &info, std::string &erro) {
+        if (this->threads.empty()) {
+            erro = "CarregadorTexturas nao iniciado";
+            return false;
+        }
+        if (texID >= this->opcoesDe.size()) {
+            erro = "Textura nao foi criada pelo CarregadorTexturas: " + caminho;
+            return false;
+        }
+        int nNiveis;
+        if (!escolherArquivo(caminho, this->opcoesDe[texID], info, nNiveis, erro))
+            return false;
+        info.texID = texID;
+
+        this->pedir(texID, info.arquivo, info.formato, nNiveis);
+        return true;
+    }
+
+    // Envia para a GPU as imagens já decodificadas, até maxBytes de pixels
+    // (0: todas). Não espera pelas threads. false se alguma imagem não pôde
+    // ser decodificada (a textura fica com a provisória)
+    bool atualizar(std::string &erro, size_t maxBytes = 0) {
+        {
+            std::unique_lock<std::mutex> trava(this->mtxProntas, std::try_to_lock);
+            if (trava.owns_lock() && !this->prontas.empty()) {
+                this->aEnviar.insert(this->aEnviar.end(), this->prontas.begin(), this->prontas.end());
+                this->prontas.clear();
+            }
+        }
+
+        bool ok = true;
+        size_t bytes = 0;
+        size_t k = 0;
+        for (; k < this->aEnviar.size(); k++) {
+            Decodificada &d = this->aEnviar[k];
+            if (d.pixels == NULL) {
+                erro += (ok ? "" : "\n") + std::string("Falha ao decodificar ") + d.caminho;
+                ok = false;
+                continue;
+            }
+            size_t tamanho = bytesPixels(d);
+            if (maxBytes > 0 && bytes > 0 && bytes + tamanho > maxBytes)
+                break;
+            this->enviar(d);
+            bytes += tamanho;
+        }
+        this->aEnviar.erase(this->aEnviar.begin(), this->aEnviar.begin() + k);
+        return ok;
+    }
+
+    // Espera todas as decodificações pedidas e envia todas
+    bool aguardar(std::string &erro) {
+        {
+            std::unique_lock<std::mutex> trava(this->mtxPedidos);
+            this->cvOcioso.wait(trava, [this] { return this->pendentes == 0; });
+        }
+        bool ok = true;
+        for (;;) {
+            {
+                std::lock_guard<std::mutex> trava(this->mtxProntas);
+                if (this->prontas.empty() && this->aEnviar.empty())
+                    break;
+            }
+            ok = this->atualizar(erro) && ok;
+        }
+        return ok;
+    }
+
+    // Texturas pedidas que ainda mostram a provisória
+    long getPendentes() {
+        long n;
+        {
+            std::lock_guard<std::mutex> trava(this->mtxPedidos);
+            n = this->pendentes;
+        }
+        std::lock_guard<std::mutex> trava(this->mtxProntas);
+        return n + (long)this->prontas.size() + (long)this->aEnviar.size();
+    }
+
+    long getEnviadas() const {
+        return this->enviadas;
+    }
+
+    size_t getBytesEnviados() const {
+        return this->bytesEnviados;
+    }
+
+    // Formato GL de um vkFormat do .ktx2, ou 0 se a placa não aceita
+    static GLenum formatoKtx2(uint32_t vkFormat) {
+        if (vkFormat == VK_FORMAT_BC7_UNORM_BLOCK && (GLAD_GL_VERSION_4_2 || GLAD_GL_ARB_texture_compression_bptc))
+            return GL_COMPRESSED_RGBA_BPTC_UNORM;
+        if (vkFormat == VK_FORMAT_BC3_UNORM_BLOCK && GLAD_GL_EXT_texture_compression_s3tc)
+            return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        return 0;
+    }
+
+private:
+    // Decide entre o arquivo pedido e o .ktx2 ao lado dele e lê só o
+    // cabeçalho: dimensões, formato e memória de vídeo
+    static bool escolherArquivo(const std::string &caminho, const OpcoesTextura &opcoes, InfoTextura &info,
+                                int &nNiveis, std::string &erro) {
+        size_t ponto = caminho.find_last_of('.');
+        std::string ext = ponto == std::string::npos ? "" : caminho.substr(ponto);
+        for (size_t k = 0; k < ext.size(); k++)
+            ext[k] = (char)tolower((unsigned char)ext[k]);
+
+        if (ext == ".ktx2")
+            return lerCabecalhoKtx2(caminho, opcoes, info, nNiveis, erro);
+        if (opcoes.usarKtx2 && ponto != std::string::npos) {
+            std::string ktx2 = caminho.substr(0, ponto) + ".ktx2";
+            struct stat origem, comprimida;
+            std::string ignorado;
+            if (stat(ktx2.c_str(), &comprimida) == 0 &&
+                (stat(caminho.c_str(), &origem) != 0 || comprimida.st_mtime >= origem.st_mtime) &&
+                lerCabecalhoKtx2(ktx2, opcoes, info, nNiveis, ignorado))
+                return true;
+        }
+
+        if (!stbi_info(caminho.c_str(), &info.largura, &info.altura, &info.canais)) {
+            erro = "Falha ao ler " + caminho + ": " + stbi_failure_reason();
+            return false;
+        }
+        info.formato = GL_RGBA8;
+        info.bytes = (size_t)info.largura * info.altura * 4;
+        if (opcoes.mipmaps)
+            info.bytes = info.bytes * 4 / 3;
+        info.arquivo = caminho;
+        nNiveis = 1;
+        return true;
+    }
+
+    static bool lerCabecalhoKtx2(const std::string &caminho, const OpcoesTextura &opcoes, InfoTextura &info,
+                                 int &nNiveis, std::string &erro) {
+        TexturaKtx2 ktx;
+        if (!ktx.abrir(caminho, erro))
+            return false;
+        GLenum formato = formatoKtx2(ktx.getVkFormat());
+        if (formato == 0) {
+            erro = caminho + ": formato comprimido nao suportado por esta placa";
+            return false;
+        }
+        info.largura = ktx.getLargura();
+        info.altura = ktx.getAltura();
+        info.canais = 4;
+        info.formato = formato;
+        nNiveis = opcoes.mipmaps ? ktx.getNumNiveis() : 1;
+        info.bytes = ktx.getBytesNiveis(nNiveis);
+        info.arquivo = caminho;
+        return true;
+    }
+
+    static size_t bytesPixels(const Decodificada &d) {
+        if (d.formato == GL_RGBA8)
+            return (size_t)d.largura * d.altura * 4;
+        size_t total = 0;
+        for (size_t k = 0; k < d.bytesNiveis.size(); k++)
+            total += d.bytesNiveis[k];
+        return total;
+    }
+
+    static void liberarPixels(Decodificada &d) {
+        if (d.formato == GL_RGBA8)
+            stbi_image_free(d.pixels);
+        else
+            free(d.pixels);
+        d.pixels = NULL;
+    }
+
+    // Copia os níveis do .ktx2 para um bloco só, na ordem do envio
+    static void lerNiveisKtx2(const Pedido &pedido, Decodificada &d) {
+        TexturaKtx2 ktx;
+        std::string erro;
+        if (!ktx.abrir(pedido.caminho, erro) || ktx.getNumNiveis() < pedido.nNiveis)
+            return;
+        d.largura = ktx.getLargura();
+        d.altura = ktx.getAltura();
+        d.pixels = (unsigned char *)malloc(ktx.getBytesNiveis(pedido.nNiveis));
+        if (d.pixels == NULL)
+            return;
+        size_t pos = 0;
+        for (int k = 0; k < pedido.nNiveis; k++) {
+            memcpy(d.pixels + pos, ktx.getDadosNivel(k), ktx.getBytesNivel(k));
+            d.bytesNiveis.push_back(ktx.getBytesNivel(k));
+            pos += ktx.getBytesNivel(k);
+        }
+    }
+
+    void pedir(GLuint texID, const std::string &caminho, GLenum formato, int nNiveis) {
+        Pedido pedido = {texID, caminho, formato, nNiveis};
+        {
+            std::lock_guard<std::mutex> trava(this->mtxPedidos);
+            this->pedidos.push_back(pedido);
+            this->pendentes++;
+        }
+        this->cvPedidos.notify_one();
+    }
+
+    void trabalhar() {
+        for (;;) {
+            Pedido pedido;
+            {
+                std::unique_lock<std::mutex> trava(this->mtxPedidos);
+                this->cvPedidos.wait(trava, [this] { return this->parar || !this->pedidos.empty(); });
+                if (this->pedidos.empty())
+                    return;
+                pedido = this->pedidos.front();
+                this->pedidos.pop_front();
+            }
+
+            Decodificada d;
+            int canais;
+            d.texID = pedido.texID;
+            d.caminho = pedido.caminho;
+            d.formato = pedido.formato;
+            d.pixels = NULL;
+            if (pedido.formato == GL_RGBA8)
+                d.pixels = stbi_load(pedido.caminho.c_str(), &d.largura, &d.altura, &canais, 4);
+            else
+                lerNiveisKtx2(pedido, d);
+
+            {
+                std::lock_guard<std::mutex> trava(this->mtxProntas);
+                this->prontas.push_back(d);
+            }
+            {
+                std::lock_guard<std::mutex> trava(this->mtxPedidos);
+                if (--this->pendentes == 0)
+                    this->cvOcioso.notify_all();
+            }
+        }
+    }
+
+    // Copia os pixels para o PBO da vez e especifica a textura a partir dele
+    void enviar(Decodificada &d) {
+        size_t tamanho = bytesPixels(d);
+        GLuint pbo = this->pbos[this->proximoPbo];
+        this->proximoPbo = (this->proximoPbo + 1) % N_PBOS_TEXTURA;
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)tamanho, NULL, GL_STREAM_DRAW);
+        void *destino = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)tamanho,
+                                         GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        const GLvoid *origem = 0; // deslocamento dentro do PBO
+        if (destino != NULL) {
+            memcpy(destino, d.pixels, tamanho);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        } else {
+            // Sem mapear, envia direto da memória da CPU
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            origem = d.pixels;
+        }
+
+        const OpcoesTextura &opcoes = this->opcoesDe[d.texID];
+        glBindTexture(GL_TEXTURE_2D, d.texID);
+        if (d.formato == GL_RGBA8) {
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, d.largura, d.altura, 0, GL_RGBA, GL_UNSIGNED_BYTE, origem);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            if (opcoes.mipmaps) {
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+                glGenerateMipmap(GL_TEXTURE_2D);
+            }
+        } else {
+            // Os níveis já vêm prontos do .ktx2, um atrás do outro
+            size_t pos = 0;
+            for (size_t k = 0; k < d.bytesNiveis.size(); k++) {
+                glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)k, d.formato, dimensaoNivel(d.largura, (int)k),
+                                       dimensaoNivel(d.altura, (int)k), 0, (GLsizei)d.bytesNiveis[k],
+                                       (const GLubyte *)origem + pos);
+                pos += d.bytesNiveis[k];
+            }
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)d.bytesNiveis.size() - 1);
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        liberarPixels(d);
+        this->enviadas++;
+        this->bytesEnviados += tamanho;
+    }
+
+    void pararThreads() {
+        {
+            std::lock_guard<std::mutex> trava(this->mtxPedidos);
+            this->parar = true;
+            this->pendentes -= (long)this->pedidos.size();
+            this->pedidos.clear();
+        }
+        this->cvPedidos.notify_all();
+        for (size_t t = 0; t < this->threads.size(); t++)
+            this->threads[t].join();
+        this->threads.clear();
+    }
+
+    // Libera os pixels decodificados que não foram enviados
+    void descartar() {
+        std::lock_guard<std::mutex> trava(this->mtxProntas);
+        for (size_t k = 0; k < this->prontas.size(); k++)
+            liberarPixels(this->prontas[k]);
+        for (size_t k = 0; k < this->aEnviar.size(); k++)
+            liberarPixels(this->aEnviar[k]);
+        this->prontas.clear();
+        this->aEnviar.clear();
+    }
+};
+
+#endif /* TextureLoader_h */
@@ -0,0 +1,550 @@
+//
+//  TmxLoader.h
+//
+//  Leitura de mapas do Tiled (.tmx) em fluxo: o arquivo é lido em blocos e
+//  os gids de cada camada são decodificados conforme chegam e entregues a um
+//  DestinoTmx, sem montar árvore XML nem guardar o texto do arquivo.
+//
+//  Suporta as codificações de camada "csv", "base64" (sem compressão, zlib ou
+//  gzip) e XML (<tile gid="..."/>), várias camadas e vários tilesets. Os gids
+//  são entregues como estão no arquivo (firstgid e bits de espelhamento
+//  incluídos); cabe ao destino converter para índice no tileset.
+//
+//  A descompressão usa o zlib da stb_image: quem inclui este arquivo precisa
+//  ter a implementação da stb_image em algum .cpp (STB_IMAGE_IMPLEMENTATION).
+//
+
+#ifndef TmxLoader_h
+#define TmxLoader_h
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <stb_image.h>
+
+// Bits altos do gid usados pelo Tiled para espelhar/rotacionar o tile
+#define TMX_FLAGS_GID 0xF0000000u
+
+struct TilesetTmx {
+    int firstgid;
+    std::string source; // .tsx externo, ou o nome do tileset embutido
+};
+
+struct CamadaTmx {
+    std::string nome;
+    int largura, altura;
+    std::vector<uint32_t> gids; // em ordem de linha; 0 = sem tile
+};
+
+struct MapaTmx {
+    std::string orientacao;
+    int largura, altura;
+    int tileWidth, tileHeight;
+    std::vector<TilesetTmx> tilesets;
+    std::vector<CamadaTmx> camadas;
+};
+
+// Recebe o mapa enquanto o arquivo é lido. As chamadas chegam na ordem do
+// arquivo: iniciarMapa, tilesets, e para cada camada iniciarCamada, um ou
+// mais receberTiles (em ordem de linha) e terminarCamada
+class DestinoTmx {
+public:
+    virtual ~DestinoTmx() {}
+
+    // info traz só os atributos de <map>, sem tilesets e camadas
+    virtual bool iniciarMapa(const MapaTmx & /*info*/, std::string & /*erro*/) {
+        return true;
+    }
+
+    virtual void adicionarTileset(const TilesetTmx & /*tileset*/) {
+    }
+
+    // camada sem gids; largura * altura tiles vão chegar em receberTiles
+    virtual bool iniciarCamada(const CamadaTmx &camada, std::string &erro) = 0;
+
+    virtual void receberTiles(size_t primeiro, const uint32_t *gids, size_t n) = 0;
+
+    virtual bool terminarCamada(std::string & /*erro*/) {
+        return true;
+    }
+};
+
+class LeitorTmx {
+    enum Estado { TEXTO, TAG, COMENTARIO };
+    enum Codificacao { COD_XML, COD_CSV, COD_BASE64 };
+    enum Compressao { SEM_COMPRESSAO, COMP_ZLIB, COMP_GZIP };
+
+    static constexpr size_t TAM_BLOCO = 1 << 16; // leitura do arquivo
+    static constexpr size_t TAM_LOTE = 4096;     // gids por chamada de receberTiles
+
+    DestinoTmx *destino;
+    std::string caminho, erro;
+    int linha;
+
+    Estado estado;
+    std::string tag;
+    char aspas;
+    int fimComentario;
+
+    bool temMapa, dentroCamada, dentroDados;
+    MapaTmx info;
+    CamadaTmx camada;
+    size_t nTiles, recebidos;
+    Codificacao codificacao;
+    Compressao compressao;
+
+    uint32_t lote[TAM_LOTE];
+    size_t nLote;
+
+    // Estado dos decodificadores, mantido entre blocos do arquivo
+    uint32_t numero;
+    bool temNumero;
+    uint32_t sextetos;
+    int nSextetos;
+    uint32_t palavra;
+    int nBytesPalavra;
+    std::vector<unsigned char> comprimidos;
+
+public:
+    LeitorTmx() {
+        this->destino = NULL;
+    }
+
+    bool ler(const std::string &caminho, DestinoTmx &destino, std::string &erro) {
+        FILE *arq = fopen(caminho.c_str(), "rb");
+        if (!arq) {
+            erro = "Erro ao abrir arquivo: " + caminho;
+            return false;
+        }
+
+        this->destino = &destino;
+        this->caminho = caminho;
+        this->erro.clear();
+        this->linha = 1;
+        this->estado = TEXTO;
+        this->tag.clear();
+        this->aspas = 0;
+        this->fimComentario = 0;
+        this->temMapa = this->dentroCamada = this->dentroDados = false;
+        this->info = MapaTmx();
+
+        std::vector<char> bloco(TAM_BLOCO);
+        size_t lidos;
+        bool ok = true;
+        while (ok && (lidos = fread(bloco.data(), 1, bloco.size(), arq)) > 0)
+            ok = processar(bloco.data(), lidos);
+        fclose(arq);
+
+        if (ok && (this->dentroDados || this->estado != TEXTO))
+            ok = falhar("fim do arquivo no meio de uma tag ou de <data>");
+        if (ok && !this->temMapa)
+            ok = falhar("<map> nao encontrado");
+        if (!ok)
+            erro = this->erro;
+        return ok;
+    }
+
+private:
+    bool falhar(const std::string &mensagem) {
+        this->erro = this->caminho + ":" + std::to_string(this->linha) + ": " + mensagem;
+        return false;
+    }
+
+    bool processar(const char *p, size_t n) {
+        for (size_t k = 0; k < n; k++) {
+            char c = p[k];
+            if (c == '\n')
+                this->linha++;
+
+            switch (this->estado) {
+            case TEXTO:
+                if (c == '<') {
+                    this->estado = TAG;
+                    this->tag.clear();
+                    this->aspas = 0;
+                } else if (this->dentroDados && !decodificar(c)) {
+                    return false;
+                }
+                break;
+
+            case TAG:
+                if (this->aspas) {
+                    if (c == this->aspas)
+                        this->aspas = 0;
+                    this->tag += c;
+                } else if (c == '"' || c == '\'') {
+                    this->aspas = c;
+                    this->tag += c;
+                } else if (c == '>') {
+                    this->estado = TEXTO;
+                    if (!processarTag())
+                        return false;
+                } else {
+                    this->tag += c;
+                    if (this->tag.size() == 3 && this->tag == "!--") {
+                        this->estado = COMENTARIO;
+                        this->fimComentario = 0;
+                    }
+                }
+                break;
+
+            case COMENTARIO:
+                // Procura "-->"
+                if (c == '-')
+                    this->fimComentario = this->fimComentario < 2 ? this->fimComentario + 1 : 2;
+                else if (c == '>' && this->fimComentario == 2)
+                    this->estado = TEXTO;
+                else
+                    this->fimComentario = 0;
+                break;
+            }
+        }
+        return true;
+    }
+
+    static bool atributo(const std::string &atributos, const char *nome, std::string &valor) {
+        std::string chave = std::string(nome) + "=\"";
+        size_t pos = 0;
+        while ((pos = atributos.find(chave, pos)) != std::string::npos) {
+            // O nome tem que começar depois de espaço ("id" não casa com "nextobjectid")
+            if (pos > 0 && strchr(" \t\r\n", atributos[pos - 1])) {
+                size_t ini = pos + chave.size();
+                size_t f = atributos.find('"', ini);
+                if (f == std::string::npos)
+                    return false;
+                valor = atributos.substr(ini, f - ini);
+                return true;
+            }
+            pos++;
+        }
+        return false;
+    }
+
+    static int atributoInt(const std::string &atributos, const char *nome, int padrao) {
+        std::string valor;
+        return atributo(atributos, nome, valor) ? atoi(valor.c_str()) : padrao;
+    }
+
+    bool processarTag() {
+        if (this->tag.empty() || this->tag[0] == '?' || this->tag[0] == '!')
+            return true;
+
+        bool fechamento = this->tag[0] == '/';
+        size_t ini = fechamento ? 1 : 0;
+        size_t fimNome = this->tag.find_first_of(" \t\r\n/", ini);
+        if (fimNome == std::string::npos)
+            fimNome = this->tag.size();
+        std::string nome = this->tag.substr(ini, fimNome - ini);
+        bool vazia = this->tag[this->tag.size() - 1] == '/';
+        const std::string &atributos = this->tag;
+
+        if (fechamento) {
+            if (nome == "data" && this->dentroDados)
+                return terminarDados();
+            if (nome == "layer")
+                this->dentroCamada = false;
+            return true;
+        }
+
+        if (nome == "map") {
+            this->temMapa = true;
+            atributo(atributos, "orientation", this->info.orientacao);
+            this->info.largura = atributoInt(atributos, "width", 0);
+            this->info.altura = atributoInt(atributos, "height", 0);
+            this->info.tileWidth = atributoInt(atributos, "tilewidth", 0);
+            this->info.tileHeight = atributoInt(atributos, "tileheight", 0);
+            if (atributoInt(atributos, "infinite", 0) != 0)
+                return falhar("mapas infinitos (em chunks) nao sao suportados");
+            if (this->info.largura <= 0 || this->info.altura <= 0)
+                return falhar("<map> com dimensoes invalidas");
+            std::string erroDestino;
+            if (!this->destino->iniciarMapa(this->info, erroDestino))
+                return falhar(erroDestino);
+        } else if (nome == "tileset" && !this->dentroCamada) {
+            TilesetTmx ts;
+            ts.firstgid = atributoInt(atributos, "firstgid", 1);
+            if (!atributo(atributos, "source", ts.source))
+                atributo(atributos, "name", ts.source);
+            this->destino->adicionarTileset(ts);
+        } else if (nome == "layer") {
+            this->dentroCamada = true;
+            this->camada = CamadaTmx();
+            atributo(atributos, "name", this->camada.nome);
+            this->camada.largura = atributoInt(atributos, "width", this->info.largura);
+            this->camada.altura = atributoInt(atributos, "height", this->info.altura);
+            if (this->camada.largura <= 0 || this->camada.altura <= 0)
+                return falhar("camada \"" + this->camada.nome + "\" com dimensoes invalidas");
+        } else if (nome == "data" && this->dentroCamada) {
+            if (!iniciarDados(atributos))
+                return false;
+            if (vazia)
+                return terminarDados();
+        } else if (nome == "chunk" && this->dentroDados) {
+            return falhar("mapas infinitos (em chunks) nao sao suportados");
+        } else if (nome == "tile" && this->dentroDados) {
+            if (this->codificacao != COD_XML)
+                return falhar("<tile> dentro de <data> codificado");
+            return emitirGid((uint32_t)strtoul(valorOu(atributos, "gid", "0").c_str(), NULL, 10));
+        }
+        return true;
+    }
+
+    static std::string valorOu(const std::string &atributos, const char *nome, const char *padrao) {
+        std::string valor;
+        return atributo(atributos, nome, valor) ? valor : std::string(padrao);
+    }
+
+    bool iniciarDados(const std::string &atributos) {
+        std::string cod = valorOu(atributos, "encoding", "");
+        std::string comp = valorOu(atributos, "compression", "");
+
+        if (cod == "")
+            this->codificacao = COD_XML;
+        else if (cod == "csv")
+            this->codificacao = COD_CSV;
+        else if (cod == "base64")
+            this->codificacao = COD_BASE64;
+        else
+            return falhar("codificacao \"" + cod + "\" desconhecida");
+
+        if (comp == "")
+            this->compressao = SEM_COMPRESSAO;
+        else if (comp == "zlib" && this->codificacao == COD_BASE64)
+            this->compressao = COMP_ZLIB;
+        else if (comp == "gzip" && this->codificacao == COD_BASE64)
+            this->compressao = COMP_GZIP;
+        else
+            return falhar("compressao \"" + comp + "\" nao suportada (use zlib, gzip ou nenhuma)");
+
+        this->dentroDados = true;
+        this->nTiles = (size_t)this->camada.largura * this->camada.altura;
+        this->recebidos = 0;
+        this->nLote = 0;
+        this->numero = 0;
+        this->temNumero = false;
+        this->sextetos = 0;
+        this->nSextetos = 0;
+        this->palavra = 0;
+        this->nBytesPalavra = 0;
+        this->comprimidos.clear();
+
+        std::string erroDestino;
+        if (!this->destino->iniciarCamada(this->camada, erroDestino))
+            return falhar(erroDestino);
+        return true;
+    }
+
+    bool decodificar(char c) {
+        if (this->codificacao == COD_CSV) {
+            if ((unsigned)(c - '0') <= 9u) {
+                this->numero = this->numero * 10u + (uint32_t)(c - '0');
+                this->temNumero = true;
+                return true;
+            }
+            if (c == ',' || c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+                if (this->temNumero) {
+                    this->temNumero = false;
+                    uint32_t gid = this->numero;
+                    this->numero = 0;
+                    return emitirGid(gid);
+                }
+                return true;
+            }
+            return falhar(std::string("caractere inesperado no CSV: '") + c + "'");
+        }
+
+        if (this->codificacao == COD_BASE64) {
+            int v;
+            if (c >= 'A' && c <= 'Z')
+                v = c - 'A';
+            else if (c >= 'a' && c <= 'z')
+                v = c - 'a' + 26;
+            else if (c >= '0' && c <= '9')
+                v = c - '0' + 52;
+            else if (c == '+')
+                v = 62;
+            else if (c == '/')
+                v = 63;
+            else if (c == '=')
+                return terminarGrupoBase64();
+            else if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+                return true;
+            else
+                return falhar(std::string("caractere inesperado no base64: '") + c + "'");
+
+            this->sextetos = (this->sextetos << 6) | (uint32_t)v;
+            if (++this->nSextetos == 4) {
+                this->nSextetos = 0;
+                return emitirByte((this->sextetos >> 16) & 0xFF) && emitirByte((this->sextetos >> 8) & 0xFF) &&
+                       emitirByte(this->sextetos & 0xFF);
+            }
+            return true;
+        }
+
+        // Codificação XML: só espaços entre as tags <tile>
+        if (c != ' ' && c != '\t' && c != '\r' && c != '\n')
+            return falhar(std::string("texto inesperado em <data>: '") + c + "'");
+        return true;
+    }
+
+    // Último grupo incompleto (antes do '=' ou do fim de <data>): 2 sextetos
+    // dão 1 byte, 3 sextetos dão 2 bytes
+    bool terminarGrupoBase64() {
+        int n = this->nSextetos;
+        uint32_t s = this->sextetos;
+        this->nSextetos = 0;
+        this->sextetos = 0;
+        if (n == 2)
+            return emitirByte((s >> 4) & 0xFF);
+        if (n == 3)
+            return emitirByte((s >> 10) & 0xFF) && emitirByte((s >> 2) & 0xFF);
+        return true;
+    }
+
+    bool emitirByte(uint32_t b) {
+        if (this->compressao != SEM_COMPRESSAO) {
+            this->comprimidos.push_back((unsigned char)b);
+            return true;
+        }
+        // gids em little-endian, 4 bytes cada
+        this->palavra |= b << (8 * this->nBytesPalavra);
+        if (++this->nBytesPalavra == 4) {
+            uint32_t gid = this->palavra;
+            this->palavra = 0;
+            this->nBytesPalavra = 0;
+            return emitirGid(gid);
+        }
+        return true;
+    }
+
+    bool emitirGid(uint32_t gid) {
+        if (this->recebidos + this->nLote >= this->nTiles)
+            return falhar("camada \"" + this->camada.nome + "\" com mais tiles que " +
+                          std::to_string(this->camada.largura) + "x" + std::to_string(this->camada.altura));
+        this->lote[this->nLote++] = gid;
+        if (this->nLote == TAM_LOTE)
+            entregarLote();
+        return true;
+    }
+
+    void entregarLote() {
+        if (this->nLote > 0)
+            this->destino->receberTiles(this->recebidos, this->lote, this->nLote);
+        this->recebidos += this->nLote;
+        this->nLote = 0;
+    }
+
+    bool terminarDados() {
+        this->dentroDados = false;
+
+        if (this->codificacao == COD_CSV && this->temNumero) {
+            this->temNumero = false;
+            if (!emitirGid(this->numero))
+                return false;
+        }
+
+        if (this->codificacao == COD_BASE64 && !terminarGrupoBase64())
+            return false;
+        if (this->compressao != SEM_COMPRESSAO && !descomprimir())
+            return false;
+
+        entregarLote();
+        if (this->recebidos != this->nTiles)
+            return falhar("camada \"" + this->camada.nome + "\" com " + std::to_string(this->recebidos) +
+                          " tiles, esperados " + std::to_string(this->nTiles));
+
+        std::string erroDestino;
+        if (!this->destino->terminarCamada(erroDestino))
+            return falhar(erroDestino);
+        return true;
+    }
+
+    // A camada comprimida é a única parte guardada inteira: os bytes
+    // comprimidos e a saída de 4 bytes por tile, já que o zlib da stb_image
+    // não descomprime em fluxo
+    bool descomprimir() {
+        const unsigned char *entrada = this->comprimidos.data();
+        size_t tamEntrada = this->comprimidos.size();
+
+        if (this->compressao == COMP_GZIP) {
+            // Cabeçalho gzip (RFC 1952) antes do deflate puro
+            if (tamEntrada < 18 || entrada[0] != 0x1f || entrada[1] != 0x8b || entrada[2] != 8)
+                return falhar("dados gzip invalidos na camada \"" + this->camada.nome + "\"");
+            unsigned flags = entrada[3];
+            size_t pos = 10;
+            if (flags & 4)
+                pos += 2 + (entrada[pos] | (entrada[pos + 1] << 8));
+            for (unsigned f = 8; f <= 16; f <<= 1)
+                if (flags & f)
+                    while (pos < tamEntrada && entrada[pos++] != 0) {
+                    }
+            if (flags & 2)
+                pos += 2;
+            if (pos + 8 > tamEntrada)
+                return falhar("dados gzip invalidos na camada \"" + this->camada.nome + "\"");
+            entrada += pos;
+            tamEntrada -= pos + 8; // CRC32 e tamanho no fim
+        }
+
+        std::vector<uint32_t> saida(this->nTiles);
+        int bytesSaida = (int)(this->nTiles * 4);
+        int obtidos = this->compressao == COMP_ZLIB
+                          ? stbi_zlib_decode_buffer((char *)saida.data(), bytesSaida, (const char *)entrada,
+                                                    (int)tamEntrada)
+                          : stbi_zlib_decode_noheader_buffer((char *)saida.data(), bytesSaida,
+                                                             (const char *)entrada, (int)tamEntrada);
+        if (obtidos != bytesSaida)
+            return falhar("falha ao descomprimir a camada \"" + this->camada.nome + "\"");
+        std::vector<unsigned char>().swap(this->comprimidos);
+
+        // Bytes little-endian -> gids, no mesmo vetor
+        const unsigned char *b = (const unsigned char *)saida.data();
+        for (size_t k = 0; k < this->nTiles; k++, b += 4)
+            saida[k] = (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+
+        this->destino->receberTiles(0, saida.data(), this->nTiles);
+        this->recebidos = this->nTiles;
+        return true;
+    }
+};
+
+// Destino que guarda tudo em um MapaTmx
+class ColetorTmx : public DestinoTmx {
+    MapaTmx &mapa;
+
+public:
+    ColetorTmx(MapaTmx &mapa) : mapa(mapa) {
+    }
+
+    bool iniciarMapa(const MapaTmx &info, std::string & /*erro*/) {
+        this->mapa = info;
+        return true;
+    }
+
+    void adicionarTileset(const TilesetTmx &tileset) {
+        this->mapa.tilesets.push_back(tileset);
+    }
+
+    bool iniciarCamada(const CamadaTmx &camada, std::string & /*erro*/) {
+        this->mapa.camadas.push_back(camada);
+        this->mapa.camadas.back().gids.resize((size_t)camada.largura * camada.altura);
+        return true;
+    }
+
+    void receberTiles(size_t primeiro, const uint32_t *gids, size_t n) {
+        memcpy(this->mapa.camadas.back().gids.data() + primeiro, gids, n * sizeof(uint32_t));
+    }
+};
+
+inline bool carregarTmx(const std::string &caminho, MapaTmx &mapa, std::string &erro) {
+    mapa = MapaTmx();
+    ColetorTmx coletor(mapa);
+    LeitorTmx leitor;
+    return leitor.ler(caminho, coletor, erro);
+}
+
+#endif /* TmxLoader_h */
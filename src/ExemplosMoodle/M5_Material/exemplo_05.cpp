@@ -18,6 +18,8 @@
 #include <vector>
 
 #include "Layer.h"
+#include "ShaderProgram.h"
+#include "TextureLoader.h"
 
 using namespace std;
 
@@ -28,43 +30,31 @@ float PARALLAX_RATE = 0.01f;
 
 GLFWwindow *g_window = NULL;
 
+// As 5 camadas são decodificadas em paralelo (Common/TextureLoader.h)
+CarregadorTexturas carregador;
+
+// Pede a textura ao carregador; até a imagem ser decodificada e enviada
+// (carregador.atualizar() no laço) a camada mostra a textura provisória
 int loadTexture(unsigned int &texture, char *filename)
 {
-	glGenTextures(1, &texture);
-	glBindTexture(GL_TEXTURE_2D, texture);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-
-	GLfloat max_aniso = 0.0f;
-	glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &max_aniso);
-	// set the maximum!
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, max_aniso);
-
-	int width, height, nrChannels;
-
-	unsigned char *data = stbi_load(filename, &width, &height, &nrChannels, 0);
-	if (data)
-	{
-		if (nrChannels == 4)
-		{
-			cout << "Alpha channel" << endl;
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-		}
-		else
-		{
-			cout << "Without Alpha channel" << endl;
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-		}
-		glGenerateMipmap(GL_TEXTURE_2D);
-	}
-	else
+	OpcoesTextura opcoes;
+	opcoes.wrapS = opcoes.wrapT = GL_REPEAT;
+	opcoes.filtroMag = GL_LINEAR;
+	opcoes.filtroMin = GL_LINEAR_MIPMAP_LINEAR;
+	opcoes.anisotropia = true;
+
+	InfoTextura info;
+	string erro;
+	if (!carregador.carregar(filename, opcoes, info, erro))
 	{
-		std::cout << "Failed to load texture" << std::endl;
+		std::cout << "Failed to load texture: " << erro << std::endl;
+		texture = 0;
+		return 0;
 	}
-	stbi_image_free(data);
+	cout << (info.canais == 4 ? "Alpha channel" : "Without Alpha channel") << endl;
+
+	texture = info.texID;
+	return 1;
 }
 
 int main()
@@ -74,6 +64,14 @@ int main()
 
 	// inicia OpenGL e libs auxiliares
 	start_gl();
+
+	string erroTexturas;
+	if (!carregador.iniciar(0, erroTexturas))
+	{
+		std::cerr << erroTexturas << std::endl;
+		glfwTerminate();
+		return 1;
+	}
 	
 	// INIT LAYERS
 	vector<Layer *> layers;
@@ -213,6 +211,15 @@ int main()
 		return false;
 	}
 
+	// uniforms resolvidos uma vez, depois do link (Common/ShaderProgram.h)
+	ShaderProgram programa;
+	programa.adotar(shader_programme);
+	int uOffsetx = programa.localizar("offsetx");
+	int uOffsety = programa.localizar("offsety");
+	int uLayerZ = programa.localizar("layer_z");
+	int uSprite = programa.localizar("sprite");
+	long frames = 0, chamadasEvitadas = 0;
+
 	float previous = glfwGetTime();
 
 	glEnable(GL_BLEND);
@@ -228,7 +235,7 @@ int main()
 
 		glViewport(0, 0, g_gl_width, g_gl_height);
 
-		glUseProgram(shader_programme);
+		programa.usar();
 
 		glBindVertexArray(VAO);
 		for (int i = 0; i < layers.size(); i++)
@@ -236,17 +243,22 @@ int main()
 
 			layers[i]->offsetx += layers[i]->ratex * PARALLAX_RATE;
 
-			glUniform1f(glGetUniformLocation(shader_programme, "offsetx"), layers[i]->offsetx);
-			glUniform1f(glGetUniformLocation(shader_programme, "offsety"), layers[i]->offsety);
-			glUniform1f(glGetUniformLocation(shader_programme, "layer_z"), layers[i]->z);
+			programa.setFloat(uOffsetx, layers[i]->offsetx);
+			programa.setFloat(uOffsety, layers[i]->offsety);
+			programa.setFloat(uLayerZ, layers[i]->z);
 			// bind Texture
 			glActiveTexture(GL_TEXTURE0);
 			glBindTexture(GL_TEXTURE_2D, layers[i]->tid);
-			glUniform1i(glGetUniformLocation(shader_programme, "sprite"), 0);
+			programa.setInt(uSprite, 0);
 			glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 		}
 
 		glfwPollEvents();
+		if (!carregador.atualizar(erroTexturas, BYTES_TEXTURA_POR_FRAME))
+		{
+			std::cerr << erroTexturas << std::endl;
+			erroTexturas.clear();
+		}
 		if (GLFW_PRESS == glfwGetKey(g_window, GLFW_KEY_ESCAPE))
 		{
 			glfwSetWindowShouldClose(g_window, 1);
@@ -261,8 +273,16 @@ int main()
 		}
 		// put the stuff we've been drawing onto the display
 		glfwSwapBuffers(g_window);
+
+		chamadasEvitadas += ShaderProgram::getContadores().evitadas();
+		ShaderProgram::zerarContadores();
+		frames++;
 	}
 
+	if (frames > 0)
+		printf("chamadas GL evitadas pelo ShaderProgram: %.1f por frame\n", (double)chamadasEvitadas / frames);
+
+	carregador.encerrar();
 	// close GL context and any other GLFW resources
 	glfwTerminate();
 	return 0;
@@ -1,3 +1,6 @@
+#ifndef TileMap_h
+#define TileMap_h
+
 class TileMap {
     float z;               // caso de eventual de vários tilemaps sobrepostos
     unsigned int tid;      // indicação do tileset utilizado
@@ -64,3 +67,4 @@ public:
     
 };
 
+#endif /* TileMap_h */
@@ -0,0 +1,112 @@
+//
+//  TileMapTmx.h
+//
+//  Carrega um .tmx do Tiled direto em TileMaps, um por camada, com o leitor
+//  em fluxo de Common/TmxLoader.h: os tiles vão do arquivo para o TileMap
+//  sem passar por um .tmap convertido à mão.
+//
+
+#ifndef TileMapTmx_h
+#define TileMapTmx_h
+
+#include "TileMap.h"
+#include "TmxLoader.h"
+#include <iostream>
+#include <vector>
+using namespace std;
+
+// Índice gravado nas células sem tile (gid 0 no Tiled)
+#define TILE_VAZIO 255
+
+class DestinoTileMap : public DestinoTmx {
+    vector<TilesetTmx> tilesets;
+    vector<TileMap*> camadas;
+    int firstgidCamada;     // tileset usado pela camada atual, -1 antes do primeiro tile
+    string erroCamada;
+
+public:
+    ~DestinoTileMap() {
+        for (size_t k = 0; k < this->camadas.size(); k++)
+            delete this->camadas[k];
+    }
+
+    void adicionarTileset(const TilesetTmx &tileset) {
+        this->tilesets.push_back(tileset);
+    }
+
+    bool iniciarCamada(const CamadaTmx &camada, string & /*erro*/) {
+        TileMap *tmap = new TileMap(camada.largura, camada.altura, 0);
+        // A camada de cima fica na frente (menor z no teste de profundidade)
+        tmap->setZ(-0.1f * this->camadas.size());
+        this->camadas.push_back(tmap);
+        this->firstgidCamada = -1;
+        this->erroCamada.clear();
+        return true;
+    }
+
+    void receberTiles(size_t primeiro, const uint32_t *gids, size_t n) {
+        TileMap *tmap = this->camadas.back();
+        int w = tmap->getWidth(), h = tmap->getHeight();
+        int c = (int)(primeiro % w), r = (int)(primeiro / w);
+        for (size_t k = 0; k < n; k++) {
+            uint32_t gid = gids[k] & ~TMX_FLAGS_GID;
+            unsigned char tile = TILE_VAZIO;
+            if (gid != 0) {
+                int firstgid = tilesetDoGid(gid);
+                if (this->firstgidCamada < 0)
+                    this->firstgidCamada = firstgid;
+                else if (firstgid != this->firstgidCamada && this->erroCamada.empty())
+                    this->erroCamada = "camada usa mais de um tileset (o TileMap guarda so um)";
+                uint32_t indice = gid - (uint32_t)firstgid;
+                if (indice >= TILE_VAZIO && this->erroCamada.empty())
+                    this->erroCamada = "indice de tile " + to_string(indice) + " nao cabe no TileMap";
+                tile = (unsigned char)indice;
+            }
+            // No TileMap a linha 0 é a de baixo, como em readMap
+            tmap->setTile(c, h - r - 1, tile);
+            if (++c == w) {
+                c = 0;
+                r++;
+            }
+        }
+    }
+
+    bool terminarCamada(string &erro) {
+        erro = this->erroCamada;
+        return erro.empty();
+    }
+
+    // Entrega as camadas para quem chamou; o destino deixa de ser dono delas
+    vector<TileMap*> liberarCamadas() {
+        vector<TileMap*> camadas;
+        camadas.swap(this->camadas);
+        return camadas;
+    }
+
+private:
+    // Tileset de maior firstgid que ainda é <= gid
+    int tilesetDoGid(uint32_t gid) const {
+        int firstgid = 1;
+        for (size_t k = 0; k < this->tilesets.size(); k++)
+            if ((uint32_t)this->tilesets[k].firstgid <= gid && this->tilesets[k].firstgid >= firstgid)
+                firstgid = this->tilesets[k].firstgid;
+        return firstgid;
+    }
+};
+
+// Lê todas as camadas de tiles do .tmx; vazio em caso de erro
+inline vector<TileMap*> readTmx(const char *filename) {
+    DestinoTileMap destino;
+    LeitorTmx leitor;
+    string erro;
+    if (!leitor.ler(filename, destino, erro)) {
+        cerr << erro << endl;
+        return vector<TileMap*>();
+    }
+    vector<TileMap*> camadas = destino.liberarCamadas();
+    if (camadas.empty())
+        cerr << filename << ": nenhuma camada de tiles" << endl;
+    return camadas;
+}
+
+#endif /* TileMapTmx_h */
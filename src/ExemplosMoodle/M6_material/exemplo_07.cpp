@@ -19,6 +19,10 @@
 
 #include "gl_utils.h"
 #include "TileMap.h"
+#include "MapBinary.h"
+#include "TileMapTmx.h"
+#include "ShaderProgram.h"
+#include "TextureLoader.h"
 //#include "DiamondView.h"
 #include "SlideView.h"
 #include "ltMath.h"
@@ -44,10 +48,43 @@ int cx = -1, cy = -1;
 //TilemapView *tview = new DiamondView();
 TilemapView *tview = new SlideView();
 TileMap *tmap = NULL;
+vector<TileMap*> camadas; // todas as camadas do .tmx; tmap é a primeira
 
 GLFWwindow *g_window = NULL;
 
+// O tileset é decodificado em segundo plano (Common/TextureLoader.h)
+CarregadorTexturas carregador;
+
+// Mapa compilado pelo mapc (terrain1.tmap -> terrain1.tmapb): a camada de
+// 1 byte por célula é copiada linha a linha, sem parse de texto
+TileMap * readMapBinario (const char *filename) {
+    MapaBinario arq;
+    string erro;
+    if (!arq.abrir(filename, erro)) {
+        cerr << erro << endl;
+        return NULL;
+    }
+    int camada = arq.buscarCamada("tiles");
+    if (camada < 0)
+        camada = 0;
+    if (arq.getNumCamadas() == 0 || arq.getDescritor(camada).bytesPorCelula != 1) {
+        cerr << filename << ": TileMap precisa de uma camada de 1 byte por celula" << endl;
+        return NULL;
+    }
+    int w = arq.getCabecalho().largura, h = arq.getCabecalho().altura;
+    const unsigned char *tiles = (const unsigned char *)arq.getDadosCamada(camada);
+    TileMap *tmap = new TileMap(w, h, 0);
+    // No TileMap a linha 0 é a de baixo, como em readMap
+    for(int r = 0; r < h; r++)
+        memcpy(tmap->getMap() + (h-r-1) * w, tiles + r * w, w);
+    return tmap;
+}
+
 TileMap * readMap (const char *filename) {
+    size_t n = strlen(filename);
+    if (n > 6 && strcmp(filename + n - 6, ".tmapb") == 0)
+        return readMapBinario(filename);
+
     ifstream arq(filename);
     int w, h;
     arq >> w >> h;
@@ -65,43 +102,28 @@ TileMap * readMap (const char *filename) {
     return tmap;
 }
 
+// Pede a textura ao carregador; até a imagem ser decodificada e enviada
+// (carregador.atualizar() no laço) os tiles mostram a textura provisória
 int loadTexture(unsigned int &texture, const char *filename)
 {
-	glGenTextures(1, &texture);
-	glBindTexture(GL_TEXTURE_2D, texture);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-
-	GLfloat max_aniso = 0.0f;
-	glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &max_aniso);
-	// set the maximum!
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, max_aniso);
-
-	int width, height, nrChannels;
-
-	unsigned char *data = stbi_load(filename, &width, &height, &nrChannels, 0);
-	if (data)
+	OpcoesTextura opcoes;
+	opcoes.wrapS = opcoes.wrapT = GL_CLAMP_TO_BORDER;
+	opcoes.filtroMag = GL_LINEAR;
+	opcoes.filtroMin = GL_LINEAR_MIPMAP_LINEAR;
+	opcoes.anisotropia = true;
+
+	InfoTextura info;
+	string erro;
+	if (!carregador.carregar(filename, opcoes, info, erro))
 	{
-		if (nrChannels == 4)
-		{
-			cout << "Alpha channel" << endl;
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-		}
-		else
-		{
-			cout << "Without Alpha channel" << endl;
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-		}
-		glGenerateMipmap(GL_TEXTURE_2D);
-	}
-	else
-	{
-		std::cout << "Failed to load texture" << std::endl;
+		std::cout << "Failed to load texture: " << erro << std::endl;
+		texture = 0;
+		return 0;
 	}
-	stbi_image_free(data);
+	cout << (info.canais == 4 ? "Alpha channel" : "Without Alpha channel") << endl;
+
+	texture = info.texID;
+	return 1;
 }
 
 void SRD2SRU(double &mx, double &my, float &x, float &y) {
@@ -194,7 +216,10 @@ int main()
 	glDepthFunc(GL_LESS);
 
     cout << "Tentando criar tmap" << endl;
-    tmap = readMap("terrain1.tmap");
+    camadas = readTmx("terrain1.tmx");
+    if (camadas.empty())
+        return 1;
+    tmap = camadas[0];
     tw = w / (float)tmap->getWidth();
     th = tw / 2.0f;
     tw2 = th;
@@ -209,11 +234,19 @@ int main()
         << " tileW2=" << tileW2 << " tileH2=" << tileH2
     << endl;
 
+	string erroTexturas;
+	if (!carregador.iniciar(1, erroTexturas))
+	{
+		std::cerr << erroTexturas << std::endl;
+		glfwTerminate();
+		return 1;
+	}
 	GLuint tid;
 	loadTexture(tid, "terrain.png");
 
-    tmap->setTid(tid);
-    cout << "Tmap inicializado" << endl;
+    for (size_t k = 0; k < camadas.size(); k++)
+        camadas[k]->setTid(tid);
+    cout << "Tmap inicializado (" << camadas.size() << " camada(s))" << endl;
 
 	// LOAD TEXTURES
 
@@ -299,6 +332,18 @@ int main()
 		return false;
 	}
 
+	// uniforms resolvidos uma vez, depois do link (Common/ShaderProgram.h)
+	ShaderProgram programa;
+	programa.adotar(shader_programme);
+	int uOffsetx = programa.localizar("offsetx");
+	int uOffsety = programa.localizar("offsety");
+	int uTx = programa.localizar("tx");
+	int uTy = programa.localizar("ty");
+	int uLayerZ = programa.localizar("layer_z");
+	int uWeight = programa.localizar("weight");
+	int uSprite = programa.localizar("sprite");
+	long frames = 0, chamadasEvitadas = 0;
+
 	float previous = glfwGetTime();
     
     
@@ -325,36 +370,46 @@ int main()
 
 		glViewport(0, 0, g_gl_width, g_gl_height);
 
-		glUseProgram(shader_programme);
+		programa.usar();
 
 		glBindVertexArray(VAO);
         float x, y;
         int r = 0, c = 0;
-        for(int r = 0; r < tmap->getHeight(); r++) {
-            for(int c = 0; c < tmap->getWidth(); c++) {
-                int t_id = (int) tmap->getTile(c, r);
-                int u = t_id % tileSetCols;
-                int v = t_id / tileSetCols;
+        for (size_t k = 0; k < camadas.size(); k++) {
+            TileMap *tmap = camadas[k];
+            for(int r = 0; r < tmap->getHeight(); r++) {
+                for(int c = 0; c < tmap->getWidth(); c++) {
+                    int t_id = (int) tmap->getTile(c, r);
+                    if (t_id == TILE_VAZIO)
+                        continue;
+                    int u = t_id % tileSetCols;
+                    int v = t_id / tileSetCols;
                                 
-                tview->computeDrawPosition(c, r, tw, th, x, y);
+                    tview->computeDrawPosition(c, r, tw, th, x, y);
                 
-                glUniform1f(glGetUniformLocation(shader_programme, "offsetx"), u * tileW);
-                glUniform1f(glGetUniformLocation(shader_programme, "offsety"), v * tileH);
-                glUniform1f(glGetUniformLocation(shader_programme, "tx"), x);
-                glUniform1f(glGetUniformLocation(shader_programme, "ty"), y + 1.0);
-                glUniform1f(glGetUniformLocation(shader_programme, "layer_z"), tmap->getZ());                
-                glUniform1f(glGetUniformLocation(shader_programme, "weight"), (c == cx) && (r == cy) ? 0.5 : 0.0);                
+                    programa.setFloat(uOffsetx, u * tileW);
+                    programa.setFloat(uOffsety, v * tileH);
+                    programa.setFloat(uTx, x);
+                    programa.setFloat(uTy, y + 1.0);
+                    programa.setFloat(uLayerZ, tmap->getZ());
+                    programa.setFloat(uWeight, (c == cx) && (r == cy) ? 0.5 : 0.0);
                 
-                // bind Texture
-                // glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, tmap->getTileSet());
-                glUniform1i(glGetUniformLocation(shader_programme, "sprite"), 0);
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-            }
+                    // bind Texture
+                    // glActiveTexture(GL_TEXTURE0);
+                    glBindTexture(GL_TEXTURE_2D, tmap->getTileSet());
+                    programa.setInt(uSprite, 0);
+                    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+                }
             
+            }
         }
 
 		glfwPollEvents();
+		if (!carregador.atualizar(erroTexturas))
+		{
+			std::cerr << erroTexturas << std::endl;
+			erroTexturas.clear();
+		}
 		if (GLFW_PRESS == glfwGetKey(g_window, GLFW_KEY_ESCAPE))
 		{
 			glfwSetWindowShouldClose(g_window, 1);
@@ -376,10 +431,19 @@ int main()
         
 		// put the stuff we've been drawing onto the display
 		glfwSwapBuffers(g_window);
+
+		chamadasEvitadas += ShaderProgram::getContadores().evitadas();
+		ShaderProgram::zerarContadores();
+		frames++;
 	}
 
+	if (frames > 0)
+		printf("chamadas GL evitadas pelo ShaderProgram: %.1f por frame\n", (double)chamadasEvitadas / frames);
+
+	carregador.encerrar();
 	// close GL context and any other GLFW resources
 	glfwTerminate();
-    delete tmap;
+	for (size_t k = 0; k < camadas.size(); k++)
+		delete camadas[k];
 	return 0;
 }
@@ -27,6 +27,9 @@
 #include <string>
 #include <assert.h>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
 
 using namespace std;
 
@@ -39,6 +42,8 @@ using namespace std;
 // STB_IMAGE
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
 
 //GLM
 #include <glm/glm.hpp> 
@@ -47,10 +52,13 @@ using namespace std;
 
 using namespace glm;
 
+#include "Headless.h"
+#include "SpriteBatch.h"
+#include "TextureCache.h"
+
 
 struct Sprite
 {
-	GLuint VAO;
 	GLuint texID;
 	vec3 position;
 	vec3 dimensions; //tamanho do frame
@@ -65,24 +73,43 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
 
 // Protótipos das funções
 int setupShader();
-int setupSprite(int nAnimations, int nFrames, float &ds, float &dt);
+void setupSprite(Sprite &sprite, int nAnimations, int nFrames);
 int loadTexture(string filePath, int &width, int &height);
+void executarBenchmarkSprites(GLFWwindow *window, LoteSprites &lote, GLuint texWalk, GLuint texIdle, int maxSprites);
 
 // Dimensões da janela (pode ser alterado em tempo de execução)
 const GLuint WIDTH = 800, HEIGHT = 600;
 
+// Decodifica as texturas em segundo plano (Common/TextureLoader.h), e o cache
+// evita carregar o mesmo arquivo duas vezes
+RecursosGPU recursos;
+CarregadorTexturas carregador;
+CacheTexturas texturas(recursos, carregador);
+
 // Código fonte do Vertex Shader (em GLSL): ainda hardcoded
+// Cada sprite é uma instância do lote (Common/SpriteBatch.h): os atributos
+// são por instância e os 4 cantos do quad saem do gl_VertexID. O canto do
+// retângulo UV é somado no fragment shader, como o antigo offsetTex
 const GLchar *vertexShaderSource = R"(
  #version 400
- layout (location = 0) in vec3 position;
- layout (location = 1) in vec2 texc;
+ layout (location = 0) in vec2 posicao;
+ layout (location = 1) in vec2 escala;
+ layout (location = 2) in vec4 uvRect;
+ layout (location = 3) in vec4 tint;
  out vec2 tex_coord;
- uniform mat4 model;
+ flat out vec2 origem_tex;
+ out vec4 tint_frag;
  uniform mat4 projection;
+
+ const vec2 quad[4] = vec2[4](vec2(-0.5, 0.5), vec2(-0.5, -0.5), vec2(0.5, 0.5), vec2(0.5, -0.5));
+ const vec2 quadTex[4] = vec2[4](vec2(0.0, 0.0), vec2(0.0, 1.0), vec2(1.0, 0.0), vec2(1.0, 1.0));
+
  void main()
  {
-	tex_coord = vec2(texc.s, 1.0 - texc.t);
-	gl_Position = projection * model * vec4(position, 1.0);
+	tex_coord = quadTex[gl_VertexID] * uvRect.zw;
+	origem_tex = uvRect.xy;
+	tint_frag = tint;
+	gl_Position = projection * vec4(posicao + quad[gl_VertexID] * escala, 0.0, 1.0);
  }
  )";
 
@@ -90,21 +117,40 @@ const GLchar *vertexShaderSource = R"(
 const GLchar *fragmentShaderSource = R"(
  #version 400
  in vec2 tex_coord;
+ flat in vec2 origem_tex;
+ in vec4 tint_frag;
  out vec4 color;
  uniform sampler2D tex_buff;
- uniform vec2 offsetTex;
 
  void main()
  {
-	 color = texture(tex_buff,tex_coord + offsetTex);
+	 color = texture(tex_buff,origem_tex + tex_coord) * tint_frag;
  }
  )";
 
 // Função MAIN
-int main()
+int main(int argc, char **argv)
 {
+	// --headless[=N] desenha N frames sem janela visível; --golden=ref.png compara o último
+	// --bench-sprites[=N] mede o lote de sprites com até N vampiros (100000 por padrão)
+	OpcoesHeadless headless;
+	int benchSprites = 0;
+	for (int i = 1; i < argc; i++)
+	{
+		if (headless.ler(argv[i]))
+			continue;
+		if (strcmp(argv[i], "--bench-sprites") == 0)
+			benchSprites = 100000;
+		else if (strncmp(argv[i], "--bench-sprites=", 16) == 0)
+			benchSprites = std::max(1, atoi(argv[i] + 16));
+	}
+
 	// Inicialização da GLFW
-	glfwInit();
+	if (!iniciarGlfw(headless))
+	{
+		std::cerr << "Falha ao inicializar a GLFW" << std::endl;
+		return -1;
+	}
 
 	// Muita atenção aqui: alguns ambientes não aceitam essas configurações
 	// Você deve adaptar para a versão do OpenGL suportada por sua placa
@@ -154,18 +200,39 @@ int main()
 	glfwGetFramebufferSize(window, &width, &height);
 	glViewport(0, 0, width, height);
 
+	// No modo headless o desenho vai para um framebuffer lido de volta a cada frame
+	CapturaHeadless captura;
+	if (headless.ativo)
+	{
+		string erroCaptura;
+		if (!captura.criar(width, height, erroCaptura))
+		{
+			std::cerr << erroCaptura << std::endl;
+			glfwTerminate();
+			return -1;
+		}
+		glfwSwapInterval(0);
+	}
+
 	// Compilando e buildando o programa de shader
 	GLuint shaderID = setupShader();
 
+	// As texturas são decodificadas em threads e enviadas à GPU pelo game loop
+	string erroTexturas;
+	if (!carregador.iniciar(0, erroTexturas))
+	{
+		std::cerr << erroTexturas << std::endl;
+		glfwTerminate();
+		return -1;
+	}
+
 	//Carregando uma textura 
 	int imgWidth, imgHeight;
 	GLuint texID = loadTexture("../assets/sprites/Vampires1_Walk_full.png",imgWidth,imgHeight);
 
-	// Gerando um buffer simples, com a geometria de um triângulo
+	// Os sprites não têm geometria própria: todos são desenhados pelo lote
 	Sprite vampirao;
-	vampirao.nAnimations = 4;
-	vampirao.nFrames = 6;
-	vampirao.VAO = setupSprite(vampirao.nAnimations,vampirao.nFrames,vampirao.ds,vampirao.dt);
+	setupSprite(vampirao, 4, 6);
 	vampirao.position = vec3(400.0, 150.0, 0.0);
 	vampirao.dimensions = vec3(imgWidth/vampirao.nFrames*4,imgHeight/vampirao.nAnimations*4,1.0);
 	vampirao.texID = texID;
@@ -173,16 +240,22 @@ int main()
 	vampirao.iFrame = 0;
 
 	Sprite background;
-	background.nAnimations = 1;
-	background.nFrames = 1;
-	background.VAO = setupSprite(background.nAnimations,background.nFrames,background.ds,background.dt);
+	setupSprite(background, 1, 1);
 	background.position = vec3(400.0, 300.0, 0.0);
 	background.texID = loadTexture("../assets/backgrounds/bg_pixelado.png",imgWidth,imgHeight);
 	background.dimensions = vec3(imgWidth/background.nFrames*0.5,imgHeight/background.nAnimations*0.5,1.0);
 	background.iAnimation = 0;
 	background.iFrame = 0;
 
-	
+	// Lote com o anel de VBOs mapeados onde os quads de cada frame são escritos
+	LoteSprites lote;
+	string erroLote;
+	if (!lote.criar(CAPACIDADE_LOTE_SPRITES, erroLote))
+	{
+		std::cerr << erroLote << std::endl;
+		glfwTerminate();
+		return -1;
+	}
 
 	glUseProgram(shaderID); // Reseta o estado do shader para evitar problemas futuros
 
@@ -207,6 +280,20 @@ int main()
 	glEnable(GL_BLEND); //Habilita a transparência -- canal alpha
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); //Seta função de transparência
 
+	if (benchSprites > 0)
+	{
+		int idleWidth, idleHeight;
+		GLuint texIdle = loadTexture("../assets/sprites/Vampires1_Idle_full.png", idleWidth, idleHeight);
+		if (!carregador.aguardar(erroTexturas))
+			std::cerr << erroTexturas << std::endl;
+		executarBenchmarkSprites(window, lote, texID, texIdle, benchSprites);
+		lote.liberar();
+		carregador.encerrar();
+		texturas.liberarTudo();
+		recursos.liberarTudo();
+		glfwTerminate();
+		return 0;
+	}
 
 	double lastTime = 0.0;
 	double deltaT = 0.0;
@@ -215,9 +302,24 @@ int main()
 
 
 	vec2 offsetTexBg = vec2(0.0,0.0);
+
+	// A comparação com a referência precisa das texturas já completas
+	if (headless.ativo && !carregador.aguardar(erroTexturas))
+	{
+		std::cerr << erroTexturas << std::endl;
+		erroTexturas.clear();
+	}
+
 	// Loop da aplicação - "game loop"
 	while (!glfwWindowShouldClose(window))
 	{
+		if (headless.ativo)
+		{
+			if (captura.getCapturados() >= headless.frames)
+				break;
+			captura.iniciarFrame(captura.getCapturados());
+		}
+
 		// Este trecho de código é totalmente opcional: calcula e mostra a contagem do FPS na barra de título
 		{
 			double curr_s = glfwGetTime();		// Obtém o tempo atual.
@@ -242,6 +344,16 @@ int main()
 		// Checa se houveram eventos de input (key pressed, mouse moved etc.) e chama as funções de callback correspondentes
 		glfwPollEvents();
 
+		// Recarrega os PNGs de assets/ que foram salvos (só em build Debug) e
+		// envia para a GPU as texturas que terminaram de ser decodificadas
+		if (texturas.verificarMudancas(erroTexturas) > 0)
+			std::cout << "Texturas recarregadas: " << texturas.getRecargas() << std::endl;
+		if (!carregador.atualizar(erroTexturas, BYTES_TEXTURA_POR_FRAME) || !erroTexturas.empty())
+		{
+			std::cerr << erroTexturas << std::endl;
+			erroTexturas.clear();
+		}
+
 		// Limpa o buffer de cor
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f); // cor de fundo
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -249,71 +361,69 @@ int main()
 		glLineWidth(10);
 		glPointSize(20);
 
-		// Desenho do background
-		// Matriz de transformaçao do objeto - Matriz de modelo
-		mat4 model = mat4(1); //matriz identidade
-		model = translate(model,background.position);
-		model = rotate(model, radians(0.0f), vec3(0.0, 0.0, 1.0));
-		model = scale(model,background.dimensions);
-		glUniformMatrix4fv(glGetUniformLocation(shaderID, "model"), 1, GL_FALSE, value_ptr(model));
-
-		
-
-		currTime = glfwGetTime();
+		// No modo headless o tempo exato do frame: glfwGetTime() anda com o
+		// relógio real desde o glfwSetTime(), e 5 frames podiam dar um pouco
+		// menos que 1/FPS, deixando a animação um quadro atrás
+		currTime = headless.ativo ? captura.getCapturados() / HZ_HEADLESS : glfwGetTime();
 		deltaT = currTime - lastTime;
 
 		if (deltaT >= 1.0/FPS)
 		{
 			background.iFrame = (background.iFrame + 1) % 100;
+			vampirao.iFrame = (vampirao.iFrame + 1) % vampirao.nFrames; // incremento "circular"
+			lastTime = currTime;
 		}
+
+		// Desenho do background, na camada 0: a textura repete (GL_REPEAT) e
+		// o retângulo UV anda 1% por quadro para o fundo rolar
 		offsetTexBg.s = background.iFrame * 0.01;
 		offsetTexBg.t = 0.0;
-		glUniform2f(glGetUniformLocation(shaderID, "offsetTex"),offsetTexBg.s, offsetTexBg.t);
-
-		glBindVertexArray(background.VAO); // Conectando ao buffer de geometria
-		glBindTexture(GL_TEXTURE_2D, background.texID); // Conectando ao buffer de textura
-
-		// Chamada de desenho - drawcall
-		// Poligono Preenchido - GL_TRIANGLES
-		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-
-
-		//---------------------------------------------------------------------
-		// Desenho do vampirao
-		// Matriz de transformaçao do objeto - Matriz de modelo
-		model = mat4(1); //matriz identidade
-		model = translate(model,vampirao.position);
-		model = rotate(model, radians(0.0f), vec3(0.0, 0.0, 1.0));
-		model = scale(model,vampirao.dimensions);
-		glUniformMatrix4fv(glGetUniformLocation(shaderID, "model"), 1, GL_FALSE, value_ptr(model));
+		lote.desenhar(background.texID, 0, background.position.x, background.position.y,
+			background.dimensions.x, background.dimensions.y,
+			offsetTexBg.s, 1.0f - background.dt + offsetTexBg.t, background.ds, background.dt);
 
+		// Desenho do vampirao, na camada 1 (por cima do fundo): o quadro da
+		// animação escolhe a coluna da spritesheet
 		vec2 offsetTex;
-
-		if (deltaT >= 1.0/FPS)
-		{
-			vampirao.iFrame = (vampirao.iFrame + 1) % vampirao.nFrames; // incremento "circular"
-			lastTime = currTime;
-		}
-
 		offsetTex.s = vampirao.iFrame * vampirao.ds;
 		offsetTex.t = 0.0;
-		glUniform2f(glGetUniformLocation(shaderID, "offsetTex"),offsetTex.s, offsetTex.t);
+		lote.desenhar(vampirao.texID, 1, vampirao.position.x, vampirao.position.y,
+			vampirao.dimensions.x, vampirao.dimensions.y,
+			offsetTex.s, 1.0f - vampirao.dt + offsetTex.t, vampirao.ds, vampirao.dt);
 
-		glBindVertexArray(vampirao.VAO); // Conectando ao buffer de geometria
-		glBindTexture(GL_TEXTURE_2D, vampirao.texID); // Conectando ao buffer de textura
-
-		// Chamada de desenho - drawcall
-		// Poligono Preenchido - GL_TRIANGLES
-		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		// Chamada de desenho - um drawcall por textura
+		lote.finalizar();
+		//---------------------------------------------------------------------------
 		//---------------------------------------------------------------------------
 
 		// Troca os buffers da tela
-		glfwSwapBuffers(window);
+		if (headless.ativo)
+			captura.capturar();
+		else
+			glfwSwapBuffers(window);
 	}
-		
+
+	int resultado = 0;
+	if (headless.ativo)
+	{
+		printf("Headless: %ld frames, %.3f ms/frame\n", captura.getCapturados(), captura.finalizar());
+		string erroGolden;
+		if (!captura.compararGolden(headless, cout, erroGolden))
+		{
+			std::cerr << erroGolden << std::endl;
+			resultado = 1;
+		}
+		captura.liberar();
+	}
+
+	lote.liberar();
+	carregador.encerrar();
+	texturas.liberarTudo();
+	recursos.liberarTudo();
+
 	// Finaliza a execução da GLFW, limpando os recursos alocados por ela
 	glfwTerminate();
-	return 0;
+	return resultado;
 }
 
 // Função de callback de teclado - só pode ter uma instância (deve ser estática se
@@ -377,105 +487,137 @@ int setupShader()
 	return shaderProgram;
 }
 
-// Esta função está bastante harcoded - objetivo é criar os buffers que armazenam a
-// geometria de um triângulo
-// Apenas atributo coordenada nos vértices
-// 1 VBO com as coordenadas, VAO com apenas 1 ponteiro para atributo
-// A função retorna o identificador do VAO
-int setupSprite(int nAnimations, int nFrames, float &ds, float &dt)
+// Prepara a spritesheet de um sprite: nAnimations linhas (animações) por
+// nFrames colunas (quadros). ds e dt são a largura e a altura de um quadro
+// em coordenadas de textura; a geometria fica por conta do lote de sprites
+void setupSprite(Sprite &sprite, int nAnimations, int nFrames)
 {
-
-	ds = 1.0 / (float) nFrames;
-	dt = 1.0 / (float) nAnimations;
-	// Aqui setamos as coordenadas x, y e z do triângulo e as armazenamos de forma
-	// sequencial, já visando mandar para o VBO (Vertex Buffer Objects)
-	// Cada atributo do vértice (coordenada, cores, coordenadas de textura, normal, etc)
-	// Pode ser arazenado em um VBO único ou em VBOs separados
-	GLfloat vertices[] = {
-		// x   y    z    s     t
-		-0.5,  0.5, 0.0, 0.0, dt, //V0
-		-0.5, -0.5, 0.0, 0.0, 0.0, //V1
-		 0.5,  0.5, 0.0, ds, dt, //V2
-		 0.5, -0.5, 0.0, ds, 0.0  //V3
-		};
-
-	GLuint VBO, VAO;
-	// Geração do identificador do VBO
-	glGenBuffers(1, &VBO);
-	// Faz a conexão (vincula) do buffer como um buffer de array
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	// Envia os dados do array de floats para o buffer da OpenGl
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-	// Geração do identificador do VAO (Vertex Array Object)
-	glGenVertexArrays(1, &VAO);
-	// Vincula (bind) o VAO primeiro, e em seguida  conecta e seta o(s) buffer(s) de vértices
-	// e os ponteiros para os atributos
-	glBindVertexArray(VAO);
-	// Para cada atributo do vertice, criamos um "AttribPointer" (ponteiro para o atributo), indicando:
-	//  Localização no shader * (a localização dos atributos devem ser correspondentes no layout especificado no vertex shader)
-	//  Numero de valores que o atributo tem (por ex, 3 coordenadas xyz)
-	//  Tipo do dado
-	//  Se está normalizado (entre zero e um)
-	//  Tamanho em bytes
-	//  Deslocamento a partir do byte zero
-
-	// Ponteiro pro atributo 0 - Posição - coordenadas x, y, z
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid *)0);
-	glEnableVertexAttribArray(0);
-
-	// Ponteiro pro atributo 1 - Coordenada de textura s, t
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid *)(3 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(1);
-
-	// Observe que isso é permitido, a chamada para glVertexAttribPointer registrou o VBO como o objeto de buffer de vértice
-	// atualmente vinculado - para que depois possamos desvincular com segurança
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	// Desvincula o VAO (é uma boa prática desvincular qualquer buffer ou array para evitar bugs medonhos)
-	glBindVertexArray(0);
-
-	return VAO;
+	sprite.nAnimations = nAnimations;
+	sprite.nFrames = nFrames;
+	sprite.ds = 1.0 / (float) nFrames;
+	sprite.dt = 1.0 / (float) nAnimations;
 }
 
+// Pede a textura ao cache, que só carrega um arquivo na primeira vez: width e
+// height já voltam certos, mas os pixels só aparecem quando o game loop
+// chamar carregador.atualizar()
 int loadTexture(string filePath, int &width, int &height)
 {
-	GLuint texID;
-
-	// Gera o identificador da textura na memória
-	glGenTextures(1, &texID);
-	glBindTexture(GL_TEXTURE_2D, texID);
+	OpcoesTextura opcoes;
+	opcoes.wrapS = opcoes.wrapT = GL_REPEAT;
+	opcoes.filtroMin = opcoes.filtroMag = GL_NEAREST;
+
+	InfoTextura info;
+	string erro;
+	RecursoGPU textura;
+	if (!texturas.obter(filePath, opcoes, textura, info, erro))
+	{
+		std::cout << "Failed to load texture: " << erro << std::endl;
+		width = height = 0;
+		return 0;
+	}
+	// As texturas ficam residentes no cache até o fim do programa
+	texturas.liberar(textura);
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	width = info.largura;
+	height = info.altura;
+	return info.texID;
+}
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+// Mede o lote de sprites com 1000, 10000, ... até maxSprites vampiros andando e
+// animados na tela. Metade usa a spritesheet de andar e metade a de parado,
+// pedidas intercaladas na mesma camada, então o lote precisa ordenar por
+// textura a cada frame e sai com dois draw calls por região do anel.
+// "pedidos" é o tempo de CPU dos desenhar(), "finalizar" o da ordenação, da
+// cópia para o VBO e dos draw calls; "frame" inclui a GPU (glFinish só no
+// fim, para o anel de VBOs deixar CPU e GPU trabalharem ao mesmo tempo)
+void executarBenchmarkSprites(GLFWwindow *window, LoteSprites &lote, GLuint texWalk, GLuint texIdle, int maxSprites)
+{
+	struct VampiroBench
+	{
+		float x, y, vx;
+		int iAnimation, fase;
+		bool parado;
+		float tint[4];
+	};
 
-	int nrChannels;
+	const int frames = 60;
+	const float tamanho = 16.0f;
 
-	unsigned char *data = stbi_load(filePath.c_str(), &width, &height, &nrChannels, 0);
+	glfwSwapInterval(0);
 
-	if (data)
+	srand(42);
+	vector<VampiroBench> vampiros(maxSprites);
+	for (int k = 0; k < maxSprites; k++)
 	{
-		if (nrChannels == 3) // jpg, bmp
-		{
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-		}
-		else // png
-		{
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-		}
-		glGenerateMipmap(GL_TEXTURE_2D);
+		VampiroBench &v = vampiros[k];
+		v.x = (float)(rand() % WIDTH);
+		v.y = (float)(rand() % HEIGHT);
+		v.vx = 0.5f + (rand() % 100) / 50.0f;
+		v.iAnimation = rand() % 4;
+		v.fase = rand() % 12;
+		v.parado = (k % 2) == 1;
+		v.tint[0] = 0.6f + (rand() % 41) / 100.0f;
+		v.tint[1] = 0.6f + (rand() % 41) / 100.0f;
+		v.tint[2] = 0.6f + (rand() % 41) / 100.0f;
+		v.tint[3] = 1.0f;
 	}
-	else
+	lote.reservar(maxSprites);
+
+	cout << endl << "Benchmark do lote de sprites (" << frames << " frames por caso, "
+		 << (lote.isPersistente() ? "VBO persistente em anel" : "glBufferSubData") << ")" << endl;
+	cout << "sprites \tframe (ms)\tpedidos (ms)\tfinalizar (ms)\tdraw calls/frame\tesperas" << endl;
+
+	for (int n = std::min(1000, maxSprites);; n = std::min(n * 10, maxSprites))
 	{
-		std::cout << "Failed to load texture" << std::endl;
-	}
+		double pedidos = 0.0, finalizar = 0.0;
+		long esperas = 0;
+		long drawCalls = 0;
+		double inicio = 0.0;
 
-	stbi_image_free(data);
+		// f = -1 é o frame de aquecimento, fora da medida
+		for (int f = -1; f < frames; f++)
+		{
+			if (f == 0)
+			{
+				glFinish();
+				inicio = glfwGetTime();
+			}
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+			double t0 = glfwGetTime();
+			for (int k = 0; k < n; k++)
+			{
+				const VampiroBench &v = vampiros[k];
+				int nFrames = v.parado ? 4 : 6;
+				float ds = 1.0f / nFrames, dt = 0.25f;
+				int iFrame = ((f + 1) / 5 + v.fase) % nFrames;
+				QuadSprite q = {{fmodf(v.x + (f + 1) * v.vx, (float)WIDTH), v.y}, {tamanho, tamanho},
+								{iFrame * ds, v.iAnimation * dt, ds, dt},
+								{v.tint[0], v.tint[1], v.tint[2], v.tint[3]}};
+				lote.desenhar(v.parado ? texIdle : texWalk, 1, q);
+			}
+			double t1 = glfwGetTime();
+			lote.finalizar();
+			if (f >= 0)
+			{
+				pedidos += t1 - t0;
+				finalizar += glfwGetTime() - t1;
+				esperas += lote.getEstatisticas().esperas;
+				drawCalls += lote.getEstatisticas().drawCalls;
+			}
+
+			glfwSwapBuffers(window);
+		}
+		glFinish();
+		double tempo = (glfwGetTime() - inicio) * 1000.0 / frames;
 
-	return texID;
+		char linha[256];
+		sprintf(linha, "%8d\t%10.3f\t%12.3f\t%14.3f\t%16ld\t%7ld", n, tempo, pedidos * 1000.0 / frames,
+				finalizar * 1000.0 / frames, drawCalls / frames, esperas);
+		cout << linha << endl;
+
+		if (n == maxSprites)
+			break;
+	}
 }
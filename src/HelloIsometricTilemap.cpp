@@ -39,6 +39,8 @@ using namespace std;
 // STB_IMAGE
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
 
 //GLM
 #include <glm/glm.hpp> 
@@ -47,6 +49,11 @@ using namespace std;
 
 using namespace glm;
 
+#include "GpuResources.h"
+#include "Headless.h"
+#include "ShaderProgram.h"
+#include "TextureCache.h"
+
 
 struct Sprite
 {
@@ -62,6 +69,7 @@ struct Sprite
 struct Tile
 {
 	GLuint VAO;
+	RecursoGPU geometria; // dona do VAO, no cache de recursos
 	GLuint texID; // de qual tileset
 	int iTile; //indice dele no tileset
 	vec3 position;
@@ -72,16 +80,24 @@ struct Tile
 	//int nAnimations, nFrames;
 };	
 
+// Programa de shader + índices dos uniforms, resolvidos uma vez depois do link
+// (ver Common/ShaderProgram.h): no desenho não há glGetUniformLocation por string
+struct ShaderTile
+{
+	ShaderProgram programa;
+	int model, projection, offsetTex, tex_buff;
+};
+
 // Protótipo da função de callback de teclado
 void key_callback(GLFWwindow *window, int key, int scancode, int action, int mode);
 
 // Protótipos das funções
 int setupShader();
 int setupSprite(int nAnimations, int nFrames, float &ds, float &dt);
-int setupTile(int nTiles, float &ds, float &dt);
+RecursoGPU setupTile(int nTiles, float &ds, float &dt);
 int loadTexture(string filePath, int &width, int &height);
-void desenharMapa(GLuint shaderID);
-void desenharPersonagem(GLuint shaderID);
+void desenharMapa(ShaderTile &shader);
+void desenharPersonagem(ShaderTile &shader);
 
 // Dimensões da janela (pode ser alterado em tempo de execução)
 const GLuint WIDTH = 800, HEIGHT = 600;
@@ -126,12 +142,29 @@ int map[3][3] = {
 
 vector <Tile> tileset;
 
+// VAOs, VBOs e texturas: os 7 tiles usam o mesmo losango, criado uma vez só
+RecursosGPU recursos;
+
+// Decodifica o tileset em segundo plano (Common/TextureLoader.h), e o cache
+// evita carregar o mesmo arquivo duas vezes
+CarregadorTexturas carregador;
+CacheTexturas texturas(recursos, carregador);
+
 vec2 pos; //armazena o indice i e j de onde o "personagem" está na cena
 // Função MAIN
-int main()
+int main(int argc, char **argv)
 {
+	// --headless[=N] desenha N frames sem janela visível; --golden=ref.png compara o último
+	OpcoesHeadless headless;
+	for (int i = 1; i < argc; i++)
+		headless.ler(argv[i]);
+
 	// Inicialização da GLFW
-	glfwInit();
+	if (!iniciarGlfw(headless))
+	{
+		std::cerr << "Falha ao inicializar a GLFW" << std::endl;
+		return -1;
+	}
 
 	// Muita atenção aqui: alguns ambientes não aceitam essas configurações
 	// Você deve adaptar para a versão do OpenGL suportada por sua placa
@@ -181,8 +214,36 @@ int main()
 	glfwGetFramebufferSize(window, &width, &height);
 	glViewport(0, 0, width, height);
 
+	// No modo headless o desenho vai para um framebuffer lido de volta a cada frame
+	CapturaHeadless captura;
+	if (headless.ativo)
+	{
+		string erroCaptura;
+		if (!captura.criar(width, height, erroCaptura))
+		{
+			std::cerr << erroCaptura << std::endl;
+			glfwTerminate();
+			return -1;
+		}
+		glfwSwapInterval(0);
+	}
+
 	// Compilando e buildando o programa de shader
-	GLuint shaderID = setupShader();
+	ShaderTile shader;
+	shader.programa.adotar(setupShader());
+	shader.model = shader.programa.localizar("model");
+	shader.projection = shader.programa.localizar("projection");
+	shader.offsetTex = shader.programa.localizar("offsetTex");
+	shader.tex_buff = shader.programa.localizar("tex_buff");
+
+	// As texturas são decodificadas em threads e enviadas à GPU pelo game loop
+	string erroTexturas;
+	if (!carregador.iniciar(0, erroTexturas))
+	{
+		std::cerr << erroTexturas << std::endl;
+		glfwTerminate();
+		return -1;
+	}
 
 	//Carregando uma textura 
 	int imgWidth, imgHeight;
@@ -206,7 +267,8 @@ int main()
 		tile.dimensions = vec3(114,57,1.0);
 		tile.iTile = i;
 		tile.texID = texID;
-		tile.VAO = setupTile(7,tile.ds,tile.dt);
+		tile.geometria = setupTile(7,tile.ds,tile.dt);
+		tile.VAO = recursos.getVAO(tile.geometria);
 		tile.caminhavel = true;
 		tileset.push_back(tile);
 	}
@@ -219,7 +281,7 @@ int main()
 
 
 
-	glUseProgram(shaderID); // Reseta o estado do shader para evitar problemas futuros
+	shader.programa.usar(); // Reseta o estado do shader para evitar problemas futuros
 
 	double prev_s = glfwGetTime();	// Define o "tempo anterior" inicial.
 	double title_countdown_s = 0.1; // Intervalo para atualizar o título da janela com o FPS.
@@ -230,11 +292,11 @@ int main()
 	glActiveTexture(GL_TEXTURE0);
 
 	// Criando a variável uniform pra mandar a textura pro shader
-	glUniform1i(glGetUniformLocation(shaderID, "tex_buff"), 0);
+	shader.programa.setInt(shader.tex_buff, 0);
 
 	// Matriz de projeção paralela ortográfica
 	mat4 projection = ortho(0.0, 800.0, 600.0, 0.0, -1.0, 1.0);
-	glUniformMatrix4fv(glGetUniformLocation(shaderID, "projection"), 1, GL_FALSE, value_ptr(projection));
+	shader.programa.setMat4(shader.projection, value_ptr(projection));
 
 	glEnable(GL_DEPTH_TEST); // Habilita o teste de profundidade
 	glDepthFunc(GL_ALWAYS); // Testa a cada ciclo
@@ -247,10 +309,25 @@ int main()
 	double deltaT = 0.0;
 	double currTime = glfwGetTime();
 	double FPS = 12.0;
+	long chamadasEvitadas = 0; // chamadas GL que o ShaderProgram poupou no último frame
+
+	// A comparação com a referência precisa do tileset já completo
+	if (headless.ativo && !carregador.aguardar(erroTexturas))
+	{
+		std::cerr << erroTexturas << std::endl;
+		erroTexturas.clear();
+	}
 
 	// Loop da aplicação - "game loop"
 	while (!glfwWindowShouldClose(window))
 	{
+		if (headless.ativo)
+		{
+			if (captura.getCapturados() >= headless.frames)
+				break;
+			captura.iniciarFrame(captura.getCapturados());
+		}
+
 		// Este trecho de código é totalmente opcional: calcula e mostra a contagem do FPS na barra de título
 		{
 			double curr_s = glfwGetTime();		// Obtém o tempo atual.
@@ -265,7 +342,7 @@ int main()
 
 				// Cria uma string e define o FPS como título da janela.
 				char tmp[256];
-				sprintf(tmp, "Ola Triangulo! -- Rossana\tFPS %.2lf", fps);
+				sprintf(tmp, "Ola Triangulo! -- Rossana\tFPS %.2lf\tGL evitadas/frame %ld", fps, chamadasEvitadas);
 				glfwSetWindowTitle(window, tmp);
 
 				title_countdown_s = 0.1; // Reinicia o temporizador para atualizar o título periodicamente.
@@ -275,6 +352,16 @@ int main()
 		// Checa se houveram eventos de input (key pressed, mouse moved etc.) e chama as funções de callback correspondentes
 		glfwPollEvents();
 
+		// Recarrega os PNGs de assets/ que foram salvos (só em build Debug) e
+		// envia para a GPU as texturas que terminaram de ser decodificadas
+		if (texturas.verificarMudancas(erroTexturas) > 0)
+			std::cout << "Texturas recarregadas: " << texturas.getRecargas() << std::endl;
+		if (!carregador.atualizar(erroTexturas, BYTES_TEXTURA_POR_FRAME) || !erroTexturas.empty())
+		{
+			std::cerr << erroTexturas << std::endl;
+			erroTexturas.clear();
+		}
+
 		// Limpa o buffer de cor
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f); // cor de fundo
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -283,8 +370,8 @@ int main()
 		glPointSize(20);
 
 		// Desenhar o mapa
-		desenharMapa(shaderID);
-		desenharPersonagem(shaderID);
+		desenharMapa(shader);
+		desenharPersonagem(shader);
 
 		//---------------------------------------------------------------------
 		// Desenho do vampirao
@@ -293,7 +380,7 @@ int main()
 		model = translate(model,vampirao.position);
 		model = rotate(model, radians(0.0f), vec3(0.0, 0.0, 1.0));
 		model = scale(model,vampirao.dimensions);
-		glUniformMatrix4fv(glGetUniformLocation(shaderID, "model"), 1, GL_FALSE, value_ptr(model));
+		shader.programa.setMat4(shader.model, value_ptr(model));
 
 		vec2 offsetTex;
 
@@ -305,7 +392,7 @@ int main()
 
 		offsetTex.s = vampirao.iFrame * vampirao.ds;
 		offsetTex.t = 0.0;
-		glUniform2f(glGetUniformLocation(shaderID, "offsetTex"),offsetTex.s, offsetTex.t);
+		shader.programa.setVec2(shader.offsetTex, offsetTex.s, offsetTex.t);
 
 		glBindVertexArray(vampirao.VAO); // Conectando ao buffer de geometria
 		glBindTexture(GL_TEXTURE_2D, vampirao.texID); // Conectando ao buffer de textura
@@ -316,12 +403,42 @@ int main()
 		//---------------------------------------------------------------------------
 
 		// Troca os buffers da tela
-		glfwSwapBuffers(window);
+		if (headless.ativo)
+			captura.capturar();
+		else
+			glfwSwapBuffers(window);
+
+		chamadasEvitadas = ShaderProgram::getContadores().evitadas();
+		ShaderProgram::zerarContadores();
+	}
+
+	int resultado = 0;
+	if (headless.ativo)
+	{
+		printf("Headless: %ld frames, %.3f ms/frame\n", captura.getCapturados(), captura.finalizar());
+		string erroGolden;
+		if (!captura.compararGolden(headless, cout, erroGolden))
+		{
+			std::cerr << erroGolden << std::endl;
+			resultado = 1;
+		}
+		captura.liberar();
 	}
-		
+
+	// Memória de vídeo por tipo de recurso, e todos os objetos GL apagados
+	for (int t = 0; t < NUM_TIPOS_RECURSO; t++)
+	{
+		const UsoRecursosGPU &uso = recursos.getUso((TipoRecursoGPU)t);
+		printf("Recursos GPU: %-9s %3ld objetos, %8.1f KB (%ld reaproveitados)\n", RecursosGPU::nomeTipo((TipoRecursoGPU)t),
+			   uso.quantidade, uso.bytes / 1024.0, uso.reaproveitados);
+	}
+	carregador.encerrar();
+	texturas.liberarTudo();
+	recursos.liberarTudo();
+
 	// Finaliza a execução da GLFW, limpando os recursos alocados por ela
 	glfwTerminate();
-	return 0;
+	return resultado;
 }
 
 // Função de callback de teclado - só pode ter uma instância (deve ser estática se
@@ -542,7 +659,9 @@ int setupSprite(int nAnimations, int nFrames, float &ds, float &dt)
 	return VAO;
 }
 
-int setupTile(int nTiles, float &ds, float &dt)
+// Losango do tile, no cache de recursos: tiles com o mesmo nTiles recebem o
+// mesmo VAO
+RecursoGPU setupTile(int nTiles, float &ds, float &dt)
 {
     
 	ds = 1.0 / (float) nTiles;
@@ -559,88 +678,44 @@ int setupTile(int nTiles, float &ds, float &dt)
 		tw,     th/2.0f, 0.0, ds,     dt/2.0f  //C
 		};
 
-	GLuint VBO, VAO;
-	// Geração do identificador do VBO
-	glGenBuffers(1, &VBO);
-	// Faz a conexão (vincula) do buffer como um buffer de array
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	// Envia os dados do array de floats para o buffer da OpenGl
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+	// Cada vértice tem 2 atributos intercalados num só VBO:
+	//  0 - Posição - coordenadas x, y, z
+	//  1 - Coordenada de textura s, t
+	FormatoVertices formato;
+	formato.adicionar(0, 3);
+	formato.adicionar(1, 2);
 
-	// Geração do identificador do VAO (Vertex Array Object)
-	glGenVertexArrays(1, &VAO);
-	// Vincula (bind) o VAO primeiro, e em seguida  conecta e seta o(s) buffer(s) de vértices
-	// e os ponteiros para os atributos
-	glBindVertexArray(VAO);
-	// Para cada atributo do vertice, criamos um "AttribPointer" (ponteiro para o atributo), indicando:
-	//  Localização no shader * (a localização dos atributos devem ser correspondentes no layout especificado no vertex shader)
-	//  Numero de valores que o atributo tem (por ex, 3 coordenadas xyz)
-	//  Tipo do dado
-	//  Se está normalizado (entre zero e um)
-	//  Tamanho em bytes
-	//  Deslocamento a partir do byte zero
-
-	// Ponteiro pro atributo 0 - Posição - coordenadas x, y, z
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid *)0);
-	glEnableVertexAttribArray(0);
-
-	// Ponteiro pro atributo 1 - Coordenada de textura s, t
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid *)(3 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(1);
-
-	// Observe que isso é permitido, a chamada para glVertexAttribPointer registrou o VBO como o objeto de buffer de vértice
-	// atualmente vinculado - para que depois possamos desvincular com segurança
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	// Desvincula o VAO (é uma boa prática desvincular qualquer buffer ou array para evitar bugs medonhos)
-	glBindVertexArray(0);
-
-	return VAO;
+	// O cache cria o VBO e o VAO na primeira vez; depois devolve os mesmos
+	return recursos.geometria(formato, vertices, sizeof(vertices), 4);
 }
 
+// Pede a textura ao cache, que só carrega um arquivo na primeira vez: width e
+// height já voltam certos, mas os pixels só aparecem quando o game loop
+// chamar carregador.atualizar()
 int loadTexture(string filePath, int &width, int &height)
 {
-	GLuint texID;
-
-	// Gera o identificador da textura na memória
-	glGenTextures(1, &texID);
-	glBindTexture(GL_TEXTURE_2D, texID);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-	int nrChannels;
-
-	unsigned char *data = stbi_load(filePath.c_str(), &width, &height, &nrChannels, 0);
-
-	if (data)
+	OpcoesTextura opcoes;
+	opcoes.wrapS = opcoes.wrapT = GL_REPEAT;
+	opcoes.filtroMin = opcoes.filtroMag = GL_NEAREST;
+
+	InfoTextura info;
+	string erro;
+	RecursoGPU textura;
+	if (!texturas.obter(filePath, opcoes, textura, info, erro))
 	{
-		if (nrChannels == 3) // jpg, bmp
-		{
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-		}
-		else // png
-		{
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-		}
-		glGenerateMipmap(GL_TEXTURE_2D);
-	}
-	else
-	{
-		std::cout << "Failed to load texture" << std::endl;
+		std::cout << "Failed to load texture: " << erro << std::endl;
+		width = height = 0;
+		return 0;
 	}
+	// As texturas ficam residentes no cache até o fim do programa
+	texturas.liberar(textura);
 
-	stbi_image_free(data);
-
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	return texID;
+	width = info.largura;
+	height = info.altura;
+	return info.texID;
 }
 
-void desenharMapa(GLuint shaderID)
+void desenharMapa(ShaderTile &shader)
 {
 	//dá pra fazer um cálculo usando tilemap_width e tilemap_height
 	float x0 = 400;
@@ -660,13 +735,13 @@ void desenharMapa(GLuint shaderID)
 
 			model = translate(model, vec3(x,y,0.0));
 			model = scale(model,curr_tile.dimensions);
-			glUniformMatrix4fv(glGetUniformLocation(shaderID, "model"), 1, GL_FALSE, value_ptr(model));
+			shader.programa.setMat4(shader.model, value_ptr(model));
 
 		vec2 offsetTex;
 
 		offsetTex.s = curr_tile.iTile * curr_tile.ds;
 		offsetTex.t = 0.0;
-		glUniform2f(glGetUniformLocation(shaderID, "offsetTex"),offsetTex.s, offsetTex.t);
+		shader.programa.setVec2(shader.offsetTex, offsetTex.s, offsetTex.t);
 
 		glBindVertexArray(curr_tile.VAO); // Conectando ao buffer de geometria
 		glBindTexture(GL_TEXTURE_2D, curr_tile.texID); // Conectando ao buffer de textura
@@ -678,7 +753,7 @@ void desenharMapa(GLuint shaderID)
 	}
 }
 
-void desenharPersonagem(GLuint shaderID)
+void desenharPersonagem(ShaderTile &shader)
 {
 	Tile curr_tile = tileset[6]; //tile rosa
 
@@ -691,13 +766,13 @@ void desenharPersonagem(GLuint shaderID)
 	mat4 model = mat4(1);
 	model = translate(model, vec3(x,y,0.0));
 	model = scale(model,curr_tile.dimensions);
-	glUniformMatrix4fv(glGetUniformLocation(shaderID, "model"), 1, GL_FALSE, value_ptr(model));
+	shader.programa.setMat4(shader.model, value_ptr(model));
 
 	vec2 offsetTex;
 
 	offsetTex.s = curr_tile.iTile * curr_tile.ds;
 	offsetTex.t = 0.0;
-	glUniform2f(glGetUniformLocation(shaderID, "offsetTex"),offsetTex.s, offsetTex.t);
+	shader.programa.setVec2(shader.offsetTex, offsetTex.s, offsetTex.t);
 
 	glBindVertexArray(curr_tile.VAO); // Conectando ao buffer de geometria
 	glBindTexture(GL_TEXTURE_2D, curr_tile.texID); // Conectando ao buffer de textura
@@ -40,6 +40,8 @@ using namespace std;
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+#include "TextureLoader.h"
+
 // Protótipo da função de callback de teclado
 void key_callback(GLFWwindow *window, int key, int scancode, int action, int mode);
 
@@ -51,6 +53,9 @@ int loadTexture(string filePath);
 // Dimensões da janela (pode ser alterado em tempo de execução)
 const GLuint WIDTH = 800, HEIGHT = 800;
 
+// Decodifica as texturas em segundo plano (Common/TextureLoader.h)
+CarregadorTexturas carregador;
+
 // Código fonte do Vertex Shader (em GLSL): ainda hardcoded
 const GLchar *vertexShaderSource = R"(
  #version 400
@@ -140,6 +145,15 @@ int main()
 	// Gerando um buffer simples, com a geometria de um triângulo
 	GLuint VAO = setupGeometry();
 
+	// A textura é decodificada numa thread e enviada à GPU pelo game loop
+	string erroTexturas;
+	if (!carregador.iniciar(1, erroTexturas))
+	{
+		std::cerr << erroTexturas << std::endl;
+		glfwTerminate();
+		return -1;
+	}
+
 	//Carregando uma textura 
 	GLuint texID = loadTexture("../assets/sprites/pixelWall.png");
 
@@ -183,6 +197,13 @@ int main()
 		// Checa se houveram eventos de input (key pressed, mouse moved etc.) e chama as funções de callback correspondentes
 		glfwPollEvents();
 
+		// Até a imagem chegar, o quad mostra a textura provisória
+		if (!carregador.atualizar(erroTexturas))
+		{
+			std::cerr << erroTexturas << std::endl;
+			erroTexturas.clear();
+		}
+
 		// Limpa o buffer de cor
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f); // cor de fundo
 		glClear(GL_COLOR_BUFFER_BIT);
@@ -207,6 +228,7 @@ int main()
 	}
 	// Pede pra OpenGL desalocar os buffers
 	glDeleteVertexArrays(1, &VAO);
+	carregador.encerrar();
 	// Finaliza a execução da GLFW, limpando os recursos alocados por ela
 	glfwTerminate();
 	return 0;
@@ -338,44 +360,21 @@ int setupGeometry()
 	return VAO;
 }
 
+// Pede a textura ao carregador; os pixels só aparecem quando o game loop
+// chamar carregador.atualizar()
 int loadTexture(string filePath)
 {
-	GLuint texID;
-
-	// Gera o identificador da textura na memória
-	glGenTextures(1, &texID);
-	glBindTexture(GL_TEXTURE_2D, texID);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	OpcoesTextura opcoes;
+	opcoes.wrapS = opcoes.wrapT = GL_REPEAT;
+	opcoes.filtroMin = opcoes.filtroMag = GL_NEAREST;
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-	int width, height, nrChannels;
-
-	unsigned char *data = stbi_load(filePath.c_str(), &width, &height, &nrChannels, 0);
-
-	if (data)
+	InfoTextura info;
+	string erro;
+	if (!carregador.carregar(filePath, opcoes, info, erro))
 	{
-		if (nrChannels == 3) // jpg, bmp
-		{
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-		}
-		else // png
-		{
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-		}
-		glGenerateMipmap(GL_TEXTURE_2D);
-	}
-	else
-	{
-		std::cout << "Failed to load texture" << std::endl;
+		std::cout << "Failed to load texture: " << erro << std::endl;
+		return 0;
 	}
 
-	stbi_image_free(data);
-
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	return texID;
+	return info.texID;
 }
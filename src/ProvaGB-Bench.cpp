@@ -0,0 +1,951 @@
+/*
+ * Benchmarks de linha de comando do ProvaGB-Tilemap (--bench-mapa,
+ * --bench-carga, --bench-caminhos, --bench-agentes, --bench-hpa,
+ * --bench-campo, --bench-entidades, --bench-colisoes). Nenhum abre janela:
+ * medem as estruturas do jogo em mapas gerados e imprimem uma tabela.
+ * O --bench, que mede o desenho, continua no jogo.
+ */
+
+ #include <algorithm>
+ #include <chrono>
+ #include <cmath>
+ #include <cstdio>
+ #include <cstdlib>
+ #include <cstring>
+ #include <fstream>
+ #include <iostream>
+ #include <string>
+ #include <vector>
+
+ using namespace std;
+
+ #include <glad/glad.h>
+
+ #include <glm/glm.hpp>
+
+ using namespace glm;
+
+ #include "Entities.h"
+ #include "FlowField.h"
+ #include "GameLoop.h"
+ #include "HierarchicalPath.h"
+ #include "MapData.h"
+ #include "MapLoader.h"
+ #include "Pathfinding.h"
+ #include "PathQueue.h"
+ #include "SpatialGrid.h"
+
+ #include "ProvaGB-Tilemap.h"
+
+ // Compara o layout antigo (um vector<vector<int>> por camada) com a MapGrid
+ // plana de 2 bytes por célula: memória ocupada, varredura em ordem de linha
+ // (como o renderizador), varredura por coluna e acessos aleatórios (como
+ // colisões e consultas). Nas duas últimas quase todo acesso é cache miss, e
+ // o custo acompanha quantas linhas de cache o mapa ocupa
+ void executarBenchmarkMapa()
+ {
+     const int n = 4096;
+     const int nAleatorios = 1 << 22;
+     typedef chrono::steady_clock relogio;
+
+     cout << "Benchmark de armazenamento do mapa (" << n << "x" << n << ")" << endl;
+
+     vector<vector<int>> tiles(n, vector<int>(n)), items(n, vector<int>(n));
+     MapGrid grade;
+     grade.resize(n, n);
+
+     srand(42);
+     for (int i = 0; i < n; i++)
+     {
+         for (int j = 0; j < n; j++)
+         {
+             int r = rand() % 100;
+             tiles[i][j] = r < 75 ? 0 : (r < 85 ? 1 : 2);
+             items[i][j] = (rand() % 100) < 5 ? 1 : 0;
+             grade.setTile(i, j, tiles[i][j]);
+             grade.setItem(i, j, items[i][j]);
+         }
+     }
+
+     vector<int> sorteados(2 * nAleatorios);
+     for (size_t k = 0; k < sorteados.size(); k++)
+         sorteados[k] = rand() % n;
+
+     // Cada linha do layout antigo é uma alocação separada (com o próprio vector)
+     size_t memAntiga = 2 * (sizeof(tiles) + (size_t)n * (sizeof(vector<int>) + (size_t)n * sizeof(int)));
+     size_t memNova = sizeof(grade) + grade.getMemoryBytes();
+
+     double tempos[2][3];
+     long long soma[2] = {0, 0};
+     for (int layout = 0; layout < 2; layout++)
+     {
+         relogio::time_point t0 = relogio::now();
+         for (int i = 0; i < n; i++)
+         {
+             if (layout == 0)
+             {
+                 for (int j = 0; j < n; j++)
+                     soma[layout] += tiles[i][j] + items[i][j];
+             }
+             else
+             {
+                 const CelulaMapa *linha = grade.getLinha(i);
+                 for (int j = 0; j < n; j++)
+                     soma[layout] += linha[j].tile + linha[j].item;
+             }
+         }
+
+         relogio::time_point t1 = relogio::now();
+         for (int j = 0; j < n; j++)
+         {
+             for (int i = 0; i < n; i++)
+             {
+                 if (layout == 0)
+                     soma[layout] += tiles[i][j] + items[i][j];
+                 else
+                     soma[layout] += grade.getTile(i, j) + grade.getItem(i, j);
+             }
+         }
+
+         relogio::time_point t2 = relogio::now();
+         for (int k = 0; k < nAleatorios; k++)
+         {
+             int i = sorteados[2 * k], j = sorteados[2 * k + 1];
+             if (layout == 0)
+                 soma[layout] += tiles[i][j] + items[i][j];
+             else
+                 soma[layout] += grade.getTile(i, j) + grade.getItem(i, j);
+         }
+         relogio::time_point t3 = relogio::now();
+
+         tempos[layout][0] = chrono::duration<double, nano>(t1 - t0).count() / ((double)n * n);
+         tempos[layout][1] = chrono::duration<double, nano>(t2 - t1).count() / ((double)n * n);
+         tempos[layout][2] = chrono::duration<double, nano>(t3 - t2).count() / nAleatorios;
+     }
+
+     char linha[256];
+     cout << "layout                \tmemoria (MB)\tlinha (ns)\tcoluna (ns)\taleatorio (ns)" << endl;
+     sprintf(linha, "vector<vector<int>> x2\t%12.1f\t%10.3f\t%11.3f\t%14.3f", memAntiga / 1048576.0,
+             tempos[0][0], tempos[0][1], tempos[0][2]);
+     cout << linha << endl;
+     sprintf(linha, "MapGrid (2 B/celula)  \t%12.1f\t%10.3f\t%11.3f\t%14.3f", memNova / 1048576.0,
+             tempos[1][0], tempos[1][1], tempos[1][2]);
+     cout << linha << endl;
+
+     if (soma[0] != soma[1])
+         cout << "ERRO: somas diferentes entre os layouts (" << soma[0] << " != " << soma[1] << ")" << endl;
+ }
+
+ // Gera um map.txt de 4096x4096 temporário e compara a leitura antiga
+ // (ifstream >>) com a do MapLoader.h (arquivo mapeado + scanner próprio).
+ // As duas grades resultantes têm que ser idênticas
+ void executarBenchmarkCarga()
+ {
+     const int n = 4096;
+     const int repeticoes = 5;
+     const char *caminho = "bench_carga_4096.txt";
+     typedef chrono::steady_clock relogio;
+
+     const char *caminhoBinario = "bench_carga_4096.tmapb";
+
+     cout << "Benchmark de carga do map.txt (" << n << "x" << n << ")" << endl;
+
+     // Mesmo formato do assets/maps/map.txt, com índices do PNG (2, 4, 6)
+     string texto = "tileset.png\n7 114 57\n" + to_string(n) + " " + to_string(n) + "\n";
+     texto.reserve(texto.size() + 4 * (size_t)n * n + 2 * n);
+     srand(42);
+     for (int camada = 0; camada < 2; camada++)
+     {
+         for (int i = 0; i < n; i++)
+         {
+             for (int j = 0; j < n; j++)
+             {
+                 int r = rand() % 100;
+                 if (camada == 0)
+                     texto += r < 75 ? '2' : (r < 85 ? '4' : '6');
+                 else
+                     texto += r < 5 ? '1' : '0';
+                 texto += j + 1 < n ? ' ' : '\n';
+             }
+         }
+     }
+     {
+         ofstream saida(caminho, ios::binary);
+         saida.write(texto.data(), texto.size());
+     }
+     cout << "arquivo: " << texto.size() / 1048576.0 << " MB" << endl;
+
+     MapData antigo, novo;
+     relogio::time_point t0 = relogio::now();
+     bool okAntigo = carregarMapaStream(caminho, antigo);
+     double msAntigo = chrono::duration<double, milli>(relogio::now() - t0).count();
+
+     // A primeira leitura já pegou o arquivo no cache do SO; mede o melhor de
+     // algumas repetições para o loader novo
+     double msNovo = 1e30;
+     bool okNovo = true;
+     for (int r = 0; r < repeticoes; r++)
+     {
+         relogio::time_point t1 = relogio::now();
+         okNovo = okNovo && carregarMapa(caminho, novo);
+         msNovo = std::min(msNovo, chrono::duration<double, milli>(relogio::now() - t1).count());
+     }
+     remove(caminho);
+
+     // O mesmo mapa compilado para .tmapb: a carga só valida o cabeçalho e
+     // mapeia o arquivo, as páginas são lidas do disco quando acessadas
+     string erro;
+     bool okBinario = salvarMapaBinario(caminhoBinario, novo, erro);
+     double msBinario = 1e30;
+     MapData binario;
+     for (int r = 0; r < repeticoes && okBinario; r++)
+     {
+         relogio::time_point t1 = relogio::now();
+         okBinario = carregarMapa(caminhoBinario, binario);
+         msBinario = std::min(msBinario, chrono::duration<double, milli>(relogio::now() - t1).count());
+     }
+     bool binarioIgual = okBinario && binario.grade.getMemoryBytes() == novo.grade.getMemoryBytes() &&
+                         memcmp(binario.grade.getCelulas(), novo.grade.getCelulas(), novo.grade.getMemoryBytes()) == 0;
+     binario = MapData();
+     remove(caminhoBinario);
+
+     char linha[256];
+     cout << "loader                 \ttempo (ms)" << endl;
+     sprintf(linha, "ifstream >>            \t%10.1f", msAntigo);
+     cout << linha << endl;
+     sprintf(linha, "mmap + scanner         \t%10.1f", msNovo);
+     cout << linha << endl;
+     sprintf(linha, ".tmapb (mmap, no lugar)\t%10.3f", msBinario);
+     cout << linha << endl;
+     sprintf(linha, "speedup do scanner: %.1fx", msAntigo / msNovo);
+     cout << linha << endl;
+
+     bool iguais = okAntigo && okNovo &&
+                   antigo.grade.getMemoryBytes() == novo.grade.getMemoryBytes() &&
+                   memcmp(antigo.grade.getCelulas(), novo.grade.getCelulas(), novo.grade.getMemoryBytes()) == 0;
+     if (!iguais)
+         cout << "ERRO: os dois loaders produziram mapas diferentes" << endl;
+     if (!binarioIgual)
+         cout << "ERRO: o .tmapb nao reproduz o mapa original " << erro << endl;
+ }
+
+ // Muitas consultas de caminho seguidas em mapas gerados (10% de lava,
+ // intransponível), como várias unidades pedindo caminho no mesmo frame: de
+ // uma casa aleatória até outra a no máximo ALCANCE casas. O A* e o JPS
+ // respondem às mesmas consultas, e o benchmark confere que os dois acham
+ // caminho nas mesmas e com o mesmo custo
+ void executarBenchmarkCaminhos()
+ {
+     const int tamanhos[] = {256, 1024, 2048};
+     const int nTamanhos = sizeof(tamanhos) / sizeof(tamanhos[0]);
+     const int nConsultas = 2000;
+     const int alcance = 128;
+     typedef chrono::steady_clock relogio;
+
+     float custos[256];
+     montarCustosBenchmark(custos, false);
+
+     cout << "Benchmark de busca de caminho (" << nConsultas << " consultas por mapa, alcance " << alcance << ")" << endl;
+     cout << "tamanho   \tA* (us)\tnos A*\tJPS (us)\tnos JPS\tachados\tspeedup" << endl;
+
+     for (int t = 0; t < nTamanhos; t++)
+     {
+         int n = tamanhos[t];
+         MapData m;
+         gerarMapaAleatorio(m, n, n, 42);
+
+         srand(7);
+         vector<PontoGrade> origens, destinos;
+         while ((int)origens.size() < nConsultas)
+         {
+             PontoGrade o = {rand() % n, rand() % n};
+             PontoGrade d = {std::min(n - 1, std::max(0, o.linha + rand() % (2 * alcance + 1) - alcance)),
+                             std::min(n - 1, std::max(0, o.coluna + rand() % (2 * alcance + 1) - alcance))};
+             if (custos[m.grade.getTile(o.linha, o.coluna)] < 0.0f || custos[m.grade.getTile(d.linha, d.coluna)] < 0.0f)
+                 continue;
+             origens.push_back(o);
+             destinos.push_back(d);
+         }
+
+         Pathfinder pf;
+         vector<PontoGrade> caminho;
+         vector<float> custoAEstrela(nConsultas, -1.0f);
+         double us[2];
+         long nos[2] = {0, 0};
+         int achados[2] = {0, 0};
+         int diferentes = 0;
+         for (int modo = 0; modo < 2; modo++)
+         {
+             relogio::time_point inicio = relogio::now();
+             for (int q = 0; q < nConsultas; q++)
+             {
+                 bool achou = modo == 0 ? pf.buscarAEstrela(m.grade, custos, origens[q], destinos[q], caminho)
+                                        : pf.buscarJPS(m.grade, custos, origens[q], destinos[q], caminho);
+                 nos[modo] += pf.getEstatisticas().nosExpandidos;
+                 achados[modo] += achou;
+                 if (modo == 0)
+                     custoAEstrela[q] = pf.getEstatisticas().custo;
+                 else if (fabs(custoAEstrela[q] - pf.getEstatisticas().custo) > 1e-2f)
+                     diferentes++;
+             }
+             us[modo] = chrono::duration<double, micro>(relogio::now() - inicio).count() / nConsultas;
+         }
+
+         char linha[256];
+         sprintf(linha, "%4dx%-4d\t%7.1f\t%6ld\t%8.1f\t%7ld\t%d/%d\t%6.1fx", n, n, us[0], nos[0] / nConsultas,
+                 us[1], nos[1] / nConsultas, achados[1], nConsultas, us[0] / us[1]);
+         cout << linha << endl;
+         if (diferentes > 0 || achados[0] != achados[1])
+             cout << "ERRO: A* e JPS discordam em " << diferentes << " consultas" << endl;
+     }
+ }
+
+ // 1000 agentes pedem caminho de uma vez num mapa 1024x1024 e o laço
+ // principal recolhe as respostas da FilaCaminhos a cada "frame" de 1 ms,
+ // com 1 thread de busca e depois com mais, até uma por núcleo. Mostra a
+ // vazão em consultas por segundo e por thread, e o maior tempo que um
+ // coletar() segurou o frame. Os caminhos têm de sair iguais com qualquer
+ // número de threads
+ void executarBenchmarkAgentes()
+ {
+     const int n = 1024;
+     const int nAgentes = 1000;
+     const int alcance = 256;
+     typedef chrono::steady_clock relogio;
+
+     float custos[256];
+     montarCustosBenchmark(custos, false);
+
+     MapData m;
+     gerarMapaAleatorio(m, n, n, 42);
+
+     srand(11);
+     vector<PedidoCaminho> pedidos;
+     while ((int)pedidos.size() < nAgentes)
+     {
+         PedidoCaminho p;
+         p.id = (unsigned int)pedidos.size();
+         p.origem.linha = rand() % n;
+         p.origem.coluna = rand() % n;
+         p.destino.linha = std::min(n - 1, std::max(0, p.origem.linha + rand() % (2 * alcance + 1) - alcance));
+         p.destino.coluna = std::min(n - 1, std::max(0, p.origem.coluna + rand() % (2 * alcance + 1) - alcance));
+         if (custos[m.grade.getTile(p.origem.linha, p.origem.coluna)] < 0.0f ||
+             custos[m.grade.getTile(p.destino.linha, p.destino.coluna)] < 0.0f)
+             continue;
+         pedidos.push_back(p);
+     }
+
+     int nucleos = (int)std::thread::hardware_concurrency();
+     if (nucleos <= 0)
+         nucleos = 1;
+     vector<int> nThreads;
+     for (int t = 1; t < nucleos; t *= 2)
+         nThreads.push_back(t);
+     nThreads.push_back(nucleos);
+
+     cout << "Benchmark de agentes (" << nAgentes << " pedidos de A* num mapa " << n << "x" << n << ", alcance "
+          << alcance << ", " << nucleos << " nucleos)" << endl;
+     cout << "threads\ttempo (ms)\tconsultas/s\tpor thread\tcoletar max (us)\tachados" << endl;
+
+     vector<unsigned int> tamanhosRef;
+     for (size_t k = 0; k < nThreads.size(); k++)
+     {
+         FilaCaminhos fila;
+         string erro;
+         if (!fila.iniciar(m.grade, custos, nThreads[k], false, erro))
+         {
+             std::cerr << erro << std::endl;
+             return;
+         }
+
+         vector<unsigned int> tamanhos(nAgentes, 0);
+         LoteRespostas lote;
+         int recebidas = 0, achados = 0;
+         double coletarMax = 0.0;
+         relogio::time_point inicio = relogio::now();
+         fila.pedir(pedidos);
+         while (recebidas < nAgentes)
+         {
+             relogio::time_point antes = relogio::now();
+             size_t prontas = fila.coletar(lote);
+             coletarMax = std::max(coletarMax, chrono::duration<double, micro>(relogio::now() - antes).count());
+             for (size_t r = 0; r < prontas; r++)
+             {
+                 tamanhos[lote.respostas[r].id] = lote.respostas[r].tamanho;
+                 achados += lote.respostas[r].achou;
+             }
+             recebidas += (int)prontas;
+             if (recebidas < nAgentes)
+                 std::this_thread::sleep_for(chrono::milliseconds(1));
+         }
+         double segundos = chrono::duration<double>(relogio::now() - inicio).count();
+         fila.encerrar();
+
+         double vazao = nAgentes / segundos;
+         if (k == 0)
+             tamanhosRef = tamanhos;
+         char linha[256];
+         sprintf(linha, "%7d\t%10.1f\t%11.0f\t%10.0f\t%16.1f\t%d/%d", nThreads[k], segundos * 1000.0, vazao,
+                 vazao / nThreads[k], coletarMax, achados, nAgentes);
+         cout << linha << endl;
+         if (tamanhos != tamanhosRef)
+             cout << "ERRO: caminhos diferentes dos obtidos com 1 thread" << endl;
+     }
+ }
+
+ // true se caminho vai de origem a destino em passos de uma casa, só por
+ // casas passáveis
+ bool caminhoValido(const MapGrid &grade, const float custos[256], const vector<PontoGrade> &caminho,
+                    PontoGrade origem, PontoGrade destino)
+ {
+     if (caminho.empty() || caminho.front().linha != origem.linha || caminho.front().coluna != origem.coluna ||
+         caminho.back().linha != destino.linha || caminho.back().coluna != destino.coluna)
+         return false;
+     for (size_t k = 0; k < caminho.size(); k++)
+     {
+         if (custos[grade.getTile(caminho[k].linha, caminho[k].coluna)] < 0.0f)
+             return false;
+         if (k > 0 && (std::max(abs(caminho[k].linha - caminho[k - 1].linha), abs(caminho[k].coluna - caminho[k - 1].coluna)) != 1))
+             return false;
+     }
+     return true;
+ }
+
+ // Consultas longas (pontas em qualquer lugar do mapa) com o A* e com o
+ // HPA*, em mapas aleatórios de 512x512 a 2048x2048. Depois troca tiles
+ // espalhados (terra <-> lava) e compara o reparo incremental com construir
+ // o grafo de novo: os dois têm de responder igual
+ void executarBenchmarkHPA()
+ {
+     const int tamanhos[] = {512, 1024, 2048};
+     const int nTamanhos = sizeof(tamanhos) / sizeof(tamanhos[0]);
+     const int nConsultas = 100;
+     const int nAlteracoes = 64;
+     typedef chrono::steady_clock relogio;
+
+     float custos[256];
+     montarCustosBenchmark(custos, false);
+
+     cout << "Benchmark HPA* (" << nConsultas << " consultas longas por mapa, clusters de " << TAM_CLUSTER_HPA << "x"
+          << TAM_CLUSTER_HPA << ")" << endl;
+     cout << "tamanho   \tconstrucao (ms)\tnos\tMB\tA* (us)\tHPA* (us)\tspeedup\tcusto HPA*/A*" << endl;
+
+     for (int t = 0; t < nTamanhos; t++)
+     {
+         int n = tamanhos[t];
+         MapData m;
+         gerarMapaAleatorio(m, n, n, 42);
+
+         relogio::time_point inicio = relogio::now();
+         NavegacaoHPA hpa;
+         hpa.construir(m.grade, custos);
+         double msConstrucao = chrono::duration<double, milli>(relogio::now() - inicio).count();
+
+         srand(13);
+         vector<PontoGrade> origens, destinos;
+         while ((int)origens.size() < nConsultas)
+         {
+             PontoGrade o = {rand() % n, rand() % n};
+             PontoGrade d = {rand() % n, rand() % n};
+             if (custos[m.grade.getTile(o.linha, o.coluna)] < 0.0f || custos[m.grade.getTile(d.linha, d.coluna)] < 0.0f)
+                 continue;
+             origens.push_back(o);
+             destinos.push_back(d);
+         }
+
+         Pathfinder pf;
+         vector<PontoGrade> caminho;
+         vector<float> custoAEstrela(nConsultas, -1.0f);
+         inicio = relogio::now();
+         for (int q = 0; q < nConsultas; q++)
+             if (pf.buscarAEstrela(m.grade, custos, origens[q], destinos[q], caminho))
+                 custoAEstrela[q] = pf.getEstatisticas().custo;
+         double usAEstrela = chrono::duration<double, micro>(relogio::now() - inicio).count() / nConsultas;
+
+         vector<float> custoHPA(nConsultas, -1.0f);
+         int invalidos = 0;
+         inicio = relogio::now();
+         for (int q = 0; q < nConsultas; q++)
+             if (hpa.buscar(origens[q], destinos[q], caminho))
+                 custoHPA[q] = hpa.getEstatisticas().custo;
+         double usHPA = chrono::duration<double, micro>(relogio::now() - inicio).count() / nConsultas;
+
+         // Validação fora da medida
+         double razao = 0.0;
+         int achados = 0, discordam = 0;
+         for (int q = 0; q < nConsultas; q++)
+         {
+             if ((custoHPA[q] >= 0.0f) != (custoAEstrela[q] >= 0.0f))
+                 discordam++;
+             if (custoHPA[q] < 0.0f || custoAEstrela[q] < 0.0f)
+                 continue;
+             hpa.buscar(origens[q], destinos[q], caminho);
+             if (!caminhoValido(m.grade, custos, caminho, origens[q], destinos[q]))
+                 invalidos++;
+             if (custoAEstrela[q] > 0.0f)
+             {
+                 razao += custoHPA[q] / custoAEstrela[q];
+                 achados++;
+             }
+         }
+
+         char linha[256];
+         sprintf(linha, "%4dx%-4d\t%15.1f\t%6zu\t%4.1f\t%7.0f\t%9.1f\t%6.0fx\t%.3f", n, n, msConstrucao, hpa.getNumNos(),
+                 hpa.getMemoryBytes() / (1024.0 * 1024.0), usAEstrela, usHPA, usAEstrela / usHPA,
+                 achados > 0 ? razao / achados : 0.0);
+         cout << linha << endl;
+         if (invalidos > 0 || discordam > 0)
+             cout << "ERRO: " << invalidos << " caminhos invalidos, " << discordam << " consultas com resposta diferente do A*" << endl;
+
+         // Tiles trocados em pontos espalhados do mapa
+         for (int k = 0; k < nAlteracoes; k++)
+         {
+             int l = rand() % n, c = rand() % n;
+             m.grade.setTile(l, c, m.grade.getTile(l, c) == 1 ? 0 : 1);
+             hpa.marcarAlterada(l, c);
+         }
+         inicio = relogio::now();
+         int religados = hpa.reparar();
+         double usReparo = chrono::duration<double, micro>(relogio::now() - inicio).count();
+
+         NavegacaoHPA nova;
+         inicio = relogio::now();
+         nova.construir(m.grade, custos);
+         double msNova = chrono::duration<double, milli>(relogio::now() - inicio).count();
+
+         int diferentes = 0;
+         vector<PontoGrade> caminhoNovo;
+         for (int q = 0; q < nConsultas; q++)
+         {
+             bool a = hpa.buscar(origens[q], destinos[q], caminho);
+             bool b = nova.buscar(origens[q], destinos[q], caminhoNovo);
+             if (a != b || (a && fabs(hpa.getEstatisticas().custo - nova.getEstatisticas().custo) > 1e-2f))
+                 diferentes++;
+         }
+         sprintf(linha, "          %d tiles trocados: reparo de %d clusters em %.0f us (construir de novo: %.1f ms)",
+                 nAlteracoes, religados, usReparo, msNova);
+         cout << linha << endl;
+         if (diferentes > 0)
+             cout << "ERRO: o grafo reparado responde diferente do reconstruido em " << diferentes << " consultas" << endl;
+     }
+ }
+
+ // Distâncias iguais a menos do erro de arredondamento (as somas são feitas
+ // em outra ordem); devolve quantas casas diferem
+ int compararCampos(const CampoFluxo &a, const CampoFluxo &b, int n)
+ {
+     int diferentes = 0;
+     for (int l = 0; l < n; l++)
+         for (int c = 0; c < n; c++)
+         {
+             float da = a.getDistancia(l, c), db = b.getDistancia(l, c);
+             if ((da >= DISTANCIA_INFINITA) != (db >= DISTANCIA_INFINITA) ||
+                 (da < DISTANCIA_INFINITA && fabs(da - db) > 1e-3f * std::max(1.0f, da)))
+                 diferentes++;
+         }
+     return diferentes;
+ }
+
+ // Campo de fluxo das moedas em mapas gerados: Dijkstra contra as varreduras
+ // por linha, com a lava intransponível e com a lava só cara, e a remoção
+ // incremental de moedas contra recalcular o campo inteiro
+ void executarBenchmarkCampo()
+ {
+     const int tamanhos[] = {256, 1024, 2048};
+     const int nTamanhos = sizeof(tamanhos) / sizeof(tamanhos[0]);
+     const int nRemocoes = 100;
+     typedef chrono::steady_clock relogio;
+
+     float custos[256];
+     montarCustosBenchmark(custos, false);
+
+     cout << "Benchmark do campo de fluxo das moedas (" << nRemocoes << " moedas removidas por mapa)" << endl;
+     cout << "tamanho   \tlava\tDijkstra (ms)\tvarredura (ms)\tvarreduras\tremocao (us)\tcasas/remocao\trecalculo (ms)" << endl;
+
+     for (int t = 0; t < nTamanhos; t++)
+     {
+         int n = tamanhos[t];
+         for (int modoLava = 0; modoLava < 2; modoLava++)
+         {
+             montarCustosBenchmark(custos, modoLava == 1);
+             MapData m;
+             gerarMapaAleatorio(m, n, n, 42);
+
+             CampoFluxo dijkstra, varredura;
+             relogio::time_point inicio = relogio::now();
+             dijkstra.calcular(m.grade, custos, CAMPO_DIJKSTRA);
+             double msDijkstra = chrono::duration<double, milli>(relogio::now() - inicio).count();
+             inicio = relogio::now();
+             varredura.calcular(m.grade, custos, CAMPO_VARREDURA);
+             double msVarredura = chrono::duration<double, milli>(relogio::now() - inicio).count();
+             int diferentes = compararCampos(dijkstra, varredura, n);
+
+             // Moedas sorteadas, coletadas uma a uma
+             vector<PontoGrade> moedas;
+             for (int l = 0; l < n; l++)
+                 for (int c = 0; c < n; c++)
+                     if (m.grade.getItem(l, c) == ITEM_MOEDA && custos[m.grade.getTile(l, c)] >= 0.0f)
+                         moedas.push_back(PontoGrade{l, c});
+             srand(7);
+             for (int k = 0; k < nRemocoes && k < (int)moedas.size(); k++)
+                 std::swap(moedas[k], moedas[k + rand() % (moedas.size() - k)]);
+             int nMoedas = std::min(nRemocoes, (int)moedas.size());
+
+             long recalculadas = 0;
+             double usRemocao = 0.0;
+             for (int k = 0; k < nMoedas; k++)
+             {
+                 m.grade.setItem(moedas[k].linha, moedas[k].coluna, ITEM_VAZIO);
+                 inicio = relogio::now();
+                 recalculadas += dijkstra.removerMoeda(moedas[k].linha, moedas[k].coluna);
+                 usRemocao += chrono::duration<double, micro>(relogio::now() - inicio).count();
+             }
+
+             CampoFluxo inteiro;
+             inicio = relogio::now();
+             inteiro.calcular(m.grade, custos, CAMPO_DIJKSTRA);
+             double msRecalculo = chrono::duration<double, milli>(relogio::now() - inicio).count();
+             int diferentesRemocao = compararCampos(dijkstra, inteiro, n);
+
+             char linha[256];
+             sprintf(linha, "%4dx%-4d\t%s\t%13.1f\t%14.1f\t%10d\t%12.1f\t%13.0f\t%14.1f", n, n,
+                     modoLava == 0 ? "bloq" : "cara", msDijkstra, msVarredura, varredura.getVarreduras(),
+                     usRemocao / nMoedas, (double)recalculadas / nMoedas, msRecalculo);
+             cout << linha << endl;
+             if (diferentes > 0)
+                 cout << "ERRO: varredura difere do Dijkstra em " << diferentes << " casas" << endl;
+             if (diferentesRemocao > 0)
+                 cout << "ERRO: campo atualizado difere do recalculado em " << diferentesRemocao << " casas" << endl;
+         }
+     }
+ }
+
+ // O trabalho de CPU de um frame com muitas entidades (guardar as posições,
+ // andar com os atores, animar e montar as instâncias do desenho) no
+ // RegistroEntidades, comparado com o mesmo feito sobre structs alocadas uma
+ // a uma, como eram o personagem e a moeda. Mede também a troca de 1% das
+ // entidades por frame e confere que os Entidade removidos deixam de valer
+ void executarBenchmarkEntidades()
+ {
+     const int tamanhos[] = {1000, 10000, 100000};
+     const int nTamanhos = sizeof(tamanhos) / sizeof(tamanhos[0]);
+     const int frames = 100;
+     const int DL[8] = {-1, 1, 0, 0, -1, -1, 1, 1};
+     const int DC[8] = {0, 0, -1, 1, -1, 1, -1, 1};
+     const vec2 dimTile(64.0f, 32.0f);
+     typedef chrono::steady_clock relogio;
+
+     // Os sprites do jogo sem o atlas: as regiões não importam aqui
+     Sprite tabela[NUM_SPRITES] = {};
+     tabela[SPRITE_MOEDA].regiao.du = tabela[SPRITE_MOEDA].regiao.dv = 1.0f;
+     tabela[SPRITE_MOEDA].dimensions = vec3(32.0f, 32.0f, 1.0f);
+     tabela[SPRITE_MOEDA].nFrames = tabela[SPRITE_MOEDA].nAnimations = 1;
+     tabela[SPRITE_PERSONAGEM] = tabela[SPRITE_MOEDA];
+     tabela[SPRITE_PERSONAGEM].dimensions = vec3(64.0f, 64.0f, 1.0f);
+     tabela[SPRITE_PERSONAGEM].position = vec3(dimTile.x / 2.0f, 0.0f, 0.0f);
+     tabela[SPRITE_PERSONAGEM].nFrames = 6;
+     tabela[SPRITE_PERSONAGEM].nAnimations = 4;
+
+     // O mesmo estado numa struct por entidade
+     struct EntidadeAvulsa
+     {
+         Sprite sprite;
+         vec2 pos, posAnterior;
+         int quadro, animacao;
+         uint8_t flags;
+     };
+
+     cout << "Benchmark de entidades (" << frames << " frames, metade moedas e metade atores andando)" << endl;
+     cout << "entidades\tregistro (us)\tstructs (us)\tspeedup\ttroca 1% (us)\tMB" << endl;
+
+     for (int t = 0; t < nTamanhos; t++)
+     {
+         int n = tamanhos[t];
+         int lado = (int)sqrt((double)n) * 2;
+
+         // A câmera vê a área inteira, para todas as entidades irem ao desenho
+         camera.posicao = vec2(WIDTH / 2.0f - lado * dimTile.x / 2.0f, 150.0f - dimTile.y);
+         camera.tamanho = vec2(lado * dimTile.x, lado * dimTile.y + 2.0f * dimTile.y);
+
+         srand(5);
+         RegistroEntidades registro;
+         registro.reservar(n);
+         vector<EntidadeAvulsa *> avulsas;
+         for (int k = 0; k < n; k++)
+         {
+             bool ator = k % 2 == 1;
+             float l = (float)(rand() % lado), c = (float)(rand() % lado);
+             int s = ator ? SPRITE_PERSONAGEM : SPRITE_MOEDA;
+             uint8_t f = (uint8_t)(ENTIDADE_VISIVEL | (ator ? ENTIDADE_ATOR : ENTIDADE_MOEDA));
+             registro.criar(l, c, s, tabela[s].nFrames, f);
+
+             EntidadeAvulsa *e = new EntidadeAvulsa();
+             e->sprite = tabela[s];
+             e->pos = e->posAnterior = vec2(l, c);
+             e->quadro = e->animacao = 0;
+             e->flags = f;
+             avulsas.push_back(e);
+         }
+         // Em ordem qualquer, como ficam objetos criados e destruídos ao longo do jogo
+         for (int k = n - 1; k > 0; k--)
+             std::swap(avulsas[k], avulsas[rand() % (k + 1)]);
+
+         vector<InstanciaEntidade> instancias;
+         instancias.reserve(n);
+         relogio::time_point inicio = relogio::now();
+         for (int f = 0; f < frames; f++)
+         {
+             registro.guardarPosicoes();
+             float *linhas = registro.getLinhas();
+             float *colunas = registro.getColunas();
+             const uint8_t *flags = registro.getFlags();
+             for (int k = 0; k < n; k++)
+             {
+                 if (!(flags[k] & ENTIDADE_ATOR))
+                     continue;
+                 int d = (k + f) & 7;
+                 linhas[k] += (float)DL[d];
+                 colunas[k] += (float)DC[d];
+             }
+             registro.animar(f, FPS, HZ_LOGICA);
+             montarInstanciasEntidades(registro, tabela, dimTile, 0.5f, instancias);
+         }
+         double usRegistro = chrono::duration<double, micro>(relogio::now() - inicio).count() / frames;
+         size_t desenhadas = instancias.size();
+
+         inicio = relogio::now();
+         for (int f = 0; f < frames; f++)
+         {
+             int q = (int)(f * FPS / HZ_LOGICA);
+             instancias.clear();
+             for (int atores = 0; atores < 2; atores++)
+             {
+                 for (int k = 0; k < n; k++)
+                 {
+                     EntidadeAvulsa &e = *avulsas[k];
+                     if (atores == 0)
+                     {
+                         e.posAnterior = e.pos;
+                         if (e.flags & ENTIDADE_ATOR)
+                         {
+                             int d = (k + f) & 7;
+                             e.pos += vec2((float)DL[d], (float)DC[d]);
+                         }
+                         e.quadro = q % e.sprite.nFrames;
+                     }
+                     if (!(e.flags & ENTIDADE_VISIVEL) || ((e.flags & ENTIDADE_ATOR) != 0) != (atores == 1))
+                         continue;
+
+                     vec2 p = mix(e.posAnterior, e.pos, 0.5f);
+                     float x = WIDTH / 2.0f + (p.y - p.x) * dimTile.x / 2.0f + e.sprite.position.x;
+                     float y = 150.0f + (p.x + p.y) * dimTile.y / 2.0f + e.sprite.position.y;
+                     float meiaLargura = e.sprite.dimensions.x / 2.0f, meiaAltura = e.sprite.dimensions.y / 2.0f;
+                     if (x + meiaLargura < camera.posicao.x || x - meiaLargura > camera.posicao.x + camera.tamanho.x ||
+                         y + meiaAltura < camera.posicao.y || y - meiaAltura > camera.posicao.y + camera.tamanho.y)
+                         continue;
+
+                     RegiaoAtlas r = e.sprite.regiao.celula(e.quadro, e.animacao, e.sprite.nFrames, e.sprite.nAnimations);
+                     InstanciaEntidade inst = {{p.x, p.y},
+                                               {e.sprite.dimensions.x, e.sprite.dimensions.y},
+                                               {e.sprite.position.x, e.sprite.position.y},
+                                               {r.u, r.v, r.du, r.dv},
+                                               (GLfloat)r.pagina,
+                                               {1.0f, 1.0f, 1.0f}};
+                     instancias.push_back(inst);
+                 }
+             }
+         }
+         double usAvulsas = chrono::duration<double, micro>(relogio::now() - inicio).count() / frames;
+         bool confere = instancias.size() == desenhadas;
+         for (int k = 0; k < n; k++)
+             delete avulsas[k];
+
+         // Troca de 1% por frame, pelos Entidade sorteados
+         vector<Entidade> vivas, removidas;
+         for (size_t k = 0; k < registro.tamanho(); k++)
+             vivas.push_back(registro.getEntidade(k));
+         int nTroca = std::max(1, n / 100);
+         inicio = relogio::now();
+         for (int f = 0; f < frames; f++)
+         {
+             for (int r = 0; r < nTroca; r++)
+             {
+                 size_t v = rand() % vivas.size();
+                 registro.remover(vivas[v]);
+                 removidas.push_back(vivas[v]);
+                 vivas[v] = registro.criar((float)(rand() % lado), (float)(rand() % lado), SPRITE_MOEDA, 1,
+                                           ENTIDADE_VISIVEL | ENTIDADE_MOEDA);
+             }
+         }
+         double usTroca = chrono::duration<double, micro>(relogio::now() - inicio).count() / frames;
+
+         int erradas = 0;
+         for (size_t k = 0; k < removidas.size(); k++)
+             if (registro.valida(removidas[k]))
+                 erradas++;
+         for (size_t k = 0; k < vivas.size(); k++)
+         {
+             int i = registro.indice(vivas[k]);
+             if (i < 0 || registro.getEntidade(i).slot != vivas[k].slot)
+                 erradas++;
+         }
+         if (registro.tamanho() != (size_t)n)
+             erradas++;
+
+         char linha[256];
+         sprintf(linha, "%9d\t%13.1f\t%12.1f\t%6.1fx\t%13.1f\t%.2f", n, usRegistro, usAvulsas, usAvulsas / usRegistro,
+                 usTroca, registro.getMemoryBytes() / (1024.0 * 1024.0));
+         cout << linha << endl;
+         if (!confere)
+             cout << "ERRO: os dois caminhos desenham quantidades diferentes de entidades" << endl;
+         if (erradas > 0)
+             cout << "ERRO: " << erradas << " Entidade com validade errada depois das trocas" << endl;
+     }
+ }
+
+ // Entidades andando num mapa 512x512, cada uma procurando as vizinhas a até
+ // uma casa a cada frame pela GradeEspacial, comparado com testar todos os
+ // pares. Confere as contagens da grade com as do teste de todos os pares,
+ // também para consultas por retângulo
+ void executarBenchmarkColisoes()
+ {
+     const int tamanhos[] = {1000, 10000, 100000};
+     const int nTamanhos = sizeof(tamanhos) / sizeof(tamanhos[0]);
+     const int lado = 512;
+     const int frames = 20;
+     const float raio = 1.0f;
+     const int nRetangulos = 100;
+     typedef chrono::steady_clock relogio;
+
+     cout << "Benchmark de colisao entre entidades (mapa " << lado << "x" << lado << ", raio " << raio
+          << ", baldes de " << TAM_BALDE_GRADE << "x" << TAM_BALDE_GRADE << ", " << frames << " frames)" << endl;
+     cout << "entidades\tmover (us)\tconsultas (us)\tpor consulta (ns)\tvizinhas\ttodos os pares (ms)\tspeedup" << endl;
+
+     for (int t = 0; t < nTamanhos; t++)
+     {
+         int n = tamanhos[t];
+         srand(11);
+         RegistroEntidades registro;
+         GradeEspacial grade;
+         grade.iniciar(lado, lado);
+         vector<Entidade> handles;
+         for (int k = 0; k < n; k++)
+         {
+             float l = (float)(rand() % (lado * 16)) / 16.0f, c = (float)(rand() % (lado * 16)) / 16.0f;
+             Entidade e = registro.criar(l, c, SPRITE_PERSONAGEM, 1, ENTIDADE_VISIVEL | ENTIDADE_ATOR);
+             grade.inserir(e, l, c);
+             handles.push_back(e);
+         }
+
+         // Passos sorteados antes, para a medida só ver a grade
+         vector<float> passos(2 * n);
+         for (int k = 0; k < 2 * n; k++)
+             passos[k] = (float)(rand() % 33 - 16) / 32.0f;
+
+         vector<Entidade> vizinhas;
+         double usMover = 0.0, usConsultas = 0.0;
+         long total = 0;
+         for (int f = 0; f < frames; f++)
+         {
+             float *linhas = registro.getLinhas();
+             float *colunas = registro.getColunas();
+             relogio::time_point inicio = relogio::now();
+             for (int k = 0; k < n; k++)
+             {
+                 int p = (k + f * 7) % n;
+                 linhas[k] = std::min(std::max(linhas[k] + passos[2 * p], 0.0f), lado - 1.0f);
+                 colunas[k] = std::min(std::max(colunas[k] + passos[2 * p + 1], 0.0f), lado - 1.0f);
+                 grade.mover(handles[k], linhas[k], colunas[k]);
+             }
+             usMover += chrono::duration<double, micro>(relogio::now() - inicio).count();
+
+             inicio = relogio::now();
+             total = 0;
+             for (int k = 0; k < n; k++)
+             {
+                 vizinhas.clear();
+                 total += (long)grade.consultarRaio(linhas[k], colunas[k], raio, vizinhas) - 1; // menos ela mesma
+             }
+             usConsultas += chrono::duration<double, micro>(relogio::now() - inicio).count();
+         }
+         usMover /= frames;
+         usConsultas /= frames;
+
+         // Todos os pares, uma vez, na posição final
+         const float *linhas = registro.getLinhas();
+         const float *colunas = registro.getColunas();
+         double msPares = -1.0;
+         long totalPares = -1;
+         if (n <= 10000)
+         {
+             relogio::time_point inicio = relogio::now();
+             totalPares = 0;
+             for (int a = 0; a < n; a++)
+                 for (int b = 0; b < n; b++)
+                 {
+                     float dl = linhas[a] - linhas[b], dc = colunas[a] - colunas[b];
+                     if (a != b && dl * dl + dc * dc <= raio * raio)
+                         totalPares++;
+                 }
+             msPares = chrono::duration<double, milli>(relogio::now() - inicio).count();
+         }
+
+         int retangulosErrados = 0;
+         for (int r = 0; r < nRetangulos; r++)
+         {
+             float l0 = (float)(rand() % lado), c0 = (float)(rand() % lado);
+             float l1 = l0 + (float)(rand() % 64), c1 = c0 + (float)(rand() % 64);
+             vizinhas.clear();
+             size_t achadas = grade.consultarRetangulo(l0, c0, l1, c1, vizinhas);
+             size_t esperadas = 0;
+             for (int k = 0; k < n; k++)
+                 if (linhas[k] >= l0 && linhas[k] <= l1 && colunas[k] >= c0 && colunas[k] <= c1)
+                     esperadas++;
+             if (achadas != esperadas)
+                 retangulosErrados++;
+         }
+
+         char linha[256];
+         if (msPares < 0.0)
+             sprintf(linha, "%9d\t%10.1f\t%14.1f\t%17.1f\t%8.2f\t%19s\t%7s", n, usMover, usConsultas,
+                     usConsultas * 1000.0 / n, (double)total / n, "-", "-");
+         else
+             sprintf(linha, "%9d\t%10.1f\t%14.1f\t%17.1f\t%8.2f\t%19.1f\t%6.0fx", n, usMover, usConsultas,
+                     usConsultas * 1000.0 / n, (double)total / n, msPares, msPares * 1000.0 / usConsultas);
+         cout << linha << endl;
+         if (totalPares >= 0 && totalPares != total)
+             cout << "ERRO: a grade achou " << total << " vizinhas, o teste de todos os pares " << totalPares << endl;
+         if (retangulosErrados > 0)
+             cout << "ERRO: " << retangulosErrados << " consultas por retangulo com contagem errada" << endl;
+     }
+ }
+
+ struct BenchmarkLinhaComando
+ {
+     const char *opcao;
+     void (*executar)();
+ };
+
+ const BenchmarkLinhaComando BENCHMARKS[] = {
+     {"--bench-mapa", executarBenchmarkMapa},
+     {"--bench-carga", executarBenchmarkCarga},
+     {"--bench-caminhos", executarBenchmarkCaminhos},
+     {"--bench-agentes", executarBenchmarkAgentes},
+     {"--bench-hpa", executarBenchmarkHPA},
+     {"--bench-campo", executarBenchmarkCampo},
+     {"--bench-entidades", executarBenchmarkEntidades},
+     {"--bench-colisoes", executarBenchmarkColisoes},
+ };
+
+ bool executarBenchmarkLinhaComando(const char *opcao)
+ {
+     for (size_t k = 0; k < sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]); k++)
+     {
+         if (strcmp(opcao, BENCHMARKS[k].opcao) == 0)
+         {
+             BENCHMARKS[k].executar();
+             return true;
+         }
+     }
+     return false;
+ }
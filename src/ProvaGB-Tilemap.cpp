@@ -13,6 +13,10 @@
  #include <fstream>
  #include <sstream>
  #include <vector>
+ #include <cstdlib>
+ #include <cstring>
+ #include <algorithm>
+ #include <chrono>
  
  using namespace std;
  
@@ -25,6 +29,8 @@
  // STB_IMAGE
  #define STB_IMAGE_IMPLEMENTATION
  #include <stb_image.h>
+ #define STB_IMAGE_WRITE_IMPLEMENTATION
+ #include <stb_image_write.h>
  
  //GLM
  #include <glm/glm.hpp> 
@@ -32,68 +38,201 @@
  #include <glm/gtc/type_ptr.hpp>
  
  using namespace glm;
- 
- struct Sprite
- {
-     GLuint VAO;
-     GLuint texID;
-     vec3 position;
-     vec3 dimensions;
-     float ds, dt;
-     int iAnimation, iFrame;
-     int nAnimations, nFrames;
- };
+
+ #include "Entities.h"
+ #include "FlowField.h"
+ #include "GameLoop.h"
+ #include "GpuResources.h"
+ #include "Headless.h"
+ #include "HierarchicalPath.h"
+ #include "InputQueue.h"
+ #include "InputReplay.h"
+ #include "Logger.h"
+ #include "MapData.h"
+ #include "MapLoader.h"
+ #include "Pathfinding.h"
+ #include "Profiler.h"
+ #include "ShaderProgram.h"
+ #include "SpatialGrid.h"
+ #include "TextureAtlas.h"
+
+ #include "ProvaGB-Tilemap.h"
  
  struct Tile
  {
      GLuint VAO;
-     GLuint texID;
-     int iTile;
+     RecursoGPU geometria;
+     RegiaoAtlas regiao; // coluna do tileset no atlas
      vec3 position;
      vec3 dimensions;
-     float ds, dt;
      bool caminhavel;
      bool letal;
+     float custo; // custo de entrar na casa para a busca de caminho
  };
  
- struct MapData
+
+ // Atributos de instância do renderizador instanciado: um registro por tile
+ struct InstanciaTile
+ {
+     GLfloat celula[2]; // (i, j) no mapa
+     GLfloat iTile;     // índice em tileset / uvTiles
+     GLfloat tint[3];
+ };
+
+ // Bloco de TAM_CHUNK x TAM_CHUNK células com os tiles (linha a linha) num
+ // VBO estático. O VBO é criado na primeira vez que o chunk aparece na tela
+ // e só é reconstruído quando alguma célula dele muda (ver
+ // marcarCelulaAlterada)
+ struct ChunkMapa
+ {
+     RecursoGPU VAO, VBO;
+     int nTiles;
+     bool sujo;
+ };
+
+ // Mesmo layout de DrawArraysIndirectCommand (glMultiDrawArraysIndirect)
+ struct ComandoIndireto
+ {
+     GLuint count;
+     GLuint instanceCount;
+     GLuint first;
+     GLuint baseInstance;
+ };
+
+ // Shader do desenho por tile (os losangos do mapa), com os índices dos
+ // uniforms resolvidos depois do link
+ struct ShaderSprite
+ {
+     ShaderProgram programa;
+     int model, projection, uvRect, pagina, colorTint, atlas;
+ };
+
+ // Shader do mapa instanciado
+ struct ShaderMapa
+ {
+     ShaderProgram programa;
+     int projection, origem, dimTile, uvTiles, paginaTiles, atlas;
+ };
+
+ // Shader das entidades, também instanciado
+ struct ShaderEntidades
  {
-     string tilesetPath;
-     int numTiles;
-     int tileWidth, tileHeight;
-     int mapWidth, mapHeight;
-     vector<vector<int>> tiles;
-     vector<vector<int>> items; // 0=vazio, 1=moeda
+     ShaderProgram programa;
+     int projection, origem, dimTile, atlas;
  };
  
  // Protótipos das funções
  void key_callback(GLFWwindow *window, int key, int scancode, int action, int mode);
- int setupShader();
- int setupSprite(int nAnimations, int nFrames, float &ds, float &dt);
- int setupTile(int nTiles, float &ds, float &dt);
- int setupCoin(float &ds, float &dt);
- int loadTexture(string filePath, int &width, int &height);
- void desenharMapa(GLuint shaderID);
- void desenharPersonagem(GLuint shaderID);
- bool carregarMapa(const string& filepath, MapData& mapData);
+ void mouse_callback(GLFWwindow *window, int button, int action, int mods);
+ int setupShader(const GLchar *vsSource, const GLchar *fsSource);
+ void resolverUniforms(ShaderSprite &shader, GLuint programa);
+ void resolverUniforms(ShaderMapa &shader, GLuint programa);
+ void resolverUniforms(ShaderEntidades &shader, GLuint programa);
+ RecursoGPU setupTile();
+ void relatarRecursos(const char *quando);
+ void liberarRecursos();
+ void aplicarRegiao(ShaderSprite &shader, const RegiaoAtlas &regiao);
+ void desenharMapa(ShaderSprite &shader);
+ void setupMapaInstanciado(ShaderMapa &shader);
+ void setupChunks();
+ void reconstruirChunk(int ci, int cj);
+ void apontarAtributosChunk(size_t primeiro);
+ void marcarCelulaAlterada(int i, int j);
+ bool teclaMovimento(int key);
+ void moverPersonagem(int key);
+ void regrasTile(int tipo, Tile &tile);
+ void montarCustosCaminho();
+ void iniciarCaminho(int linha, int coluna);
+ void seguirCaminho();
+ void seguirCampo();
+ bool andarAte(PontoGrade casa);
+ void atualizarJogo();
+ EstadoReplay estadoAtual();
+ void atualizarCamera(vec2 alvo);
+ void aplicarProjecao(ShaderSprite &shader, ShaderMapa &instShader, ShaderEntidades &entShader);
+ bool linhasVisiveis(int &iIni, int &iFim);
+ bool colunasVisiveis(int i, int &jIni, int &jFim);
+ void desenharMapaInstanciado(ShaderMapa &shader);
+ int criarEntidades();
+ void setupEntidades(ShaderEntidades &shader);
+ void desenharEntidades(ShaderEntidades &shader, float alfa);
  void processarColisoes();
- 
- // Dimensões da janela
- const GLuint WIDTH = 1024, HEIGHT = 768;
+ void executarBenchmark(GLFWwindow *window, ShaderSprite &shader, ShaderMapa &instShader, ShaderEntidades &entShader);
  
  // Variáveis globais
  vector<Tile> tileset;
  MapData mapa;
  vec2 pos;
- Sprite personagem;
- Sprite moeda;
+
+ // Sprites que as entidades usam, pelo índice guardado no RegistroEntidades
+ Sprite sprites[NUM_SPRITES];
+ Sprite &moeda = sprites[SPRITE_MOEDA];
+ Sprite &personagem = sprites[SPRITE_PERSONAGEM];
+
+ // Moedas e personagem (Common/Entities.h), indexados por casa em
+ // gradeEntidades (Common/SpatialGrid.h) para a colisão. pos continua sendo
+ // a posição lógica do personagem; moverPersonagem() a copia para a
+ // entidade jogador
+ RegistroEntidades entidades;
+ GradeEspacial gradeEntidades;
+ Entidade jogador;
+ vector<InstanciaEntidade> instanciasEntidades;
+ RecursoGPU entidadesVAO = recursoNulo(), entidadesVBO = recursoNulo();
  int moedasColetadas = 0;
  int moedasTotal = 0;
  bool jogoGanho = false;
  bool jogoPerdido = false;
- double lastTime = 0.0;
- double currTime = 0.0;
- double FPS = 8.0;
+ double FPS = 8.0; // frames da animação do personagem por segundo
+
+ // A lógica roda em passos fixos de 1/HZ_LOGICA s (Common/GameLoop.h). O
+ // callback de teclado só põe os eventos na filaEntrada, que o próximo
+ // passo esvazia, e o desenho interpola o personagem entre posAnterior e pos
+ long passoLogica = 0;
+ vec2 posAnterior;
+ FilaSPSC<EventoTecla, 256> filaEntrada;
+ long perdidosAvisados = 0; // eventos descartados com a fila cheia já no log
+
+ // --gravar guarda os eventos tratados em cada passo; --replay os devolve à
+ // fila no mesmo passo e ignora o teclado (Common/InputReplay.h)
+ GravacaoEntrada gravacao, replay;
+ bool gravando = false, reproduzindo = false;
+
+ // Clique para mover (Common/Pathfinding.h): o caminho até a casa clicada é
+ // seguido uma casa a cada PASSOS_POR_CASA passos de lógica
+ const int PASSOS_POR_CASA = 8;
+ float custosCaminho[256];
+ bool custosUniformes = true; // todo tile passável custa o mesmo: dá para usar o JPS
+ Pathfinder pathfinder;
+ NavegacaoHPA navegacao; // cliques a mais de DISTANCIA_HPA casas (Common/HierarchicalPath.h)
+ const int DISTANCIA_HPA = 4 * TAM_CLUSTER_HPA;
+ vector<PontoGrade> caminhoAtual;
+ size_t proximaCasa = 0;
+
+ // Tecla C: o personagem segue o campo de fluxo até a moeda mais próxima
+ // (Common/FlowField.h), atualizado a cada moeda coletada
+ CampoFluxo campoMoedas;
+ bool seguindoCampo = false;
+
+ // Renderização instanciada do mapa (tecla I alterna com o caminho por tile)
+ bool renderInstanciado = true;
+ const int TAM_CHUNK = 32;
+ vector<ChunkMapa> chunks;
+ int chunksLinhas = 0, chunksColunas = 0;
+ int chunksDesenhados = 0;
+ int tilesDesenhados = 0;
+ vector<InstanciaTile> instancias; // rascunho para reconstruir um chunk
+ vector<ComandoIndireto> comandos;
+ RecursoGPU indirectBuffer = recursoNulo();
+ // glMultiDrawArraysIndirect com baseInstance precisa de GL 4.3 (ou das
+ // extensões); sem ele (macOS fica no 4.1) vai um glDrawArraysInstanced por
+ // linha, com os atributos apontando para a primeira instância da linha
+ bool desenhoIndireto = false;
+
+ // Todos os VAOs, buffers e texturas do jogo, para deduplicar a geometria e
+ // contar a memória de vídeo
+ RecursosGPU recursos;
+
+ Camera camera = {vec2(0.0f, 0.0f), vec2(WIDTH, HEIGHT)};
  
  // Shaders
  const GLchar *vertexShaderSource = R"(
@@ -103,9 +242,11 @@
   out vec2 tex_coord;
   uniform mat4 model;
   uniform mat4 projection;
+  uniform vec4 uvRect;
   void main()
   {
-     tex_coord = vec2(texc.s, 1.0 - texc.t);
+     // Coordenada do quad em [0,1] -> retângulo da imagem no atlas
+     tex_coord = uvRect.xy + vec2(texc.s, 1.0 - texc.t) * uvRect.zw;
      gl_Position = projection * model * vec4(position, 1.0);
   }
   )";
@@ -114,21 +255,152 @@
   #version 400
   in vec2 tex_coord;
   out vec4 color;
-  uniform sampler2D tex_buff;
-  uniform vec2 offsetTex;
+  uniform sampler2DArray atlas;
+  uniform float pagina;
   uniform vec3 colorTint;
  
   void main()
   {
-      vec4 texColor = texture(tex_buff, tex_coord + offsetTex);
+      vec4 texColor = texture(atlas, vec3(tex_coord, pagina));
       color = vec4(texColor.rgb * colorTint, texColor.a);
   }
   )";
+
+ // Shaders do mapa instanciado: a geometria do losango vem de gl_VertexID,
+ // a fórmula isométrica é calculada aqui e o retângulo no atlas sai da
+ // tabela uvTiles, indexada pelo tipo do tile de cada instância
+ const GLchar *vertexShaderInstSource = R"(
+  #version 400
+  layout (location = 0) in vec2 celula;
+  layout (location = 1) in float iTile;
+  layout (location = 2) in vec3 tint;
+  out vec2 tex_coord;
+  out vec3 tint_frag;
+  flat out float pagina;
+  uniform mat4 projection;
+  uniform vec2 origem;
+  uniform vec2 dimTile;
+  uniform vec4 uvTiles[8];
+  uniform float paginaTiles;
+
+  const vec2 losango[4] = vec2[4](vec2(0.0, 0.5), vec2(0.5, 1.0), vec2(0.5, 0.0), vec2(1.0, 0.5));
+
+  void main()
+  {
+     // Fórmula isométrica
+     vec2 pos = origem + vec2((celula.y - celula.x) * dimTile.x / 2.0,
+                              (celula.x + celula.y) * dimTile.y / 2.0);
+
+     vec2 vertice = losango[gl_VertexID] * dimTile;
+     vec2 texc = losango[gl_VertexID];
+     vec4 uvRect = uvTiles[int(iTile)];
+     pagina = paginaTiles;
+
+     tex_coord = uvRect.xy + vec2(texc.s, 1.0 - texc.t) * uvRect.zw;
+     tint_frag = tint;
+     gl_Position = projection * vec4(pos + vertice, 0.0, 1.0);
+  }
+  )";
+
+ const GLchar *fragmentShaderInstSource = R"(
+  #version 400
+  in vec2 tex_coord;
+  in vec3 tint_frag;
+  flat in float pagina;
+  out vec4 color;
+  uniform sampler2DArray atlas;
+
+  void main()
+  {
+      vec4 texColor = texture(atlas, vec3(tex_coord, pagina));
+      color = vec4(texColor.rgb * tint_frag, texColor.a);
+  }
+  )";
  
- int main()
+ // Shader das entidades: um quad por instância, centrado no canto do
+ // losango da célula mais o deslocamento do sprite, com o quadro da
+ // animação já recortado no atlas
+ const GLchar *vertexShaderEntSource = R"(
+  #version 400
+  layout (location = 0) in vec2 celula;
+  layout (location = 1) in vec2 dimensoes;
+  layout (location = 2) in vec2 deslocamento;
+  layout (location = 3) in vec4 uvRect;
+  layout (location = 4) in float paginaInst;
+  layout (location = 5) in vec3 tint;
+  out vec2 tex_coord;
+  out vec3 tint_frag;
+  flat out float pagina;
+  uniform mat4 projection;
+  uniform vec2 origem;
+  uniform vec2 dimTile;
+
+  const vec2 quad[4] = vec2[4](vec2(-0.5, 0.5), vec2(-0.5, -0.5), vec2(0.5, 0.5), vec2(0.5, -0.5));
+  const vec2 quadTex[4] = vec2[4](vec2(0.0, 0.0), vec2(0.0, 1.0), vec2(1.0, 0.0), vec2(1.0, 1.0));
+
+  void main()
+  {
+     vec2 pos = origem + vec2((celula.y - celula.x) * dimTile.x / 2.0,
+                              (celula.x + celula.y) * dimTile.y / 2.0) + deslocamento;
+
+     vec2 texc = quadTex[gl_VertexID];
+     tex_coord = uvRect.xy + vec2(texc.s, 1.0 - texc.t) * uvRect.zw;
+     tint_frag = tint;
+     pagina = paginaInst;
+     gl_Position = projection * vec4(pos + quad[gl_VertexID] * dimensoes, 0.0, 1.0);
+  }
+  )";
+
+ int main(int argc, char **argv)
  {
+     // Um argumento que não é opção troca o mapa (map.txt ou .tmapb gerado pelo mapc)
+     string arquivoMapa = "assets/maps/map.txt";
+     string arquivoPerfil; // --perfil=saida.csv ou saida.json
+     OpcoesHeadless headless; // --headless[=N] --golden=ref.png
+     double fpsMaximo = 0.0;  // --fps-max=N, 0 = sem limite
+     string arquivoGravacao, arquivoReplay;
+     bool replayRapido = false; // --rapido: um passo por frame, sem vsync
+     for (int i = 1; i < argc; i++)
+     {
+         if (headless.ler(argv[i]))
+             continue;
+         if (strncmp(argv[i], "--", 2) != 0)
+             arquivoMapa = argv[i];
+         if (strncmp(argv[i], "--perfil=", 9) == 0)
+             arquivoPerfil = argv[i] + 9;
+         if (strncmp(argv[i], "--fps-max=", 10) == 0)
+             fpsMaximo = atof(argv[i] + 10);
+         if (strncmp(argv[i], "--gravar=", 9) == 0)
+             arquivoGravacao = argv[i] + 9;
+         if (strncmp(argv[i], "--replay=", 9) == 0)
+             arquivoReplay = argv[i] + 9;
+         if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+             arquivoReplay = argv[++i];
+         if (strcmp(argv[i], "--rapido") == 0)
+             replayRapido = true;
+         if (strncmp(argv[i], "--log=", 6) == 0 && !Logger::padrao().setNivel(argv[i] + 6))
+         {
+             std::cerr << "Nivel de log desconhecido: " << argv[i] + 6 << " (use erro, aviso, info ou debug)" << std::endl;
+             return -1;
+         }
+         if (strncmp(argv[i], "--bench-", 8) == 0)
+         {
+             // Benchmarks sem janela (ProvaGB-Bench.cpp)
+             if (!executarBenchmarkLinhaComando(argv[i]))
+             {
+                 std::cerr << "Benchmark desconhecido: " << argv[i] << std::endl;
+                 return -1;
+             }
+             return 0;
+         }
+     }
+
      // Inicialização da GLFW
-     glfwInit();
+     if (!iniciarGlfw(headless))
+     {
+         std::cerr << "Falha ao inicializar a GLFW" << std::endl;
+         return -1;
+     }
      glfwWindowHint(GLFW_SAMPLES, 8);
  
      GLFWwindow *window = glfwCreateWindow(WIDTH, HEIGHT, "Jogo Isometrico - Colete todas as moedas!", nullptr, nullptr);
@@ -140,6 +412,7 @@
      }
      glfwMakeContextCurrent(window);
      glfwSetKeyCallback(window, key_callback);
+     glfwSetMouseButtonCallback(window, mouse_callback);
  
      if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
      {
@@ -149,68 +422,109 @@
  
      const GLubyte *renderer = glGetString(GL_RENDERER);
      const GLubyte *version = glGetString(GL_VERSION);
-     cout << "Renderer: " << renderer << endl;
-     cout << "OpenGL version supported " << version << endl;
+     escreverLog(LOG_INFO, "Renderer: %s", renderer);
+     escreverLog(LOG_INFO, "OpenGL version supported %s", version);
  
      int width, height;
      glfwGetFramebufferSize(window, &width, &height);
      glViewport(0, 0, width, height);
+
+     // Com --headless o desenho vai para um framebuffer próprio, lido de volta
+     // a cada frame no lugar do glfwSwapBuffers
+     CapturaHeadless captura;
+     if (headless.ativo)
+     {
+         string erroCaptura;
+         if (!captura.criar(width, height, erroCaptura))
+         {
+             std::cerr << erroCaptura << std::endl;
+             glfwTerminate();
+             return -1;
+         }
+         glfwSwapInterval(0);
+     }
  
-     GLuint shaderID = setupShader();
+     ShaderSprite shader;
+     ShaderMapa instShader;
+     ShaderEntidades entShader;
+     resolverUniforms(shader, setupShader(vertexShaderSource, fragmentShaderSource));
+     resolverUniforms(instShader, setupShader(vertexShaderInstSource, fragmentShaderInstSource));
+     resolverUniforms(entShader, setupShader(vertexShaderEntSource, fragmentShaderInstSource));
  
-     // Carregar mapa do arquivo
-     if (!carregarMapa("assets/maps/map.txt", mapa))
+     // Carregar mapa do arquivo, ou o mapa inicial gravado no replay
+     reproduzindo = !arquivoReplay.empty();
+     if (reproduzindo)
+     {
+         string erroReplay;
+         if (!replay.carregar(arquivoReplay, mapa, erroReplay))
+         {
+             std::cerr << erroReplay << std::endl;
+             return -1;
+         }
+         escreverLog(LOG_INFO, "Replay de %s: %u passos, %zu eventos", arquivoReplay.c_str(),
+                     replay.getEstadoFinal().passos, replay.getNumEventos());
+     }
+     else if (!carregarMapa(arquivoMapa, mapa))
      {
          std::cerr << "Erro ao carregar o mapa!" << std::endl;
          return -1;
      }
- 
+     gravando = !arquivoGravacao.empty();
+     if (gravando)
+         gravacao.iniciar(mapa);
+ 
+     // Todas as imagens do jogo num atlas só: o mapa e o personagem são
+     // desenhados sem trocar de textura. A coin.png tem 4724x4724 e aparece
+     // com 32x32, então entra reduzida
+     TextureAtlas atlas;
+     string erroAtlas;
+     bool atlasOk = atlas.adicionarImagem("tileset", mapa.tilesetPath, erroAtlas) &&
+                    atlas.adicionarImagem("moeda", "assets/sprites/coin.png", erroAtlas, 64, 64) &&
+                    atlas.adicionarImagem("personagem", "assets/sprites/Vampires1_Walk_full.png", erroAtlas) &&
+                    atlas.construir(erroAtlas);
+     if (!atlasOk)
+     {
+         std::cerr << erroAtlas << std::endl;
+         return -1;
+     }
+     escreverLog(LOG_INFO, "Atlas: %d imagens em %d pagina(s) de %dx%d", atlas.getNumImagens(), atlas.getNumPaginas(),
+                 atlas.getLarguraPagina(), atlas.getAlturaPagina());
+     // A textura do atlas passa a ser apagada pelo cache, no fim
+     recursos.adotar(RECURSO_TEXTURA, atlas.getTexID(), atlas.getMemoryBytes());
+
      // Configurar tileset com apenas 2 tipos: terra(0) e lava(1)
-     int imgWidth, imgHeight;
-     GLuint texID = loadTexture(mapa.tilesetPath, imgWidth, imgHeight);
- 
-     int tileIndices[3] = {2, 3, 6}; // Terra, Lava, Rosa
+     int tileIndices[3] = {2, 3, 6}; // Terra, Lava, Rosa (colunas no tileset de 7 tiles)
      for (int i = 0; i < 3; i++)
      {
          Tile tile;
          tile.dimensions = vec3(mapa.tileWidth, mapa.tileHeight, 1.0);
-         tile.iTile = tileIndices[i];
-         tile.texID = texID;
-         tile.VAO = setupTile(7, tile.ds, tile.dt); // Apenas 2 tiles
-         
-  
-         if (i == 0) { // Terra
-            tile.caminhavel = true;
-            tile.letal = false;
-        } else if (i == 1) { // Lava
-            tile.caminhavel = true;
-            tile.letal = true;
-        } else if (i == 2) { // Rosa
-            tile.caminhavel = true;
-            tile.letal = false;
-        }
+         tile.regiao = atlas.buscar("tileset")->celula(tileIndices[i], 0, 7, 1);
+         tile.geometria = setupTile(); // o mesmo losango para os três
+         tile.VAO = recursos.getVAO(tile.geometria);
+         regrasTile(i, tile);
  
          tileset.push_back(tile);
      }
+     montarCustosCaminho();
+     navegacao.construir(mapa.grade, custosCaminho);
+     campoMoedas.calcular(mapa.grade, custosCaminho);
  
      // Configurar moeda (coin.png)
-     GLuint moedaTexID = loadTexture("assets/sprites/coin.png", imgWidth, imgHeight);
-     moeda.VAO = setupCoin(moeda.ds, moeda.dt);
+     moeda.regiao = *atlas.buscar("moeda");
      moeda.position = vec3(0, 0, 0);
      moeda.dimensions = vec3(32, 32, 1.0);
-     moeda.texID = moedaTexID;
      moeda.iAnimation = 0;
      moeda.iFrame = 0;
+     moeda.nAnimations = 1;
+     moeda.nFrames = 1;
  
      // Configurar personagem animado
-     GLuint personagemTexID = loadTexture("assets/sprites/Vampires1_Walk_full.png", imgWidth, imgHeight);
      personagem.nAnimations = 4;
      personagem.nFrames = 6;
-     personagem.VAO = setupSprite(personagem.nAnimations, personagem.nFrames, personagem.ds, personagem.dt);
-     personagem.position = vec3(0, 0, 0);
-     personagem.dimensions = vec3(imgWidth/personagem.nFrames*2, imgHeight/personagem.nAnimations*2, 1.0);
-     personagem.texID = personagemTexID;
-     personagem.iAnimation = 1;
+     personagem.regiao = *atlas.buscar("personagem");
+     personagem.position = vec3(tileset[0].dimensions.x / 2.0f, 0, 0); // no meio do losango
+     personagem.dimensions = vec3(personagem.regiao.largura/personagem.nFrames*2, personagem.regiao.altura/personagem.nAnimations*2, 1.0);
+     personagem.iAnimation = 0; // linha de cima da spritesheet
      personagem.iFrame = 0;
  
      // Encontrar posição inicial segura (apenas em terra)
@@ -220,7 +534,7 @@
      bool posicaoValida = false;
      for (int tentativas = 0; tentativas < 100 && !posicaoValida; tentativas++)
      {
-         int tileType = mapa.tiles[(int)pos.x][(int)pos.y];
+         int tileType = mapa.grade.getTile((int)pos.x, (int)pos.y);
          if (tileType == 0) // Apenas terra é segura
          {
              posicaoValida = true;
@@ -232,39 +546,81 @@
          }
      }
      
-     cout << "Posicao inicial do personagem: (" << pos.x << ", " << pos.y << ")" << endl;
+     posAnterior = pos;
+     escreverLog(LOG_INFO, "Posicao inicial do personagem: (%g, %g)", pos.x, pos.y);
  
-     // Contar moedas totais
-     for (int i = 0; i < mapa.mapHeight; i++)
-     {
-         for (int j = 0; j < mapa.mapWidth; j++)
-         {
-             if (mapa.items[i][j] == 1) // moeda
-                 moedasTotal++;
-         }
-     }
+     // Uma entidade por moeda, mais o personagem
+     moedasTotal = criarEntidades();
  
-     cout << "Total de moedas no mapa: " << moedasTotal << endl;
+     escreverLog(LOG_INFO, "Total de moedas no mapa: %d", moedasTotal);
  
-     glUseProgram(shaderID);
+     shader.programa.usar();
  
      double prev_s = glfwGetTime();
      double title_countdown_s = 0.1;
+     long chamadasEvitadas = 0; // chamadas GL poupadas pelo ShaderProgram no último frame
  
-     glActiveTexture(GL_TEXTURE0);
-     glUniform1i(glGetUniformLocation(shaderID, "tex_buff"), 0);
- 
-     mat4 projection = ortho(0.0, (double)WIDTH, (double)HEIGHT, 0.0, -1.0, 1.0);
-     glUniformMatrix4fv(glGetUniformLocation(shaderID, "projection"), 1, GL_FALSE, value_ptr(projection));
+     // O atlas fica ligado na unidade 0 o tempo todo
+     atlas.bind(0);
+     shader.programa.setInt(shader.atlas, 0);
  
+
      glEnable(GL_DEPTH_TEST);
      glDepthFunc(GL_ALWAYS);
      glEnable(GL_BLEND);
      glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+     setupMapaInstanciado(instShader);
+     setupEntidades(entShader);
+     atualizarCamera(pos);
+     aplicarProjecao(shader, instShader, entShader);
+     relatarRecursos("na carga");
+
+     for (int i = 1; i < argc; i++)
+     {
+         if (strcmp(argv[i], "--bench") == 0)
+         {
+             executarBenchmark(window, shader, instShader, entShader);
+             liberarRecursos();
+             glfwTerminate();
+             return 0;
+         }
+     }
  
+     // Fases do frame medidas com --perfil
+     Profiler perfil;
+     if (!arquivoPerfil.empty())
+         perfil.ativar();
+     int escEntrada = perfil.registrar("entrada");
+     int escLogica = perfil.registrar("logica");
+     int escMapa = perfil.registrar("mapa");
+     int escEntidades = perfil.registrar("entidades");
+     int escSwap = perfil.registrar("swap");
+
+     PassoFixo passo(HZ_LOGICA);
+     LimitadorFrames limitador(headless.ativo ? 0.0 : fpsMaximo);
+
+     // No replay rápido o relógio da lógica anda um passo por frame
+     bool relogioFixo = reproduzindo && replayRapido;
+     if (relogioFixo)
+         glfwSwapInterval(0);
+     long frames = 0;
+     double msSimulacao = 0.0;
+     chrono::steady_clock::time_point inicioLaco = chrono::steady_clock::now();
+
      // Game loop
      while (!glfwWindowShouldClose(window))
      {
+         if (reproduzindo && passoLogica >= (long)replay.getEstadoFinal().passos)
+             break;
+         if (headless.ativo)
+         {
+             if (captura.getCapturados() >= headless.frames)
+                 break;
+             captura.iniciarFrame(captura.getCapturados());
+         }
+         perfil.iniciarFrame();
+
          // FPS calculation
          {
              double curr_s = glfwGetTime();
@@ -276,173 +632,574 @@
              {
                  double fps = 1.0 / elapsed_s;
                  char tmp[512];
-                 sprintf(tmp, "Jogo Isometrico - Moedas: %d/%d - FPS %.2lf %s", 
-                         moedasColetadas, moedasTotal, fps,
+                 sprintf(tmp, "Jogo Isometrico - Moedas: %d/%d - FPS %.2lf - GL evitadas/frame %ld %s", 
+                         moedasColetadas, moedasTotal, fps, chamadasEvitadas,
                          jogoGanho ? "- VOCE GANHOU!" : (jogoPerdido ? "- GAME OVER!" : ""));
                  glfwSetWindowTitle(window, tmp);
                  title_countdown_s = 0.1;
+
+                 // O log sai no máximo 10 vezes por segundo, fora do tratamento da entrada
+                 Logger::padrao().descarregar();
              }
          }
  
+         perfil.iniciar(escEntrada);
          glfwPollEvents();
+         perfil.terminar(escEntrada);
  
          glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
          glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
  
-         if (!jogoGanho && !jogoPerdido)
+         // Zero, um ou vários passos, conforme o tempo desde o último frame
+         perfil.iniciar(escLogica);
+         chrono::steady_clock::time_point inicioLogica = chrono::steady_clock::now();
+         int nPassos = passo.avancar(relogioFixo ? frames / HZ_LOGICA : glfwGetTime());
+         for (int k = 0; k < nPassos; k++)
          {
-             processarColisoes();
+             if (reproduzindo && passoLogica >= (long)replay.getEstadoFinal().passos)
+                 break;
+             atualizarJogo();
          }
- 
-         desenharMapa(shaderID);
-         desenharPersonagem(shaderID);
- 
-         glfwSwapBuffers(window);
+         msSimulacao += chrono::duration<double, milli>(chrono::steady_clock::now() - inicioLogica).count();
+         perfil.terminar(escLogica);
+
+         vec2 posDesenho = mix(posAnterior, pos, passo.alfa());
+         vec2 cameraAnterior = camera.posicao;
+         atualizarCamera(posDesenho);
+         if (camera.posicao != cameraAnterior)
+             aplicarProjecao(shader, instShader, entShader);
+ 
+         perfil.iniciar(escMapa);
+         if (renderInstanciado)
+         {
+             desenharMapaInstanciado(instShader);
+             shader.programa.usar();
+         }
+         else
+         {
+             desenharMapa(shader);
+         }
+         perfil.terminar(escMapa);
+
+         perfil.iniciar(escEntidades);
+         desenharEntidades(entShader, passo.alfa());
+         shader.programa.usar();
+         perfil.terminar(escEntidades);
+ 
+         perfil.iniciar(escSwap);
+         if (headless.ativo)
+             captura.capturar();
+         else
+             glfwSwapBuffers(window);
+         perfil.terminar(escSwap);
+         limitador.esperar();
+
+         chamadasEvitadas = ShaderProgram::getContadores().evitadas();
+         ShaderProgram::zerarContadores();
+         perfil.terminarFrame();
+         frames++;
+     }
+     escreverLog(filaEntrada.getPerdidos() > 0 ? LOG_AVISO : LOG_INFO, "Eventos de entrada perdidos com a fila cheia: %ld",
+                 filaEntrada.getPerdidos());
+     Logger::padrao().descarregar();
+     double msLaco = chrono::duration<double, milli>(chrono::steady_clock::now() - inicioLaco).count();
+
+     int resultado = 0;
+     if (gravando)
+     {
+         string erroGravacao;
+         if (gravacao.salvar(arquivoGravacao, estadoAtual(), erroGravacao))
+             printf("Gravacao salva em %s: %ld passos, %zu eventos\n", arquivoGravacao.c_str(), passoLogica, gravacao.getNumEventos());
+         else
+             std::cerr << erroGravacao << std::endl;
+     }
+     if (reproduzindo)
+     {
+         const EstadoReplay &esperado = replay.getEstadoFinal();
+         EstadoReplay obtido = estadoAtual();
+         printf("Replay: %ld passos em %ld frames\n", passoLogica, frames);
+         printf("  simulacao %10.3f ms (%.3f us/passo)\n", msSimulacao, passoLogica > 0 ? msSimulacao * 1000.0 / passoLogica : 0.0);
+         printf("  desenho   %10.3f ms (%.3f ms/frame)\n", msLaco - msSimulacao, frames > 0 ? (msLaco - msSimulacao) / frames : 0.0);
+         printf("  total     %10.3f ms\n", msLaco);
+         if (obtido == esperado)
+         {
+             printf("Estado final confere: %u moedas, %s\n", obtido.moedasColetadas,
+                    obtido.ganhou ? "vitoria" : (obtido.perdeu ? "derrota" : "em jogo"));
+         }
+         else
+         {
+             fprintf(stderr, "Estado final diferente da gravacao%s:\n", obtido.passos < esperado.passos ? " (replay interrompido)" : "");
+             fprintf(stderr, "  gravado: passo %u, %u moedas, ganhou %d, perdeu %d, posicao (%d, %d), mapa %016llx\n",
+                     esperado.passos, esperado.moedasColetadas, esperado.ganhou, esperado.perdeu,
+                     esperado.linha, esperado.coluna, (unsigned long long)esperado.hashMapa);
+             fprintf(stderr, "  obtido:  passo %u, %u moedas, ganhou %d, perdeu %d, posicao (%d, %d), mapa %016llx\n",
+                     obtido.passos, obtido.moedasColetadas, obtido.ganhou, obtido.perdeu,
+                     obtido.linha, obtido.coluna, (unsigned long long)obtido.hashMapa);
+             resultado = 1;
+         }
+     }
+
+     if (perfil.estaAtivo())
+     {
+         perfil.finalizar();
+         perfil.imprimirResumo(cout);
+         string erroPerfil;
+         if (perfil.salvar(arquivoPerfil, erroPerfil))
+             cout << "Perfil salvo em " << arquivoPerfil << endl;
+         else
+             std::cerr << erroPerfil << std::endl;
+         perfil.liberar();
+     }
+
+     if (headless.ativo)
+     {
+         double msFrame = captura.finalizar();
+         printf("Headless: %ld frames, %.3f ms/frame (com a leitura do framebuffer)\n", captura.getCapturados(), msFrame);
+         string erroGolden;
+         if (!captura.compararGolden(headless, cout, erroGolden))
+         {
+             std::cerr << erroGolden << std::endl;
+             resultado = 1;
+         }
+         captura.liberar();
      }
  
+     liberarRecursos();
      glfwTerminate();
-     return 0;
+     return resultado;
  }
  
+ // Só enfileira: o estado do jogo muda no passo de lógica (atualizarJogo)
  void key_callback(GLFWwindow *window, int key, int scancode, int action, int mode)
  {
      if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
          glfwSetWindowShouldClose(window, GL_TRUE);
- 
+
+     // No replay a entrada vem só da gravação
+     if (reproduzindo)
+         return;
+
+     EventoTecla evento = {key, action, mode, 0, 0};
+     filaEntrada.inserir(evento);
+ }
+
+ // Clique com o botão esquerdo: converte o cursor para a casa do mapa sob
+ // ele (inverso da fórmula isométrica, a partir do centro do losango) e
+ // enfileira como um evento, como as teclas
+ void mouse_callback(GLFWwindow *window, int button, int action, int mods)
+ {
+     if (button != GLFW_MOUSE_BUTTON_LEFT || action != GLFW_PRESS || reproduzindo)
+         return;
+
+     double cx, cy;
+     int larguraJanela, alturaJanela;
+     glfwGetCursorPos(window, &cx, &cy);
+     glfwGetWindowSize(window, &larguraJanela, &alturaJanela);
+     if (larguraJanela <= 0 || alturaJanela <= 0)
+         return;
+     vec2 mundo = camera.posicao + vec2((float)cx / larguraJanela, (float)cy / alturaJanela) * camera.tamanho;
+
+     float tw = tileset[0].dimensions.x;
+     float th = tileset[0].dimensions.y;
+     float u = (mundo.x - WIDTH / 2.0f - tw / 2.0f) / (tw / 2.0f);
+     float v = (mundo.y - 150.0f - th / 2.0f) / (th / 2.0f);
+     int linha = (int)floor((v - u) / 2.0f + 0.5f);
+     int coluna = (int)floor((u + v) / 2.0f + 0.5f);
+     if (linha < 0 || coluna < 0 || linha >= mapa.mapHeight || coluna >= mapa.mapWidth)
+         return;
+
+     EventoTecla evento = {TECLA_CLIQUE, action, mods, linha, coluna};
+     filaEntrada.inserir(evento);
+ }
+
+ // Aplica uma tecla de movimento; chamada pela lógica, em atualizarJogo()
+ // As teclas que moverPersonagem() trata: W/A/S/D e as diagonais Q/E/Z/X
+ bool teclaMovimento(int key)
+ {
+     switch (key)
+     {
+         case GLFW_KEY_W: case GLFW_KEY_A: case GLFW_KEY_S: case GLFW_KEY_D:
+         case GLFW_KEY_Q: case GLFW_KEY_E: case GLFW_KEY_Z: case GLFW_KEY_X:
+             return true;
+     }
+     return false;
+ }
+
+ void moverPersonagem(int key)
+ {
      if (jogoGanho || jogoPerdido) return;
  
      vec2 novaPos = pos;
  
-     if (action == GLFW_PRESS)
+     switch(key)
+     {
+         case GLFW_KEY_W: // NORTE
+             if (pos.x > 0)
+             {
+                 novaPos.x--;
+             }
+             break;
+         case GLFW_KEY_A: // OESTE
+             if (pos.y > 0)
+             {
+                 novaPos.y--;
+             }
+             break;
+         case GLFW_KEY_S: // SUL
+             if (pos.x < mapa.mapHeight - 1)
+             {
+                 novaPos.x++;
+             }
+             break;
+         case GLFW_KEY_D: // LESTE
+             if (pos.y < mapa.mapWidth - 1)
+             {
+                 novaPos.y++;
+             }
+             break;
+         case GLFW_KEY_Q: // NOROESTE
+             if (pos.x > 0 && pos.y > 0)
+             {
+                 novaPos.x--;
+                 novaPos.y--;
+             }
+             break;
+         case GLFW_KEY_E: // NORDESTE
+             if (pos.x > 0 && pos.y < mapa.mapWidth - 1)
+             {
+                 novaPos.x--;
+                 novaPos.y++;
+             }
+             break;
+         case GLFW_KEY_Z: // SUDOESTE
+             if (pos.x < mapa.mapHeight - 1 && pos.y > 0)
+             {
+                 novaPos.x++;
+                 novaPos.y--;
+             }
+             break;
+         case GLFW_KEY_X: // SUDESTE
+             if (pos.x < mapa.mapHeight - 1 && pos.y < mapa.mapWidth - 1)
+             {
+                 novaPos.x++;
+                 novaPos.y++;
+             }
+             break;
+     }
+ 
+     // Verificar se pode mover - simplificado para apenas 2 tipos de tile
+     if (novaPos.x >= 0 && novaPos.x < mapa.mapHeight && 
+         novaPos.y >= 0 && novaPos.y < mapa.mapWidth)
+     {
+         int tileType = mapa.grade.getTile((int)novaPos.x, (int)novaPos.y);
+         
+         // Garantir que apenas tiles 0 e 1 são válidos
+         if (tileType == 0 || tileType == 1 || tileType == 2) {
+            pos = novaPos;
+        
+            // Se pisar no rosa (tileType == 2), transforme em terra (0)
+            if (tileType == 2) {
+                mapa.grade.setTile((int)novaPos.x, (int)novaPos.y, 0);
+                marcarCelulaAlterada((int)novaPos.x, (int)novaPos.y);
+                navegacao.marcarAlterada((int)novaPos.x, (int)novaPos.y);
+                escreverLog(LOG_INFO, "PISOU NO TILE ROSA! Ele virou terra.");
+            }
+        } else {
+            escreverLog(LOG_DEBUG, "Movimento bloqueado - tile inválido: %d", tileType);
+        }
+     }
+     else
+     {
+         escreverLog(LOG_DEBUG, "Movimento bloqueado - fora dos limites");
+     }
+
+     int k = entidades.indice(jogador);
+     if (k >= 0)
+     {
+         entidades.getLinhas()[k] = pos.x;
+         entidades.getColunas()[k] = pos.y;
+         gradeEntidades.mover(jogador, pos.x, pos.y);
+     }
+
+     escreverLog(LOG_DEBUG, "Posicao do personagem: (%g, %g)", pos.x, pos.y);
+     escreverLog(LOG_DEBUG, "Tile na posicao: %d", (int)mapa.grade.getTile((int)pos.x, (int)pos.y));
+ }
+
+ // Um passo de lógica: as teclas pressionadas desde o passo anterior, com a
+ // colisão de cada casa pisada, e as animações, que contam passos
+ void atualizarJogo()
+ {
+     posAnterior = pos;
+     entidades.guardarPosicoes();
+     if (reproduzindo)
+         replay.entregar(passoLogica, filaEntrada);
+
+     long perdidos = filaEntrada.getPerdidos();
+     if (perdidos != perdidosAvisados)
+     {
+         escreverLog(LOG_AVISO, "Fila de entrada cheia: %ld eventos perdidos (total %ld)%s", perdidos - perdidosAvisados,
+                     perdidos, gravando ? ", que nao vao para a gravacao" : "");
+         perdidosAvisados = perdidos;
+     }
+
+     EventoTecla evento;
+     while (filaEntrada.retirar(evento))
      {
-         switch(key)
+         if (gravando)
+             gravacao.registrar(passoLogica, evento);
+         if (evento.acao != GLFW_PRESS)
+             continue;
+         if (evento.tecla == GLFW_KEY_I)
          {
-             case GLFW_KEY_W: // NORTE
-                 if (pos.x > 0)
-                 {
-                     novaPos.x--;
-                 }
-                 break;
-             case GLFW_KEY_A: // OESTE
-                 if (pos.y > 0)
-                 {
-                     novaPos.y--;
-                 }
-                 break;
-             case GLFW_KEY_S: // SUL
-                 if (pos.x < mapa.mapHeight - 1)
-                 {
-                     novaPos.x++;
-                 }
-                 break;
-             case GLFW_KEY_D: // LESTE
-                 if (pos.y < mapa.mapWidth - 1)
-                 {
-                     novaPos.y++;
-                 }
-                 break;
-             case GLFW_KEY_Q: // NOROESTE
-                 if (pos.x > 0 && pos.y > 0)
-                 {
-                     novaPos.x--;
-                     novaPos.y--;
-                 }
-                 break;
-             case GLFW_KEY_E: // NORDESTE
-                 if (pos.x > 0 && pos.y < mapa.mapWidth - 1)
-                 {
-                     novaPos.x--;
-                     novaPos.y++;
-                 }
-                 break;
-             case GLFW_KEY_Z: // SUDOESTE
-                 if (pos.x < mapa.mapHeight - 1 && pos.y > 0)
-                 {
-                     novaPos.x++;
-                     novaPos.y--;
-                 }
-                 break;
-             case GLFW_KEY_X: // SUDESTE
-                 if (pos.x < mapa.mapHeight - 1 && pos.y < mapa.mapWidth - 1)
-                 {
-                     novaPos.x++;
-                     novaPos.y++;
-                 }
-                 break;
+             renderInstanciado = !renderInstanciado;
+             escreverLog(LOG_INFO, "Renderizacao do mapa: %s", renderInstanciado ? "instanciada" : "por tile");
+             continue;
          }
- 
-         // Verificar se pode mover - simplificado para apenas 2 tipos de tile
-         if (novaPos.x >= 0 && novaPos.x < mapa.mapHeight && 
-             novaPos.y >= 0 && novaPos.y < mapa.mapWidth)
+         if (evento.tecla == TECLA_CLIQUE)
          {
-             int tileType = mapa.tiles[(int)novaPos.x][(int)novaPos.y];
-             
-             // Garantir que apenas tiles 0 e 1 são válidos
-             if (tileType == 0 || tileType == 1 || tileType == 2) {
-                pos = novaPos;
-            
-                // Se pisar no rosa (tileType == 2), transforme em terra (0)
-                if (tileType == 2) {
-                    mapa.tiles[(int)novaPos.x][(int)novaPos.y] = 0;
-                    cout << "PISOU NO TILE ROSA! Ele virou terra." << endl;
-                }
-            } else {
-                cout << "Movimento bloqueado - tile inválido: " << tileType << endl;
-            }
+             seguindoCampo = false;
+             iniciarCaminho(evento.linha, evento.coluna);
+             continue;
          }
-         else
+         if (evento.tecla == GLFW_KEY_C)
          {
-             cout << "Movimento bloqueado - fora dos limites" << endl;
+             caminhoAtual.clear();
+             seguindoCampo = true;
+             continue;
          }
+         // Andar pelo teclado cancela o clique e o campo; as outras teclas
+         // (Esc, Shift, letras sem função) não mexem em nada
+         if (!teclaMovimento(evento.tecla))
+             continue;
+         caminhoAtual.clear();
+         seguindoCampo = false;
+         moverPersonagem(evento.tecla);
+         if (!jogoGanho && !jogoPerdido)
+             processarColisoes();
      }
+     if (!caminhoAtual.empty() && passoLogica % PASSOS_POR_CASA == 0)
+         seguirCaminho();
+     else if (seguindoCampo && passoLogica % PASSOS_POR_CASA == 0)
+         seguirCampo();
+     if (!jogoGanho && !jogoPerdido)
+         processarColisoes();
 
-     cout << "Posicao do personagem: (" << pos.x << ", " << pos.y << ")" << endl;
-cout << "Tile na posicao: " << mapa.tiles[(int)pos.x][(int)pos.y] << endl;
+     passoLogica++;
+     entidades.animar(passoLogica, FPS, HZ_LOGICA);
  }
  
- void processarColisoes()
+ // Terra (0), lava (1) e rosa (2): a lava é letal, os três custam o mesmo
+ void regrasTile(int tipo, Tile &tile)
  {
-     int x = (int)pos.x;
-     int y = (int)pos.y;
- 
-     // Verificar se coletou moeda
-     if (mapa.items[x][y] == 1) // Moeda
+     tile.caminhavel = true;
+     tile.letal = tipo == 1;
+     tile.custo = 1.0f;
+ }
+
+ // Custos da busca de caminho a partir da tabela de tiles: tiles letais ou
+ // não caminháveis, e valores que não são tile nenhum, são intransponíveis
+ void montarCustosCaminho()
+ {
+     for (int t = 0; t < 256; t++)
+         custosCaminho[t] = -1.0f;
+
+     float custoPassavel = -1.0f;
+     custosUniformes = true;
+     for (size_t t = 0; t < tileset.size(); t++)
      {
-         mapa.items[x][y] = 0; // Remove a moeda
-         moedasColetadas++;
-         cout << "Moeda coletada! Total: " << moedasColetadas << "/" << moedasTotal << endl;
-         
-         if (moedasColetadas >= moedasTotal)
-         {
-             jogoGanho = true;
-             cout << "PARABENS! Voce coletou todas as moedas!" << endl;
-         }
+         if (!tileset[t].caminhavel || tileset[t].letal)
+             continue;
+         custosCaminho[t] = tileset[t].custo;
+         if (custoPassavel >= 0.0f && tileset[t].custo != custoPassavel)
+             custosUniformes = false;
+         custoPassavel = tileset[t].custo;
      }
- 
-     // Verificar se pisou em lava
-     int tileType = mapa.tiles[x][y];
-     if (tileType == 1) // Lava
+ }
+
+ // A tabela de montarCustosCaminho() para os mapas gerados dos benchmarks,
+ // que não carregam o tileset. Com lavaCara a lava passa a ser transponível,
+ // só mais cara
+ void montarCustosBenchmark(float custos[256], bool lavaCara)
+ {
+     const float CUSTO_LAVA = 10.0f;
+     for (int t = 0; t < 256; t++)
+         custos[t] = -1.0f;
+     for (int t = 0; t < 3; t++)
      {
-         jogoPerdido = true;
-         cout << "GAME OVER! Voce pisou na lava!" << endl;
+         Tile tile;
+         regrasTile(t, tile);
+         if (tile.caminhavel && !tile.letal)
+             custos[t] = tile.custo;
+         else if (tile.caminhavel && lavaCara)
+             custos[t] = CUSTO_LAVA;
      }
  }
- 
- void desenharMapa(GLuint shaderID)
+
+ void iniciarCaminho(int linha, int coluna)
  {
-     float x0 = WIDTH / 2.0f;
-     float y0 = 150.0f;
- 
-     glUniform3f(glGetUniformLocation(shaderID, "colorTint"), 1.0f, 1.0f, 1.0f);
- 
-     for (int i = 0; i < mapa.mapHeight; i++)
+     if (jogoGanho || jogoPerdido)
+         return;
+
+     // Longe, o grafo de clusters responde sem varrer as casas do meio
+     PontoGrade origem = {(int)pos.x, (int)pos.y};
+     PontoGrade destino = {linha, coluna};
+     bool longe = std::max(abs(linha - origem.linha), abs(coluna - origem.coluna)) > DISTANCIA_HPA;
+     bool achou;
+     if (longe)
+         achou = navegacao.buscar(origem, destino, caminhoAtual);
+     else if (custosUniformes)
+         achou = pathfinder.buscarJPS(mapa.grade, custosCaminho, origem, destino, caminhoAtual);
+     else
+         achou = pathfinder.buscarAEstrela(mapa.grade, custosCaminho, origem, destino, caminhoAtual);
+     proximaCasa = 1;
+     if (achou)
+         escreverLog(LOG_DEBUG, "Caminho ate (%d, %d): %zu casas, %ld nos expandidos%s", linha, coluna,
+                     caminhoAtual.size() - 1,
+                     longe ? navegacao.getEstatisticas().nosExpandidos : pathfinder.getEstatisticas().nosExpandidos,
+                     longe ? " (HPA*)" : "");
+     else
+         escreverLog(LOG_INFO, "Sem caminho seguro ate (%d, %d)", linha, coluna);
+ }
+
+ // Anda uma casa do caminho, pela mesma regra das teclas
+ void seguirCaminho()
+ {
+     if (proximaCasa >= caminhoAtual.size())
      {
-         for (int j = 0; j < mapa.mapWidth; j++)
+         caminhoAtual.clear();
+         return;
+     }
+
+     if (!andarAte(caminhoAtual[proximaCasa]))
+     {
+         caminhoAtual.clear();
+         return;
+     }
+     proximaCasa++;
+ }
+
+ // Anda uma casa rumo à moeda mais próxima; para numa moeda ou quando
+ // nenhuma é alcançável sem passar por lava
+ void seguirCampo()
+ {
+     PontoGrade atual = {(int)pos.x, (int)pos.y}, proxima;
+     if (jogoGanho || jogoPerdido || !campoMoedas.proximaCasa(atual, proxima) || !andarAte(proxima))
+         seguindoCampo = false;
+ }
+
+ // Anda até a casa vizinha pela mesma regra das teclas; false se ela não é
+ // vizinha
+ bool andarAte(PontoGrade casa)
+ {
+     // W/S mudam a linha, A/D a coluna, Q/E/Z/X as duas
+     const int teclas[3][3] = {{GLFW_KEY_Q, GLFW_KEY_W, GLFW_KEY_E},
+                               {GLFW_KEY_A, 0, GLFW_KEY_D},
+                               {GLFW_KEY_Z, GLFW_KEY_S, GLFW_KEY_X}};
+     int dl = casa.linha - (int)pos.x, dc = casa.coluna - (int)pos.y;
+     if (abs(dl) > 1 || abs(dc) > 1 || (dl == 0 && dc == 0))
+         return false;
+     moverPersonagem(teclas[dl + 1][dc + 1]);
+     return true;
+ }
+
+ // O que o replay compara com a gravação
+ EstadoReplay estadoAtual()
+ {
+     EstadoReplay estado;
+     memset(&estado, 0, sizeof(estado));
+     estado.passos = (uint32_t)passoLogica;
+     estado.moedasColetadas = (uint32_t)moedasColetadas;
+     estado.ganhou = jogoGanho;
+     estado.perdeu = jogoPerdido;
+     estado.linha = (int32_t)pos.x;
+     estado.coluna = (int32_t)pos.y;
+     estado.hashMapa = hashMapa(mapa.grade);
+     return estado;
+ }
+
+ // Colisão das entidades que andam pelo mapa (por enquanto só o personagem)
+ // com as moedas e a lava. As moedas ao alcance de cada uma saem da
+ // gradeEntidades, sem percorrer as outras entidades
+ void processarColisoes()
+ {
+     static vector<Entidade> vizinhas, coletadas;
+     coletadas.clear();
+
+     int kJogador = entidades.indice(jogador);
+     uint8_t *flags = entidades.getFlags();
+     const float *linhas = entidades.getLinhas();
+     const float *colunas = entidades.getColunas();
+     for (size_t k = 0; k < entidades.tamanho(); k++)
+     {
+         if (!(flags[k] & ENTIDADE_ATOR))
+             continue;
+
+         // Verificar se coletou moeda: as que estão na mesma casa
+         vizinhas.clear();
+         gradeEntidades.consultarRaio(linhas[k], colunas[k], 0.5f, vizinhas);
+         for (size_t v = 0; v < vizinhas.size(); v++)
+         {
+             int m = entidades.indice(vizinhas[v]);
+             if (m < 0 || !(flags[m] & ENTIDADE_MOEDA))
+                 continue;
+             flags[m] &= ~ENTIDADE_MOEDA; // outro ator não a coleta de novo
+             coletadas.push_back(vizinhas[v]);
+
+             int x = (int)linhas[m];
+             int y = (int)colunas[m];
+             mapa.grade.setItem(x, y, ITEM_VAZIO); // Remove a moeda
+             campoMoedas.removerMoeda(x, y);
+             moedasColetadas++;
+             escreverLog(LOG_INFO, "Moeda coletada! Total: %d/%d", moedasColetadas, moedasTotal);
+
+             if (moedasColetadas >= moedasTotal)
+             {
+                 jogoGanho = true;
+                 escreverLog(LOG_INFO, "PARABENS! Voce coletou todas as moedas!");
+             }
+         }
+
+         // Verificar se pisou em lava
+         int tileType = mapa.grade.getTile((int)linhas[k], (int)colunas[k]);
+         if (tileType == 1 && (int)k == kJogador) // Lava
          {
-             int tileIndex = mapa.tiles[i][j];
+             jogoPerdido = true;
+             escreverLog(LOG_INFO, "GAME OVER! Voce pisou na lava!");
+         }
+     }
+
+     // Fora do laço: remover troca a ordem dos vetores
+     for (size_t c = 0; c < coletadas.size(); c++)
+     {
+         gradeEntidades.remover(coletadas[c]);
+         entidades.remover(coletadas[c]);
+     }
+ }
+
+ void desenharMapa(ShaderSprite &shader)
+ {
+     float x0 = WIDTH / 2.0f;
+     float y0 = 150.0f;
+ 
+     shader.programa.setVec3(shader.colorTint, 1.0f, 1.0f, 1.0f);
+
+     int iIni, iFim;
+     if (!linhasVisiveis(iIni, iFim))
+         return;
+
+     for (int i = iIni; i <= iFim; i++)
+     {
+         int jIni, jFim;
+         if (!colunasVisiveis(i, jIni, jFim))
+             continue;
+
+         const CelulaMapa *linha = mapa.grade.getLinha(i);
+         for (int j = jIni; j <= jFim; j++)
+         {
+             int tileIndex = linha[j].tile;
              
-             // Garantir que só usamos tiles válidos (0=terra, 1=lava)
-             if (tileIndex < 0 || tileIndex > 2) {
+             // Garantir que só usamos tiles válidos (0=terra, 1=lava, 2=rosa)
+             if (tileIndex > 2) {
                  tileIndex = 0; // Default para terra se inválido
              }
              
@@ -455,90 +1212,560 @@ cout << "Tile na posicao: " << mapa.tiles[(int)pos.x][(int)pos.y] << endl;
              mat4 model = mat4(1);
              model = translate(model, vec3(x, y, 0.0));
              model = scale(model, curr_tile.dimensions);
-             glUniformMatrix4fv(glGetUniformLocation(shaderID, "model"), 1, GL_FALSE, value_ptr(model));
+             shader.programa.setMat4(shader.model, value_ptr(model));
  
-             vec2 offsetTex;
-             offsetTex.s = curr_tile.iTile * curr_tile.ds;
-             offsetTex.t = 0.0;
-             glUniform2f(glGetUniformLocation(shaderID, "offsetTex"), offsetTex.s, offsetTex.t);
+             aplicarRegiao(shader, curr_tile.regiao);
  
              glBindVertexArray(curr_tile.VAO);
-             glBindTexture(GL_TEXTURE_2D, curr_tile.texID);
              glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+         }
+     }
+ }
  
-             // Desenhar moeda se houver (item = 1)
-             if (mapa.items[i][j] == 1)
-             {
-                 // Elevar moeda um pouco acima do tile
-                 model = mat4(1);
-                 model = translate(model, vec3(x, y, 0.0));
-                 model = scale(model, moeda.dimensions);
-                 glUniformMatrix4fv(glGetUniformLocation(shaderID, "model"), 1, GL_FALSE, value_ptr(model));
- 
-                 offsetTex.s = 0.0;
-                 offsetTex.t = 0.0;
-                 glUniform2f(glGetUniformLocation(shaderID, "offsetTex"), offsetTex.s, offsetTex.t);
- 
-                 glBindVertexArray(moeda.VAO);
-                 glBindTexture(GL_TEXTURE_2D, moeda.texID);
-                 glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+ void setupMapaInstanciado(ShaderMapa &shader)
+ {
+     shader.programa.usar();
+     shader.programa.setInt(shader.atlas, 0);
+     shader.programa.setVec2(shader.origem, WIDTH / 2.0f, 150.0f);
+     shader.programa.setVec2(shader.dimTile, tileset[0].dimensions.x, tileset[0].dimensions.y);
+
+     // Tabela de regiões por tipo de tile; todos vêm da mesma imagem, logo
+     // da mesma página
+     vector<GLfloat> uvTiles;
+     for (size_t k = 0; k < tileset.size(); k++)
+     {
+         const RegiaoAtlas &r = tileset[k].regiao;
+         uvTiles.insert(uvTiles.end(), {r.u, r.v, r.du, r.dv});
+     }
+     shader.programa.setVec4Array(shader.uvTiles, (int)tileset.size(), uvTiles.data());
+     shader.programa.setFloat(shader.paginaTiles, (float)tileset[0].regiao.pagina);
+
+     desenhoIndireto = GLAD_GL_VERSION_4_3 ||
+                       (GLAD_GL_ARB_multi_draw_indirect && (GLAD_GL_VERSION_4_2 || GLAD_GL_ARB_base_instance));
+     if (desenhoIndireto)
+         indirectBuffer = recursos.criarBuffer();
+
+     setupChunks();
+ }
+
+ // (Re)cria os chunks para as dimensões atuais do mapa, todos marcados como
+ // sujos; deve ser chamada sempre que o mapa inteiro for substituído
+ void setupChunks()
+ {
+     for (size_t c = 0; c < chunks.size(); c++)
+     {
+         recursos.liberar(chunks[c].VBO);
+         recursos.liberar(chunks[c].VAO);
+     }
+
+     chunksLinhas = (mapa.mapHeight + TAM_CHUNK - 1) / TAM_CHUNK;
+     chunksColunas = (mapa.mapWidth + TAM_CHUNK - 1) / TAM_CHUNK;
+
+     ChunkMapa vazio = {recursoNulo(), recursoNulo(), 0, true};
+     chunks.assign((size_t)chunksLinhas * chunksColunas, vazio);
+ }
+
+ // Atributos do VBO do chunk ligado a partir da instância primeiro
+ void apontarAtributosChunk(size_t primeiro)
+ {
+     const GLint tamanhos[] = {2, 1, 3};
+     const size_t deslocamentos[] = {offsetof(InstanciaTile, celula), offsetof(InstanciaTile, iTile),
+                                     offsetof(InstanciaTile, tint)};
+     for (GLuint a = 0; a < 3; a++)
+         glVertexAttribPointer(a, tamanhos[a], GL_FLOAT, GL_FALSE, sizeof(InstanciaTile),
+                               (GLvoid *)(primeiro * sizeof(InstanciaTile) + deslocamentos[a]));
+ }
+
+ void reconstruirChunk(int ci, int cj)
+ {
+     ChunkMapa &chunk = chunks[ci * chunksColunas + cj];
+
+     if (!recursos.valido(chunk.VAO))
+     {
+         chunk.VAO = recursos.criarVAO();
+         glBindVertexArray(recursos.getVAO(chunk.VAO));
+
+         chunk.VBO = recursos.criarBuffer();
+         glBindBuffer(GL_ARRAY_BUFFER, recursos.getNome(chunk.VBO));
+
+         // Só há atributos por instância; os 4 vértices saem de gl_VertexID
+         apontarAtributosChunk(0);
+         for (GLuint a = 0; a < 3; a++)
+         {
+             glEnableVertexAttribArray(a);
+             glVertexAttribDivisor(a, 1);
+         }
+
+         glBindVertexArray(0);
+     }
+
+     int iFim = std::min((ci + 1) * TAM_CHUNK, mapa.mapHeight);
+     int jFim = std::min((cj + 1) * TAM_CHUNK, mapa.mapWidth);
+
+     instancias.clear();
+     for (int i = ci * TAM_CHUNK; i < iFim; i++)
+     {
+         const CelulaMapa *linha = mapa.grade.getLinha(i);
+         for (int j = cj * TAM_CHUNK; j < jFim; j++)
+         {
+             int tileIndex = linha[j].tile;
+             if (tileIndex > 2) {
+                 tileIndex = 0;
              }
+
+             InstanciaTile inst = {{(GLfloat)i, (GLfloat)j}, (GLfloat)tileIndex, {1.0f, 1.0f, 1.0f}};
+             instancias.push_back(inst);
          }
      }
+     chunk.nTiles = (int)instancias.size();
+
+     glBindBuffer(GL_ARRAY_BUFFER, recursos.getNome(chunk.VBO));
+     glBufferData(GL_ARRAY_BUFFER, instancias.size() * sizeof(InstanciaTile), instancias.data(), GL_STATIC_DRAW);
+     glBindBuffer(GL_ARRAY_BUFFER, 0);
+     recursos.setBytes(chunk.VBO, instancias.size() * sizeof(InstanciaTile));
+
+     chunk.sujo = false;
  }
- 
- void desenharPersonagem(GLuint shaderID)
+
+ // Segue o personagem (na posição alvo, em células) quando ele chega perto
+ // da borda da janela. Em cada eixo em que o mapa inteiro cabe na janela a
+ // câmera fica parada na origem
+ void atualizarCamera(vec2 alvo)
  {
      float x0 = WIDTH / 2.0f;
      float y0 = 150.0f;
- 
-     // CORREÇÃO: Usar o tile atual onde o personagem está, não sempre o base_tile
-     int tileAtualIndex = mapa.tiles[(int)pos.x][(int)pos.y];
-     
-     // Garantir que o índice é válido (0=terra, 1=lava)
-     if (tileAtualIndex < 0 || tileAtualIndex > 1) {
-         tileAtualIndex = 0; // Default para terra se inválido
+     float tw = tileset[0].dimensions.x;
+     float th = tileset[0].dimensions.y;
+     const vec2 margem = vec2(200.0f, 150.0f);
+
+     vec2 personagemMundo = vec2(x0 + (alvo.y - alvo.x) * tw / 2.0f + tw / 2.0f,
+                                 y0 + (alvo.x + alvo.y) * th / 2.0f);
+     vec2 mundoMin = vec2(x0 - (mapa.mapHeight - 1) * tw / 2.0f, y0);
+     vec2 mundoMax = vec2(x0 + (mapa.mapWidth - 1) * tw / 2.0f + tw,
+                          y0 + (mapa.mapHeight + mapa.mapWidth - 2) * th / 2.0f + th);
+
+     for (int eixo = 0; eixo < 2; eixo++)
+     {
+         if (mundoMin[eixo] >= 0.0f && mundoMax[eixo] <= camera.tamanho[eixo])
+         {
+             camera.posicao[eixo] = 0.0f;
+             continue;
+         }
+
+         float &c = camera.posicao[eixo];
+         if (personagemMundo[eixo] - c < margem[eixo])
+             c = personagemMundo[eixo] - margem[eixo];
+         else if (personagemMundo[eixo] - c > camera.tamanho[eixo] - margem[eixo])
+             c = personagemMundo[eixo] - camera.tamanho[eixo] + margem[eixo];
+
+         c = glm::clamp(c, mundoMin[eixo] - margem[eixo], mundoMax[eixo] + margem[eixo] - camera.tamanho[eixo]);
      }
-     
-     Tile tile_atual = tileset[tileAtualIndex];
-     
-     // Usar as dimensões do tile atual para o cálculo de posição
-     float x = x0 + (pos.y - pos.x) * tile_atual.dimensions.x / 2.0f +
-                tile_atual.dimensions.x / 2.0f;
-     float y = y0 + (pos.x + pos.y) * tile_atual.dimensions.y / 2.0f ;
- 
-     currTime = glfwGetTime();
-     double deltaT = currTime - lastTime;
- 
-     if (deltaT >= 1.0 / FPS)
+ }
+
+ void aplicarProjecao(ShaderSprite &shader, ShaderMapa &instShader, ShaderEntidades &entShader)
+ {
+     mat4 projection = ortho(camera.posicao.x, camera.posicao.x + camera.tamanho.x,
+                             camera.posicao.y + camera.tamanho.y, camera.posicao.y, -1.0f, 1.0f);
+
+     entShader.programa.usar();
+     entShader.programa.setMat4(entShader.projection, value_ptr(projection));
+     instShader.programa.usar();
+     instShader.programa.setMat4(instShader.projection, value_ptr(projection));
+     shader.programa.usar();
+     shader.programa.setMat4(shader.projection, value_ptr(projection));
+ }
+
+ // Inverso da fórmula isométrica: com u = (x - x0) / (tw/2) e
+ // v = (y - y0) / (th/2), temos i = (v - u) / 2 e j = (u + v) / 2.
+ // Aplicado aos cantos da câmera (com a margem de um tile mais meia moeda)
+ // dá a faixa de linhas que pode ter algum losango na tela
+ bool linhasVisiveis(int &iIni, int &iFim)
+ {
+     float x0 = WIDTH / 2.0f;
+     float y0 = 150.0f;
+     float tw = tileset[0].dimensions.x;
+     float th = tileset[0].dimensions.y;
+     float m = std::max(moeda.dimensions.x, moeda.dimensions.y) / 2.0f;
+
+     float uMin = (camera.posicao.x - tw - m - x0) / (tw / 2.0f);
+     float uMax = (camera.posicao.x + camera.tamanho.x + m - x0) / (tw / 2.0f);
+     float vMin = (camera.posicao.y - th - m - y0) / (th / 2.0f);
+     float vMax = (camera.posicao.y + camera.tamanho.y + m - y0) / (th / 2.0f);
+
+     iIni = std::max(0, (int)ceil((vMin - uMax) / 2.0f));
+     iFim = std::min(mapa.mapHeight - 1, (int)floor((vMax - uMin) / 2.0f));
+     return iIni <= iFim;
+ }
+
+ // Para a linha i, as colunas cujo losango intersecta a câmera: a restrição
+ // em x fixa j - i e a restrição em y fixa i + j
+ bool colunasVisiveis(int i, int &jIni, int &jFim)
+ {
+     float x0 = WIDTH / 2.0f;
+     float y0 = 150.0f;
+     float tw = tileset[0].dimensions.x;
+     float th = tileset[0].dimensions.y;
+     float m = std::max(moeda.dimensions.x, moeda.dimensions.y) / 2.0f;
+
+     float uMin = (camera.posicao.x - tw - m - x0) / (tw / 2.0f);
+     float uMax = (camera.posicao.x + camera.tamanho.x + m - x0) / (tw / 2.0f);
+     float vMin = (camera.posicao.y - th - m - y0) / (th / 2.0f);
+     float vMax = (camera.posicao.y + camera.tamanho.y + m - y0) / (th / 2.0f);
+
+     jIni = std::max(0, (int)ceil(std::max(i + uMin, vMin - i)));
+     jFim = std::min(mapa.mapWidth - 1, (int)floor(std::min(i + uMax, vMax - i)));
+     return jIni <= jFim;
+ }
+
+ void marcarCelulaAlterada(int i, int j)
+ {
+     if (chunks.empty())
+         return;
+     chunks[(i / TAM_CHUNK) * chunksColunas + j / TAM_CHUNK].sujo = true;
+ }
+
+ void desenharMapaInstanciado(ShaderMapa &shader)
+ {
+     chunksDesenhados = 0;
+     tilesDesenhados = 0;
+
+     int iIni, iFim;
+     if (!linhasVisiveis(iIni, iFim))
+         return;
+
+     int jMin = mapa.mapWidth, jMax = -1;
+     for (int i = iIni; i <= iFim; i++)
      {
-         personagem.iFrame = (personagem.iFrame + 1) % personagem.nFrames;
-         lastTime = currTime;
+         int jIni, jFim;
+         if (colunasVisiveis(i, jIni, jFim))
+         {
+             jMin = std::min(jMin, jIni);
+             jMax = std::max(jMax, jFim);
+         }
      }
+     if (jMin > jMax)
+         return;
+
+     // Para cada chunk na faixa visível, um comando indireto por
+     // linha com o trecho de colunas na tela (os tiles do chunk estão em
+     // ordem de linha no VBO, então cada trecho é contíguo)
+     struct DesenhoChunk { int indice; size_t primeiroComando; GLsizei nComandos; };
+     vector<DesenhoChunk> desenhos;
+     comandos.clear();
+
+     for (int ci = iIni / TAM_CHUNK; ci <= iFim / TAM_CHUNK; ci++)
+     {
+         for (int cj = jMin / TAM_CHUNK; cj <= jMax / TAM_CHUNK; cj++)
+         {
+             int chunkIIni = ci * TAM_CHUNK, chunkIFim = std::min(chunkIIni + TAM_CHUNK, mapa.mapHeight) - 1;
+             int chunkJIni = cj * TAM_CHUNK, chunkJFim = std::min(chunkJIni + TAM_CHUNK, mapa.mapWidth) - 1;
+             int largura = chunkJFim - chunkJIni + 1;
+
+             size_t primeiro = comandos.size();
+             for (int i = std::max(iIni, chunkIIni); i <= std::min(iFim, chunkIFim); i++)
+             {
+                 int jIni, jFim;
+                 if (!colunasVisiveis(i, jIni, jFim))
+                     continue;
+                 jIni = std::max(jIni, chunkJIni);
+                 jFim = std::min(jFim, chunkJFim);
+                 if (jIni > jFim)
+                     continue;
+
+                 ComandoIndireto cmd = {4, (GLuint)(jFim - jIni + 1), 0,
+                                        (GLuint)((i - chunkIIni) * largura + (jIni - chunkJIni))};
+                 comandos.push_back(cmd);
+                 tilesDesenhados += jFim - jIni + 1;
+             }
+
+             if (comandos.size() == primeiro)
+                 continue;
+
+             int indice = ci * chunksColunas + cj;
+             if (chunks[indice].sujo)
+                 reconstruirChunk(ci, cj);
+
+             DesenhoChunk d = {indice, primeiro, (GLsizei)(comandos.size() - primeiro)};
+             desenhos.push_back(d);
+         }
+     }
+
+     chunksDesenhados = (int)desenhos.size();
+     if (desenhos.empty())
+         return;
+
+     shader.programa.usar();
+
+     if (!desenhoIndireto)
+     {
+         for (size_t d = 0; d < desenhos.size(); d++)
+         {
+             const ChunkMapa &chunk = chunks[desenhos[d].indice];
+             glBindVertexArray(recursos.getVAO(chunk.VAO));
+             glBindBuffer(GL_ARRAY_BUFFER, recursos.getNome(chunk.VBO));
+             for (GLsizei c = 0; c < desenhos[d].nComandos; c++)
+             {
+                 const ComandoIndireto &cmd = comandos[desenhos[d].primeiroComando + c];
+                 apontarAtributosChunk(cmd.baseInstance);
+                 glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)cmd.instanceCount);
+             }
+         }
+         glBindBuffer(GL_ARRAY_BUFFER, 0);
+         glBindVertexArray(0);
+         return;
+     }
+
+     glBindBuffer(GL_DRAW_INDIRECT_BUFFER, recursos.getNome(indirectBuffer));
+     glBufferData(GL_DRAW_INDIRECT_BUFFER, comandos.size() * sizeof(ComandoIndireto), comandos.data(), GL_STREAM_DRAW);
+     recursos.setBytes(indirectBuffer, comandos.size() * sizeof(ComandoIndireto));
+
+     // Só os losangos na tela; as moedas vêm depois, com as outras entidades
+     for (size_t d = 0; d < desenhos.size(); d++)
+     {
+         glBindVertexArray(recursos.getVAO(chunks[desenhos[d].indice].VAO));
+         glMultiDrawArraysIndirect(GL_TRIANGLE_STRIP, (GLvoid *)(desenhos[d].primeiroComando * sizeof(ComandoIndireto)),
+                                   desenhos[d].nComandos, 0);
+     }
+     glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+     glBindVertexArray(0);
+ }
+
+ void gerarMapaAleatorio(MapData& mapData, int largura, int altura, unsigned int semente)
+ {
+     srand(semente);
+
+     mapData.mapWidth = largura;
+     mapData.mapHeight = altura;
+     mapData.grade.resize(largura, altura);
+
+     // Mesma proporção aproximada do map.txt: maioria terra, um pouco de lava e rosa
+     for (int i = 0; i < altura; i++)
+     {
+         for (int j = 0; j < largura; j++)
+         {
+             int r = rand() % 100;
+             mapData.grade.setTile(i, j, r < 75 ? 0 : (r < 85 ? 1 : 2));
+             mapData.grade.setItem(i, j, (rand() % 100) < 5 ? ITEM_MOEDA : ITEM_VAZIO);
+         }
+     }
+ }
+
+ // Compara o tempo de frame do caminho por tile (um draw call por tile) com o
+ // instanciado por chunks em mapas gerados, com a câmera no centro do mapa.
+ // Os dois caminhos só desenham os tiles visíveis, e as moedas saem das
+ // entidades nos dois; acima de 1024x1024 só o instanciado é medido
+ void executarBenchmark(GLFWwindow *window, ShaderSprite &shader, ShaderMapa &instShader, ShaderEntidades &entShader)
+ {
+     const int tamanhos[] = {64, 128, 256, 512, 1024, 2048, 4096};
+     const int nTamanhos = sizeof(tamanhos) / sizeof(tamanhos[0]);
+     const int frames = 20;
+
+     glfwSwapInterval(0);
+
+     cout << endl << "Benchmark de renderizacao do mapa (" << frames << " frames por caso)" << endl;
+     cout << "tamanho   \tpor tile (ms)\tinstanciado (ms)\tchunks\ttiles\tGL evitadas/frame (por tile)" << endl;
+
+     for (int t = 0; t < nTamanhos; t++)
+     {
+         int n = tamanhos[t];
+         gerarMapaAleatorio(mapa, n, n, 42);
+         setupChunks();
+         criarEntidades();
+
+         // Centro do mapa na fórmula isométrica: i = j = n/2 cai em x = x0
+         camera.posicao = vec2(WIDTH / 2.0f, 150.0f + (n - 1) * tileset[0].dimensions.y / 2.0f) - camera.tamanho / 2.0f;
+         aplicarProjecao(shader, instShader, entShader);
+
+         double tempos[2] = {-1.0, -1.0};
+         long evitadas = -1;
+         for (int modo = (n > 1024 ? 1 : 0); modo < 2; modo++)
+         {
+             // Frame de aquecimento: o caminho instanciado monta os chunks aqui
+             if (modo == 1)
+                 desenharMapaInstanciado(instShader);
+
+             glFinish();
+             ShaderProgram::zerarContadores();
+             double inicio = glfwGetTime();
+             for (int f = 0; f < frames; f++)
+             {
+                 glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                 if (modo == 0)
+                 {
+                     shader.programa.usar();
+                     desenharMapa(shader);
+                 }
+                 else
+                 {
+                     desenharMapaInstanciado(instShader);
+                 }
+                 desenharEntidades(entShader, 1.0f);
+                 glfwSwapBuffers(window);
+                 glFinish();
+             }
+             tempos[modo] = (glfwGetTime() - inicio) * 1000.0 / frames;
+             if (modo == 0)
+                 evitadas = ShaderProgram::getContadores().evitadas() / frames;
+         }
+
+         char linha[256];
+         if (tempos[0] < 0.0)
+             sprintf(linha, "%4dx%-4d\t%10s\t%16.3f\t%d/%d\t%d\t%s", n, n, "-", tempos[1], chunksDesenhados, (int)chunks.size(), tilesDesenhados, "-");
+         else
+             sprintf(linha, "%4dx%-4d\t%10.3f\t%16.3f\t%d/%d\t%d\t%ld", n, n, tempos[0], tempos[1], chunksDesenhados, (int)chunks.size(), tilesDesenhados, evitadas);
+         cout << linha << endl;
+     }
+
+     shader.programa.usar();
+ }
  
-     mat4 model = mat4(1);
-     model = translate(model, vec3(x, y, 0.0));
-     model = scale(model, personagem.dimensions);
-     glUniformMatrix4fv(glGetUniformLocation(shaderID, "model"), 1, GL_FALSE, value_ptr(model));
- 
-     vec2 offsetTex;
-     offsetTex.s = personagem.iFrame * personagem.ds;
-     offsetTex.t = personagem.iAnimation * personagem.dt;
-     glUniform2f(glGetUniformLocation(shaderID, "offsetTex"), offsetTex.s, offsetTex.t);
- 
+ // Recria as entidades do mapa atual: uma por moeda e o personagem em pos.
+ // Devolve quantas moedas criou
+ int criarEntidades()
+ {
+     entidades.limpar();
+     gradeEntidades.iniciar(mapa.mapWidth, mapa.mapHeight);
+     int nMoedas = 0;
+     for (int i = 0; i < mapa.mapHeight; i++)
+     {
+         const CelulaMapa *linha = mapa.grade.getLinha(i);
+         for (int j = 0; j < mapa.mapWidth; j++)
+         {
+             if (linha[j].item != ITEM_MOEDA)
+                 continue;
+             Entidade e = entidades.criar((float)i, (float)j, SPRITE_MOEDA, moeda.nFrames, ENTIDADE_VISIVEL | ENTIDADE_MOEDA);
+             gradeEntidades.inserir(e, (float)i, (float)j);
+             nMoedas++;
+         }
+     }
+
+     jogador = entidades.criar(pos.x, pos.y, SPRITE_PERSONAGEM, personagem.nFrames, ENTIDADE_VISIVEL | ENTIDADE_ATOR);
+     gradeEntidades.inserir(jogador, pos.x, pos.y);
+     entidades.getAnimacoes()[entidades.indice(jogador)] = (uint8_t)personagem.iAnimation;
+     return nMoedas;
+ }
+
+ void setupEntidades(ShaderEntidades &shader)
+ {
+     shader.programa.usar();
+     shader.programa.setInt(shader.atlas, 0);
+     shader.programa.setVec2(shader.origem, WIDTH / 2.0f, 150.0f);
+     shader.programa.setVec2(shader.dimTile, tileset[0].dimensions.x, tileset[0].dimensions.y);
+
+     entidadesVAO = recursos.criarVAO();
+     glBindVertexArray(recursos.getVAO(entidadesVAO));
+     entidadesVBO = recursos.criarBuffer();
+     glBindBuffer(GL_ARRAY_BUFFER, recursos.getNome(entidadesVBO));
+
+     // Como no mapa, só atributos por instância
+     const GLint tamanhos[] = {2, 2, 2, 4, 1, 3};
+     const size_t deslocamentos[] = {offsetof(InstanciaEntidade, celula), offsetof(InstanciaEntidade, dimensoes),
+                                     offsetof(InstanciaEntidade, deslocamento), offsetof(InstanciaEntidade, uv),
+                                     offsetof(InstanciaEntidade, pagina), offsetof(InstanciaEntidade, tint)};
+     for (GLuint a = 0; a < 6; a++)
+     {
+         glVertexAttribPointer(a, tamanhos[a], GL_FLOAT, GL_FALSE, sizeof(InstanciaEntidade), (GLvoid *)deslocamentos[a]);
+         glEnableVertexAttribArray(a);
+         glVertexAttribDivisor(a, 1);
+     }
+
+     glBindBuffer(GL_ARRAY_BUFFER, 0);
+     glBindVertexArray(0);
+ }
+
+ // As entidades visíveis na câmera, com a posição interpolada por alfa entre
+ // os dois últimos passos de lógica: primeiro as paradas (moedas), depois os
+ // atores, que ficam por cima. Só lê os vetores do registro e a tabela de
+ // sprites
+ void montarInstanciasEntidades(const RegistroEntidades &registro, const Sprite *tabela, vec2 dimTile, float alfa,
+                                vector<InstanciaEntidade> &saida)
+ {
+     float x0 = WIDTH / 2.0f;
+     float y0 = 150.0f;
+
+     const float *linhas = registro.getLinhas();
+     const float *colunas = registro.getColunas();
+     const float *linhasAnteriores = registro.getLinhasAnteriores();
+     const float *colunasAnteriores = registro.getColunasAnteriores();
+     const uint16_t *iSprites = registro.getSprites();
+     const uint8_t *animacoes = registro.getAnimacoes();
+     const uint8_t *quadros = registro.getQuadros();
+     const uint8_t *flags = registro.getFlags();
+
+     vec3 tintAtor(1.0f, 1.0f, 1.0f);
      if (jogoPerdido)
-         glUniform3f(glGetUniformLocation(shaderID, "colorTint"), 1.0f, 0.5f, 0.5f);
+         tintAtor = vec3(1.0f, 0.5f, 0.5f);
      else if (jogoGanho)
-         glUniform3f(glGetUniformLocation(shaderID, "colorTint"), 0.5f, 1.0f, 0.5f);
-     else
-         glUniform3f(glGetUniformLocation(shaderID, "colorTint"), 1.0f, 1.0f, 1.0f);
- 
-     glBindVertexArray(personagem.VAO);
-     glBindTexture(GL_TEXTURE_2D, personagem.texID);
-     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+         tintAtor = vec3(0.5f, 1.0f, 0.5f);
+
+     saida.clear();
+     for (int atores = 0; atores < 2; atores++)
+     {
+         for (size_t k = 0; k < registro.tamanho(); k++)
+         {
+             if (!(flags[k] & ENTIDADE_VISIVEL) || ((flags[k] & ENTIDADE_ATOR) != 0) != (atores == 1))
+                 continue;
+
+             float i = linhasAnteriores[k] * (1.0f - alfa) + linhas[k] * alfa;
+             float j = colunasAnteriores[k] * (1.0f - alfa) + colunas[k] * alfa;
+             const Sprite &sprite = tabela[iSprites[k]];
+             float x = x0 + (j - i) * dimTile.x / 2.0f + sprite.position.x;
+             float y = y0 + (i + j) * dimTile.y / 2.0f + sprite.position.y;
+             float meiaLargura = sprite.dimensions.x / 2.0f, meiaAltura = sprite.dimensions.y / 2.0f;
+             if (x + meiaLargura < camera.posicao.x || x - meiaLargura > camera.posicao.x + camera.tamanho.x ||
+                 y + meiaAltura < camera.posicao.y || y - meiaAltura > camera.posicao.y + camera.tamanho.y)
+                 continue;
+
+             RegiaoAtlas r = sprite.regiao.celula(quadros[k], animacoes[k], sprite.nFrames, sprite.nAnimations);
+             vec3 tint = atores == 1 ? tintAtor : vec3(1.0f, 1.0f, 1.0f);
+             InstanciaEntidade inst = {{i, j},
+                                       {sprite.dimensions.x, sprite.dimensions.y},
+                                       {sprite.position.x, sprite.position.y},
+                                       {r.u, r.v, r.du, r.dv},
+                                       (GLfloat)r.pagina,
+                                       {tint.r, tint.g, tint.b}};
+             saida.push_back(inst);
+         }
+     }
+ }
+
+ // Todas as entidades visíveis num draw call instanciado
+ void desenharEntidades(ShaderEntidades &shader, float alfa)
+ {
+     montarInstanciasEntidades(entidades, sprites, vec2(tileset[0].dimensions.x, tileset[0].dimensions.y), alfa, instanciasEntidades);
+     if (instanciasEntidades.empty())
+         return;
+
+     shader.programa.usar();
+     glBindBuffer(GL_ARRAY_BUFFER, recursos.getNome(entidadesVBO));
+     glBufferData(GL_ARRAY_BUFFER, instanciasEntidades.size() * sizeof(InstanciaEntidade), instanciasEntidades.data(),
+                  GL_STREAM_DRAW);
+     glBindBuffer(GL_ARRAY_BUFFER, 0);
+     recursos.setBytes(entidadesVBO, instanciasEntidades.size() * sizeof(InstanciaEntidade));
+
+     glBindVertexArray(recursos.getVAO(entidadesVAO));
+     glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)instanciasEntidades.size());
+     glBindVertexArray(0);
  }
  
  bool carregarMapa(const string& filepath, MapData& mapData)
+ {
+     string erro;
+     const string extBinario = ".tmapb";
+     bool binario = filepath.size() >= extBinario.size() &&
+                    filepath.compare(filepath.size() - extBinario.size(), extBinario.size(), extBinario) == 0;
+     bool ok = binario ? carregarMapaBinario(filepath, mapData, erro) : carregarMapaTexto(filepath, mapData, erro);
+     if (!ok)
+     {
+         cerr << erro << endl;
+         return false;
+     }
+     return true;
+ }
+ 
+ // Leitura antiga com ifstream >>, mantida só para comparação no --bench-carga
+ bool carregarMapaStream(const string& filepath, MapData& mapData)
  {
      ifstream file(filepath);
      if (!file.is_open())
@@ -554,25 +1781,23 @@ cout << "Tile na posicao: " << mapa.tiles[(int)pos.x][(int)pos.y] << endl;
      file >> mapData.numTiles >> mapData.tileWidth >> mapData.tileHeight;
      file >> mapData.mapWidth >> mapData.mapHeight;
  
-     mapData.tiles.resize(mapData.mapHeight, vector<int>(mapData.mapWidth));
-     mapData.items.resize(mapData.mapHeight, vector<int>(mapData.mapWidth));
+     mapData.grade.resize(mapData.mapWidth, mapData.mapHeight);
  
-     // Ler tiles - converter qualquer valor >= 2 para terra (0)
+     // Ler tiles - converter os índices do PNG para os tipos do jogo
      for (int i = 0; i < mapData.mapHeight; i++)
      {
          for (int j = 0; j < mapData.mapWidth; j++)
          {
-             file >> mapData.tiles[i][j];
-             // Simplificar: apenas terra(0) ou lava(1)
-             int valor = mapData.tiles[i][j];
+             int valor;
+             file >> valor;
              if (valor == 2) // Terra (índice 2 no PNG)
-             mapData.tiles[i][j] = 0;
-         else if (valor == 4) // Lava (índice 3 no PNG)
-             mapData.tiles[i][j] = 1;
-         else if (valor == 6) // Rosa (índice 6 no PNG)
-             mapData.tiles[i][j] = 2;
-         else
-             mapData.tiles[i][j] = -1;
+                 mapData.grade.setTile(i, j, 0);
+             else if (valor == 4) // Lava (índice 3 no PNG)
+                 mapData.grade.setTile(i, j, 1);
+             else if (valor == 6) // Rosa (índice 6 no PNG)
+                 mapData.grade.setTile(i, j, 2);
+             else
+                 mapData.grade.setTile(i, j, TILE_INVALIDO);
          }
      }
  
@@ -581,11 +1806,10 @@ cout << "Tile na posicao: " << mapa.tiles[(int)pos.x][(int)pos.y] << endl;
      {
          for (int j = 0; j < mapData.mapWidth; j++)
          {
-             file >> mapData.items[i][j];
+             int valor;
+             file >> valor;
              // Garantir que apenas 0 (vazio) ou 1 (moeda) são válidos
-             if (mapData.items[i][j] != 1) {
-                 mapData.items[i][j] = 0;
-             }
+             mapData.grade.setItem(i, j, valor == 1 ? ITEM_MOEDA : ITEM_VAZIO);
          }
      }
  
@@ -593,10 +1817,10 @@ cout << "Tile na posicao: " << mapa.tiles[(int)pos.x][(int)pos.y] << endl;
      return true;
  }
  
- int setupShader()
+ int setupShader(const GLchar *vsSource, const GLchar *fsSource)
  {
      GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-     glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
+     glShaderSource(vertexShader, 1, &vsSource, NULL);
      glCompileShader(vertexShader);
  
      GLint success;
@@ -609,7 +1833,7 @@ cout << "Tile na posicao: " << mapa.tiles[(int)pos.x][(int)pos.y] << endl;
      }
  
      GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-     glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
+     glShaderSource(fragmentShader, 1, &fsSource, NULL);
      glCompileShader(fragmentShader);
  
      glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
@@ -636,140 +1860,82 @@ cout << "Tile na posicao: " << mapa.tiles[(int)pos.x][(int)pos.y] << endl;
  
      return shaderProgram;
  }
- 
- int setupSprite(int nAnimations, int nFrames, float &ds, float &dt)
+
+ void resolverUniforms(ShaderSprite &shader, GLuint programa)
  {
-    ds = 1.0 / (float)nFrames;
-    dt = 1.0 / (float)nAnimations;
- 
-    GLfloat vertices[] = {
-        -0.5,  0.5, 0.0, 0.0, 0.0,
-        -0.5, -0.5, 0.0, 0.0, dt,
-         0.5,  0.5, 0.0, ds,  0.0,
-         0.5, -0.5, 0.0, ds,  dt
-    };
- 
-    GLuint VBO, VAO;
-    glGenBuffers(1, &VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
- 
-    glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
- 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid *)0);
-    glEnableVertexAttribArray(0);
- 
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid *)(3 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(1);
- 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
- 
-    return VAO;
+     shader.programa.adotar(programa);
+     shader.model = shader.programa.localizar("model");
+     shader.projection = shader.programa.localizar("projection");
+     shader.uvRect = shader.programa.localizar("uvRect");
+     shader.pagina = shader.programa.localizar("pagina");
+     shader.colorTint = shader.programa.localizar("colorTint");
+     shader.atlas = shader.programa.localizar("atlas");
  }
- 
- int setupCoin(float &ds, float &dt)
+
+ void resolverUniforms(ShaderMapa &shader, GLuint programa)
  {
-    ds = 1.0;
-    dt = 1.0;
- 
-    GLfloat vertices[] = {
-        -0.5,  0.5, 0.0, 0.0, 0.0,
-        -0.5, -0.5, 0.0, 0.0, 1.0,
-         0.5,  0.5, 0.0, 1.0, 0.0,
-         0.5, -0.5, 0.0, 1.0, 1.0
-    };
- 
-    GLuint VBO, VAO;
-    glGenBuffers(1, &VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
- 
-    glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
- 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid *)0);
-    glEnableVertexAttribArray(0);
- 
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid *)(3 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(1);
- 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
- 
-    return VAO;
+     shader.programa.adotar(programa);
+     shader.projection = shader.programa.localizar("projection");
+     shader.origem = shader.programa.localizar("origem");
+     shader.dimTile = shader.programa.localizar("dimTile");
+     shader.uvTiles = shader.programa.localizar("uvTiles");
+     shader.paginaTiles = shader.programa.localizar("paginaTiles");
+     shader.atlas = shader.programa.localizar("atlas");
  }
- 
- int setupTile(int nTiles, float &ds, float &dt)
+
+ void resolverUniforms(ShaderEntidades &shader, GLuint programa)
  {
-    ds = 1.0 / (float)nTiles;
-    dt = 1.0;
+     shader.programa.adotar(programa);
+     shader.projection = shader.programa.localizar("projection");
+     shader.origem = shader.programa.localizar("origem");
+     shader.dimTile = shader.programa.localizar("dimTile");
+     shader.atlas = shader.programa.localizar("atlas");
+ }
  
+ // Losango unitário, com as coordenadas de textura de 0 a 1 dentro da região
+ // do tile no atlas (ver aplicarRegiao). Os três tipos de tile recebem o
+ // mesmo, do cache de recursos
+ RecursoGPU setupTile()
+ {
     float th = 1.0, tw = 1.0;
  
     GLfloat vertices[] = {
-        0.0,     th/2.0f, 0.0, 0.0,      dt/2.0f,
-        tw/2.0f, th,      0.0, ds/2.0f,  dt,
-        tw/2.0f, 0.0,     0.0, ds/2.0f,  0.0,
-         tw,      th/2.0f, 0.0, ds,       dt/2.0f
+        0.0,     th/2.0f, 0.0, 0.0,  0.5,
+        tw/2.0f, th,      0.0, 0.5,  1.0,
+        tw/2.0f, 0.0,     0.0, 0.5,  0.0,
+         tw,      th/2.0f, 0.0, 1.0,  0.5
      };
  
-     GLuint VBO, VAO;
-     glGenBuffers(1, &VBO);
-     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
- 
-     glGenVertexArrays(1, &VAO);
-     glBindVertexArray(VAO);
- 
-     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid *)0);
-     glEnableVertexAttribArray(0);
- 
-     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid *)(3 * sizeof(GLfloat)));
-     glEnableVertexAttribArray(1);
- 
-     glBindBuffer(GL_ARRAY_BUFFER, 0);
-     glBindVertexArray(0);
- 
-     return VAO;
+     FormatoVertices formato;
+     formato.adicionar(0, 3);
+     formato.adicionar(1, 2);
+     return recursos.geometria(formato, vertices, sizeof(vertices), 4);
  }
  
- int loadTexture(string filePath, int &width, int &height)
+ // Objetos GL vivos e memória de vídeo estimada por tipo de recurso
+ void relatarRecursos(const char *quando)
  {
-     GLuint texID;
- 
-     glGenTextures(1, &texID);
-     glBindTexture(GL_TEXTURE_2D, texID);
- 
-     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
- 
-     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
- 
-     int nrChannels;
-     unsigned char *data = stbi_load(filePath.c_str(), &width, &height, &nrChannels, 0);
-  
-     if (data)
-     {
-         if (nrChannels == 3)
-         {
-             glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-         }
-         else
-         {
-             glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-         }
-         glGenerateMipmap(GL_TEXTURE_2D);
-     }
-     else
+     for (int t = 0; t < NUM_TIPOS_RECURSO; t++)
      {
-         std::cout << "Failed to load texture" << std::endl;
+         const UsoRecursosGPU &uso = recursos.getUso((TipoRecursoGPU)t);
+         escreverLog(LOG_INFO, "Recursos GPU %s: %-9s %3ld objetos, %8.1f KB (%ld reaproveitados)", quando,
+                     RecursosGPU::nomeTipo((TipoRecursoGPU)t), uso.quantidade, uso.bytes / 1024.0, uso.reaproveitados);
      }
+     escreverLog(LOG_INFO, "Recursos GPU %s: total %.1f KB", quando, recursos.getBytesTotal() / 1024.0);
+ }
  
-     stbi_image_free(data);
-     glBindTexture(GL_TEXTURE_2D, 0);
+ // No fim do programa, com o contexto ainda ativo: apaga todos os objetos
+ // GL do cache, inclusive a textura do atlas
+ void liberarRecursos()
+ {
+     relatarRecursos("no fim");
+     int vivos = recursos.liberarTudo();
+     escreverLog(LOG_INFO, "Recursos GPU: %d objetos apagados no fim", vivos);
+ }
  
-     return texID;
- }
\ No newline at end of file
+ // Retângulo e página da imagem no atlas para o shader de sprites
+ void aplicarRegiao(ShaderSprite &shader, const RegiaoAtlas &regiao)
+ {
+     shader.programa.setVec4(shader.uvRect, regiao.u, regiao.v, regiao.du, regiao.dv);
+     shader.programa.setFloat(shader.pagina, (float)regiao.pagina);
+ }
@@ -0,0 +1,74 @@
+//
+//  ProvaGB-Tilemap.h
+//
+//  O que o jogo (ProvaGB-Tilemap.cpp) e os benchmarks de linha de comando
+//  (ProvaGB-Bench.cpp) compartilham: os tipos do desenho das entidades, a
+//  câmera e as funções do jogo que os benchmarks medem ou usam para montar
+//  os mapas.
+//
+
+ #ifndef ProvaGB_Tilemap_h
+ #define ProvaGB_Tilemap_h
+
+ #include <string>
+ #include <vector>
+
+ #include <glad/glad.h>
+ #include <glm/glm.hpp>
+
+ #include "Entities.h"
+ #include "MapData.h"
+ #include "TextureAtlas.h"
+
+ // Dimensões da janela
+ const GLuint WIDTH = 1024, HEIGHT = 768;
+
+ // Moeda e personagem: desenhados pelo shader instanciado das entidades, só
+ // precisam da região no atlas, do tamanho e da animação
+ struct Sprite
+ {
+     RegiaoAtlas regiao; // imagem inteira (todos os frames) no atlas
+     glm::vec3 position;
+     glm::vec3 dimensions;
+     int iAnimation, iFrame;
+     int nAnimations, nFrames;
+ };
+
+ // Sprites que as entidades usam, pelo índice guardado no RegistroEntidades
+ enum { SPRITE_MOEDA = 0, SPRITE_PERSONAGEM, NUM_SPRITES };
+
+ // Atributos de instância do desenho das entidades (moedas e personagem),
+ // montados a cada frame dos vetores do RegistroEntidades
+ struct InstanciaEntidade
+ {
+     GLfloat celula[2];       // (i, j) interpolada entre os dois últimos passos
+     GLfloat dimensoes[2];
+     GLfloat deslocamento[2]; // a partir do canto do losango, em pixels
+     GLfloat uv[4];           // quadro da animação no atlas
+     GLfloat pagina;
+     GLfloat tint[3];
+ };
+
+ // Câmera 2D: a viewport mostra o retângulo [posicao, posicao + tamanho] do
+ // mundo (coordenadas em pixels da fórmula isométrica)
+ struct Camera
+ {
+     glm::vec2 posicao;
+     glm::vec2 tamanho;
+ };
+
+ extern Camera camera;
+ extern double FPS; // frames da animação do personagem por segundo
+
+ bool carregarMapa(const std::string& filepath, MapData& mapData);
+ bool carregarMapaStream(const std::string& filepath, MapData& mapData);
+ void gerarMapaAleatorio(MapData& mapData, int largura, int altura, unsigned int semente);
+ void montarCustosBenchmark(float custos[256], bool lavaCara);
+ void montarInstanciasEntidades(const RegistroEntidades &registro, const Sprite *tabela, glm::vec2 dimTile, float alfa,
+                                std::vector<InstanciaEntidade> &saida);
+
+ // Roda o benchmark da opção (--bench-mapa, --bench-carga, ...), sem abrir
+ // janela; devolve false se a opção não é de nenhum (ProvaGB-Bench.cpp)
+ bool executarBenchmarkLinhaComando(const char *opcao);
+
+ #endif /* ProvaGB_Tilemap_h */
@@ -0,0 +1,251 @@
+/* mapc - conversor de mapas para o formato binário .tmapb
+ *
+ * Uso: mapc <entrada.txt | entrada.tmap | entrada.tmx> [saida.tmapb]
+ *
+ *   .txt  map.txt do ProvaGB-Tilemap. Gera a camada "celulas" (tile + item,
+ *         2 bytes por célula), carregada no lugar pelo jogo.
+ *   .tmap mapa dos exemplos do Módulo 6 (largura altura + índices). Gera a
+ *         camada "tiles".
+ *   .tmx  mapa do Tiled (CSV, base64, base64 + zlib/gzip). Gera uma camada
+ *         por <layer>, com índices relativos ao firstgid do primeiro tileset
+ *         (gid 0 vira célula vazia).
+ *
+ * Sem saída, grava ao lado da entrada trocando a extensão por .tmapb.
+ */
+
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// STB_IMAGE: só o zlib é usado, para as camadas comprimidas do .tmx
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include "MapBinary.h"
+#include "MapLoader.h"
+#include "TmxLoader.h"
+
+using namespace std;
+
+static string extensao(const string &caminho)
+{
+    size_t ponto = caminho.find_last_of('.');
+    size_t barra = caminho.find_last_of("/\\");
+    if (ponto == string::npos || (barra != string::npos && ponto < barra))
+        return "";
+    string ext = caminho.substr(ponto);
+    for (size_t k = 0; k < ext.size(); k++)
+        ext[k] = (char)tolower((unsigned char)ext[k]);
+    return ext;
+}
+
+static bool copiarTileset(CabecalhoTmapb &cab, const string &tileset, string &erro)
+{
+    if (tileset.size() >= sizeof(cab.tileset))
+    {
+        erro = "nome do tileset longo demais para .tmapb: " + tileset;
+        return false;
+    }
+    memcpy(cab.tileset, tileset.c_str(), tileset.size());
+    return true;
+}
+
+// Escolhe uint8 ou uint16 pelo maior índice e preenche o buffer da camada
+static void montarCamada(const vector<uint32_t> &indices, bool temVazio, vector<uint8_t> &buffer, int &bytesPorCelula)
+{
+    uint32_t maior = 0;
+    for (size_t k = 0; k < indices.size(); k++)
+        if (indices[k] != UINT32_MAX && indices[k] > maior)
+            maior = indices[k];
+
+    // O maior valor de cada tipo fica reservado para célula vazia
+    bytesPorCelula = (maior < TMAPB_SEM_TILE8 || (!temVazio && maior == TMAPB_SEM_TILE8)) ? 1 : 2;
+    buffer.resize(indices.size() * bytesPorCelula);
+    for (size_t k = 0; k < indices.size(); k++)
+    {
+        if (bytesPorCelula == 1)
+            buffer[k] = indices[k] == UINT32_MAX ? TMAPB_SEM_TILE8 : (uint8_t)indices[k];
+        else
+        {
+            uint16_t v = indices[k] == UINT32_MAX ? TMAPB_SEM_TILE16 : (uint16_t)indices[k];
+            memcpy(&buffer[2 * k], &v, 2);
+        }
+    }
+}
+
+static bool converterTxt(const string &entrada, const string &saida, string &erro)
+{
+    MapData mapa;
+    if (!carregarMapaTexto(entrada, mapa, erro))
+        return false;
+    return salvarMapaBinario(saida, mapa, erro);
+}
+
+static bool converterTmap(const string &entrada, const string &saida, string &erro)
+{
+    ArquivoMapeado arquivo;
+    if (!arquivo.abrir(entrada.c_str()))
+    {
+        erro = "Erro ao abrir arquivo: " + entrada;
+        return false;
+    }
+    const char *dados = arquivo.getDados();
+    LeitorInteiros leitor(dados, dados + arquivo.getTamanho());
+
+    int w, h;
+    if (!leitor.lerInt(w) || !leitor.lerInt(h) || w <= 0 || h <= 0)
+    {
+        erro = entrada + ":" + leitor.descreverPosicao() + ": esperadas largura e altura";
+        return false;
+    }
+
+    vector<uint32_t> indices((size_t)w * h);
+    for (size_t k = 0; k < indices.size(); k++)
+    {
+        int tid;
+        if (!leitor.lerInt(tid) || tid < 0 || tid >= TMAPB_SEM_TILE16)
+        {
+            erro = entrada + ":" + leitor.descreverPosicao() + ": esperado indice de tile";
+            return false;
+        }
+        indices[k] = (uint32_t)tid;
+    }
+
+    CabecalhoTmapb cab;
+    memset(&cab, 0, sizeof(cab));
+    cab.largura = (uint32_t)w;
+    cab.altura = (uint32_t)h;
+
+    vector<uint8_t> buffer;
+    vector<CamadaTmapb> camadas(1);
+    camadas[0].nome = "tiles";
+    montarCamada(indices, false, buffer, camadas[0].bytesPorCelula);
+    camadas[0].dados = buffer.data();
+    return gravarMapaBinario(saida, cab, camadas, erro);
+}
+
+static bool converterTmx(const string &entrada, const string &saida, string &erro)
+{
+    MapaTmx tmx;
+    if (!carregarTmx(entrada, tmx, erro))
+        return false;
+    if (tmx.camadas.empty())
+    {
+        erro = entrada + ": nenhuma camada de tiles";
+        return false;
+    }
+
+    CabecalhoTmapb cab;
+    memset(&cab, 0, sizeof(cab));
+    cab.largura = (uint32_t)tmx.largura;
+    cab.altura = (uint32_t)tmx.altura;
+    cab.tileWidth = (uint32_t)tmx.tileWidth;
+    cab.tileHeight = (uint32_t)tmx.tileHeight;
+
+    uint32_t firstgid = 1;
+    if (!tmx.tilesets.empty())
+    {
+        firstgid = (uint32_t)tmx.tilesets[0].firstgid;
+        if (!copiarTileset(cab, tmx.tilesets[0].source, erro))
+            return false;
+        if (tmx.tilesets.size() > 1)
+            cerr << "aviso: " << entrada << " tem " << tmx.tilesets.size()
+                 << " tilesets; os indices ficam relativos ao primeiro (" << tmx.tilesets[0].source << ")" << endl;
+    }
+
+    vector<vector<uint8_t>> buffers(tmx.camadas.size());
+    vector<CamadaTmapb> camadas(tmx.camadas.size());
+    for (size_t c = 0; c < tmx.camadas.size(); c++)
+    {
+        const CamadaTmx &camada = tmx.camadas[c];
+        if (camada.largura != tmx.largura || camada.altura != tmx.altura || camada.gids.empty())
+        {
+            erro = entrada + ": camada \"" + camada.nome + "\" vazia ou com tamanho diferente do mapa";
+            return false;
+        }
+
+        vector<uint32_t> indices(camada.gids.size());
+        bool temVazio = false;
+        for (size_t k = 0; k < indices.size(); k++)
+        {
+            uint32_t gid = camada.gids[k] & ~TMX_FLAGS_GID;
+            if (gid == 0)
+            {
+                indices[k] = UINT32_MAX;
+                temVazio = true;
+            }
+            else if (gid < firstgid || gid - firstgid >= TMAPB_SEM_TILE16)
+            {
+                erro = entrada + ": gid " + to_string(gid) + " fora do intervalo na camada \"" + camada.nome + "\"";
+                return false;
+            }
+            else
+                indices[k] = gid - firstgid;
+        }
+
+        camadas[c].nome = camada.nome;
+        if (camadas[c].nome.size() >= sizeof(DescritorCamada().nome))
+        {
+            camadas[c].nome.resize(sizeof(DescritorCamada().nome) - 1);
+            cerr << "aviso: nome da camada \"" << camada.nome << "\" truncado para \"" << camadas[c].nome << "\"" << endl;
+        }
+        montarCamada(indices, temVazio, buffers[c], camadas[c].bytesPorCelula);
+        camadas[c].dados = buffers[c].data();
+    }
+    return gravarMapaBinario(saida, cab, camadas, erro);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        cerr << "Uso: mapc <entrada.txt | entrada.tmap | entrada.tmx> [saida.tmapb]" << endl;
+        return 1;
+    }
+
+    string entrada = argv[1];
+    string ext = extensao(entrada);
+    string saida = argc == 3 ? argv[2] : entrada.substr(0, entrada.size() - ext.size()) + ".tmapb";
+
+    chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+    string erro;
+    bool ok;
+    if (ext == ".txt")
+        ok = converterTxt(entrada, saida, erro);
+    else if (ext == ".tmap")
+        ok = converterTmap(entrada, saida, erro);
+    else if (ext == ".tmx")
+        ok = converterTmx(entrada, saida, erro);
+    else
+    {
+        erro = "extensao nao reconhecida: " + entrada + " (use .txt, .tmap ou .tmx)";
+        ok = false;
+    }
+
+    if (!ok)
+    {
+        cerr << erro << endl;
+        return 1;
+    }
+
+    // Confere o arquivo gerado e mostra o resumo
+    MapaBinario mapa;
+    if (!mapa.abrir(saida, erro))
+    {
+        cerr << erro << endl;
+        return 1;
+    }
+    const CabecalhoTmapb &cab = mapa.getCabecalho();
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    cout << entrada << " -> " << saida << " (" << ms << " ms)" << endl;
+    cout << "  " << cab.largura << "x" << cab.altura << ", tile " << cab.tileWidth << "x" << cab.tileHeight
+         << ", tileset \"" << cab.tileset << "\"" << endl;
+    for (int k = 0; k < mapa.getNumCamadas(); k++)
+        cout << "  camada \"" << mapa.getDescritor(k).nome << "\": " << mapa.getDescritor(k).bytesPorCelula
+             << " byte(s) por celula" << endl;
+    return 0;
+}
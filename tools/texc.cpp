@@ -0,0 +1,178 @@
+/* texc - conversor de texturas PNG para KTX2 comprimido na GPU
+ *
+ * Uso: texc [--bc7 | --bc3] [--sem-mipmaps] <entrada.png> [saida.ktx2]
+ *      texc [--bc7 | --bc3] [--sem-mipmaps] <entrada.png> <entrada2.png> ...
+ *
+ *   --bc7 (padrão) blocos BC7 modos 5 e 6: 1 byte por pixel, alpha completo.
+ *         Precisa de OpenGL 4.2 ou GL_ARB_texture_compression_bptc.
+ *   --bc3 blocos BC3 (DXT5): mesmo tamanho, cores piores, existe em placas
+ *         mais antigas (GL_EXT_texture_compression_s3tc).
+ *   --sem-mipmaps grava só o nível 0.
+ *
+ * Sem saída, grava ao lado de cada entrada trocando a extensão por .ktx2,
+ * que é onde o CarregadorTexturas (Common/TextureLoader.h) procura. A
+ * cadeia de mipmaps é gerada aqui, pela média de 2x2 pixels, como o
+ * glGenerateMipmap faria na carga.
+ */
+
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include "BlockCompression.h"
+#include "Ktx2.h"
+
+using namespace std;
+
+static string extensao(const string &caminho)
+{
+    size_t ponto = caminho.find_last_of('.');
+    size_t barra = caminho.find_last_of("/\\");
+    if (ponto == string::npos || (barra != string::npos && ponto < barra))
+        return "";
+    string ext = caminho.substr(ponto);
+    for (size_t k = 0; k < ext.size(); k++)
+        ext[k] = (char)tolower((unsigned char)ext[k]);
+    return ext;
+}
+
+static double milissegundos(chrono::steady_clock::time_point desde)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - desde).count();
+}
+
+// PSNR do nível 0 comprimido contra o original. A cor dos pixels com alpha
+// 0 não aparece e o compressor a ignora, então só o alpha deles entra
+static double psnr(const uint8_t *original, const vector<uint8_t> &decodificada)
+{
+    double soma = 0.0;
+    size_t amostras = 0;
+    for (size_t k = 0; k < decodificada.size(); k += 4)
+    {
+        int canais = original[k + 3] == 0 ? 1 : 4;
+        for (int c = 4 - canais; c < 4; c++)
+        {
+            double d = (double)original[k + c] - decodificada[k + c];
+            soma += d * d;
+        }
+        amostras += canais;
+    }
+    double mse = amostras ? soma / amostras : 0.0;
+    return mse <= 0.0 ? 99.0 : 10.0 * log10(255.0 * 255.0 / mse);
+}
+
+static bool converter(const string &entrada, const string &saida, FormatoBloco formato, bool mipmaps, string &erro)
+{
+    chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+    int largura, altura, canais;
+    unsigned char *pixels = stbi_load(entrada.c_str(), &largura, &altura, &canais, 4);
+    if (!pixels)
+    {
+        erro = "Falha ao ler " + entrada + ": " + stbi_failure_reason();
+        return false;
+    }
+    double msPng = milissegundos(t0);
+
+    // Nível 0 e, com mipmaps, cada metade até 1x1
+    chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+    vector<vector<uint8_t>> niveis;
+    vector<uint8_t> atual(pixels, pixels + (size_t)largura * altura * 4), proximo;
+    int l = largura, a = altura;
+    for (;;)
+    {
+        niveis.push_back(vector<uint8_t>());
+        comprimirImagem(formato, atual.data(), l, a, niveis.back());
+        if (!mipmaps || (l == 1 && a == 1) || niveis.size() == KTX2_MAX_NIVEIS)
+            break;
+        reduzirMetade(atual.data(), l, a, proximo);
+        atual.swap(proximo);
+        l = max(1, l / 2);
+        a = max(1, a / 2);
+    }
+    double msComprimir = milissegundos(t1);
+
+    vector<uint8_t> decodificada;
+    descomprimirImagem(formato, niveis[0].data(), largura, altura, decodificada);
+    double qualidade = psnr(pixels, decodificada);
+    stbi_image_free(pixels);
+
+    uint32_t vkFormat = formato == BLOCO_BC7 ? VK_FORMAT_BC7_UNORM_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+    if (!gravarKtx2(saida, vkFormat, largura, altura, niveis, erro))
+        return false;
+
+    // Confere o arquivo gerado e mede a leitura, que é o que a carga faz
+    chrono::steady_clock::time_point t2 = chrono::steady_clock::now();
+    TexturaKtx2 ktx;
+    if (!ktx.abrir(saida, erro))
+        return false;
+    vector<uint8_t> copia(ktx.getBytesNiveis(ktx.getNumNiveis()));
+    size_t pos = 0;
+    for (int k = 0; k < ktx.getNumNiveis(); k++)
+    {
+        memcpy(&copia[pos], ktx.getDadosNivel(k), ktx.getBytesNivel(k));
+        pos += ktx.getBytesNivel(k);
+    }
+    double msKtx = milissegundos(t2);
+
+    size_t bytesRgba = (size_t)largura * altura * 4;
+    if (mipmaps)
+        bytesRgba = bytesRgba * 4 / 3;
+    size_t bytesGpu = ktx.getBytesNiveis(ktx.getNumNiveis());
+    cout << entrada << " -> " << saida << " (" << (formato == BLOCO_BC7 ? "BC7" : "BC3") << ", "
+         << ktx.getNumNiveis() << " nivel(is), comprimido em " << msComprimir << " ms)" << endl;
+    printf("  %dx%d, GPU %.1f KB (RGBA8: %.1f KB), PSNR %.1f dB\n", largura, altura, bytesGpu / 1024.0,
+           bytesRgba / 1024.0, qualidade);
+    printf("  carga: PNG %.2f ms (stbi_load), KTX2 %.2f ms\n", msPng, msKtx);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    FormatoBloco formato = BLOCO_BC7;
+    bool mipmaps = true;
+    vector<string> entradas;
+    string saida;
+    for (int k = 1; k < argc; k++)
+    {
+        string arg = argv[k];
+        if (arg == "--bc7")
+            formato = BLOCO_BC7;
+        else if (arg == "--bc3")
+            formato = BLOCO_BC3;
+        else if (arg == "--sem-mipmaps")
+            mipmaps = false;
+        else if (extensao(arg) == ".ktx2")
+            saida = arg;
+        else
+            entradas.push_back(arg);
+    }
+    if (entradas.empty() || (!saida.empty() && entradas.size() != 1))
+    {
+        cerr << "Uso: texc [--bc7 | --bc3] [--sem-mipmaps] <entrada.png> [saida.ktx2]" << endl;
+        cerr << "     texc [--bc7 | --bc3] [--sem-mipmaps] <entrada.png> <entrada2.png> ..." << endl;
+        return 1;
+    }
+
+    int falhas = 0;
+    for (size_t k = 0; k < entradas.size(); k++)
+    {
+        string destino = saida;
+        if (destino.empty())
+            destino = entradas[k].substr(0, entradas[k].size() - extensao(entradas[k]).size()) + ".ktx2";
+        string erro;
+        if (!converter(entradas[k], destino, formato, mipmaps, erro))
+        {
+            cerr << erro << endl;
+            falhas++;
+        }
+    }
+    return falhas == 0 ? 0 : 1;
+}